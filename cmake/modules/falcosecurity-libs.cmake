@@ -81,6 +81,11 @@ set(BUILD_LIBSCAP_MODERN_BPF ${BUILD_FALCO_MODERN_BPF} CACHE BOOL "")
 set(CREATE_TEST_TARGETS OFF CACHE BOOL "")
 set(BUILD_LIBSCAP_EXAMPLES OFF CACHE BOOL "")
 
+# the test_input engine is only enabled along with the tests of this
+# dependency by default, but it feeds the events of the synthetic event
+# generator (engine.kind=nodriver), so it is explicitly enabled here
+set(HAS_ENGINE_TEST_INPUT On)
+
 set(USE_BUNDLED_TBB ON CACHE BOOL "")
 set(USE_BUNDLED_JSONCPP ON CACHE BOOL "")
 set(USE_BUNDLED_VALIJSON ON CACHE BOOL "")
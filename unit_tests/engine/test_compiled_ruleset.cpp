@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "../test_synthetic_events.h"
+#include <engine/compiled_ruleset.h>
+
+#include <functional>
+
+using falco_compiled::field;
+
+// The fields and interpreted checks used by the compiled conditions
+// below, like the state of a generated ruleset
+struct compiled_state
+{
+	enum
+	{
+		PROC_NAME,
+		PROC_PNAME,
+		PROC_PID,
+		FD_NAME,
+		FD_NUM,
+		USER_UID,
+		NUM_FIELDS
+	};
+
+	std::array<field, NUM_FIELDS> f;
+	std::array<falco_compiled::interpreted, 1> c;
+};
+
+struct compiled_case
+{
+	std::string condition;
+	// the code ruleset_codegen generates for the condition
+	std::function<bool(compiled_state&, sinsp_evt*)> run;
+};
+
+static const std::array<std::string_view, 2> s_names = {{
+	std::string_view("synthetic-1", 11),
+	std::string_view("synthetic-3", 11),
+}};
+
+static std::vector<compiled_case> compiled_cases()
+{
+	using S = compiled_state;
+	return {
+		{"proc.name = synthetic-1", [](S& st, sinsp_evt* evt) {
+			return (st.f[S::PROC_NAME].extract(evt) && st.f[S::PROC_NAME].str() == std::string_view("synthetic-1", 11)); }},
+		{"proc.name != synthetic-1", [](S& st, sinsp_evt* evt) {
+			return (st.f[S::PROC_NAME].extract(evt) && st.f[S::PROC_NAME].str() != std::string_view("synthetic-1", 11)); }},
+		{"proc.name in (synthetic-3, synthetic-1, synthetic-1)", [](S& st, sinsp_evt* evt) {
+			return (st.f[S::PROC_NAME].extract(evt) && falco_compiled::in_sorted(st.f[S::PROC_NAME].str(), s_names)); }},
+		{"fd.name contains a", [](S& st, sinsp_evt* evt) {
+			return (st.f[S::FD_NAME].extract(evt) && st.f[S::FD_NAME].str().find(std::string_view("a", 1)) != std::string_view::npos); }},
+		{"fd.name startswith /synthetic/a", [](S& st, sinsp_evt* evt) {
+			return (st.f[S::FD_NAME].extract(evt) && st.f[S::FD_NAME].str().substr(0, 12) == std::string_view("/synthetic/a", 12)); }},
+		{"fd.name endswith z", [](S& st, sinsp_evt* evt) {
+			return (st.f[S::FD_NAME].extract(evt) && st.f[S::FD_NAME].str().size() >= 1
+				&& st.f[S::FD_NAME].str().substr(st.f[S::FD_NAME].str().size() - 1) == std::string_view("z", 1)); }},
+		// the parent of the synthetic processes is not known
+		{"not proc.pname = init", [](S& st, sinsp_evt* evt) {
+			return !(st.f[S::PROC_PNAME].extract(evt) && st.f[S::PROC_PNAME].str() == std::string_view("init", 4)); }},
+		{"not proc.pname exists", [](S& st, sinsp_evt* evt) {
+			return !st.f[S::PROC_PNAME].exists(evt); }},
+		{"not fd.name startswith /synthetic/", [](S& st, sinsp_evt* evt) {
+			return !(st.f[S::FD_NAME].extract(evt) && st.f[S::FD_NAME].str().substr(0, 11) == std::string_view("/synthetic/", 11)); }},
+		{"fd.num >= 3", [](S& st, sinsp_evt* evt) {
+			return (st.f[S::FD_NUM].extract(evt) && st.f[S::FD_NUM].i64() >= INT64_C(3)); }},
+		{"fd.num > -1", [](S& st, sinsp_evt* evt) {
+			return (st.f[S::FD_NUM].extract(evt) && st.f[S::FD_NUM].i64() > INT64_C(-1)); }},
+		{"proc.pid != 0", [](S& st, sinsp_evt* evt) {
+			return (st.f[S::PROC_PID].extract(evt) && st.f[S::PROC_PID].i64() != INT64_C(0)); }},
+		{"user.uid = 0", [](S& st, sinsp_evt* evt) {
+			return (st.f[S::USER_UID].extract(evt) && st.f[S::USER_UID].u64() == UINT64_C(0)); }},
+		{"user.uid > 4294967295", [](S& st, sinsp_evt* evt) {
+			return (st.f[S::USER_UID].extract(evt) && st.f[S::USER_UID].u64() > UINT64_C(4294967295)); }},
+		{"evt.type = openat and (proc.name = synthetic-0 or fd.num < 5)", [](S& st, sinsp_evt* evt) {
+			return (st.c[0].run(evt) && ((st.f[S::PROC_NAME].extract(evt) && st.f[S::PROC_NAME].str() == std::string_view("synthetic-0", 11))
+				|| (st.f[S::FD_NUM].extract(evt) && st.f[S::FD_NUM].i64() < INT64_C(5)))); }},
+	};
+}
+
+TEST(CompiledRuleset, same_results_as_the_interpreter)
+{
+	sinsp inspector;
+	sinsp_filter_check_list filterlist;
+	auto f = std::make_shared<sinsp_filter_factory>(&inspector, filterlist);
+
+	compiled_state st;
+	std::string err;
+	ASSERT_TRUE(st.f[compiled_state::PROC_NAME].init(*f, "proc.name", field::kind::string, &err)) << err;
+	ASSERT_TRUE(st.f[compiled_state::PROC_PNAME].init(*f, "proc.pname", field::kind::string, &err)) << err;
+	ASSERT_TRUE(st.f[compiled_state::PROC_PID].init(*f, "proc.pid", field::kind::signed_number, &err)) << err;
+	ASSERT_TRUE(st.f[compiled_state::FD_NAME].init(*f, "fd.name", field::kind::string, &err)) << err;
+	ASSERT_TRUE(st.f[compiled_state::FD_NUM].init(*f, "fd.num", field::kind::signed_number, &err)) << err;
+	ASSERT_TRUE(st.f[compiled_state::USER_UID].init(*f, "user.uid", field::kind::unsigned_number, &err)) << err;
+	ASSERT_TRUE(st.c[0].init(f, "evt.type = openat", &err)) << err;
+
+	// a field can't be read with another kind than its own
+	field wrong_kind;
+	ASSERT_FALSE(wrong_kind.init(*f, "fd.num", field::kind::unsigned_number, &err));
+
+	auto cases = compiled_cases();
+	std::vector<std::unique_ptr<sinsp_filter>> filters;
+	for (const auto& c : cases)
+	{
+		sinsp_filter_compiler compiler(f, c.condition);
+		filters.push_back(compiler.compile());
+	}
+
+	std::vector<uint64_t> matches(cases.size(), 0);
+	uint64_t num_events = for_each_synthetic_event(inspector, synthetic_test_config(2000), [&](sinsp_evt* evt)
+	{
+		for (size_t i = 0; i < cases.size(); i++)
+		{
+			bool expected = filters[i]->run(evt);
+			ASSERT_EQ(cases[i].run(st, evt), expected)
+				<< cases[i].condition << " on event " << evt->get_num() << " (" << evt->get_name() << ")";
+			matches[i] += expected;
+		}
+	});
+
+	// the corpus exercises both outcomes of the string comparisons
+	ASSERT_GT(num_events, 0);
+	for (size_t i = 0; i < cases.size(); i++)
+	{
+		const auto& cond = cases[i].condition;
+		if (cond.compare(0, 10, "proc.name ") == 0 || cond.compare(0, 8, "fd.name ") == 0)
+		{
+			ASSERT_GT(matches[i], 0) << cond;
+			ASSERT_LT(matches[i], num_events) << cond;
+		}
+	}
+}
@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include <falco_engine_c.h>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+struct test_event
+{
+	std::string user;
+	uint64_t count;
+};
+
+int test_extract(void* user_data, const falco_engine_c_event* evt, uint32_t field_idx, falco_engine_c_value* value)
+{
+	auto e = (const test_event*) evt->data;
+	switch(field_idx)
+	{
+	case 0:
+		value->str = e->user.c_str();
+		return 1;
+	case 1:
+		value->u64 = e->count;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+const falco_engine_c_field s_fields[] = {
+	{"myapp.user", FALCO_ENGINE_C_FIELD_STRING, "the user"},
+	{"myapp.count", FALCO_ENGINE_C_FIELD_UINT64, "the count"},
+};
+
+const char* s_rules = R"END(
+- rule: root user
+  desc: root user
+  condition: myapp.user = root
+  output: root user (count=%myapp.count)
+  priority: CRITICAL
+  source: myapp
+
+- rule: high count
+  desc: high count
+  condition: myapp.count > 10
+  output: high count (user=%myapp.user)
+  priority: NOTICE
+  source: myapp
+)END";
+
+class EngineCApi : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		m_engine = falco_engine_c_create();
+		ASSERT_NE(m_engine, nullptr);
+		ASSERT_EQ(falco_engine_c_add_source(m_engine, "myapp", s_fields, 2, test_extract, nullptr, &m_source_idx),
+			FALCO_ENGINE_C_OK) << falco_engine_c_last_error(m_engine);
+		ASSERT_EQ(falco_engine_c_load_rules(m_engine, s_rules, "rules.yaml"), FALCO_ENGINE_C_OK)
+			<< falco_engine_c_last_error(m_engine);
+	}
+
+	void TearDown() override
+	{
+		falco_engine_c_destroy(m_engine);
+	}
+
+	uint32_t find_rule(const std::string& name)
+	{
+		for(uint32_t i = 0; i < falco_engine_c_num_rules(m_engine); i++)
+		{
+			if(name == falco_engine_c_rule_name(m_engine, i))
+			{
+				return i;
+			}
+		}
+		return UINT32_MAX;
+	}
+
+	falco_engine_c* m_engine = nullptr;
+	uint32_t m_source_idx = 0;
+};
+} // namespace
+
+TEST_F(EngineCApi, evaluate_batch)
+{
+	std::vector<test_event> data = {{"root", 1}, {"alice", 2}, {"root", 20}, {"bob", 30}};
+	std::vector<falco_engine_c_event> events;
+	for(const auto& d : data)
+	{
+		events.push_back({0, &d, sizeof(d)});
+	}
+
+	ASSERT_EQ(falco_engine_c_num_enabled_rules(m_engine, m_source_idx), 2);
+	std::vector<falco_engine_c_match> matches(8);
+	uint32_t num_matches = 0, num_consumed = 0;
+	ASSERT_EQ(falco_engine_c_evaluate(m_engine, m_source_idx, events.data(), events.size(),
+		matches.data(), matches.size(), &num_matches, &num_consumed), FALCO_ENGINE_C_OK)
+		<< falco_engine_c_last_error(m_engine);
+	EXPECT_EQ(num_consumed, 4);
+	ASSERT_EQ(num_matches, 4);
+
+	auto root_user = find_rule("root user");
+	auto high_count = find_rule("high count");
+	EXPECT_EQ(matches[0].event_idx, 0);
+	EXPECT_EQ(matches[0].rule_id, root_user);
+	EXPECT_EQ(matches[0].priority, 2);
+	EXPECT_EQ(matches[1].event_idx, 2);
+	EXPECT_EQ(matches[2].event_idx, 2);
+	EXPECT_EQ(matches[3].event_idx, 3);
+	EXPECT_EQ(matches[3].rule_id, high_count);
+
+	falco_engine_c_rule_stats stats;
+	ASSERT_EQ(falco_engine_c_rule_stats(m_engine, root_user, &stats), FALCO_ENGINE_C_OK);
+	EXPECT_EQ(stats.matches, 2);
+	ASSERT_EQ(falco_engine_c_rule_stats(m_engine, high_count, &stats), FALCO_ENGINE_C_OK);
+	EXPECT_EQ(stats.matches, 2);
+}
+
+TEST_F(EngineCApi, small_match_buffer)
+{
+	std::vector<test_event> data = {{"root", 20}, {"root", 20}};
+	std::vector<falco_engine_c_event> events;
+	for(const auto& d : data)
+	{
+		events.push_back({0, &d, sizeof(d)});
+	}
+
+	// no room for the worst case of a single event
+	std::vector<falco_engine_c_match> matches(3);
+	uint32_t num_matches = 0, num_consumed = 0;
+	ASSERT_EQ(falco_engine_c_evaluate(m_engine, m_source_idx, events.data(), events.size(),
+		matches.data(), 1, &num_matches, &num_consumed), FALCO_ENGINE_C_ERROR);
+
+	// a missing buffer is reported, not dereferenced
+	ASSERT_EQ(falco_engine_c_evaluate(m_engine, m_source_idx, events.data(), events.size(),
+		nullptr, matches.size(), &num_matches, &num_consumed), FALCO_ENGINE_C_ERROR);
+
+	// room for one event at a time
+	ASSERT_EQ(falco_engine_c_evaluate(m_engine, m_source_idx, events.data(), events.size(),
+		matches.data(), matches.size(), &num_matches, &num_consumed), FALCO_ENGINE_C_OK);
+	EXPECT_EQ(num_consumed, 1);
+	EXPECT_EQ(num_matches, 2);
+	ASSERT_EQ(falco_engine_c_evaluate(m_engine, m_source_idx, events.data() + 1, events.size() - 1,
+		matches.data(), matches.size(), &num_matches, &num_consumed), FALCO_ENGINE_C_OK);
+	EXPECT_EQ(num_consumed, 1);
+	EXPECT_EQ(num_matches, 2);
+}
+
+TEST_F(EngineCApi, enable_rules_and_errors)
+{
+	ASSERT_EQ(falco_engine_c_enable_rules(m_engine, "root*", 0), FALCO_ENGINE_C_OK);
+	EXPECT_EQ(falco_engine_c_num_enabled_rules(m_engine, m_source_idx), 1);
+
+	EXPECT_EQ(falco_engine_c_load_rules(m_engine, "- rule: broken\n  condition: myapp.nope = 1\n", "bad.yaml"),
+		FALCO_ENGINE_C_ERROR);
+	EXPECT_NE(std::string(falco_engine_c_last_error(m_engine)), "");
+	EXPECT_EQ(falco_engine_c_rule_name(m_engine, 1000), nullptr);
+}
@@ -100,4 +100,18 @@ TEST(FalcoUtils, matches_wildcard)
 	ASSERT_FALSE(falco::utils::matches_wildcard("hello*world", "hello new world yes"));
 	ASSERT_FALSE(falco::utils::matches_wildcard("*hello*world", "come on hello this world yes"));
 	ASSERT_FALSE(falco::utils::matches_wildcard("*hello*world*", "come on hello this yes"));
+
+	// the last segment is matched at the end
+	ASSERT_TRUE(falco::utils::matches_wildcard("a*b", "abxb"));
+	ASSERT_TRUE(falco::utils::matches_wildcard("ab*ba", "abba"));
+	ASSERT_FALSE(falco::utils::matches_wildcard("ab*ba", "aba"));
+
+	// pathological inputs are matched without backtracking
+	std::string pattern;
+	for (int i = 0; i < 1000; i++)
+	{
+		pattern += "*a";
+	}
+	ASSERT_TRUE(falco::utils::matches_wildcard(pattern + "*", std::string(100000, 'a')));
+	ASSERT_FALSE(falco::utils::matches_wildcard(pattern + "*b*", std::string(100000, 'a')));
 }
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include <engine/filter_evttype_resolver.h>
+
+static libsinsp::events::set<ppm_event_code> resolve(const std::string& cond)
+{
+	auto ast = libsinsp::filter::parser(cond).parse();
+	return filter_evttype_resolver().event_codes(ast.get());
+}
+
+TEST(EvttypeResolver, evt_type)
+{
+	auto open_codes = libsinsp::events::names_to_event_set({"open"});
+	ASSERT_TRUE(resolve("evt.type = open").equals(open_codes));
+	ASSERT_TRUE(resolve("evt.type = open and proc.name = cat").equals(open_codes));
+
+	auto codes = resolve("not evt.type in (open, close)");
+	ASSERT_FALSE(codes.contains(PPME_SYSCALL_OPEN_E));
+	ASSERT_FALSE(codes.contains(PPME_SYSCALL_CLOSE_X));
+	ASSERT_TRUE(codes.contains(PPME_SYSCALL_READ_X));
+}
+
+TEST(EvttypeResolver, unconstrained)
+{
+	ASSERT_TRUE(filter_evttype_resolver::is_universal(resolve("proc.name = cat")));
+	ASSERT_TRUE(filter_evttype_resolver::is_universal(resolve("evt.arg.flags exists or proc.name = cat")));
+	ASSERT_TRUE(filter_evttype_resolver::is_universal(resolve("not evt.arg.flags exists")));
+	ASSERT_TRUE(filter_evttype_resolver::is_universal(resolve("not evt.rawarg.fd < 0")));
+	ASSERT_TRUE(filter_evttype_resolver::is_universal(resolve("toupper(evt.arg.flags) = X")));
+}
+
+TEST(EvttypeResolver, evt_dir)
+{
+	auto codes = resolve("evt.dir = < and proc.name = cat");
+	ASSERT_FALSE(filter_evttype_resolver::is_universal(codes));
+	ASSERT_TRUE(codes.contains(PPME_SYSCALL_OPEN_X));
+	ASSERT_FALSE(codes.contains(PPME_SYSCALL_OPEN_E));
+
+	codes = resolve("not evt.dir = <");
+	ASSERT_TRUE(codes.contains(PPME_SYSCALL_OPEN_E));
+	ASSERT_FALSE(codes.contains(PPME_SYSCALL_OPEN_X));
+
+	codes = resolve("evt.dir = > or evt.dir = <");
+	ASSERT_TRUE(filter_evttype_resolver::is_universal(codes));
+}
+
+TEST(EvttypeResolver, event_params)
+{
+	auto codes = resolve("evt.arg.flags exists");
+	ASSERT_FALSE(filter_evttype_resolver::is_universal(codes));
+	ASSERT_TRUE(codes.contains(PPME_SYSCALL_OPEN_X));
+	// the parameters of an event pair are considered available in both
+	ASSERT_TRUE(codes.contains(PPME_SYSCALL_OPEN_E));
+	ASSERT_FALSE(codes.contains(PPME_SYSCALL_CLOSE_X));
+
+	ASSERT_TRUE(resolve("evt.rawarg[flags] != 0 and proc.name = cat").equals(codes));
+	ASSERT_TRUE(resolve("evt.arg.nonexistent = 1").empty());
+	ASSERT_TRUE(resolve("evt.arg.nonexistent = 1 or evt.arg.flags exists").equals(codes));
+	ASSERT_FALSE(filter_evttype_resolver::is_universal(resolve("evt.arg[5] exists")));
+}
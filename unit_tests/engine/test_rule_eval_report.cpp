@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "../test_synthetic_events.h"
+#include <engine/evttype_index_ruleset.h>
+
+// A corpus of pathological events: long file names made of a single
+// repeated letter, which are the worst case of the string operators
+static falco_configuration::synthetic_config pathological_config()
+{
+	auto config = synthetic_test_config();
+	config.m_min_string_len = 8192;
+	config.m_max_string_len = 16384;
+	config.m_string_pattern = "repeated";
+	return config;
+}
+
+static bool is_openat(sinsp_evt* evt)
+{
+	return evt->get_type() == PPME_SYSCALL_OPENAT_2_E || evt->get_type() == PPME_SYSCALL_OPENAT_2_X;
+}
+
+TEST(RuleEvalReport, max_field_lengths)
+{
+	sinsp inspector;
+	sinsp_filter_check_list filterlist;
+	auto f = std::make_shared<sinsp_filter_factory>(&inspector, filterlist);
+	evttype_index_ruleset r(f);
+
+	// field lengths are only measured on the events over the budget
+	filter_ruleset::eval_thresholds thresholds;
+	thresholds.event_budget_ns = 1;
+	thresholds.max_field_lengths["evt.rawarg.name"] = 4096;
+	thresholds.max_field_lengths["not.a_field"] = 1;
+	r.set_eval_thresholds(thresholds);
+	add_synthetic_rule(r, f, 0, "name_rule", falco_common::PRIORITY_WARNING, "evt.type=openat and evt.rawarg.name startswith /synthetic/");
+	add_synthetic_rule(r, f, 1, "close_rule", falco_common::PRIORITY_WARNING, "evt.type=close and evt.dir=<");
+
+	uint64_t num_openat = 0, num_close = 0;
+	for_each_synthetic_event(inspector, pathological_config(), [&](sinsp_evt* evt)
+	{
+		falco_rule match;
+		filter_ruleset::slow_evaluation v;
+		bool matched = r.run(evt, match, 0);
+		bool slow = r.last_slow_evaluation(v);
+
+		if (is_openat(evt))
+		{
+			// the rule is still evaluated on the long names, so padding
+			// can't evade it
+			ASSERT_TRUE(matched);
+			ASSERT_EQ(match.name, "name_rule");
+			if (slow)
+			{
+				num_openat++;
+				ASSERT_EQ(v.field, "evt.rawarg.name");
+				ASSERT_GT(v.field_length, 4096);
+				ASSERT_GT(v.eval_time_ns, 1);
+			}
+		}
+		else if (evt->get_type() == PPME_SYSCALL_CLOSE_X)
+		{
+			// only the fields read by the evaluated rules are measured
+			ASSERT_TRUE(matched);
+			ASSERT_EQ(match.name, "close_rule");
+			if (slow)
+			{
+				num_close++;
+				ASSERT_TRUE(v.field.empty());
+				ASSERT_EQ(v.field_length, 0);
+			}
+		}
+
+		// each slow evaluation is only reported once
+		ASSERT_FALSE(r.last_slow_evaluation(v));
+	});
+	ASSERT_GT(num_openat, 0);
+	ASSERT_GT(num_close, 0);
+}
+
+TEST(RuleEvalReport, event_budget)
+{
+	sinsp inspector;
+	sinsp_filter_check_list filterlist;
+	auto f = std::make_shared<sinsp_filter_factory>(&inspector, filterlist);
+	evttype_index_ruleset r(f);
+
+	// the rules are still all evaluated when the budget is exceeded
+	filter_ruleset::eval_thresholds thresholds;
+	thresholds.event_budget_ns = 1;
+	r.set_eval_thresholds(thresholds);
+	add_synthetic_rule(r, f, 0, "contains_rule", falco_common::PRIORITY_WARNING, "evt.type=openat and evt.rawarg.name contains aaaab");
+	add_synthetic_rule(r, f, 1, "open_rule", falco_common::PRIORITY_WARNING, "evt.type=openat and evt.dir=<");
+
+	uint64_t num_matches = 0, num_slow = 0;
+	for_each_synthetic_event(inspector, pathological_config(), [&](sinsp_evt* evt)
+	{
+		if (!is_openat(evt))
+		{
+			return;
+		}
+
+		std::vector<falco_rule> matches;
+		filter_ruleset::slow_evaluation v;
+		if (r.run(evt, matches, 0))
+		{
+			ASSERT_EQ(matches.size(), 1);
+			ASSERT_EQ(matches[0].name, "open_rule");
+			num_matches++;
+		}
+		if (r.last_slow_evaluation(v))
+		{
+			ASSERT_GT(v.eval_time_ns, 1);
+			ASSERT_TRUE(v.field.empty());
+			num_slow++;
+		}
+	});
+	ASSERT_GT(num_matches, 0);
+	ASSERT_GT(num_slow, 0);
+}
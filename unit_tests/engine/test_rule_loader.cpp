@@ -1178,3 +1178,226 @@ TEST_F(test_falco_engine, exceptions_fields_transformer_space_quoted)
   ASSERT_FALSE(has_warnings());
   EXPECT_EQ(get_compiled_rule_condition("test_rule"), "(evt.type = open and not tolower(proc.name) = test)");
 }
+
+TEST_F(test_falco_engine, staged_rules_compile_once)
+{
+	std::string macros_content = R"END(
+- macro: is_shell
+  condition: proc.name in (bash, sh)
+)END";
+
+	std::string rules_content = R"END(
+- macro: unused_macro
+  condition: evt.type=close
+
+- rule: shell_rule
+  desc: shell rule description
+  condition: evt.type=execve and is_shell
+  output: command=%proc.cmdline
+  priority: INFO
+
+- rule: other_rule
+  desc: other rule description
+  condition: evt.type=open
+  output: file=%fd.name
+  priority: INFO
+)END";
+
+	std::string more_content = R"END(
+- rule: more_rule
+  desc: more rule description
+  condition: evt.type=connect and is_shell
+  output: command=%proc.cmdline
+  priority: INFO
+)END";
+
+	std::string broken_content = R"END(
+- rule: broken_rule
+  desc: rule with an unknown macro
+  condition: evt.type=open and not_a_macro
+  output: file=%fd.name
+  priority: INFO
+)END";
+
+	falco::load_result::rules_contents_t rc = {
+		{"macros.yaml", macros_content},
+		{"rules.yaml", rules_content},
+		{"more.yaml", more_content},
+		{"broken.yaml", broken_content},
+	};
+
+	// reading does not compile anything
+	m_engine->stage_rules(macros_content, "macros.yaml");
+	m_engine->stage_rules(rules_content, "rules.yaml");
+	ASSERT_EQ(m_engine->get_rules().size(), 0);
+
+	bool selected = false;
+	auto results = m_engine->compile_staged_rules([&selected](falco_engine& e)
+	{
+		e.enable_rule("other_rule", false);
+		selected = true;
+	});
+	ASSERT_EQ(results.size(), 2);
+	ASSERT_TRUE(selected);
+	ASSERT_TRUE(results[0]->successful());
+	ASSERT_TRUE(results[1]->successful());
+	ASSERT_EQ(m_engine->get_rules().size(), 2);
+	ASSERT_EQ(num_rules_for_ruleset("falco-default-ruleset"), 1);
+	ASSERT_EQ(get_compiled_rule_condition("shell_rule"), "(evt.type = execve and proc.name in (bash, sh))");
+
+	// the warnings are attributed to the file they come from
+	ASSERT_FALSE(results[0]->has_warnings());
+	ASSERT_TRUE(results[1]->has_warnings());
+	ASSERT_EQ(results[1]->as_json(rc)["name"], "rules.yaml");
+
+	// and so are the errors, in which case the selection is not applied
+	m_engine->stage_rules(broken_content, "broken.yaml");
+	m_engine->stage_rules(more_content, "more.yaml");
+	selected = false;
+	results = m_engine->compile_staged_rules([&selected](falco_engine& e) { selected = true; });
+	ASSERT_EQ(results.size(), 2);
+	ASSERT_FALSE(selected);
+	ASSERT_FALSE(results[0]->successful());
+	ASSERT_NE(results[0]->as_string(true, rc).find("not_a_macro"), std::string::npos);
+	ASSERT_TRUE(results[1]->successful());
+
+	// nothing staged
+	ASSERT_TRUE(m_engine->compile_staged_rules().empty());
+}
+
+static std::string s_lazy_filters_rules = R"END(
+- rule: enabled_rule
+  desc: enabled rule description
+  condition: evt.type=open
+  output: file=%fd.name
+  priority: WARNING
+
+- rule: disabled_rule
+  desc: disabled rule description
+  condition: evt.type=close
+  output: file=%fd.name
+  priority: WARNING
+  enabled: false
+
+- rule: invalid_disabled_rule
+  desc: disabled rule with an unknown field
+  condition: evt.type=open and proc.not_a_field=1
+  output: file=%fd.name
+  priority: WARNING
+  enabled: false
+
+- rule: invalid_debug_rule
+  desc: below min priority rule with an unknown field
+  condition: evt.type=open and proc.not_a_field=1
+  output: file=%fd.name
+  priority: DEBUG
+)END";
+
+TEST_F(test_falco_engine, lazy_filters_off)
+{
+	// without lazy filters, all the rules are validated when loading
+	ASSERT_FALSE(load_rules(s_lazy_filters_rules, "rules.yaml"));
+	ASSERT_TRUE(check_error_message("nonexistent field"));
+}
+
+TEST_F(test_falco_engine, lazy_filters)
+{
+	m_engine->set_min_priority(falco_common::PRIORITY_INFORMATIONAL);
+	m_engine->set_lazy_filters(true);
+	ASSERT_TRUE(load_rules(s_lazy_filters_rules, "rules.yaml")) << m_load_result_string;
+	ASSERT_EQ(num_rules_for_ruleset(), 1);
+
+	// a deferred filter is compiled when the rule is first enabled
+	m_engine->enable_rule_exact("disabled_rule", true);
+	ASSERT_EQ(num_rules_for_ruleset(), 2);
+	ASSERT_THROW(m_engine->enable_rule_exact("invalid_disabled_rule", true), falco_exception);
+}
+
+static std::string s_lazy_filters_selection_rules = R"END(
+- rule: enabled_rule
+  desc: enabled rule description
+  condition: evt.type=open
+  output: file=%fd.name
+  priority: WARNING
+  tags: [valid]
+
+- rule: invalid_rule
+  desc: enabled rule with an unknown field
+  condition: evt.type=open and proc.not_a_field=1
+  output: file=%fd.name
+  priority: WARNING
+)END";
+
+TEST_F(test_falco_engine, lazy_filters_selection)
+{
+	// the rules disabled by the selection, like with -D or "rules:",
+	// are never compiled
+	m_engine->set_lazy_filters(true);
+	m_engine->stage_rules(s_lazy_filters_selection_rules, "rules.yaml");
+	std::vector<std::unique_ptr<falco::load_result>> results;
+	ASSERT_NO_THROW(results = m_engine->compile_staged_rules([](falco_engine& e)
+	{
+		e.enable_rule_exact("invalid_rule", false);
+	}));
+	ASSERT_EQ(results.size(), 1);
+	ASSERT_TRUE(results[0]->successful());
+	ASSERT_EQ(num_rules_for_ruleset(), 1);
+}
+
+TEST_F(test_falco_engine, lazy_filters_tags_selection)
+{
+	// and neither are the ones left out when selecting by tags, like
+	// with -t, even if they were enabled by default first
+	m_engine->set_lazy_filters(true);
+	m_engine->stage_rules(s_lazy_filters_selection_rules, "rules.yaml");
+	std::vector<std::unique_ptr<falco::load_result>> results;
+	ASSERT_NO_THROW(results = m_engine->compile_staged_rules([](falco_engine& e)
+	{
+		e.enable_rule("", false);
+		e.enable_rule_by_tag(std::set<std::string>{"valid"}, true);
+	}));
+	ASSERT_EQ(results.size(), 1);
+	ASSERT_TRUE(results[0]->successful());
+	ASSERT_EQ(num_rules_for_ruleset(), 1);
+}
+
+TEST_F(test_falco_engine, lazy_filters_no_selection)
+{
+	// the rules left enabled are compiled once loaded
+	m_engine->set_lazy_filters(true);
+	m_engine->stage_rules(s_lazy_filters_selection_rules, "rules.yaml");
+	ASSERT_THROW(m_engine->compile_staged_rules(), falco_exception);
+}
+
+TEST_F(test_falco_engine, unsatisfiable_condition_warning)
+{
+	std::string rules_content = R"END(
+- rule: unsatisfiable_rule
+  desc: rule requiring two event types at once
+  condition: evt.type=open and evt.type=close
+  output: file=%fd.name
+  priority: WARNING
+  warn_evttypes: false
+)END";
+
+	// a condition that can never be true is reported as such, even
+	// when the event type warnings are disabled for the rule
+	ASSERT_TRUE(load_rules(rules_content, "rules.yaml")) << m_load_result_string;
+	ASSERT_TRUE(check_warning_message("Rule condition can never match any event"));
+	ASSERT_FALSE(check_warning_message("Rule matches too many evt.type values"));
+}
+
+TEST_F(test_falco_engine, unconstrained_condition_warning)
+{
+	std::string rules_content = R"END(
+- rule: unconstrained_rule
+  desc: rule without any event type restriction
+  condition: proc.name=cat
+  output: file=%fd.name
+  priority: WARNING
+)END";
+
+	ASSERT_TRUE(load_rules(rules_content, "rules.yaml")) << m_load_result_string;
+	ASSERT_TRUE(check_warning_message("Rule matches too many evt.type values"));
+	ASSERT_FALSE(check_warning_message("Rule condition can never match any event"));
+}
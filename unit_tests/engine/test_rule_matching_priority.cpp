@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "../test_synthetic_events.h"
+#include <engine/evttype_index_ruleset.h>
+
+TEST(RuleMatchingPriority, highest_priority_wins)
+{
+	sinsp inspector;
+	sinsp_filter_check_list filterlist;
+	auto f = std::make_shared<sinsp_filter_factory>(&inspector, filterlist);
+	evttype_index_ruleset r(f);
+
+	// defined from the lowest priority to the highest one, so that
+	// matching in definition order gives a different result
+	add_synthetic_rule(r, f, 0, "debug_rule", falco_common::PRIORITY_DEBUG, "evt.type=openat and evt.dir=<");
+	add_synthetic_rule(r, f, 1, "critical_rule", falco_common::PRIORITY_CRITICAL, "evt.type=openat and evt.dir=<");
+	add_synthetic_rule(r, f, 2, "critical_rule_2", falco_common::PRIORITY_CRITICAL, "evt.type=openat and evt.dir=<");
+	add_synthetic_rule(r, f, 3, "unmatched_rule", falco_common::PRIORITY_EMERGENCY, "evt.type=openat and proc.name=not_a_process");
+
+	uint64_t num_matches = 0;
+	for_each_synthetic_event(inspector, synthetic_test_config(), [&](sinsp_evt* evt)
+	{
+		falco_rule first, by_priority;
+		bool matched = r.run(evt, first, 0);
+		ASSERT_EQ(r.run_by_priority(evt, by_priority, 0), matched);
+		if (matched)
+		{
+			ASSERT_EQ(first.name, "debug_rule");
+			// ties are broken by definition order
+			ASSERT_EQ(by_priority.name, "critical_rule");
+			num_matches++;
+		}
+	});
+	ASSERT_GT(num_matches, 0);
+
+	// the evaluation of the matching events stops at the second rule
+	filter_ruleset::priority_match_stats stats;
+	r.get_priority_match_stats(stats);
+	ASSERT_GT(stats.events, num_matches);
+	ASSERT_LT(stats.evaluations, stats.candidates);
+}
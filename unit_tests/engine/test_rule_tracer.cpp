@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "../test_synthetic_events.h"
+#include <engine/rule_tracer.h>
+#include <engine/falco_common.h>
+
+// Traces a single rule against the events of the synthetic generator
+class RuleTracer : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		m_factory = std::make_shared<sinsp_filter_factory>(&m_inspector, m_filterlist);
+	}
+
+	std::shared_ptr<rule_tracer::traced_rule> trace(rule_tracer& tracer, const std::string& cond)
+	{
+		falco_rule rule;
+		rule.name = "traced";
+		rule.source = falco_common::syscall_source;
+		m_conditions.push_back(libsinsp::filter::parser(cond).parse());
+		return tracer.trace_rule(rule, m_conditions.back().get(), m_factory);
+	}
+
+	std::unique_ptr<sinsp_filter> compile(const std::string& cond)
+	{
+		sinsp_filter_compiler compiler(m_factory, cond);
+		return compiler.compile();
+	}
+
+	// Invokes fn on at most max_events events
+	void for_each_event(size_t max_events, const std::function<void(sinsp_evt*)>& fn)
+	{
+		auto n = for_each_synthetic_event(m_inspector, synthetic_test_config(), fn, max_events);
+		ASSERT_EQ(n, max_events);
+	}
+
+	sinsp m_inspector;
+	sinsp_filter_check_list m_filterlist;
+	std::shared_ptr<sinsp_filter_factory> m_factory;
+	std::vector<std::unique_ptr<libsinsp::filter::ast::expr>> m_conditions;
+};
+
+static rule_tracer::config tracer_config()
+{
+	rule_tracer::config c;
+	c.rules = {"traced"};
+	c.capacity = 100000;
+	return c;
+}
+
+TEST_F(RuleTracer, same_result_as_the_filter)
+{
+	const std::string cond = "evt.type = openat and (proc.name = synthetic-1 or not fd.name contains a)";
+	rule_tracer tracer(tracer_config());
+	auto traced = trace(tracer, cond);
+	auto filter = compile(cond);
+
+	uint64_t matches = 0;
+	for_each_event(500, [&](sinsp_evt* evt)
+	{
+		bool res = rule_tracer::run(traced.get(), evt);
+		ASSERT_EQ(res, filter->run(evt));
+		auto traces = tracer.get_traces();
+		ASSERT_FALSE(traces.empty());
+		ASSERT_EQ(traces.back().result, res);
+		ASSERT_EQ(traces.back().evt_num, evt->get_num());
+		matches += res;
+	});
+	ASSERT_GT(matches, 0);
+	ASSERT_LT(matches, 500);
+	ASSERT_EQ(tracer.get_traces().size(), 500);
+}
+
+TEST_F(RuleTracer, short_circuit)
+{
+	rule_tracer tracer(tracer_config());
+	auto and_rule = trace(tracer, "proc.name = nomatch and fd.name exists");
+	auto or_rule = trace(tracer, "proc.name exists or fd.name exists");
+	auto not_rule = trace(tracer, "not proc.name = nomatch and proc.name exists");
+
+	for_each_event(10, [&](sinsp_evt* evt)
+	{
+		// only the predicates evaluated until the result was known
+		// are recorded
+		ASSERT_FALSE(rule_tracer::run(and_rule.get(), evt));
+		auto t = tracer.get_traces().back();
+		ASSERT_EQ(t.steps.size(), 1);
+		ASSERT_EQ(t.steps[0].predicate, "proc.name = nomatch");
+		ASSERT_FALSE(t.steps[0].result);
+
+		ASSERT_TRUE(rule_tracer::run(or_rule.get(), evt));
+		t = tracer.get_traces().back();
+		ASSERT_EQ(t.steps.size(), 1);
+		ASSERT_EQ(t.steps[0].predicate, "proc.name exists");
+		ASSERT_TRUE(t.steps[0].result);
+
+		// the negated predicate is recorded with its own result
+		ASSERT_TRUE(rule_tracer::run(not_rule.get(), evt));
+		t = tracer.get_traces().back();
+		ASSERT_EQ(t.steps.size(), 2);
+		ASSERT_FALSE(t.steps[0].result);
+		ASSERT_TRUE(t.steps[1].result);
+		ASSERT_EQ(t.steps[1].values.size(), 1);
+		ASSERT_EQ(t.steps[1].values[0].compare(0, 10, "synthetic-"), 0);
+	});
+}
+
+TEST_F(RuleTracer, sampling)
+{
+	auto c = tracer_config();
+	c.sampling_ratio = 4;
+	rule_tracer tracer(c);
+	auto traced = trace(tracer, "proc.name exists");
+
+	for_each_event(100, [&](sinsp_evt* evt)
+	{
+		ASSERT_TRUE(rule_tracer::run(traced.get(), evt));
+	});
+
+	// the first evaluation and one out of four afterwards
+	auto traces = tracer.get_traces();
+	ASSERT_EQ(traces.size(), 25);
+	ASSERT_EQ(tracer.to_json()["recorded"], 25);
+}
+
+TEST_F(RuleTracer, process_filter)
+{
+	auto c = tracer_config();
+	c.processes = {"synthetic-2"};
+	rule_tracer tracer(c);
+	const std::string cond = "fd.name exists";
+	auto traced = trace(tracer, cond);
+	auto filter = compile(cond);
+	auto proc_filter = compile("proc.name = synthetic-2");
+
+	uint64_t expected = 0;
+	for_each_event(200, [&](sinsp_evt* evt)
+	{
+		// the events of the other processes are evaluated but not traced
+		ASSERT_EQ(rule_tracer::run(traced.get(), evt), filter->run(evt));
+		expected += proc_filter->run(evt);
+	});
+
+	auto traces = tracer.get_traces();
+	ASSERT_GT(expected, 0);
+	ASSERT_EQ(traces.size(), expected);
+	for (const auto& t : traces)
+	{
+		ASSERT_EQ(t.proc_name, "synthetic-2");
+	}
+}
+
+TEST_F(RuleTracer, value_truncation)
+{
+	auto c = tracer_config();
+	c.max_value_length = 5;
+	rule_tracer tracer(c);
+	auto traced = trace(tracer, "fd.name exists");
+
+	uint64_t truncated = 0;
+	for_each_event(50, [&](sinsp_evt* evt)
+	{
+		rule_tracer::run(traced.get(), evt);
+		auto t = tracer.get_traces().back();
+		ASSERT_EQ(t.steps.size(), 1);
+		for (const auto& v : t.steps[0].values)
+		{
+			// the names of the synthetic files are longer than 5
+			ASSERT_EQ(v, "/synt...");
+			truncated++;
+		}
+	});
+	ASSERT_GT(truncated, 0);
+}
+
+TEST_F(RuleTracer, ring_bound)
+{
+	auto c = tracer_config();
+	c.capacity = 10;
+	rule_tracer tracer(c);
+	auto traced = trace(tracer, "proc.name exists");
+
+	uint64_t last_num = 0;
+	for_each_event(50, [&](sinsp_evt* evt)
+	{
+		rule_tracer::run(traced.get(), evt);
+		last_num = evt->get_num();
+	});
+
+	// only the last evaluations are kept, the oldest first
+	auto traces = tracer.get_traces();
+	ASSERT_EQ(traces.size(), 10);
+	ASSERT_EQ(traces.back().evt_num, last_num);
+	for (size_t i = 1; i < traces.size(); i++)
+	{
+		ASSERT_LT(traces[i - 1].evt_num, traces[i].evt_num);
+	}
+	auto j = tracer.to_json();
+	ASSERT_EQ(j["recorded"], 50);
+	ASSERT_EQ(j["traces"].size(), 10);
+}
+
+TEST_F(RuleTracer, invalid_condition)
+{
+	rule_tracer tracer(tracer_config());
+	ASSERT_THROW(trace(tracer, "proc.nofield = 1"), falco_exception);
+}
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include <engine/ruleset_codegen.h>
+#include <engine/falco_common.h>
+
+static falco_rule create_rule(const std::string& name, const std::string& source, const std::string& condition)
+{
+	falco_rule rule;
+	rule.name = name;
+	rule.source = source;
+	libsinsp::filter::parser parser(condition);
+	rule.condition = parser.parse();
+	return rule;
+}
+
+TEST(RulesetCodegen, quote)
+{
+	ASSERT_EQ(ruleset_codegen::quote("abc"), "\"abc\"");
+	ASSERT_EQ(ruleset_codegen::quote("a\"b\\c"), "\"a\\\"b\\\\c\"");
+	ASSERT_EQ(ruleset_codegen::quote(std::string("a\nb\0c", 5)), "\"a\\012b\\000c\"");
+}
+
+TEST(RulesetCodegen, native_and_interpreted_checks)
+{
+	sinsp inspector;
+	sinsp_filter_check_list filterlist;
+	auto f = std::make_shared<sinsp_filter_factory>(&inspector, filterlist);
+
+	ruleset_codegen codegen;
+	codegen.add_source("syscall", f);
+	codegen.add_rule(create_rule("A", "syscall",
+		"evt.type = open and proc.name in (sh, bash, sh) and fd.num >= 3"));
+	codegen.add_rule(create_rule("B", "syscall",
+		"proc.name startswith ba or proc.pid exists"));
+	auto code = codegen.generate();
+
+	// evt.* fields are always interpreted, and the "in" lists are
+	// sorted without duplicates
+	ASSERT_NE(code.find("st.c[0].run(evt)"), std::string::npos);
+	ASSERT_NE(code.find("std::array<std::string_view, 2> list_0"), std::string::npos);
+	ASSERT_NE(code.find("std::string_view(\"bash\", 4),\n\tstd::string_view(\"sh\", 2)"), std::string::npos);
+	ASSERT_NE(code.find("falco_compiled::in_sorted("), std::string::npos);
+	ASSERT_NE(code.find(".exists(evt)"), std::string::npos);
+	ASSERT_NE(code.find("falco_get_compiled_ruleset(const char* source)"), std::string::npos);
+
+	const auto& stats = codegen.get_stats();
+	ASSERT_EQ(stats.rules, 2);
+	ASSERT_EQ(stats.interpreted_checks, 1);
+	ASSERT_EQ(stats.native_checks, 4);
+
+	ASSERT_THROW(codegen.add_rule(create_rule("C", "k8s_audit", "ka.verb = get")), falco_exception);
+}
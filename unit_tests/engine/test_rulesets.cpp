@@ -202,3 +202,208 @@ TEST(Ruleset, enable_disable_rules_using_tags)
 	ASSERT_EQ(r->enabled_count(RULESET_1), 0);
 	ASSERT_EQ(r->enabled_count(RULESET_2), 0);
 }
+
+TEST(Ruleset, profile_indexed_by_rule_id)
+{
+	sinsp inspector;
+
+	sinsp_filter_check_list filterlist;
+	auto f = create_factory(&inspector, filterlist);
+	auto r = create_ruleset(f);
+	auto ast = create_ast(f);
+	auto filter = create_filter(f, ast.get());
+
+	falco_rule rule_A = {};
+	rule_A.id = 0;
+	rule_A.name = "rule_A";
+	rule_A.source = falco_common::syscall_source;
+
+	falco_rule rule_B = {};
+	rule_B.id = 3;
+	rule_B.name = "rule_B";
+	rule_B.source = falco_common::syscall_source;
+
+	r->add(rule_A, filter, ast);
+	r->add(rule_B, filter, ast);
+	r->enable("", filter_ruleset::match_type::substring, RULESET_0);
+	r->set_profiling(true);
+
+	/* No event processed yet, the profile is sized by the highest rule id */
+	std::vector<filter_ruleset::rule_profile> profile;
+	r->get_profile(profile);
+	ASSERT_EQ(profile.size(), 4);
+	for (const auto& p : profile)
+	{
+		ASSERT_EQ(p.evaluations, 0);
+		ASSERT_EQ(p.eval_time_ns, 0);
+	}
+
+	/* A larger vector is left as-is */
+	profile.resize(8);
+	r->get_profile(profile);
+	ASSERT_EQ(profile.size(), 8);
+}
+
+TEST(Ruleset, dispatch_values)
+{
+	auto values_of = [](const std::string& cond, std::set<std::string>& values)
+	{
+		libsinsp::filter::parser parser(cond);
+		auto ast = parser.parse();
+		return evttype_index_ruleset::dispatch_values(ast.get(), "ka.verb", values);
+	};
+
+	std::set<std::string> values;
+	ASSERT_TRUE(values_of("ka.verb = create", values));
+	ASSERT_EQ(values, std::set<std::string>({"create"}));
+
+	ASSERT_TRUE(values_of("ka.user.name = admin and ka.verb in (create, update)", values));
+	ASSERT_EQ(values, std::set<std::string>({"create", "update"}));
+
+	// conjunctions only keep the common values
+	ASSERT_TRUE(values_of("ka.verb in (create, update) and ka.verb in (update, delete)", values));
+	ASSERT_EQ(values, std::set<std::string>({"update"}));
+
+	// disjunctions are constrained only if all of their branches are
+	ASSERT_TRUE(values_of("(ka.verb = create and ka.user.name = admin) or ka.verb = delete", values));
+	ASSERT_EQ(values, std::set<std::string>({"create", "delete"}));
+	ASSERT_FALSE(values_of("ka.verb = create or ka.user.name = admin", values));
+
+	// other operators, negations and transformers don't constrain the field
+	ASSERT_FALSE(values_of("ka.verb != create", values));
+	ASSERT_FALSE(values_of("not ka.verb = create", values));
+	ASSERT_FALSE(values_of("ka.verb startswith cre", values));
+	ASSERT_FALSE(values_of("toupper(ka.verb) = CREATE", values));
+	ASSERT_FALSE(values_of("ka.user.name = admin", values));
+
+	// neither do the comparisons with the values of other fields
+	auto cmp = libsinsp::filter::ast::binary_check_expr::create(
+		libsinsp::filter::ast::field_expr::create("ka.verb", ""), "=",
+		libsinsp::filter::ast::field_expr::create("ka.user.name", ""));
+	ASSERT_FALSE(evttype_index_ruleset::dispatch_values(cmp.get(), "ka.verb", values));
+	ASSERT_TRUE(values.empty());
+}
+
+TEST(Ruleset, set_dispatch_field)
+{
+	sinsp inspector;
+
+	sinsp_filter_check_list filterlist;
+	auto f = create_factory(&inspector, filterlist);
+	auto r = create_ruleset(f);
+
+	ASSERT_NO_THROW(r->set_dispatch_field("proc.name"));
+	ASSERT_NO_THROW(r->set_dispatch_field(""));
+	ASSERT_ANY_THROW(r->set_dispatch_field("not.a.field"));
+	// only string fields can index the rules
+	ASSERT_ANY_THROW(r->set_dispatch_field("proc.pid"));
+}
+
+TEST(Ruleset, extraction_plan)
+{
+	sinsp inspector;
+
+	sinsp_filter_check_list filterlist;
+	auto f = create_factory(&inspector, filterlist);
+	auto r = create_ruleset(f);
+
+	std::vector<std::pair<std::string, std::string>> rules = {
+		{"rule_A", "evt.type = open and proc.name = cat"},
+		{"rule_B", "evt.type in (open, close) and fd.name = /etc and proc.name = cat"},
+		{"rule_C", "evt.type = open and fd.name = /tmp"},
+	};
+	for (const auto& def : rules)
+	{
+		falco_rule rule = {};
+		rule.name = def.first;
+		rule.source = falco_common::syscall_source;
+		auto ast = libsinsp::filter::parser(def.second).parse();
+		r->add(rule, create_filter(f, ast.get()), std::move(ast));
+		r->enable(rule.name, filter_ruleset::match_type::exact, RULESET_0);
+	}
+
+	auto find = [](const std::vector<filter_ruleset::extraction_plan_field>& plan, const std::string& field)
+	{
+		for (const auto& p : plan)
+		{
+			if (p.field == field)
+			{
+				return p;
+			}
+		}
+		return filter_ruleset::extraction_plan_field{};
+	};
+
+	std::vector<filter_ruleset::extraction_plan_field> plan;
+	r->get_extraction_plan(PPME_SYSCALL_OPEN_E, plan, RULESET_0);
+	ASSERT_EQ(plan.size(), 3);
+	ASSERT_EQ(find(plan, "evt.type").first_rule, 0);
+	ASSERT_EQ(find(plan, "evt.type").num_rules, 3);
+	ASSERT_EQ(find(plan, "proc.name").first_rule, 0);
+	ASSERT_EQ(find(plan, "proc.name").num_rules, 2);
+	ASSERT_EQ(find(plan, "fd.name").first_rule, 1);
+	ASSERT_EQ(find(plan, "fd.name").num_rules, 2);
+
+	r->get_extraction_plan(PPME_SYSCALL_CLOSE_E, plan, RULESET_0);
+	ASSERT_EQ(plan.size(), 3);
+	ASSERT_EQ(find(plan, "fd.name").first_rule, 0);
+	ASSERT_EQ(find(plan, "fd.name").num_rules, 1);
+
+	/* Rules not enabled in a ruleset are not part of its plan */
+	r->get_extraction_plan(PPME_SYSCALL_OPEN_E, plan, RULESET_1);
+	ASSERT_TRUE(plan.empty());
+}
+
+TEST(Ruleset, extraction_plan_dispatch_values)
+{
+	sinsp inspector;
+
+	sinsp_filter_check_list filterlist;
+	auto f = create_factory(&inspector, filterlist);
+	auto r = create_ruleset(f);
+	r->set_dispatch_field("proc.name");
+
+	std::vector<std::pair<std::string, std::string>> rules = {
+		{"rule_A", "proc.name = cat and fd.name = /etc"},
+		{"rule_B", "fd.name = /tmp"},
+		{"rule_C", "proc.name = bash and fd.name = /bin"},
+	};
+	std::size_t id = 0;
+	for (const auto& def : rules)
+	{
+		falco_rule rule = {};
+		rule.id = id++;
+		rule.name = def.first;
+		rule.source = "other";
+		auto ast = libsinsp::filter::parser(def.second).parse();
+		r->add(rule, create_filter(f, ast.get()), std::move(ast));
+		r->enable(rule.name, filter_ruleset::match_type::exact, RULESET_0);
+	}
+
+	std::vector<filter_ruleset::extraction_plan_field> plan;
+
+	/* Without a dispatch value, the indexed rules are excluded */
+	r->get_extraction_plan(PPME_PLUGINEVENT_E, plan, RULESET_0);
+	ASSERT_EQ(plan.size(), 1);
+	ASSERT_EQ(plan[0].field, "fd.name");
+	ASSERT_EQ(plan[0].num_rules, 1);
+
+	/* The indexed rules are merged with the others in definition order */
+	std::string value = "cat";
+	r->get_extraction_plan(PPME_PLUGINEVENT_E, plan, RULESET_0, &value);
+	ASSERT_EQ(plan.size(), 2);
+	ASSERT_EQ(plan[0].field, "fd.name");
+	ASSERT_EQ(plan[0].first_rule, 0);
+	ASSERT_EQ(plan[0].num_rules, 2);
+	ASSERT_EQ(plan[1].field, "proc.name");
+	ASSERT_EQ(plan[1].first_rule, 0);
+	ASSERT_EQ(plan[1].num_rules, 1);
+
+	value = "bash";
+	r->get_extraction_plan(PPME_PLUGINEVENT_E, plan, RULESET_0, &value);
+	ASSERT_EQ(plan.size(), 2);
+	ASSERT_EQ(plan[0].field, "fd.name");
+	ASSERT_EQ(plan[0].num_rules, 2);
+	ASSERT_EQ(plan[1].field, "proc.name");
+	ASSERT_EQ(plan[1].first_rule, 1);
+}
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/columnar_writer.h>
+
+#include <cstdio>
+#include <fstream>
+
+static const std::string s_export = "falco_test_columnar_writer.jsonl";
+
+static std::vector<nlohmann::json> read_lines()
+{
+	std::vector<nlohmann::json> res;
+	std::ifstream in(s_export);
+	std::string line;
+	while (std::getline(in, line))
+	{
+		res.push_back(nlohmann::json::parse(line));
+	}
+	return res;
+}
+
+TEST(ColumnarWriter, typed_columns_and_row_groups)
+{
+	using ct = columnar_writer::column_type;
+	std::vector<columnar_writer::column_info> columns = {
+		{"evt.num", ct::u64},
+		{"evt.res", ct::i64},
+		{"proc.name", ct::string},
+		{"evt.is_io", ct::boolean},
+	};
+
+	nlohmann::json metadata;
+	metadata["source"] = "syscall";
+	{
+		columnar_writer w(s_export, columns, 2, metadata);
+		std::string n1 = "1", n2 = "2", n3 = "3";
+		std::string r1 = "-2", r2 = "0";
+		std::string cat = "cat", bash = "bash";
+		std::string t = "true", f = "false";
+		w.append({&n1, &r1, &cat, &t});
+		w.append({&n2, nullptr, &cat, &f});
+		w.append({&n3, &r2, &bash, nullptr});
+		w.close();
+		ASSERT_EQ(w.num_rows(), 3);
+	}
+
+	auto lines = read_lines();
+	std::remove(s_export.c_str());
+	ASSERT_EQ(lines.size(), 3);
+
+	ASSERT_EQ(lines[0]["source"], "syscall");
+	ASSERT_EQ(lines[0]["columns"].size(), 4);
+	ASSERT_EQ(lines[0]["columns"][1]["name"], "evt.res");
+	ASSERT_EQ(lines[0]["columns"][1]["type"], "i64");
+
+	const auto& g = lines[1];
+	ASSERT_EQ(g["row_group"], 0);
+	ASSERT_EQ(g["num_rows"], 2);
+	ASSERT_EQ(g["columns"][0]["values"], nlohmann::json::parse("[1, 2]"));
+	ASSERT_EQ(g["columns"][1]["values"], nlohmann::json::parse("[-2, null]"));
+	ASSERT_EQ(g["columns"][2]["dictionary"], nlohmann::json::parse("[\"cat\"]"));
+	ASSERT_EQ(g["columns"][2]["indices"], nlohmann::json::parse("[0, 0]"));
+	ASSERT_EQ(g["columns"][3]["values"], nlohmann::json::parse("[true, false]"));
+
+	ASSERT_EQ(lines[2]["row_group"], 1);
+	ASSERT_EQ(lines[2]["num_rows"], 1);
+	ASSERT_EQ(lines[2]["columns"][2]["dictionary"], nlohmann::json::parse("[\"bash\"]"));
+	ASSERT_EQ(lines[2]["columns"][3]["values"], nlohmann::json::parse("[null]"));
+}
+
+TEST(ColumnarWriter, unparsable_values_demote_column_to_string)
+{
+	std::vector<columnar_writer::column_info> columns = {
+		{"fd.num", columnar_writer::column_type::i64},
+	};
+
+	{
+		columnar_writer w(s_export, columns, 100, nlohmann::json::object());
+		std::string a = "3", b = "<NA>", c = "3";
+		w.append({&a});
+		w.append({nullptr});
+		w.append({&b});
+		w.append({&c});
+		w.close();
+	}
+
+	auto lines = read_lines();
+	std::remove(s_export.c_str());
+	ASSERT_EQ(lines.size(), 2);
+
+	const auto& col = lines[1]["columns"][0];
+	ASSERT_EQ(col["type"], "string");
+	ASSERT_EQ(col["dictionary"], nlohmann::json::parse("[\"3\", \"<NA>\"]"));
+	ASSERT_EQ(col["indices"], nlohmann::json::parse("[0, null, 1, 0]"));
+}
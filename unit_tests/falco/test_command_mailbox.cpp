@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/command_mailbox.h>
+
+using command_type = command_mailbox::command_type;
+
+TEST(CommandMailbox, coalesces_and_queues_commands)
+{
+	command_mailbox m;
+	std::vector<command_mailbox::command> commands;
+	ASSERT_FALSE(m.pending());
+
+	m.post(command_type::terminate);
+	m.post(command_type::terminate);
+	m.post({command_type::disable_rule, "rule a"});
+	m.post({command_type::enable_rule, "rule b"});
+	ASSERT_TRUE(m.pending());
+
+	auto posted = m.take(commands);
+	ASSERT_FALSE(m.pending());
+	ASSERT_TRUE(command_mailbox::has(posted, command_type::terminate));
+	ASSERT_TRUE(command_mailbox::has(posted, command_type::enable_rule));
+	ASSERT_TRUE(command_mailbox::has(posted, command_type::disable_rule));
+	ASSERT_FALSE(command_mailbox::has(posted, command_type::restart));
+	ASSERT_EQ(commands.size(), 2);
+	ASSERT_EQ(commands[0].arg, "rule a");
+	ASSERT_EQ(commands[1].arg, "rule b");
+
+	ASSERT_EQ(m.take(commands), 0);
+	ASSERT_TRUE(commands.empty());
+}
+
+TEST(CommandMailbox, broadcasts_to_open_mailboxes)
+{
+	command_bus bus;
+	std::vector<command_mailbox::command> commands;
+
+	auto m1 = bus.open();
+	auto m2 = bus.open();
+	ASSERT_NE(m1, nullptr);
+	ASSERT_NE(m2, nullptr);
+	ASSERT_NE(m1, m2);
+
+	bus.broadcast(command_type::restart);
+	bus.broadcast({command_type::enable_rule, "rule"});
+	ASSERT_EQ(m1->take(commands), (uint32_t) command_type::restart | (uint32_t) command_type::enable_rule);
+	ASSERT_EQ(commands.size(), 1);
+	ASSERT_TRUE(m2->pending());
+
+	// a closed mailbox receives nothing, and is reopened empty
+	bus.close(m2);
+	bus.broadcast(command_type::terminate);
+	ASSERT_TRUE(command_mailbox::has(m1->take(commands), command_type::terminate));
+	auto m3 = bus.open();
+	ASSERT_EQ(m3, m2);
+	ASSERT_FALSE(m3->pending());
+
+	// all mailboxes in use
+	for (size_t i = 2; i < command_bus::max_mailboxes; i++)
+	{
+		ASSERT_NE(bus.open(), nullptr);
+	}
+	ASSERT_EQ(bus.open(), nullptr);
+}
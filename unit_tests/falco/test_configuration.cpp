@@ -839,3 +839,352 @@ TEST(Configuration, configuration_webserver_ip)
         EXPECT_ANY_THROW(falco_config.init_from_content("", cmdline_config_options));
     }
 }
+
+TEST(Configuration, configuration_replay_pacing)
+{
+    falco_configuration falco_config;
+    std::vector<std::string> cmdline_config_options = {
+        "engine.kind=replay",
+        "engine.replay.capture_file=/tmp/capture.scap",
+    };
+
+    // by default, captures are replayed as fast as possible
+    EXPECT_NO_THROW(falco_config.init_from_content("", cmdline_config_options));
+    EXPECT_EQ(falco_config.m_replay.m_speed, 0);
+    EXPECT_EQ(falco_config.m_replay.m_events_per_second, 0);
+    EXPECT_FALSE(falco_config.m_replay.m_loop);
+    EXPECT_FALSE(falco_config.m_replay.m_rebase_timestamps);
+
+    std::string config_content =
+        "engine:\n"
+        "  kind: replay\n"
+        "  replay:\n"
+        "    capture_file: /tmp/capture.scap\n"
+        "    speed: 2.5\n"
+        "    loop: true\n"
+        "    rebase_timestamps: true\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_EQ(falco_config.m_replay.m_speed, 2.5);
+    EXPECT_TRUE(falco_config.m_replay.m_loop);
+    EXPECT_TRUE(falco_config.m_replay.m_rebase_timestamps);
+
+    cmdline_config_options.push_back("engine.replay.events_per_second=1000");
+    EXPECT_NO_THROW(falco_config.init_from_content("", cmdline_config_options));
+    EXPECT_EQ(falco_config.m_replay.m_events_per_second, 1000);
+
+    // speed and events_per_second are mutually exclusive
+    cmdline_config_options.push_back("engine.replay.speed=1");
+    EXPECT_ANY_THROW(falco_config.init_from_content("", cmdline_config_options));
+
+    EXPECT_ANY_THROW(falco_config.init_from_content("", {"engine.kind=replay", "engine.replay.capture_file=/tmp/capture.scap", "engine.replay.speed=-1"}));
+}
+
+TEST(Configuration, configuration_replay_time_window)
+{
+    falco_configuration falco_config;
+    std::string config_content =
+        "engine:\n"
+        "  kind: replay\n"
+        "  replay:\n"
+        "    capture_file: /tmp/capture.scap\n"
+        "    time_window:\n"
+        "      start: 1000\n"
+        "      end: 2000\n"
+        "    tids: [1, 42]\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_EQ(falco_config.m_replay.m_start_time, 1000);
+    EXPECT_EQ(falco_config.m_replay.m_end_time, 2000);
+    EXPECT_EQ(falco_config.m_replay.m_tids, std::set<int64_t>({1, 42}));
+    EXPECT_TRUE(falco_config.m_replay.m_use_index);
+
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"engine.replay.time_window.end=500"}));
+}
+
+TEST(Configuration, configuration_capture_export)
+{
+    falco_configuration falco_config;
+    std::string config_content =
+        "engine:\n"
+        "  kind: replay\n"
+        "  replay:\n"
+        "    capture_file: /tmp/capture.scap\n"
+        "capture_export:\n"
+        "  enabled: true\n"
+        "  output_file: /tmp/export.jsonl.gz\n"
+        "  condition: evt.type = open\n"
+        "  fields: [evt.num, proc.name]\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_TRUE(falco_config.m_capture_export.m_enabled);
+    EXPECT_EQ(falco_config.m_capture_export.m_source, "syscall");
+    EXPECT_EQ(falco_config.m_capture_export.m_condition, "evt.type = open");
+    EXPECT_EQ(falco_config.m_capture_export.m_fields, std::vector<std::string>({"evt.num", "proc.name"}));
+    EXPECT_EQ(falco_config.m_capture_export.m_row_group_size, 65536);
+
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"capture_export.row_group_size=0"}));
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"engine.kind=nodriver"}));
+}
+
+TEST(Configuration, configuration_nodriver_synthetic)
+{
+    falco_configuration falco_config;
+    std::string config_content =
+        "engine:\n"
+        "  kind: nodriver\n"
+        "  nodriver:\n"
+        "    synthetic:\n"
+        "      enabled: true\n"
+        "      string_length:\n"
+        "        min: 8\n"
+        "        max: 65534\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_EQ(falco_config.m_nodriver.m_synthetic.m_max_string_len, 65534);
+
+    // the strings must fit in a 16-bit parameter length
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"engine.nodriver.synthetic.string_length.max=65535"}));
+}
+
+TEST(Configuration, configuration_shadow_rules)
+{
+    falco_configuration falco_config;
+
+    // disabled by default
+    EXPECT_NO_THROW(falco_config.init_from_content("", {}));
+    EXPECT_FALSE(falco_config.m_shadow_rules.m_enabled);
+    EXPECT_EQ(falco_config.m_shadow_rules.m_sample_ratio, 10);
+    EXPECT_EQ(falco_config.m_shadow_rules.m_max_cpu_pct, 5);
+
+    std::string config_content =
+        "shadow_rules:\n"
+        "  enabled: true\n"
+        "  rules_files:\n"
+        "    - /etc/falco/candidate_rules.yaml\n"
+        "  sample_ratio: 4\n"
+        "  max_cpu_pct: 2.5\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_TRUE(falco_config.m_shadow_rules.m_enabled);
+    ASSERT_EQ(falco_config.m_shadow_rules.m_rules_filenames.size(), 1);
+    EXPECT_EQ(falco_config.m_shadow_rules.m_rules_filenames.front(), "/etc/falco/candidate_rules.yaml");
+    EXPECT_EQ(falco_config.m_shadow_rules.m_sample_ratio, 4);
+    EXPECT_EQ(falco_config.m_shadow_rules.m_max_cpu_pct, 2.5);
+
+    // enabled without candidate rules files
+    EXPECT_ANY_THROW(falco_config.init_from_content("", {"shadow_rules.enabled=true"}));
+
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"shadow_rules.sample_ratio=0"}));
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"shadow_rules.max_cpu_pct=0"}));
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"shadow_rules.max_cpu_pct=101"}));
+}
+
+TEST(Configuration, configuration_stall_detector)
+{
+    falco_configuration falco_config;
+
+    // disabled by default
+    EXPECT_NO_THROW(falco_config.init_from_content("", {}));
+    EXPECT_FALSE(falco_config.m_stall_detector.m_enabled);
+    EXPECT_EQ(falco_config.m_stall_detector.m_threshold_ms, 200);
+    EXPECT_EQ(falco_config.m_stall_detector.m_check_interval_ms, 50);
+    EXPECT_EQ(falco_config.m_stall_detector.m_max_logs_per_minute, 10);
+
+    std::string config_content =
+        "stall_detector:\n"
+        "  enabled: true\n"
+        "  threshold_ms: 500\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_TRUE(falco_config.m_stall_detector.m_enabled);
+    EXPECT_EQ(falco_config.m_stall_detector.m_threshold_ms, 500);
+
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"stall_detector.check_interval_ms=0"}));
+}
+
+TEST(Configuration, configuration_webserver_profiler)
+{
+    falco_configuration falco_config;
+
+    // disabled by default
+    EXPECT_NO_THROW(falco_config.init_from_content("", {}));
+    EXPECT_FALSE(falco_config.m_webserver_config.m_profiler_enabled);
+    EXPECT_EQ(falco_config.m_webserver_config.m_profiler_max_duration_s, 60);
+
+    std::string config_content =
+        "webserver:\n"
+        "  enabled: true\n"
+        "  profiler_enabled: true\n"
+        "  profiler_max_duration_s: 5\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_TRUE(falco_config.m_webserver_config.m_profiler_enabled);
+    EXPECT_EQ(falco_config.m_webserver_config.m_profiler_max_duration_s, 5);
+}
+
+TEST(Configuration, configuration_webserver_rules_control)
+{
+    falco_configuration falco_config;
+
+    // disabled by default
+    EXPECT_NO_THROW(falco_config.init_from_content("", {}));
+    EXPECT_FALSE(falco_config.m_webserver_config.m_rules_control_enabled);
+
+    std::string config_content =
+        "webserver:\n"
+        "  enabled: true\n"
+        "  rules_control_enabled: true\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_TRUE(falco_config.m_webserver_config.m_rules_control_enabled);
+}
+
+TEST(Configuration, configuration_memory_budget)
+{
+    falco_configuration falco_config;
+
+    // disabled by default
+    EXPECT_NO_THROW(falco_config.init_from_content("", {}));
+    EXPECT_FALSE(falco_config.m_memory_budget.m_enabled);
+    EXPECT_EQ(falco_config.m_memory_budget.m_limit_mb, 256);
+
+    std::string config_content =
+        "memory_budget:\n"
+        "  enabled: true\n"
+        "  limit_mb: 64\n"
+        "  shrink_threshold_pct: 50\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_TRUE(falco_config.m_memory_budget.m_enabled);
+    EXPECT_EQ(falco_config.m_memory_budget.m_limit_mb, 64);
+    EXPECT_EQ(falco_config.m_memory_budget.m_shrink_threshold_pct, 50);
+    EXPECT_EQ(falco_config.m_memory_budget.m_drop_threshold_pct, 95);
+
+    // thresholds must be increasing
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"memory_budget.summarize_threshold_pct=40"}));
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"memory_budget.limit_mb=0"}));
+}
+
+TEST(Configuration, configuration_otlp_output)
+{
+    falco_configuration falco_config;
+
+    auto has_otlp_output = [&falco_config]()
+    {
+        for (const auto& o : falco_config.m_outputs)
+        {
+            if (o.name == "otlp")
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // disabled by default
+    EXPECT_NO_THROW(falco_config.init_from_content("", {}));
+    EXPECT_FALSE(has_otlp_output());
+    EXPECT_FALSE(falco_config.m_otlp_metrics_enabled);
+
+    std::string config_content =
+        "otlp_output:\n"
+        "  enabled: true\n"
+        "  endpoint: http://localhost:4318\n"
+        "  headers:\n"
+        "    - 'Authorization: Bearer abc'\n"
+        "  batch_size: 100\n"
+        "  metrics_enabled: true\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_TRUE(has_otlp_output());
+    EXPECT_TRUE(falco_config.m_otlp_metrics_enabled);
+    EXPECT_EQ(falco_config.m_otlp_output.options["endpoint"], "http://localhost:4318");
+    EXPECT_EQ(falco_config.m_otlp_output.options["headers"], "Authorization: Bearer abc\n");
+    EXPECT_EQ(falco_config.m_otlp_output.options["batch_size"], "100");
+    EXPECT_EQ(falco_config.m_otlp_output.options["linger_ms"], "1000");
+    EXPECT_EQ(falco_config.m_otlp_output.options["compress"], "true");
+
+    // metrics only
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {"otlp_output.alerts_enabled=false"}));
+    EXPECT_FALSE(has_otlp_output());
+    EXPECT_TRUE(falco_config.m_otlp_metrics_enabled);
+
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"otlp_output.endpoint="}));
+    EXPECT_ANY_THROW(falco_config.init_from_content(config_content, {"otlp_output.batch_size=0"}));
+}
+
+TEST(Configuration, configuration_rules_dispatch_fields)
+{
+    falco_configuration falco_config;
+
+    EXPECT_NO_THROW(falco_config.init_from_content("", {}));
+    EXPECT_TRUE(falco_config.m_rules_dispatch_fields.empty());
+
+    std::string config_content =
+        "rules_dispatch_fields:\n"
+        "  k8s_audit: ka.verb\n"
+        "  aws_cloudtrail: ct.name\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_EQ(falco_config.m_rules_dispatch_fields.size(), 2);
+    EXPECT_EQ(falco_config.m_rules_dispatch_fields["k8s_audit"], "ka.verb");
+    EXPECT_EQ(falco_config.m_rules_dispatch_fields["aws_cloudtrail"], "ct.name");
+}
+
+TEST(Configuration, configuration_rule_evaluation_report)
+{
+    falco_configuration falco_config;
+
+    EXPECT_NO_THROW(falco_config.init_from_content("", {}));
+    EXPECT_FALSE(falco_config.m_rule_eval_report.m_enabled);
+    EXPECT_TRUE(falco_config.m_rule_eval_report.m_max_field_lengths.empty());
+
+    std::string config_content =
+        "rule_evaluation_report:\n"
+        "  enabled: true\n"
+        "  max_field_lengths:\n"
+        "    proc.cmdline: 4096\n"
+        "    fd.name: 1024\n"
+        "  event_budget_us: 500\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_TRUE(falco_config.m_rule_eval_report.m_enabled);
+    EXPECT_EQ(falco_config.m_rule_eval_report.m_max_field_lengths.size(), 2);
+    EXPECT_EQ(falco_config.m_rule_eval_report.m_max_field_lengths["proc.cmdline"], 4096);
+    EXPECT_EQ(falco_config.m_rule_eval_report.m_max_field_lengths["fd.name"], 1024);
+    EXPECT_EQ(falco_config.m_rule_eval_report.m_event_budget_us, 500);
+
+    config_content =
+        "rule_evaluation_report:\n"
+        "  enabled: true\n"
+        "  max_field_lengths:\n"
+        "    fd.name: 0\n"
+        "  event_budget_us: 500\n";
+    EXPECT_THROW(falco_config.init_from_content(config_content, {}), std::logic_error);
+
+    // without a budget nothing would ever be reported
+    config_content =
+        "rule_evaluation_report:\n"
+        "  enabled: true\n"
+        "  max_field_lengths:\n"
+        "    fd.name: 1024\n";
+    EXPECT_THROW(falco_config.init_from_content(config_content, {}), std::logic_error);
+}
+
+TEST(Configuration, configuration_rule_trace)
+{
+    falco_configuration falco_config;
+
+    EXPECT_NO_THROW(falco_config.init_from_content("", {}));
+    EXPECT_FALSE(falco_config.m_rule_trace.m_enabled);
+    EXPECT_EQ(falco_config.m_rule_trace.m_sampling_ratio, 1);
+
+    std::string config_content =
+        "rule_trace:\n"
+        "  enabled: true\n"
+        "  rules: [rule A, rule B]\n"
+        "  processes: [bash]\n"
+        "  sampling_ratio: 10\n"
+        "  file: /tmp/trace.json\n";
+    EXPECT_NO_THROW(falco_config.init_from_content(config_content, {}));
+    EXPECT_TRUE(falco_config.m_rule_trace.m_enabled);
+    EXPECT_EQ(falco_config.m_rule_trace.m_rules, std::set<std::string>({"rule A", "rule B"}));
+    EXPECT_EQ(falco_config.m_rule_trace.m_processes, std::set<std::string>({"bash"}));
+    EXPECT_EQ(falco_config.m_rule_trace.m_sampling_ratio, 10);
+    EXPECT_EQ(falco_config.m_rule_trace.m_capacity, 1000);
+    EXPECT_EQ(falco_config.m_rule_trace.m_file, "/tmp/trace.json");
+
+    config_content =
+        "rule_trace:\n"
+        "  enabled: true\n";
+    EXPECT_THROW(falco_config.init_from_content(config_content, {}), std::logic_error);
+}
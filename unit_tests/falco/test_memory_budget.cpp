@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/memory_budget.h>
+
+TEST(MemoryBudget, accounts_and_grades_pressure)
+{
+	memory_budget b(1000, 70, 85, 95, 10, 16);
+	auto a1 = b.add_account("a1");
+	auto a2 = b.add_account("a2");
+	ASSERT_EQ(b.current_level(), memory_budget::level::none);
+
+	a1->charge(400);
+	a2->charge(300);
+	ASSERT_EQ(b.used(), 700);
+	ASSERT_EQ(b.current_level(), memory_budget::level::shrink);
+
+	a2->charge(150);
+	ASSERT_EQ(b.current_level(), memory_budget::level::summarize);
+	ASSERT_FALSE(b.should_drop(falco_common::PRIORITY_DEBUG));
+
+	a1->charge(100);
+	ASSERT_EQ(b.current_level(), memory_budget::level::drop);
+
+	a1->release(500);
+	a2->release(450);
+	ASSERT_EQ(b.used(), 0);
+	ASSERT_EQ(b.current_level(), memory_budget::level::none);
+
+	a1->count_dropped();
+	a2->count_summarized();
+	auto usage = b.get_usage();
+	ASSERT_EQ(usage.size(), 2);
+	ASSERT_EQ(usage[0].name, "a1");
+	ASSERT_EQ(usage[0].dropped, 1);
+	ASSERT_EQ(usage[1].summarized, 1);
+}
+
+TEST(MemoryBudget, drops_by_priority)
+{
+	memory_budget b(1000, 50, 50, 50, 10, 16);
+	auto a = b.add_account("a");
+
+	// entering the drop level only drops debug alerts
+	a->charge(500);
+	ASSERT_TRUE(b.should_drop(falco_common::PRIORITY_DEBUG));
+	ASSERT_FALSE(b.should_drop(falco_common::PRIORITY_INFORMATIONAL));
+
+	// halfway to the limit
+	a->charge(250);
+	ASSERT_TRUE(b.should_drop(falco_common::PRIORITY_NOTICE));
+	ASSERT_FALSE(b.should_drop(falco_common::PRIORITY_WARNING));
+
+	// at and above the limit, critical alerts are still kept
+	a->charge(500);
+	ASSERT_TRUE(b.should_drop(falco_common::PRIORITY_ERROR));
+	ASSERT_FALSE(b.should_drop(falco_common::PRIORITY_CRITICAL));
+	ASSERT_FALSE(b.should_drop(falco_common::PRIORITY_EMERGENCY));
+}
+
+TEST(MemoryBudget, shrinks_queues_but_critical)
+{
+	memory_budget b(1000, 50, 70, 90, 10, 16);
+	auto a = b.add_account("a");
+
+	// below the shrink level the queues are not capped
+	ASSERT_FALSE(b.should_drop_queued(falco_common::PRIORITY_DEBUG, 100));
+
+	a->charge(500);
+	ASSERT_FALSE(b.should_drop_queued(falco_common::PRIORITY_DEBUG, 9));
+	ASSERT_TRUE(b.should_drop_queued(falco_common::PRIORITY_DEBUG, 10));
+	ASSERT_TRUE(b.should_drop_queued(falco_common::PRIORITY_ERROR, 10));
+
+	// critical and more severe alerts are never dropped
+	ASSERT_FALSE(b.should_drop_queued(falco_common::PRIORITY_CRITICAL, 10));
+	ASSERT_FALSE(b.should_drop_queued(falco_common::PRIORITY_ALERT, 10));
+	ASSERT_FALSE(b.should_drop_queued(falco_common::PRIORITY_EMERGENCY, 10));
+}
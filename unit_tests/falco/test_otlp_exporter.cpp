@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/otlp_exporter.h>
+#include <httplib.h>
+#include <zlib.h>
+
+#include <atomic>
+#include <thread>
+
+static std::string gunzip(const std::string& data)
+{
+	z_stream zs = {};
+	inflateInit2(&zs, 15 + 16);
+	std::string res;
+	char buf[4096];
+	zs.next_in = (Bytef*) data.data();
+	zs.avail_in = data.size();
+	int ret;
+	do
+	{
+		zs.next_out = (Bytef*) buf;
+		zs.avail_out = sizeof(buf);
+		ret = inflate(&zs, Z_NO_FLUSH);
+		res.append(buf, sizeof(buf) - zs.avail_out);
+	} while (ret == Z_OK);
+	inflateEnd(&zs);
+	return res;
+}
+
+// A local OTLP/HTTP collector, answering with the given status codes in
+// order, and then always with 200
+class mock_collector
+{
+public:
+	explicit mock_collector(std::vector<int> statuses = {})
+		: m_statuses(statuses)
+	{
+		m_server.Post(".*", [this](const httplib::Request& req, httplib::Response& res)
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			int status = m_requests < m_statuses.size() ? m_statuses[m_requests] : 200;
+			m_requests++;
+			if (status == 200)
+			{
+				m_paths.push_back(req.path);
+				m_bodies.push_back(req.get_header_value("Content-Encoding") == "gzip" ? gunzip(req.body) : req.body);
+			}
+			res.status = status;
+		});
+		m_port = m_server.bind_to_any_port("127.0.0.1");
+		m_thread = std::thread([this]{ m_server.listen_after_bind(); });
+		while (!m_server.is_running())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	~mock_collector()
+	{
+		m_server.stop();
+		m_thread.join();
+	}
+
+	std::string endpoint() const
+	{
+		return "http://127.0.0.1:" + std::to_string(m_port);
+	}
+
+	bool wait_bodies(size_t n)
+	{
+		for (int i = 0; i < 500; i++)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mtx);
+				if (m_bodies.size() >= n)
+				{
+					return true;
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return false;
+	}
+
+	std::vector<std::string> bodies()
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		return m_bodies;
+	}
+
+	std::vector<std::string> paths()
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		return m_paths;
+	}
+
+private:
+	httplib::Server m_server;
+	std::thread m_thread;
+	int m_port;
+	std::mutex m_mtx;
+	std::vector<int> m_statuses;
+	size_t m_requests = 0;
+	std::vector<std::string> m_paths;
+	std::vector<std::string> m_bodies;
+};
+
+static falco::outputs::message test_message(const std::string& rule)
+{
+	falco::outputs::message msg;
+	msg.ts = 1700000000000000000;
+	msg.priority = falco_common::PRIORITY_CRITICAL;
+	msg.msg = "something happened";
+	msg.rule = rule;
+	msg.source = "syscall";
+	msg.fields["proc.name"] = "cat";
+	msg.fields["proc.pid"] = 42;
+	msg.tags = {"a", "b"};
+	return msg;
+}
+
+static otlp_exporter::config test_config(const mock_collector& c, const std::string& path)
+{
+	std::map<std::string, std::string> options = {
+		{"endpoint", c.endpoint() + "/"},
+		{"batch_size", "2"},
+		{"linger_ms", "60000"},
+		{"retry_backoff_ms", "1"},
+	};
+	return otlp_exporter::parse_options(options, path);
+}
+
+TEST(OtlpExporter, batches_and_encodes_log_records)
+{
+	mock_collector c;
+	otlp_exporter e(test_config(c, "/v1/logs"), otlp_exporter::logs_encoder("myhost"));
+
+	e.add(otlp_exporter::make_log_record(test_message("r1"), false));
+	e.add(otlp_exporter::make_log_record(test_message("r2"), false));
+	e.add(otlp_exporter::make_log_record(test_message("r3"), false));
+
+	// a full batch is sent right away, and the last record on stop
+	ASSERT_TRUE(c.wait_bodies(1));
+	e.stop();
+	ASSERT_TRUE(c.wait_bodies(2));
+	ASSERT_EQ(c.paths()[0], "/v1/logs");
+	ASSERT_EQ(e.get_stats().sent_records, 3);
+
+	falco::otlp::ExportLogsServiceRequest req;
+	ASSERT_TRUE(req.ParseFromString(c.bodies()[0]));
+	ASSERT_EQ(req.resource_logs_size(), 1);
+	bool found_host = false;
+	for (const auto& kv : req.resource_logs(0).resource().attributes())
+	{
+		found_host |= kv.key() == "host.name" && kv.value().string_value() == "myhost";
+	}
+	ASSERT_TRUE(found_host);
+
+	const auto& records = req.resource_logs(0).scope_logs(0).log_records();
+	ASSERT_EQ(records.size(), 2);
+	ASSERT_EQ(records[0].time_unix_nano(), 1700000000000000000);
+	ASSERT_EQ(records[0].severity_number(), falco::otlp::SEVERITY_NUMBER_FATAL);
+	ASSERT_EQ(records[0].severity_text(), "Critical");
+	ASSERT_EQ(records[0].body().string_value(), "something happened");
+	std::map<std::string, falco::otlp::AnyValue> attrs;
+	for (const auto& kv : records[0].attributes())
+	{
+		attrs[kv.key()] = kv.value();
+	}
+	ASSERT_EQ(attrs["falco.rule"].string_value(), "r1");
+	ASSERT_EQ(attrs["proc.name"].string_value(), "cat");
+	ASSERT_EQ(attrs["proc.pid"].int_value(), 42);
+	ASSERT_EQ(attrs["falco.tags"].array_value().values_size(), 2);
+}
+
+TEST(OtlpExporter, sends_after_linger)
+{
+	mock_collector c;
+	auto cfg = test_config(c, "/v1/logs");
+	cfg.batch_size = 100;
+	cfg.linger_ms = 20;
+	otlp_exporter e(cfg, otlp_exporter::logs_encoder("myhost"));
+
+	e.add(otlp_exporter::make_log_record(test_message("r1"), false));
+	ASSERT_TRUE(c.wait_bodies(1));
+}
+
+TEST(OtlpExporter, retries_transient_failures_only)
+{
+	{
+		mock_collector c({503, 503});
+		otlp_exporter e(test_config(c, "/v1/logs"), otlp_exporter::logs_encoder("myhost"));
+		e.add(otlp_exporter::make_log_record(test_message("r1"), false));
+		e.add(otlp_exporter::make_log_record(test_message("r2"), false));
+		ASSERT_TRUE(c.wait_bodies(1));
+		e.stop();
+		auto stats = e.get_stats();
+		ASSERT_EQ(stats.retried_requests, 2);
+		ASSERT_EQ(stats.sent_records, 2);
+	}
+	{
+		mock_collector c({400});
+		otlp_exporter e(test_config(c, "/v1/logs"), otlp_exporter::logs_encoder("myhost"));
+		e.add(otlp_exporter::make_log_record(test_message("r1"), false));
+		e.add(otlp_exporter::make_log_record(test_message("r2"), false));
+		e.stop();
+		auto stats = e.get_stats();
+		ASSERT_EQ(stats.retried_requests, 0);
+		ASSERT_EQ(stats.failed_requests, 1);
+		ASSERT_EQ(stats.dropped_records, 2);
+	}
+}
+
+TEST(OtlpExporter, exports_metrics_snapshots)
+{
+	mock_collector c;
+	otlp_exporter e(test_config(c, "/v1/metrics"), otlp_exporter::metrics_encoder("myhost"));
+
+	nlohmann::json fields;
+	fields["evt.source"] = "syscall";
+	fields["falco.n_evts"] = 10;
+	fields["falco.cpu_usage_perc"] = 1.5;
+	std::vector<otlp_exporter::record_t> metrics;
+	otlp_exporter::make_metrics(1000, fields, metrics);
+	ASSERT_EQ(metrics.size(), 2);
+	for (auto& m : metrics)
+	{
+		e.add(std::move(m));
+	}
+	ASSERT_TRUE(c.wait_bodies(1));
+
+	falco::otlp::ExportMetricsServiceRequest req;
+	ASSERT_TRUE(req.ParseFromString(c.bodies()[0]));
+	ASSERT_EQ(c.paths()[0], "/v1/metrics");
+	std::map<std::string, falco::otlp::NumberDataPoint> points;
+	for (const auto& m : req.resource_metrics(0).scope_metrics(0).metrics())
+	{
+		points[m.name()] = m.gauge().data_points(0);
+	}
+	ASSERT_EQ(points["falco.n_evts"].as_int(), 10);
+	ASSERT_EQ(points["falco.cpu_usage_perc"].as_double(), 1.5);
+	ASSERT_EQ(points["falco.n_evts"].time_unix_nano(), 1000);
+	ASSERT_EQ(points["falco.n_evts"].attributes(0).key(), "evt.source");
+}
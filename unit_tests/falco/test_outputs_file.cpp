@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/outputs_file.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+static std::string read_all(const std::string& filename)
+{
+	std::ifstream f(filename);
+	std::stringstream ss;
+	ss << f.rdbuf();
+	return ss.str();
+}
+
+static void run_batching_test(const std::string& keep_alive)
+{
+	std::string filename = "falco_test_outputs_file.txt";
+	falco::outputs::config oc;
+	oc.name = "file";
+	oc.options["filename"] = filename;
+	oc.options["keep_alive"] = keep_alive;
+
+	std::unique_ptr<falco::outputs::abstract_output> o = std::make_unique<falco::outputs::output_file>();
+	std::string err;
+	ASSERT_TRUE(o->init(oc, true, "test-host", false, err));
+
+	falco::outputs::message msg = {};
+	msg.msg = "first";
+	o->output(&msg);
+	msg.msg = "second";
+	o->output(&msg);
+
+	// nothing must be written until the batch is flushed
+	ASSERT_EQ(read_all(filename), "");
+
+	o->flush();
+	ASSERT_EQ(read_all(filename), "first\nsecond\n");
+
+	// cleanup must never lose batched messages
+	msg.msg = "third";
+	o->output(&msg);
+	o->cleanup();
+	ASSERT_EQ(read_all(filename), "first\nsecond\nthird\n");
+
+	std::remove(filename.c_str());
+}
+
+TEST(OutputsFile, batching_keep_alive)
+{
+	run_batching_test("true");
+}
+
+TEST(OutputsFile, batching_no_keep_alive)
+{
+	run_batching_test("false");
+}
+
+TEST(OutputsFile, batching_size_limit)
+{
+	std::string filename = "falco_test_outputs_file.txt";
+	falco::outputs::config oc;
+	oc.name = "file";
+	oc.options["filename"] = filename;
+	oc.options["keep_alive"] = "true";
+
+	std::unique_ptr<falco::outputs::abstract_output> o = std::make_unique<falco::outputs::output_file>();
+	std::string err;
+	ASSERT_TRUE(o->init(oc, true, "test-host", false, err));
+
+	// a batch growing past the limit is written out without waiting
+	falco::outputs::message msg = {};
+	msg.msg = std::string(falco::outputs::max_batch_size, 'a');
+	o->output(&msg);
+	ASSERT_EQ(read_all(filename).size(), falco::outputs::max_batch_size + 1);
+
+	o->cleanup();
+	std::remove(filename.c_str());
+}
+
+TEST(OutputsFile, unbuffered)
+{
+	std::string filename = "falco_test_outputs_file.txt";
+	falco::outputs::config oc;
+	oc.name = "file";
+	oc.options["filename"] = filename;
+	oc.options["keep_alive"] = "true";
+
+	std::unique_ptr<falco::outputs::abstract_output> o = std::make_unique<falco::outputs::output_file>();
+	std::string err;
+	ASSERT_TRUE(o->init(oc, false, "test-host", false, err));
+
+	// without buffered_outputs each message is written right away
+	falco::outputs::message msg = {};
+	msg.msg = "first";
+	o->output(&msg);
+	ASSERT_EQ(read_all(filename), "first\n");
+
+	o->cleanup();
+	std::remove(filename.c_str());
+}
+
+TEST(OutputsFile, batch_dropped_on_failure)
+{
+	falco::outputs::config oc;
+	oc.name = "file";
+	oc.options["filename"] = "not_a_dir/falco_test_outputs_file.txt";
+	oc.options["keep_alive"] = "true";
+
+	std::unique_ptr<falco::outputs::abstract_output> o = std::make_unique<falco::outputs::output_file>();
+	std::string err;
+	ASSERT_TRUE(o->init(oc, true, "test-host", false, err));
+
+	falco::outputs::message msg = {};
+	msg.msg = "lost";
+	o->output(&msg);
+	ASSERT_THROW(o->flush(), falco_exception);
+
+	// the messages that could not be written are not retried forever
+	std::string filename = "falco_test_outputs_file.txt";
+	oc.options["filename"] = filename;
+	ASSERT_TRUE(o->init(oc, true, "test-host", false, err));
+	msg.msg = "kept";
+	o->output(&msg);
+	o->flush();
+	ASSERT_EQ(read_all(filename), "kept\n");
+
+	o->cleanup();
+	std::remove(filename.c_str());
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include <falco/outputs_program.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+static std::string read_all(const std::string& filename)
+{
+	std::ifstream f(filename);
+	std::stringstream ss;
+	ss << f.rdbuf();
+	return ss.str();
+}
+
+static std::unique_ptr<falco::outputs::abstract_output> create_output(const std::string& keep_alive, bool buffered)
+{
+	falco::outputs::config oc;
+	oc.name = "program";
+	// every run of the program appends a line to the runs file
+	oc.options["program"] = "cat >> falco_test_outputs_program.txt && echo run >> falco_test_outputs_program_runs.txt";
+	oc.options["keep_alive"] = keep_alive;
+
+	auto o = std::make_unique<falco::outputs::output_program>();
+	std::string err;
+	EXPECT_TRUE(o->init(oc, buffered, "test-host", false, err));
+	return o;
+}
+
+TEST(OutputsProgram, one_run_per_message_without_keep_alive)
+{
+	for (bool buffered : {false, true})
+	{
+		auto o = create_output("false", buffered);
+
+		falco::outputs::message msg = {};
+		msg.msg = "first";
+		o->output(&msg);
+		// the program has already received and processed the message
+		ASSERT_EQ(read_all("falco_test_outputs_program.txt"), "first\n");
+		msg.msg = "second";
+		o->output(&msg);
+		o->flush();
+		o->cleanup();
+
+		ASSERT_EQ(read_all("falco_test_outputs_program.txt"), "first\nsecond\n");
+		ASSERT_EQ(read_all("falco_test_outputs_program_runs.txt"), "run\nrun\n");
+
+		std::remove("falco_test_outputs_program.txt");
+		std::remove("falco_test_outputs_program_runs.txt");
+	}
+}
+
+TEST(OutputsProgram, batching_keep_alive)
+{
+	auto o = create_output("true", true);
+
+	falco::outputs::message msg = {};
+	msg.msg = "first";
+	o->output(&msg);
+	msg.msg = "second";
+	o->output(&msg);
+	o->flush();
+	msg.msg = "third";
+	o->output(&msg);
+	// closing the program waits for it to exit
+	o->cleanup();
+
+	ASSERT_EQ(read_all("falco_test_outputs_program.txt"), "first\nsecond\nthird\n");
+	ASSERT_EQ(read_all("falco_test_outputs_program_runs.txt"), "run\n");
+
+	std::remove("falco_test_outputs_program.txt");
+	std::remove("falco_test_outputs_program_runs.txt");
+}
@@ -0,0 +1,365 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include <falco/plugin_batch_extractor.h>
+
+#include <array>
+#include <cstring>
+
+// A minimal extractor plugin, whose field values are derived from the
+// event number and from the arguments it receives
+namespace
+{
+enum test_field : uint32_t
+{
+	TEST_STR = 0,
+	TEST_NUM,
+	TEST_FLAG,
+	TEST_IP,
+	TEST_LIST,
+	TEST_IDX,
+	TEST_KEY,
+};
+
+struct test_plugin_state
+{
+	std::vector<std::vector<std::string>> strs;
+	std::vector<std::vector<const char*>> str_ptrs;
+	std::vector<uint64_t> nums;
+	std::vector<ss_plugin_bool> bools;
+	std::vector<std::array<uint8_t, 4>> ips;
+	std::vector<ss_plugin_byte_buffer> bufs;
+};
+
+uint32_t s_extract_calls = 0;
+uint32_t s_last_num_fields = 0;
+
+const char* plugin_get_required_api_version() { return PLUGIN_API_VERSION_STR; }
+const char* plugin_get_version() { return "0.1.0"; }
+const char* plugin_get_name() { return "batch_test"; }
+const char* plugin_get_description() { return "test plugin for the batch extraction"; }
+const char* plugin_get_contact() { return "github.com/falcosecurity/falco"; }
+const char* plugin_get_extract_event_sources() { return "[\"batch_test\"]"; }
+
+const char* plugin_get_fields()
+{
+	return R"([
+		{"type": "string", "name": "test.str", "desc": ""},
+		{"type": "uint64", "name": "test.num", "desc": ""},
+		{"type": "bool", "name": "test.flag", "desc": ""},
+		{"type": "ipaddr", "name": "test.ip", "desc": ""},
+		{"type": "string", "name": "test.list", "desc": "", "isList": true},
+		{"type": "string", "name": "test.idx", "desc": "", "arg": {"isRequired": true, "isIndex": true}},
+		{"type": "string", "name": "test.key", "desc": "", "arg": {"isRequired": true, "isKey": true}}
+	])";
+}
+
+ss_plugin_t* plugin_init(const ss_plugin_init_input* in, ss_plugin_rc* rc)
+{
+	*rc = SS_PLUGIN_SUCCESS;
+	return (ss_plugin_t*) new test_plugin_state();
+}
+
+void plugin_destroy(ss_plugin_t* s)
+{
+	delete (test_plugin_state*) s;
+}
+
+const char* plugin_get_last_error(ss_plugin_t* s)
+{
+	return "";
+}
+
+ss_plugin_rc plugin_extract_fields(ss_plugin_t* s, const ss_plugin_event_input* evt, const ss_plugin_field_extract_input* in)
+{
+	auto ps = (test_plugin_state*) s;
+	s_extract_calls++;
+	s_last_num_fields = in->num_fields;
+
+	ps->strs.assign(in->num_fields, {});
+	ps->str_ptrs.assign(in->num_fields, {});
+	ps->nums.assign(in->num_fields, 0);
+	ps->bools.assign(in->num_fields, 0);
+	ps->ips.assign(in->num_fields, {});
+	ps->bufs.assign(in->num_fields, {});
+	for(uint32_t i = 0; i < in->num_fields; i++)
+	{
+		auto& f = in->fields[i];
+		auto n = evt->evtnum;
+		f.res_len = 1;
+		switch(f.field_id)
+		{
+		case TEST_NUM:
+			ps->nums[i] = n * 10;
+			f.res.u64 = &ps->nums[i];
+			continue;
+		case TEST_FLAG:
+			ps->bools[i] = n % 2;
+			f.res.boolean = &ps->bools[i];
+			continue;
+		case TEST_IP:
+			ps->ips[i] = {10, 0, 0, (uint8_t) n};
+			ps->bufs[i].len = 4;
+			ps->bufs[i].ptr = ps->ips[i].data();
+			f.res.buf = &ps->bufs[i];
+			continue;
+		case TEST_STR:
+			ps->strs[i] = {"str-" + std::to_string(n)};
+			break;
+		case TEST_LIST:
+			ps->strs[i] = {"a", "b"};
+			break;
+		case TEST_IDX:
+		case TEST_KEY:
+			ps->strs[i] = {std::to_string(f.arg_index) + "/" + (f.arg_key != nullptr ? f.arg_key : "null")};
+			break;
+		default:
+			return SS_PLUGIN_FAILURE;
+		}
+		for(const auto& str : ps->strs[i])
+		{
+			ps->str_ptrs[i].push_back(str.c_str());
+		}
+		f.res.str = ps->str_ptrs[i].data();
+		f.res_len = ps->str_ptrs[i].size();
+	}
+	return SS_PLUGIN_SUCCESS;
+}
+
+plugin_api test_plugin_api()
+{
+	plugin_api api;
+	memset(&api, 0, sizeof(api));
+	api.get_required_api_version = plugin_get_required_api_version;
+	api.get_version = plugin_get_version;
+	api.get_name = plugin_get_name;
+	api.get_description = plugin_get_description;
+	api.get_contact = plugin_get_contact;
+	api.init = plugin_init;
+	api.destroy = plugin_destroy;
+	api.get_last_error = plugin_get_last_error;
+	api.get_fields = plugin_get_fields;
+	api.get_extract_event_sources = plugin_get_extract_event_sources;
+	api.extract_fields = plugin_extract_fields;
+	return api;
+}
+
+// A plugin event with an empty payload
+class test_event
+{
+public:
+	test_event()
+	{
+		m_buf.assign(sizeof(scap_evt) + 2 * sizeof(uint32_t) + sizeof(uint32_t), 0);
+		auto hdr = (scap_evt*) m_buf.data();
+		hdr->tid = (uint64_t) -1;
+		hdr->len = (uint32_t) m_buf.size();
+		hdr->type = PPME_PLUGINEVENT_E;
+		hdr->nparams = 2;
+		uint32_t plugin_id_len = sizeof(uint32_t);
+		memcpy(m_buf.data() + sizeof(scap_evt), &plugin_id_len, sizeof(uint32_t));
+		m_evt.init(m_buf.data(), 0);
+		set(1, 0, "batch_test");
+	}
+
+	sinsp_evt* set(uint64_t num, size_t source_idx, const char* source_name)
+	{
+		m_evt.set_num(num);
+		m_evt.set_source_idx(source_idx);
+		m_evt.set_source_name(source_name);
+		return &m_evt;
+	}
+
+	sinsp_evt* set_type(ppm_event_code type)
+	{
+		((scap_evt*) m_buf.data())->type = type;
+		m_evt.init(m_buf.data(), 0);
+		return &m_evt;
+	}
+
+private:
+	std::vector<uint8_t> m_buf;
+	sinsp_evt m_evt;
+};
+
+class PluginBatchExtractor : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		m_api = test_plugin_api();
+		m_plugin = m_inspector.register_plugin(&m_api);
+		std::string err;
+		ASSERT_TRUE(m_plugin->init("", err)) << err;
+		m_extractor = std::make_unique<plugin_batch_extractor>(m_plugin);
+		s_extract_calls = 0;
+		s_last_num_fields = 0;
+	}
+
+	std::string get_str(sinsp_evt* evt, int32_t slot)
+	{
+		std::vector<extract_value_t> values;
+		EXPECT_TRUE(m_extractor->get(evt, slot, values));
+		EXPECT_EQ(values.size(), 1);
+		return values.empty() ? "" : std::string((const char*) values[0].ptr, values[0].len);
+	}
+
+	plugin_api m_api;
+	sinsp m_inspector;
+	std::shared_ptr<sinsp_plugin> m_plugin;
+	std::unique_ptr<plugin_batch_extractor> m_extractor;
+};
+}
+
+TEST_F(PluginBatchExtractor, one_call_per_event)
+{
+	auto str = m_extractor->add_field(TEST_STR, "");
+	auto num = m_extractor->add_field(TEST_NUM, "");
+	auto list = m_extractor->add_field(TEST_LIST, "");
+	ASSERT_GE(str, 0);
+	ASSERT_GE(num, 0);
+	ASSERT_GE(list, 0);
+	ASSERT_EQ(m_extractor->add_field(TEST_STR, ""), str);
+
+	test_event e;
+	auto evt = e.set(7, 0, "batch_test");
+	std::vector<extract_value_t> values;
+	ASSERT_EQ(get_str(evt, str), "str-7");
+	ASSERT_TRUE(m_extractor->get(evt, num, values));
+	ASSERT_EQ(values.size(), 1);
+	ASSERT_EQ(values[0].len, sizeof(uint64_t));
+	ASSERT_EQ(*(uint64_t*) values[0].ptr, 70);
+	ASSERT_TRUE(m_extractor->get(evt, list, values));
+	ASSERT_EQ(values.size(), 2);
+	ASSERT_EQ(std::string((const char*) values[1].ptr, values[1].len), "b");
+	ASSERT_EQ(s_extract_calls, 1);
+	ASSERT_EQ(s_last_num_fields, 3);
+
+	// the values of the next event are extracted with another call
+	evt = e.set(8, 0, "batch_test");
+	ASSERT_EQ(get_str(evt, str), "str-8");
+	ASSERT_EQ(get_str(evt, str), "str-8");
+	ASSERT_EQ(s_extract_calls, 2);
+}
+
+TEST_F(PluginBatchExtractor, stats)
+{
+	auto str = m_extractor->add_field(TEST_STR, "");
+	m_extractor->add_field(TEST_NUM, "");
+	m_extractor->add_field(TEST_LIST, "");
+
+	// the fields not read by the rules an event reaches are extracted
+	// anyway, and the stats tell how many
+	test_event e;
+	for(uint64_t n = 1; n <= 4; n++)
+	{
+		auto evt = e.set(n, 0, "batch_test");
+		ASSERT_EQ(get_str(evt, str), "str-" + std::to_string(n));
+		ASSERT_EQ(get_str(evt, str), "str-" + std::to_string(n));
+	}
+	auto st = m_extractor->get_stats();
+	ASSERT_EQ(st.events, 4);
+	ASSERT_EQ(st.extracted_fields, 12);
+	ASSERT_EQ(st.read_fields, 4);
+}
+
+TEST_F(PluginBatchExtractor, slots_added_after_first_event)
+{
+	auto str = m_extractor->add_field(TEST_STR, "");
+	test_event e;
+	auto evt = e.set(3, 0, "batch_test");
+	ASSERT_EQ(get_str(evt, str), "str-3");
+	ASSERT_EQ(s_extract_calls, 1);
+	ASSERT_EQ(s_last_num_fields, 1);
+
+	// the event is extracted again with the new field
+	auto num = m_extractor->add_field(TEST_NUM, "");
+	std::vector<extract_value_t> values;
+	ASSERT_TRUE(m_extractor->get(evt, num, values));
+	ASSERT_EQ(values.size(), 1);
+	ASSERT_EQ(*(uint64_t*) values[0].ptr, 30);
+	ASSERT_EQ(get_str(evt, str), "str-3");
+	ASSERT_EQ(s_extract_calls, 2);
+	ASSERT_EQ(s_last_num_fields, 2);
+}
+
+TEST_F(PluginBatchExtractor, value_layout)
+{
+	auto flag = m_extractor->add_field(TEST_FLAG, "");
+	auto ip = m_extractor->add_field(TEST_IP, "");
+	test_event e;
+
+	// booleans are 32-bit values, as with ss_plugin_bool
+	std::vector<extract_value_t> values;
+	ASSERT_TRUE(m_extractor->get(e.set(5, 0, "batch_test"), flag, values));
+	ASSERT_EQ(values.size(), 1);
+	ASSERT_EQ(values[0].len, sizeof(uint32_t));
+	ASSERT_EQ(*(uint32_t*) values[0].ptr, 1);
+	ASSERT_TRUE(m_extractor->get(e.set(6, 0, "batch_test"), flag, values));
+	ASSERT_EQ(*(uint32_t*) values[0].ptr, 0);
+
+	// addresses are copied as raw bytes in network order
+	ASSERT_TRUE(m_extractor->get(e.set(6, 0, "batch_test"), ip, values));
+	ASSERT_EQ(values.size(), 1);
+	ASSERT_EQ(values[0].len, 4);
+	const uint8_t expected[] = {10, 0, 0, 6};
+	ASSERT_EQ(memcmp(values[0].ptr, expected, sizeof(expected)), 0);
+}
+
+TEST_F(PluginBatchExtractor, arguments)
+{
+	auto idx = m_extractor->add_field(TEST_IDX, "3");
+	auto numeric_key = m_extractor->add_field(TEST_KEY, "42");
+	auto key = m_extractor->add_field(TEST_KEY, "name");
+	ASSERT_NE(idx, numeric_key);
+	ASSERT_NE(numeric_key, key);
+	ASSERT_EQ(m_extractor->add_field(TEST_KEY, "42"), numeric_key);
+
+	// numeric arguments are only indexes for the fields accepting them
+	test_event e;
+	auto evt = e.set(1, 0, "batch_test");
+	ASSERT_EQ(get_str(evt, idx), "3/null");
+	ASSERT_EQ(get_str(evt, numeric_key), "0/42");
+	ASSERT_EQ(get_str(evt, key), "0/name");
+	ASSERT_EQ(s_extract_calls, 1);
+}
+
+TEST_F(PluginBatchExtractor, fallback)
+{
+	ASSERT_EQ(m_extractor->add_field(1000, ""), -1);
+	auto str = m_extractor->add_field(TEST_STR, "");
+
+	test_event e;
+	std::vector<extract_value_t> values;
+	ASSERT_FALSE(m_extractor->get(e.set(1, 0, "batch_test"), -1, values));
+
+	// events of sources the plugin does not extract from
+	ASSERT_FALSE(m_extractor->get(e.set(2, 1, "other"), str, values));
+	ASSERT_FALSE(m_extractor->get(e.set(3, sinsp_no_event_source_idx, nullptr), str, values));
+	ASSERT_EQ(s_extract_calls, 0);
+
+	// events that are not plugin events
+	e.set_type(PPME_SYSCALL_CLOSE_E);
+	ASSERT_FALSE(m_extractor->get(e.set(4, 0, "batch_test"), str, values));
+	ASSERT_EQ(s_extract_calls, 0);
+
+	e.set_type(PPME_PLUGINEVENT_E);
+	ASSERT_EQ(get_str(e.set(5, 0, "batch_test"), str), "str-5");
+	ASSERT_EQ(s_extract_calls, 1);
+}
@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/scap_index.h>
+
+#include <cstdio>
+#include <fstream>
+
+static const std::string s_capture = "falco_test_scap_index.scap";
+
+static void write_u16(std::ofstream& f, uint16_t v) { f.write((const char*) &v, sizeof(v)); }
+static void write_u32(std::ofstream& f, uint32_t v) { f.write((const char*) &v, sizeof(v)); }
+static void write_u64(std::ofstream& f, uint64_t v) { f.write((const char*) &v, sizeof(v)); }
+
+// Writes a minimal uncompressed capture: a section header block, a
+// machine info block, and one event block (40 bytes each) per event
+static void write_capture(const std::vector<std::pair<uint64_t, ppm_event_code>>& events)
+{
+	std::ofstream f(s_capture, std::ios::binary);
+
+	write_u32(f, 0x0A0D0D0A);
+	write_u32(f, 28);
+	write_u32(f, 0x1A2B3C4D);
+	write_u16(f, 1);
+	write_u16(f, 0);
+	write_u64(f, 0);
+	write_u32(f, 28);
+
+	write_u32(f, 0x201);
+	write_u32(f, 12);
+	write_u32(f, 12);
+
+	for (const auto& e : events)
+	{
+		write_u32(f, 0x216);
+		write_u32(f, 40);
+		write_u16(f, 0); // cpuid
+		write_u64(f, e.first); // ts
+		write_u64(f, 100); // tid
+		write_u32(f, 26); // len
+		write_u16(f, e.second); // type
+		write_u32(f, 0); // nparams
+		write_u16(f, 0); // padding
+		write_u32(f, 40);
+	}
+}
+
+TEST(ScapIndex, build_load_and_skip)
+{
+	write_capture({
+		{1000, PPME_SYSCALL_READ_E},
+		{2000, PPME_SYSCALL_CLONE_20_X},
+		{3000, PPME_SYSCALL_READ_E},
+		{4000, PPME_SYSCALL_READ_E},
+	});
+
+	// one event per chunk
+	std::string err;
+	ASSERT_TRUE(scap_index::build(s_capture, 1, 0, err)) << err;
+
+	scap_index index;
+	ASSERT_TRUE(index.load(s_capture, err)) << err;
+	ASSERT_EQ(index.chunks().size(), 4);
+	ASSERT_EQ(index.chunks()[0].start_offset, 40);
+	ASSERT_EQ(index.chunks()[0].end_offset, 80);
+	ASSERT_EQ(index.chunks()[1].min_ts, 2000);
+	ASSERT_EQ(index.chunks()[2].min_tid, 100);
+	ASSERT_TRUE(index.chunks()[3].event_types.contains(PPME_SYSCALL_READ_E));
+
+	// nothing can be skipped without constraints
+	scap_index::query q;
+	ASSERT_TRUE(index.skippable_ranges(q).empty());
+
+	// chunks holding state events are never skipped, and adjacent
+	// skippable chunks are merged
+	q.event_types = {PPME_SYSCALL_OPEN_E};
+	auto ranges = index.skippable_ranges(q);
+	ASSERT_EQ(ranges.size(), 2);
+	ASSERT_EQ(ranges[0], scap_index::range(40, 80));
+	ASSERT_EQ(ranges[1], scap_index::range(120, 200));
+
+	q.event_types = {};
+	q.start_ts = 3500;
+	ranges = index.skippable_ranges(q);
+	ASSERT_EQ(ranges.size(), 2);
+	ASSERT_EQ(ranges[1], scap_index::range(120, 160));
+
+	q.start_ts = 0;
+	q.tids = {1, 200};
+	ASSERT_EQ(index.skippable_ranges(q).size(), 2);
+	q.tids = {100};
+	ASSERT_TRUE(index.skippable_ranges(q).empty());
+
+	// the index becomes stale once the capture changes
+	write_capture({{1000, PPME_SYSCALL_READ_E}});
+	ASSERT_FALSE(index.load(s_capture, err));
+
+	std::remove(scap_index::sidecar_path(s_capture).c_str());
+	ASSERT_FALSE(index.load(s_capture, err));
+	std::remove(s_capture.c_str());
+}
+
+TEST(ScapIndex, state_free_runs)
+{
+	write_capture({
+		{1000, PPME_SYSCALL_CLONE_20_X},
+		{2000, PPME_SYSCALL_READ_E},
+		{3000, PPME_SYSCALL_CLONE_20_X},
+		{4000, PPME_SYSCALL_READ_E},
+		{5000, PPME_SYSCALL_READ_E},
+		{6000, PPME_SYSCALL_READ_E},
+	});
+
+	// the runs of events not updating the thread state get their own
+	// chunks even if the chunks could hold the whole capture
+	std::string err;
+	ASSERT_TRUE(scap_index::build(s_capture, 1024 * 1024, 0, err)) << err;
+	scap_index index;
+	ASSERT_TRUE(index.load(s_capture, err)) << err;
+	ASSERT_EQ(index.chunks().size(), 4);
+
+	scap_index::query q;
+	q.event_types = {PPME_SYSCALL_OPEN_E};
+	auto ranges = index.skippable_ranges(q);
+	ASSERT_EQ(ranges.size(), 2);
+	ASSERT_EQ(ranges[0], scap_index::range(80, 120));
+	ASSERT_EQ(ranges[1], scap_index::range(160, 280));
+
+	// the short runs are merged with the chunk preceding them
+	ASSERT_TRUE(scap_index::build(s_capture, 1024 * 1024, 80, err)) << err;
+	ASSERT_TRUE(index.load(s_capture, err)) << err;
+	ASSERT_EQ(index.chunks().size(), 3);
+	ASSERT_EQ(index.chunks()[0].end_offset, 120);
+	ranges = index.skippable_ranges(q);
+	ASSERT_EQ(ranges.size(), 1);
+	ASSERT_EQ(ranges[0], scap_index::range(160, 280));
+
+	std::remove(scap_index::sidecar_path(s_capture).c_str());
+	std::remove(s_capture.c_str());
+}
+
+TEST(ScapIndex, reject_invalid_captures)
+{
+	std::string err;
+	ASSERT_FALSE(scap_index::build("falco_test_scap_index_missing.scap", 1, 0, err));
+
+	std::ofstream f(s_capture, std::ios::binary);
+	write_u32(f, 0x00088b1f);
+	write_u32(f, 0);
+	f.close();
+	ASSERT_FALSE(scap_index::build(s_capture, 1, 0, err));
+	std::remove(s_capture.c_str());
+}
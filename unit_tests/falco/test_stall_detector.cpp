@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/stall_detector.h>
+
+static constexpr uint64_t s_ms = 1000 * 1000;
+
+TEST(StallDetector, detects_and_accounts_stalls)
+{
+	std::vector<stall_detector::snapshot> logged;
+	stall_detector d(nullptr, 100, 10, 1, [&logged](const stall_detector::snapshot& s)
+	{
+		logged.push_back(s);
+	});
+	auto hb = d.add_heartbeat("syscall");
+
+	uint64_t t = 1000 * 1000 * s_ms;
+	hb->set_event(PPME_SYSCALL_OPEN_E);
+	hb->enter(stall_detector::stage::rules);
+	d.check(t);
+	d.check(t + 50 * s_ms);
+	ASSERT_EQ(d.get_stats().stalls, 0);
+
+	// the stall is counted and logged once
+	d.check(t + 150 * s_ms);
+	d.check(t + 300 * s_ms);
+	ASSERT_EQ(d.get_stats().stalls, 1);
+	ASSERT_EQ(d.get_stats().ongoing, 1);
+	ASSERT_EQ(logged.size(), 1);
+	ASSERT_EQ(logged[0].source, "syscall");
+	ASSERT_EQ(logged[0].current_stage, stall_detector::stage::rules);
+	ASSERT_EQ(logged[0].evt_type, PPME_SYSCALL_OPEN_E);
+
+	// progress ends the stall and records its duration
+	hb->enter(stall_detector::stage::outputs);
+	d.check(t + 400 * s_ms);
+	auto stats = d.get_stats();
+	ASSERT_EQ(stats.ongoing, 0);
+	ASSERT_EQ(stats.completed, 1);
+	ASSERT_EQ(stats.max_ms, 400);
+	for (const auto& b : stats.buckets_le_ms)
+	{
+		ASSERT_EQ(b.second, b.first >= 400 ? 1 : 0);
+	}
+
+	// idle threads are never stalled
+	hb->enter(stall_detector::stage::idle);
+	d.check(t + 500 * s_ms);
+	d.check(t + 5000 * s_ms);
+	ASSERT_EQ(d.get_stats().stalls, 1);
+
+	// a second stall within the same minute is counted but not logged
+	hb->enter(stall_detector::stage::outputs);
+	d.check(t + 5100 * s_ms);
+	d.check(t + 5300 * s_ms);
+	ASSERT_EQ(d.get_stats().stalls, 2);
+	ASSERT_EQ(logged.size(), 1);
+}
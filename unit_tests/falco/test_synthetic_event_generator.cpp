@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <falco/synthetic_event_generator.h>
+
+#include <unordered_map>
+
+static falco_configuration::synthetic_config make_config()
+{
+	falco_configuration::synthetic_config config;
+	config.m_enabled = true;
+	config.m_event_mix = {{"openat", 1}, {"close", 1}};
+	config.m_processes = 4;
+	config.m_fds_per_process = 8;
+	config.m_min_string_len = 16;
+	config.m_max_string_len = 32;
+	config.m_pool_size = 1000;
+	return config;
+}
+
+TEST(SyntheticEventGenerator, unknown_syscall)
+{
+	auto config = make_config();
+	config.m_event_mix = {{"not_a_syscall", 1}};
+	ASSERT_THROW(synthetic_event_generator gen(config), falco_exception);
+}
+
+TEST(SyntheticEventGenerator, generate_events)
+{
+	auto config = make_config();
+	synthetic_event_generator gen(config);
+	ASSERT_EQ(gen.pool_size(), config.m_pool_size);
+
+	sinsp inspector;
+	gen.open(inspector);
+	inspector.start_capture();
+
+	sinsp_evt* evt = nullptr;
+	uint64_t num_evts = 0;
+	uint64_t last_ts = 0;
+	std::unordered_map<std::string, uint64_t> counts;
+	while (inspector.next(&evt) != SCAP_EOF)
+	{
+		if (evt == nullptr)
+		{
+			continue;
+		}
+		num_evts++;
+
+		// events are generated in enter/exit pairs with increasing timestamps
+		ASSERT_GT(evt->get_ts(), last_ts);
+		last_ts = evt->get_ts();
+		counts[evt->get_name()]++;
+
+		// every event belongs to one of the synthetic processes
+		auto tinfo = evt->get_thread_info();
+		ASSERT_NE(tinfo, nullptr);
+		ASSERT_EQ(tinfo->m_comm.rfind("synthetic-", 0), 0);
+
+		if (evt->get_type() == PPME_SYSCALL_OPENAT_2_X)
+		{
+			auto name = evt->get_param_value_str("name");
+			ASSERT_GE(name.size(), config.m_min_string_len);
+			ASSERT_LE(name.size(), config.m_max_string_len);
+		}
+	}
+	inspector.close();
+
+	ASSERT_EQ(num_evts, config.m_pool_size);
+	ASSERT_EQ(counts.size(), 2);
+	ASSERT_EQ(counts["openat"] + counts["close"], num_evts);
+}
+
+TEST(SyntheticEventGenerator, long_strings)
+{
+	// the strings that don't fit in the 16-bit length of the parameters
+	// are truncated instead of producing corrupted events
+	auto config = make_config();
+	config.m_event_mix = {{"openat", 1}};
+	config.m_min_string_len = 70000;
+	config.m_max_string_len = 70000;
+	config.m_pool_size = 10;
+	synthetic_event_generator gen(config);
+
+	sinsp inspector;
+	gen.open(inspector);
+	inspector.start_capture();
+
+	sinsp_evt* evt = nullptr;
+	uint64_t num_openat = 0;
+	while (inspector.next(&evt) != SCAP_EOF)
+	{
+		if (evt != nullptr && evt->get_type() == PPME_SYSCALL_OPENAT_2_X)
+		{
+			num_openat++;
+			ASSERT_EQ(evt->get_param_value_str("name").size(), falco_configuration::synthetic_config::max_string_len);
+		}
+	}
+	inspector.close();
+	ASSERT_GT(num_openat, 0);
+}
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "test_synthetic_events.h"
+
+void add_synthetic_rule(
+	filter_ruleset& r,
+	std::shared_ptr<sinsp_filter_factory> f,
+	uint16_t id,
+	const std::string& name,
+	falco_common::priority_type priority,
+	const std::string& cond)
+{
+	falco_rule rule = {};
+	rule.id = id;
+	rule.name = name;
+	rule.priority = priority;
+	rule.source = falco_common::syscall_source;
+
+	libsinsp::filter::parser parser(cond);
+	std::shared_ptr<libsinsp::filter::ast::expr> ast = parser.parse();
+	sinsp_filter_compiler compiler(f, ast.get());
+	std::shared_ptr<sinsp_filter> filter(compiler.compile());
+
+	r.add(rule, filter, ast);
+	r.enable(name, filter_ruleset::match_type::exact, 0);
+}
+
+falco_configuration::synthetic_config synthetic_test_config(uint32_t pool_size)
+{
+	falco_configuration::synthetic_config config;
+	config.m_enabled = true;
+	config.m_event_mix = {{"openat", 1}, {"close", 1}};
+	config.m_processes = 4;
+	config.m_fds_per_process = 8;
+	config.m_pool_size = pool_size;
+	return config;
+}
+
+uint64_t for_each_synthetic_event(
+	sinsp& inspector,
+	const falco_configuration::synthetic_config& config,
+	const std::function<void(sinsp_evt*)>& fn,
+	uint64_t max_events)
+{
+	synthetic_event_generator gen(config);
+	gen.open(inspector);
+	inspector.start_capture();
+
+	sinsp_evt* evt = nullptr;
+	uint64_t n = 0;
+	while ((max_events == 0 || n < max_events)
+		&& !testing::Test::HasFatalFailure()
+		&& inspector.next(&evt) != SCAP_EOF)
+	{
+		if (evt != nullptr)
+		{
+			fn(evt);
+			n++;
+		}
+	}
+	return n;
+}
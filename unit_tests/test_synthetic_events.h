@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#pragma once
+
+#include <falco/synthetic_event_generator.h>
+#include <engine/filter_ruleset.h>
+
+#include <gtest/gtest.h>
+
+#include <functional>
+
+// Adds a rule with the given condition to a ruleset, and enables it in
+// the ruleset with id 0
+void add_synthetic_rule(
+	filter_ruleset& r,
+	std::shared_ptr<sinsp_filter_factory> f,
+	uint16_t id,
+	const std::string& name,
+	falco_common::priority_type priority,
+	const std::string& cond);
+
+// The synthetic events most tests run on: openat and close events from
+// 4 processes having 8 fds each
+falco_configuration::synthetic_config synthetic_test_config(uint32_t pool_size = 1000);
+
+// Opens the inspector on the events generated with config, and invokes fn
+// on each of them, or on the first max_events ones if it is not zero.
+// Stops at the first fatal failure of fn. Returns the number of events.
+uint64_t for_each_synthetic_event(
+	sinsp& inspector,
+	const falco_configuration::synthetic_config& config,
+	const std::function<void(sinsp_evt*)>& fn,
+	uint64_t max_events = 0);
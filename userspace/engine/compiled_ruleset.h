@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#pragma once
+
+#include <libsinsp/sinsp.h>
+#include <libsinsp/filter.h>
+#include <libsinsp/filter/ast.h>
+#include <libsinsp/event.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+	Interface between the engine and the rulesets compiled to C++ by
+	ruleset_codegen. A compiled ruleset is a shared library exporting the
+	FALCO_COMPILED_RULESET_SYMBOL function, which returns the compiled
+	conditions of the rules of an event source, or nullptr if it has none.
+
+	Each compiled condition is identified by the name of its rule and by
+	the hash of the condition it was generated from, so that the engine
+	only uses the compiled code of the rules whose condition did not change
+	after the code generation. All the rules of a source share a state,
+	created from the filter factory of the source when loading the rules.
+
+	The rest of this file holds the helpers used by the generated code.
+*/
+
+// Bumped every time the interface changes in a non backward compatible way
+#define FALCO_COMPILED_RULESET_ABI_VERSION 1
+
+#define FALCO_COMPILED_RULESET_SYMBOL "falco_get_compiled_ruleset"
+
+struct falco_compiled_rule
+{
+	const char* name;
+	uint64_t condition_hash;
+	bool (*run)(void* state, sinsp_evt* evt);
+};
+
+struct falco_compiled_ruleset
+{
+	uint32_t abi_version;
+	const char* source;
+	uint32_t num_rules;
+	const falco_compiled_rule* rules;
+	// returns nullptr and fills err if the state can't be created, e.g.
+	// because a field is not known by the filter factory
+	void* (*create)(const std::shared_ptr<sinsp_filter_factory>& factory, std::string* err);
+	void (*destroy)(void* state);
+};
+
+typedef const falco_compiled_ruleset* (*falco_get_compiled_ruleset_fn)(const char* source);
+
+namespace falco_compiled
+{
+	// FNV-1a hash of the textual representation of a condition
+	inline uint64_t condition_hash(const libsinsp::filter::ast::expr* condition)
+	{
+		uint64_t h = 0xcbf29ce484222325ULL;
+		for (char c : libsinsp::filter::ast::as_string(condition))
+		{
+			h ^= (uint8_t) c;
+			h *= 0x100000001b3ULL;
+		}
+		return h;
+	}
+
+	// Returns true if v is in the given list, which must be sorted
+	template <size_t N>
+	inline bool in_sorted(std::string_view v, const std::array<std::string_view, N>& list)
+	{
+		return std::binary_search(list.begin(), list.end(), v);
+	}
+
+	/*!
+		\brief A field read by the compiled conditions, whose value is
+		extracted at most once per event and shared by all the rules
+	*/
+	class field
+	{
+	public:
+		enum class kind
+		{
+			string,
+			unsigned_number,
+			signed_number
+		};
+
+		// Returns the kind of the values of a field, or false if the
+		// compiled conditions can't read it natively
+		static bool kind_of(const sinsp_filter_check& check, kind& out)
+		{
+			auto info = check.get_field_info();
+			if (info == nullptr || (info->m_flags & EPF_IS_LIST))
+			{
+				return false;
+			}
+			switch (info->m_type)
+			{
+			case PT_CHARBUF:
+				out = kind::string;
+				return true;
+			case PT_UINT8:
+			case PT_UINT16:
+			case PT_UINT32:
+			case PT_UINT64:
+				out = kind::unsigned_number;
+				return true;
+			case PT_INT8:
+			case PT_INT16:
+			case PT_INT32:
+			case PT_INT64:
+				out = kind::signed_number;
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		bool init(sinsp_filter_factory& factory, const char* name, kind k, std::string* err)
+		{
+			m_check = factory.new_filtercheck(name);
+			kind actual;
+			if (m_check == nullptr
+				|| m_check->parse_field_name(name, true, false) != (int32_t) strlen(name)
+				|| !kind_of(*m_check, actual) || actual != k)
+			{
+				*err = std::string("field ") + name + " is unknown or has a different type";
+				return false;
+			}
+			m_type = m_check->get_field_info()->m_type;
+			return true;
+		}
+
+		inline bool extract(sinsp_evt* evt)
+		{
+			if (evt == m_evt && evt->get_num() == m_num)
+			{
+				return m_valid;
+			}
+			m_evt = evt;
+			m_num = evt->get_num();
+			m_values.clear();
+			m_valid = m_check->extract(evt, m_values, false)
+				&& !m_values.empty() && m_values[0].ptr != nullptr;
+			if (m_valid && m_type != PT_CHARBUF)
+			{
+				read_number(m_values[0]);
+			}
+			return m_valid;
+		}
+
+		// Returns true if the field has a value, which may be empty
+		inline bool exists(sinsp_evt* evt)
+		{
+			extract(evt);
+			return m_valid;
+		}
+
+		inline std::string_view str() const
+		{
+			const auto& v = m_values[0];
+			return std::string_view((const char*) v.ptr, strnlen((const char*) v.ptr, v.len));
+		}
+
+		inline uint64_t u64() const
+		{
+			return m_number.u;
+		}
+
+		inline int64_t i64() const
+		{
+			return m_number.i;
+		}
+
+	private:
+		template <typename T>
+		static inline T read(const extract_value_t& v)
+		{
+			T n = 0;
+			memcpy(&n, v.ptr, std::min<size_t>(sizeof(T), v.len));
+			return n;
+		}
+
+		inline void read_number(const extract_value_t& v)
+		{
+			switch (m_type)
+			{
+			case PT_UINT8: m_number.u = read<uint8_t>(v); break;
+			case PT_UINT16: m_number.u = read<uint16_t>(v); break;
+			case PT_UINT32: m_number.u = read<uint32_t>(v); break;
+			case PT_UINT64: m_number.u = read<uint64_t>(v); break;
+			case PT_INT8: m_number.i = read<int8_t>(v); break;
+			case PT_INT16: m_number.i = read<int16_t>(v); break;
+			case PT_INT32: m_number.i = read<int32_t>(v); break;
+			case PT_INT64: m_number.i = read<int64_t>(v); break;
+			default: break;
+			}
+		}
+
+		std::unique_ptr<sinsp_filter_check> m_check;
+		ppm_param_type m_type = PT_NONE;
+		std::vector<extract_value_t> m_values;
+		union
+		{
+			uint64_t u;
+			int64_t i;
+		} m_number = {0};
+		sinsp_evt* m_evt = nullptr;
+		uint64_t m_num = 0;
+		bool m_valid = false;
+	};
+
+	/*!
+		\brief A part of a compiled condition that can't be compiled to
+		C++, which is evaluated by the interpreter instead
+	*/
+	class interpreted
+	{
+	public:
+		bool init(const std::shared_ptr<sinsp_filter_factory>& factory, const char* condition, std::string* err)
+		{
+			try
+			{
+				sinsp_filter_compiler compiler(factory, condition);
+				m_filter = compiler.compile();
+				return true;
+			}
+			catch (const std::exception& e)
+			{
+				*err = std::string("can't compile ") + condition + ": " + e.what();
+				return false;
+			}
+		}
+
+		inline bool run(sinsp_evt* evt)
+		{
+			return m_filter->run(evt);
+		}
+
+	private:
+		std::unique_ptr<sinsp_filter> m_filter;
+	};
+} // namespace falco_compiled
@@ -18,10 +18,156 @@ limitations under the License.
 #include "evttype_index_ruleset.h"
 
 #include "falco_utils.h"
+#include "filter_details_resolver.h"
+#include "filter_evttype_resolver.h"
 
 #include "logger.h"
+#include "falco_usdt.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace libsinsp::filter;
+
+namespace
+{
+// Computes the values a condition constrains a field to. After visiting a
+// node, constrained tells whether the node can only be true for the
+// values of the field in values.
+struct dispatch_values_visitor : public ast::expr_visitor
+{
+	explicit dispatch_values_visitor(const std::string& field): m_field(field) { }
+
+	bool constrained = false;
+	std::set<std::string> values;
+
+	void visit(ast::and_expr* e) override
+	{
+		bool any = false;
+		std::set<std::string> res;
+		for (auto &c : e->children)
+		{
+			c->accept(this);
+			if (!constrained)
+			{
+				continue;
+			}
+			if (!any)
+			{
+				res = std::move(values);
+				any = true;
+			}
+			else
+			{
+				std::set<std::string> intersect;
+				std::set_intersection(res.begin(), res.end(),
+					values.begin(), values.end(),
+					std::inserter(intersect, intersect.begin()));
+				res = std::move(intersect);
+			}
+		}
+		constrained = any;
+		values = std::move(res);
+	}
+
+	void visit(ast::or_expr* e) override
+	{
+		std::set<std::string> res;
+		for (auto &c : e->children)
+		{
+			c->accept(this);
+			if (!constrained)
+			{
+				values.clear();
+				return;
+			}
+			res.insert(values.begin(), values.end());
+		}
+		constrained = true;
+		values = std::move(res);
+	}
+
+	void visit(ast::not_expr* e) override
+	{
+		unconstrained();
+	}
+
+	void visit(ast::identifier_expr* e) override
+	{
+		unconstrained();
+	}
+
+	void visit(ast::value_expr* e) override
+	{
+		m_operand = { e->value };
+		m_literal_operand = true;
+	}
+
+	void visit(ast::list_expr* e) override
+	{
+		m_operand.clear();
+		m_operand.insert(e->values.begin(), e->values.end());
+		m_literal_operand = true;
+	}
+
+	void visit(ast::unary_check_expr* e) override
+	{
+		unconstrained();
+	}
+
+	void visit(ast::binary_check_expr* e) override
+	{
+		m_field_matches = false;
+		e->left->accept(this);
+		if (!m_field_matches || (e->op != "=" && e->op != "==" && e->op != "in"))
+		{
+			unconstrained();
+			return;
+		}
+		// only literal values can be looked up in the index, and not
+		// the ones of other fields for example
+		m_operand.clear();
+		m_literal_operand = false;
+		e->right->accept(this);
+		if (!m_literal_operand)
+		{
+			unconstrained();
+			return;
+		}
+		constrained = true;
+		values = std::move(m_operand);
+	}
+
+	void visit(ast::field_expr* e) override
+	{
+		auto name = e->field;
+		if (!e->arg.empty())
+		{
+			name += "[" + e->arg + "]";
+		}
+		m_field_matches = name == m_field;
+	}
+
+	void visit(ast::field_transformer_expr* e) override
+	{
+		// transformed values can't be looked up in the index
+		m_field_matches = false;
+	}
+
+private:
+	inline void unconstrained()
+	{
+		constrained = false;
+		values.clear();
+	}
+
+	const std::string& m_field;
+	bool m_field_matches = false;
+	bool m_literal_operand = false;
+	std::set<std::string> m_operand;
+};
+} // namespace
 
 evttype_index_ruleset::evttype_index_ruleset(
 	std::shared_ptr<sinsp_filter_factory> f): m_filter_factory(f)
@@ -54,6 +200,27 @@ void evttype_index_ruleset::ruleset_filters::add_wrapper_to_list(filter_wrapper_
 	}
 }
 
+// Orders rules by priority, and then by the order in which they were defined
+static inline bool priority_before(const falco_rule& a, const falco_rule& b)
+{
+	return a.priority < b.priority || (a.priority == b.priority && a.id < b.id);
+}
+
+void evttype_index_ruleset::ruleset_filters::add_wrapper_to_sorted_list(filter_wrapper_list &wrappers, std::shared_ptr<filter_wrapper> wrap)
+{
+	// This is O(n) but it's also uncommon
+	// (when loading rules only).
+	if(std::find(wrappers.begin(), wrappers.end(), wrap) != wrappers.end())
+	{
+		return;
+	}
+
+	auto pos = std::find_if(wrappers.begin(),
+				wrappers.end(),
+				[&wrap](const std::shared_ptr<filter_wrapper>& w) { return priority_before(wrap->rule, w->rule); });
+	wrappers.insert(pos, wrap);
+}
+
 void evttype_index_ruleset::ruleset_filters::remove_wrapper_from_list(filter_wrapper_list &wrappers, std::shared_ptr<filter_wrapper> wrap)
 {
 	// This is O(n) but it's also uncommon
@@ -73,17 +240,30 @@ void evttype_index_ruleset::ruleset_filters::add_filter(std::shared_ptr<filter_w
 	{
 		// Should run for all event types
 		add_wrapper_to_list(m_filter_all_event_types, wrap);
+		add_wrapper_to_sorted_list(m_priority_all_event_types, wrap);
 	}
 	else
 	{
 		for(auto &etype : wrap->event_codes)
 		{
+			if(wrap->dispatched && etype == ppm_event_code::PPME_PLUGINEVENT_E)
+			{
+				for(const auto &v : wrap->dispatch_values)
+				{
+					add_wrapper_to_list(m_filter_by_dispatch_value[v], wrap);
+					add_wrapper_to_sorted_list(m_priority_by_dispatch_value[v], wrap);
+				}
+				continue;
+			}
+
 			if(m_filter_by_event_type.size() <= etype)
 			{
 				m_filter_by_event_type.resize(etype + 1);
+				m_priority_by_event_type.resize(etype + 1);
 			}
 
 			add_wrapper_to_list(m_filter_by_event_type[etype], wrap);
+			add_wrapper_to_sorted_list(m_priority_by_event_type[etype], wrap);
 		}
 	}
 
@@ -95,14 +275,42 @@ void evttype_index_ruleset::ruleset_filters::remove_filter(std::shared_ptr<filte
 	if(wrap->event_codes.empty())
 	{
 		remove_wrapper_from_list(m_filter_all_event_types, wrap);
+		remove_wrapper_from_list(m_priority_all_event_types, wrap);
 	}
 	else
 	{
 		for(auto &etype : wrap->event_codes)
 		{
+			if(wrap->dispatched && etype == ppm_event_code::PPME_PLUGINEVENT_E)
+			{
+				for(const auto &v : wrap->dispatch_values)
+				{
+					auto it = m_filter_by_dispatch_value.find(v);
+					if(it != m_filter_by_dispatch_value.end())
+					{
+						remove_wrapper_from_list(it->second, wrap);
+						if(it->second.empty())
+						{
+							m_filter_by_dispatch_value.erase(it);
+						}
+					}
+					it = m_priority_by_dispatch_value.find(v);
+					if(it != m_priority_by_dispatch_value.end())
+					{
+						remove_wrapper_from_list(it->second, wrap);
+						if(it->second.empty())
+						{
+							m_priority_by_dispatch_value.erase(it);
+						}
+					}
+				}
+				continue;
+			}
+
 			if( etype < m_filter_by_event_type.size() )
 			{
 				remove_wrapper_from_list(m_filter_by_event_type[etype], wrap);
+				remove_wrapper_from_list(m_priority_by_event_type[etype], wrap);
 			}
 		}
 	}
@@ -115,24 +323,75 @@ uint64_t evttype_index_ruleset::ruleset_filters::num_filters()
 	return m_filters.size();
 }
 
-bool evttype_index_ruleset::ruleset_filters::run(sinsp_evt *evt, falco_rule& match)
+inline bool evttype_index_ruleset::ruleset_filters::run_filter(filter_wrapper& wrap, sinsp_evt *evt, bool profiling, std::atomic<int64_t>* current_rule, eval_monitor* monitor)
 {
-    if(evt->get_type() < m_filter_by_event_type.size())
-    {
-        for(const auto &wrap : m_filter_by_event_type[evt->get_type()])
-        {
-            if(wrap->filter->run(evt))
-            {
-				match = wrap->rule;
-                return true;
-            }
-        }
-    }
+	if(monitor != nullptr)
+	{
+		monitor->on_rule(wrap.monitored_fields);
+	}
+
+	if(current_rule != nullptr)
+	{
+		current_rule->store(wrap.rule.id, std::memory_order_relaxed);
+	}
+
+	FALCO_PROBE2(rule_eval_start, wrap.rule.id, evt->get_type());
+
+	bool res;
+	if(!profiling)
+	{
+		res = wrap.run(evt);
+	}
+	else
+	{
+		auto start = std::chrono::steady_clock::now();
+		res = wrap.run(evt);
+		wrap.eval_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start).count();
+		wrap.evaluations++;
+	}
+
+	FALCO_PROBE3(rule_eval_end, wrap.rule.id, evt->get_type(), res);
+	return res;
+}
+
+const evttype_index_ruleset::filter_wrapper_list* evttype_index_ruleset::ruleset_filters::dispatch_list(const std::string* dispatch_value) const
+{
+	if(dispatch_value == nullptr || m_filter_by_dispatch_value.empty())
+	{
+		return nullptr;
+	}
+	auto it = m_filter_by_dispatch_value.find(*dispatch_value);
+	return it != m_filter_by_dispatch_value.end() ? &it->second : nullptr;
+}
+
+bool evttype_index_ruleset::ruleset_filters::run(sinsp_evt *evt, const std::string* dispatch_value, falco_rule& match, bool profiling, std::atomic<int64_t>* current_rule, eval_monitor* monitor)
+{
+	// the rules indexed by the dispatch field are the ones that would be
+	// in the event type bucket otherwise, so both are evaluated in the
+	// order in which the rules were defined
+	static const filter_wrapper_list empty;
+	const auto& by_type = evt->get_type() < m_filter_by_event_type.size()
+		? m_filter_by_event_type[evt->get_type()]
+		: empty;
+	bool found = visit_by_id(dispatch_list(dispatch_value), by_type, [&](filter_wrapper& wrap)
+	{
+		if(run_filter(wrap, evt, profiling, current_rule, monitor))
+		{
+			match = wrap.rule;
+			return true;
+		}
+		return false;
+	});
+	if(found)
+	{
+		return true;
+	}
 
 	// Finally, try filters that are not specific to an event type.
 	for(const auto &wrap : m_filter_all_event_types)
 	{
-		if(wrap->filter->run(evt))
+		if(run_filter(*wrap, evt, profiling, current_rule, monitor))
 		{
 			match = wrap->rule;
 			return true;
@@ -142,21 +401,23 @@ bool evttype_index_ruleset::ruleset_filters::run(sinsp_evt *evt, falco_rule& mat
 	return false;
 }
 
-bool evttype_index_ruleset::ruleset_filters::run(sinsp_evt *evt, std::vector<falco_rule>& matches)
+bool evttype_index_ruleset::ruleset_filters::run(sinsp_evt *evt, const std::string* dispatch_value, std::vector<falco_rule>& matches, bool profiling, std::atomic<int64_t>* current_rule, eval_monitor* monitor)
 {
 	bool match_found = false;
 
-	if(evt->get_type() < m_filter_by_event_type.size())
+	static const filter_wrapper_list empty;
+	const auto& by_type = evt->get_type() < m_filter_by_event_type.size()
+		? m_filter_by_event_type[evt->get_type()]
+		: empty;
+	visit_by_id(dispatch_list(dispatch_value), by_type, [&](filter_wrapper& wrap)
 	{
-		for(const auto &wrap : m_filter_by_event_type[evt->get_type()])
+		if(run_filter(wrap, evt, profiling, current_rule, monitor))
 		{
-			if(wrap->filter->run(evt))
-			{
-				matches.push_back(wrap->rule);
-				match_found = true;
-			}
+			matches.push_back(wrap.rule);
+			match_found = true;
 		}
-	}
+		return false;
+	});
 
 	if(match_found)
 	{
@@ -166,7 +427,7 @@ bool evttype_index_ruleset::ruleset_filters::run(sinsp_evt *evt, std::vector<fal
 	// Finally, try filters that are not specific to an event type.
 	for(const auto &wrap : m_filter_all_event_types)
 	{
-		if(wrap->filter->run(evt))
+		if(run_filter(*wrap, evt, profiling, current_rule, monitor))
 		{
 			matches.push_back(wrap->rule);
 			match_found = true;
@@ -176,6 +437,111 @@ bool evttype_index_ruleset::ruleset_filters::run(sinsp_evt *evt, std::vector<fal
 	return match_found;
 }
 
+bool evttype_index_ruleset::ruleset_filters::run_by_priority(sinsp_evt *evt, const std::string* dispatch_value, falco_rule& match, bool profiling, std::atomic<int64_t>* current_rule, eval_monitor* monitor, priority_match_stats& stats)
+{
+	// the candidate rules are the same of run(), in up to three lists
+	// each sorted by priority, which are merged while evaluating them
+	// so that the evaluation can stop at the first match
+	const filter_wrapper_list* lists[3];
+	size_t num_lists = 0;
+	if(dispatch_value != nullptr && !m_priority_by_dispatch_value.empty())
+	{
+		auto it = m_priority_by_dispatch_value.find(*dispatch_value);
+		if(it != m_priority_by_dispatch_value.end())
+		{
+			lists[num_lists++] = &it->second;
+		}
+	}
+	if(evt->get_type() < m_priority_by_event_type.size())
+	{
+		lists[num_lists++] = &m_priority_by_event_type[evt->get_type()];
+	}
+	lists[num_lists++] = &m_priority_all_event_types;
+
+	filter_wrapper_list::const_iterator its[3];
+	for(size_t i = 0; i < num_lists; i++)
+	{
+		its[i] = lists[i]->begin();
+		stats.candidates += lists[i]->size();
+	}
+	stats.events++;
+
+	while(true)
+	{
+		size_t best = num_lists;
+		for(size_t i = 0; i < num_lists; i++)
+		{
+			if(its[i] != lists[i]->end()
+			   && (best == num_lists || priority_before((*its[i])->rule, (*its[best])->rule)))
+			{
+				best = i;
+			}
+		}
+		if(best == num_lists)
+		{
+			return false;
+		}
+
+		const auto &wrap = *its[best]++;
+		stats.evaluations++;
+		if(run_filter(*wrap, evt, profiling, current_rule, monitor))
+		{
+			match = wrap->rule;
+			return true;
+		}
+	}
+}
+
+void evttype_index_ruleset::ruleset_filters::extraction_plan(ppm_event_code etype, std::vector<extraction_plan_field>& plan, const std::string* dispatch_value) const
+{
+	plan.clear();
+	std::unordered_map<std::string, size_t> index;
+	size_t pos = 0;
+	auto add_rule = [&](const filter_wrapper& wrap)
+	{
+		for(const auto &f : wrap.fields)
+		{
+			auto it = index.find(f);
+			if(it == index.end())
+			{
+				index[f] = plan.size();
+				plan.push_back({f, pos, 1});
+			}
+			else
+			{
+				plan[it->second].num_rules++;
+			}
+		}
+		pos++;
+		return false;
+	};
+
+	// same order as run()
+	static const filter_wrapper_list empty;
+	const auto& by_type = etype < m_filter_by_event_type.size()
+		? m_filter_by_event_type[etype]
+		: empty;
+	const filter_wrapper_list* dispatched = etype == ppm_event_code::PPME_PLUGINEVENT_E
+		? dispatch_list(dispatch_value)
+		: nullptr;
+	visit_by_id(dispatched, by_type, add_rule);
+	for(const auto &wrap : m_filter_all_event_types)
+	{
+		add_rule(*wrap);
+	}
+}
+
+std::vector<std::string> evttype_index_ruleset::ruleset_filters::dispatch_values() const
+{
+	std::vector<std::string> res;
+	res.reserve(m_filter_by_dispatch_value.size());
+	for(const auto &it : m_filter_by_dispatch_value)
+	{
+		res.push_back(it.first);
+	}
+	return res;
+}
+
 libsinsp::events::set<ppm_sc_code> evttype_index_ruleset::ruleset_filters::sc_codes()
 {
 	libsinsp::events::set<ppm_sc_code> res;
@@ -206,18 +572,43 @@ void evttype_index_ruleset::add(
 		auto wrap = std::make_shared<filter_wrapper>();
 		wrap->rule = rule;
 		wrap->filter = filter;
+		wrap->condition = condition;
 		if(rule.source == falco_common::syscall_source)
 		{
 			wrap->sc_codes = libsinsp::filter::ast::ppm_sc_codes(condition.get());
-			wrap->event_codes = libsinsp::filter::ast::ppm_event_codes(condition.get());
+			wrap->event_codes = filter_evttype_resolver().event_codes(condition.get());
 		}
 		else
 		{
 			wrap->sc_codes = { };
 			wrap->event_codes = { ppm_event_code::PPME_PLUGINEVENT_E };
+			if(m_dispatch_check)
+			{
+				wrap->dispatched = dispatch_values(condition.get(), m_dispatch_field, wrap->dispatch_values);
+			}
 		}
+		wrap->monitored_fields = m_eval_monitor.fields_mask(condition.get());
+		filter_details details;
+		filter_details_resolver().run(condition.get(), details);
+		wrap->fields.assign(details.fields.begin(), details.fields.end());
+		std::sort(wrap->fields.begin(), wrap->fields.end());
 		wrap->event_codes.insert(ppm_event_code::PPME_ASYNCEVENT_E);
+		auto compiled = m_compiled_rules.find(rule.name);
+		if(compiled != m_compiled_rules.end())
+		{
+			if(compiled->second->condition_hash == falco_compiled::condition_hash(condition.get()))
+			{
+				wrap->compiled = compiled->second->run;
+				wrap->compiled_state = m_compiled_state.get();
+				wrap->verify = m_compiled_verify;
+			}
+			else
+			{
+				m_stale_compiled_rules++;
+			}
+		}
 		m_filters.insert(wrap);
+		m_filters_by_name[rule.name].push_back(wrap);
 	}
 	catch (const sinsp_exception& e)
 	{
@@ -225,11 +616,132 @@ void evttype_index_ruleset::add(
 	}
 }
 
+void evttype_index_ruleset::compile_filter(filter_wrapper& wrap)
+{
+	// the traced rules are evaluated by the tracer in place of their
+	// filter or compiled condition, so that the other rules are
+	// evaluated exactly as if there was no tracer
+	if(m_rule_tracer && !wrap.traced && m_rule_tracer->traces(wrap.rule.name))
+	{
+		wrap.traced = m_rule_tracer->trace_rule(wrap.rule, wrap.condition.get(), m_filter_factory);
+		wrap.compiled = &rule_tracer::run;
+		wrap.compiled_state = wrap.traced.get();
+		wrap.verify = false;
+	}
+
+	// the filter of the rules with a compiled condition is only
+	// needed to verify it
+	if(wrap.filter || (wrap.compiled != nullptr && !wrap.verify))
+	{
+		return;
+	}
+
+	sinsp_filter_compiler compiler(m_filter_factory, wrap.condition.get(), m_filter_cache_factory);
+	try
+	{
+		wrap.filter = compiler.compile();
+	}
+	catch (const sinsp_exception& e)
+	{
+		throw falco_exception("Could not compile the condition of rule "
+			+ wrap.rule.name + ": " + e.what());
+	}
+}
+
+void evttype_index_ruleset::set_compile_on_enable(bool enabled)
+{
+	m_compile_on_enable = enabled;
+	if(!enabled)
+	{
+		return;
+	}
+
+	for(const auto &ruleset : m_rulesets)
+	{
+		for(const auto &wrap : ruleset->get_filters())
+		{
+			compile_filter(*wrap);
+		}
+	}
+}
+
 void evttype_index_ruleset::on_loading_complete()
 {
 	print_enabled_rules_falco_logger();
 }
 
+void evttype_index_ruleset::set_filter_cache_factory(std::shared_ptr<sinsp_filter_cache_factory> factory)
+{
+	m_filter_cache_factory = factory;
+}
+
+void evttype_index_ruleset::get_extraction_plan(
+	ppm_event_code etype,
+	std::vector<extraction_plan_field>& plan,
+	uint16_t ruleset_id,
+	const std::string* dispatch_value)
+{
+	if(ruleset_id >= m_rulesets.size() || !m_rulesets[ruleset_id])
+	{
+		plan.clear();
+		return;
+	}
+	m_rulesets[ruleset_id]->extraction_plan(etype, plan, dispatch_value);
+}
+
+void evttype_index_ruleset::set_compiled_ruleset(const falco_compiled_ruleset* compiled, bool verify)
+{
+	m_compiled_rules.clear();
+	m_compiled_state.reset();
+	m_compiled_verify = verify;
+	m_stale_compiled_rules = 0;
+	if(compiled == nullptr)
+	{
+		return;
+	}
+
+	if(compiled->abi_version != FALCO_COMPILED_RULESET_ABI_VERSION)
+	{
+		throw falco_exception("The compiled ruleset has version " + std::to_string(compiled->abi_version)
+			+ " of the interface, but version " + std::to_string(FALCO_COMPILED_RULESET_ABI_VERSION) + " is required");
+	}
+
+	std::string err;
+	void* state = compiled->create(m_filter_factory, &err);
+	if(state == nullptr)
+	{
+		throw falco_exception("Could not initialize the compiled ruleset of the event source "
+			+ std::string(compiled->source) + ": " + err);
+	}
+	m_compiled_state = std::shared_ptr<void>(state, compiled->destroy);
+	for(uint32_t i = 0; i < compiled->num_rules; i++)
+	{
+		m_compiled_rules[compiled->rules[i].name] = &compiled->rules[i];
+	}
+}
+
+void evttype_index_ruleset::get_compiled_stats(compiled_stats& stats)
+{
+	stats.stale_rules += m_stale_compiled_rules;
+	for(const auto &wrap : m_filters)
+	{
+		if(wrap->compiled == nullptr || wrap->traced)
+		{
+			continue;
+		}
+		stats.compiled_rules++;
+		if(wrap->mismatches > 0)
+		{
+			stats.mismatches[wrap->rule.name] += wrap->mismatches;
+		}
+	}
+}
+
+void evttype_index_ruleset::set_rule_tracer(std::shared_ptr<rule_tracer> tracer)
+{
+	m_rule_tracer = tracer;
+}
+
 void evttype_index_ruleset::print_enabled_rules_falco_logger()
 {
 	falco_logger::log(falco_logger::level::DEBUG, "Enabled rules:\n");
@@ -246,6 +758,52 @@ void evttype_index_ruleset::print_enabled_rules_falco_logger()
 		}
 	}
 	falco_logger::log(falco_logger::level::DEBUG, "(" + std::to_string(n) + ") enabled rules in total\n");
+
+	if(m_filter_cache_factory == nullptr || falco_logger::current_level < falco_logger::level::DEBUG)
+	{
+		return;
+	}
+
+	// count the extractions the filter cache can save on the event type
+	// buckets, i.e. the fields read by more than one rule of a bucket,
+	// with one bucket per dispatch value for the plugin events
+	uint64_t shared_fields = 0;
+	uint64_t saved_extractions = 0;
+	std::vector<extraction_plan_field> plan;
+	auto count_shared = [&]()
+	{
+		for (const auto& f : plan)
+		{
+			if (f.num_rules > 1)
+			{
+				shared_fields++;
+				saved_extractions += f.num_rules - 1;
+			}
+		}
+	};
+	for (const auto& ruleset_ptr : m_rulesets)
+	{
+		if (!ruleset_ptr)
+		{
+			continue;
+		}
+		for (const auto& etype : ruleset_ptr->event_codes())
+		{
+			ruleset_ptr->extraction_plan(etype, plan);
+			count_shared();
+			if (etype == ppm_event_code::PPME_PLUGINEVENT_E)
+			{
+				for (const auto& v : ruleset_ptr->dispatch_values())
+				{
+					ruleset_ptr->extraction_plan(etype, plan, &v);
+					count_shared();
+				}
+			}
+		}
+	}
+	falco_logger::log(falco_logger::level::DEBUG, "Extraction plan: " + std::to_string(shared_fields)
+		+ " fields shared by more than one rule of the same event type, up to "
+		+ std::to_string(saved_extractions) + " extractions saved per event type\n");
 }
 
 void evttype_index_ruleset::clear()
@@ -255,6 +813,7 @@ void evttype_index_ruleset::clear()
 		m_rulesets[i] = std::make_shared<ruleset_filters>();
 	}
 	m_filters.clear();
+	m_filters_by_name.clear();
 }
 
 void evttype_index_ruleset::enable(const std::string &pattern, match_type match, uint16_t ruleset_id)
@@ -274,6 +833,30 @@ void evttype_index_ruleset::enable_disable(const std::string &pattern, match_typ
 		m_rulesets.emplace_back(std::make_shared<ruleset_filters>());
 	}
 
+	if(match == match_type::exact && !pattern.empty())
+	{
+		auto it = m_filters_by_name.find(pattern);
+		if(it != m_filters_by_name.end())
+		{
+			for(const auto &wrap : it->second)
+			{
+				if(enabled)
+				{
+					if(m_compile_on_enable)
+					{
+						compile_filter(*wrap);
+					}
+					m_rulesets[ruleset_id]->add_filter(wrap);
+				}
+				else
+				{
+					m_rulesets[ruleset_id]->remove_filter(wrap);
+				}
+			}
+		}
+		return;
+	}
+
 	for(const auto &wrap : m_filters)
 	{
 		bool matches;
@@ -302,6 +885,10 @@ void evttype_index_ruleset::enable_disable(const std::string &pattern, match_typ
 		{
 			if(enabled)
 			{
+				if(m_compile_on_enable)
+				{
+					compile_filter(*wrap);
+				}
 				m_rulesets[ruleset_id]->add_filter(wrap);
 			}
 			else
@@ -341,6 +928,10 @@ void evttype_index_ruleset::enable_disable_tags(const std::set<std::string> &tag
 		{
 			if(enabled)
 			{
+				if(m_compile_on_enable)
+				{
+					compile_filter(*wrap);
+				}
 				m_rulesets[ruleset_id]->add_filter(wrap);
 			}
 			else
@@ -368,7 +959,23 @@ bool evttype_index_ruleset::run(sinsp_evt *evt, falco_rule& match, uint16_t rule
 		return false;
 	}
 
-	return m_rulesets[ruleset_id]->run(evt, match);
+	eval_monitor* monitor = nullptr;
+	if(m_eval_monitor.enabled())
+	{
+		monitor = &m_eval_monitor;
+		monitor->begin_event();
+	}
+
+	bool res = m_rulesets[ruleset_id]->run(evt, extract_dispatch_value(evt), match, m_profiling, m_current_rule, monitor);
+	if(m_current_rule != nullptr)
+	{
+		m_current_rule->store(-1, std::memory_order_relaxed);
+	}
+	if(monitor != nullptr)
+	{
+		monitor->end_event(evt);
+	}
+	return res;
 }
 
 bool evttype_index_ruleset::run(sinsp_evt *evt, std::vector<falco_rule>& matches, uint16_t ruleset_id)
@@ -378,7 +985,56 @@ bool evttype_index_ruleset::run(sinsp_evt *evt, std::vector<falco_rule>& matches
 		return false;
 	}
 
-	return m_rulesets[ruleset_id]->run(evt, matches);
+	eval_monitor* monitor = nullptr;
+	if(m_eval_monitor.enabled())
+	{
+		monitor = &m_eval_monitor;
+		monitor->begin_event();
+	}
+
+	bool res = m_rulesets[ruleset_id]->run(evt, extract_dispatch_value(evt), matches, m_profiling, m_current_rule, monitor);
+	if(m_current_rule != nullptr)
+	{
+		m_current_rule->store(-1, std::memory_order_relaxed);
+	}
+	if(monitor != nullptr)
+	{
+		monitor->end_event(evt);
+	}
+	return res;
+}
+
+bool evttype_index_ruleset::run_by_priority(sinsp_evt *evt, falco_rule& match, uint16_t ruleset_id)
+{
+	if(m_rulesets.size() < (size_t)ruleset_id + 1)
+	{
+		return false;
+	}
+
+	eval_monitor* monitor = nullptr;
+	if(m_eval_monitor.enabled())
+	{
+		monitor = &m_eval_monitor;
+		monitor->begin_event();
+	}
+
+	bool res = m_rulesets[ruleset_id]->run_by_priority(evt, extract_dispatch_value(evt), match, m_profiling, m_current_rule, monitor, m_priority_match_stats);
+	if(m_current_rule != nullptr)
+	{
+		m_current_rule->store(-1, std::memory_order_relaxed);
+	}
+	if(monitor != nullptr)
+	{
+		monitor->end_event(evt);
+	}
+	return res;
+}
+
+void evttype_index_ruleset::get_priority_match_stats(priority_match_stats& stats)
+{
+	stats.events += m_priority_match_stats.events;
+	stats.evaluations += m_priority_match_stats.evaluations;
+	stats.candidates += m_priority_match_stats.candidates;
 }
 
 void evttype_index_ruleset::enabled_evttypes(std::set<uint16_t> &evttypes, uint16_t ruleset_id)
@@ -407,3 +1063,195 @@ libsinsp::events::set<ppm_event_code> evttype_index_ruleset::enabled_event_codes
 	}
 	return m_rulesets[ruleset]->event_codes();
 }
+
+void evttype_index_ruleset::set_profiling(bool enabled)
+{
+	m_profiling = enabled;
+}
+
+void evttype_index_ruleset::set_current_rule_tracker(std::atomic<int64_t>* tracker)
+{
+	m_current_rule = tracker;
+}
+
+void evttype_index_ruleset::get_profile(std::vector<rule_profile>& profile)
+{
+	for(const auto &wrap : m_filters)
+	{
+		if(profile.size() <= wrap->rule.id)
+		{
+			profile.resize(wrap->rule.id + 1);
+		}
+		profile[wrap->rule.id].evaluations += wrap->evaluations;
+		profile[wrap->rule.id].eval_time_ns += wrap->eval_time_ns;
+	}
+}
+
+void evttype_index_ruleset::set_dispatch_field(const std::string& field)
+{
+	m_dispatch_field = field;
+	m_dispatch_check.reset();
+	if(field.empty())
+	{
+		return;
+	}
+
+	auto check = m_filter_factory->new_filtercheck(field.c_str());
+	if(check == nullptr || check->parse_field_name(field.c_str(), true, false) != (int32_t) field.size())
+	{
+		throw falco_exception("Unknown dispatch field: " + field);
+	}
+	auto info = check->get_field_info();
+	if(info == nullptr || info->m_type != PT_CHARBUF || (info->m_flags & EPF_IS_LIST))
+	{
+		throw falco_exception("Dispatch field must be a string field: " + field);
+	}
+	m_dispatch_check = std::move(check);
+}
+
+const std::string* evttype_index_ruleset::extract_dispatch_value(sinsp_evt *evt)
+{
+	if(!m_dispatch_check || evt->get_type() != ppm_event_code::PPME_PLUGINEVENT_E)
+	{
+		return nullptr;
+	}
+
+	m_dispatch_extracted.clear();
+	if(!m_dispatch_check->extract(evt, m_dispatch_extracted) || m_dispatch_extracted.empty())
+	{
+		return nullptr;
+	}
+	const auto& v = m_dispatch_extracted[0];
+	m_dispatch_value.assign((const char*) v.ptr, strnlen((const char*) v.ptr, v.len));
+	return &m_dispatch_value;
+}
+
+bool evttype_index_ruleset::dispatch_values(
+		ast::expr* condition,
+		const std::string& field,
+		std::set<std::string>& values)
+{
+	dispatch_values_visitor v(field);
+	condition->accept(&v);
+	values = std::move(v.values);
+	return v.constrained;
+}
+
+void evttype_index_ruleset::set_eval_thresholds(const eval_thresholds& thresholds)
+{
+	m_eval_monitor.set_thresholds(thresholds, *m_filter_factory);
+	for(const auto &wrap : m_filters)
+	{
+		wrap->monitored_fields = m_eval_monitor.fields_mask(wrap->condition.get());
+	}
+}
+
+bool evttype_index_ruleset::last_slow_evaluation(slow_evaluation& v)
+{
+	return m_eval_monitor.pop_slow_evaluation(v);
+}
+
+void evttype_index_ruleset::eval_monitor::set_thresholds(const eval_thresholds& thresholds, sinsp_filter_factory& factory)
+{
+	m_fields.clear();
+	m_budget_ns = thresholds.event_budget_ns;
+	m_slow = false;
+	for(const auto &l : thresholds.max_field_lengths)
+	{
+		auto check = factory.new_filtercheck(l.first.c_str());
+		if(check == nullptr || check->parse_field_name(l.first.c_str(), true, false) != (int32_t) l.first.size())
+		{
+			// the field belongs to another source
+			continue;
+		}
+		if(m_fields.size() == 64)
+		{
+			throw falco_exception("Too many fields with a maximum length, at most 64 are supported");
+		}
+		auto& f = m_fields.emplace_back();
+		f.field = l.first;
+		f.max_length = l.second;
+		f.check = std::move(check);
+	}
+}
+
+uint64_t evttype_index_ruleset::eval_monitor::fields_mask(ast::expr* condition) const
+{
+	if(m_fields.empty() || condition == nullptr)
+	{
+		return 0;
+	}
+
+	filter_details details;
+	filter_details_resolver().run(condition, details);
+	uint64_t mask = 0;
+	for(size_t i = 0; i < m_fields.size(); i++)
+	{
+		if(details.fields.find(m_fields[i].field) != details.fields.end())
+		{
+			mask |= (uint64_t) 1 << i;
+		}
+	}
+	return mask;
+}
+
+void evttype_index_ruleset::eval_monitor::begin_event()
+{
+	m_read_fields = 0;
+	m_slow = false;
+	m_start = std::chrono::steady_clock::now();
+}
+
+void evttype_index_ruleset::eval_monitor::end_event(sinsp_evt *evt)
+{
+	uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - m_start).count();
+	if(elapsed <= m_budget_ns)
+	{
+		return;
+	}
+
+	m_slow = true;
+	m_slow_evaluation.eval_time_ns = elapsed;
+	m_slow_evaluation.field.clear();
+	m_slow_evaluation.field_length = 0;
+
+	// the fields are only extracted again for the slow events, to tell
+	// which one is the likely cause
+	uint64_t read = m_read_fields;
+	for(size_t i = 0; read != 0; i++, read >>= 1)
+	{
+		if((read & 1) == 0)
+		{
+			continue;
+		}
+
+		// the length of list fields is the one of their longest value
+		size_t len = 0;
+		m_extracted.clear();
+		if(m_fields[i].check->extract(evt, m_extracted))
+		{
+			for(const auto &v : m_extracted)
+			{
+				len = std::max<size_t>(len, v.len);
+			}
+		}
+		if(len > m_fields[i].max_length)
+		{
+			m_slow_evaluation.field = m_fields[i].field;
+			m_slow_evaluation.field_length = len;
+			break;
+		}
+	}
+}
+
+bool evttype_index_ruleset::eval_monitor::pop_slow_evaluation(slow_evaluation& v)
+{
+	if(!m_slow)
+	{
+		return false;
+	}
+	m_slow = false;
+	v = m_slow_evaluation;
+	return true;
+}
@@ -17,20 +17,26 @@ limitations under the License.
 
 #pragma once
 
+#include <chrono>
 #include <string>
 #include <set>
 #include <vector>
 #include <list>
 #include <map>
+#include <unordered_map>
 
 #include "filter_ruleset.h"
+#include "compiled_ruleset.h"
+#include "rule_tracer.h"
 #include <libsinsp/sinsp.h>
 #include <libsinsp/filter.h>
 #include <libsinsp/event.h>
 
 /*!
 	\brief A filter_ruleset that indexes enabled rules by event type,
-	and performs linear search on each event type bucket
+	and performs linear search on each event type bucket. The rules of
+	the plugin event type can be further indexed by the value of a
+	dispatch field (see set_dispatch_field()).
 */
 class evttype_index_ruleset: public filter_ruleset
 {
@@ -47,6 +53,9 @@ public:
 
 	bool run(sinsp_evt *evt, falco_rule& match, uint16_t ruleset_id) override;
 	bool run(sinsp_evt *evt, std::vector<falco_rule>&matches, uint16_t ruleset_id) override;
+	bool run_by_priority(sinsp_evt *evt, falco_rule& match, uint16_t ruleset_id) override;
+
+	void get_priority_match_stats(priority_match_stats& stats) override;
 
 	uint64_t enabled_count(uint16_t ruleset_id) override;
 
@@ -85,6 +94,44 @@ public:
 
 	libsinsp::events::set<ppm_event_code> enabled_event_codes(uint16_t ruleset) override;
 
+	void set_profiling(bool enabled) override;
+
+	void set_current_rule_tracker(std::atomic<int64_t>* tracker) override;
+
+	void get_profile(std::vector<rule_profile>& profile) override;
+
+	void set_dispatch_field(const std::string& field) override;
+
+	void set_eval_thresholds(const eval_thresholds& thresholds) override;
+
+	bool last_slow_evaluation(slow_evaluation& v) override;
+
+	void set_filter_cache_factory(std::shared_ptr<sinsp_filter_cache_factory> factory) override;
+
+	void get_extraction_plan(
+		ppm_event_code etype,
+		std::vector<extraction_plan_field>& plan,
+		uint16_t ruleset_id,
+		const std::string* dispatch_value = nullptr) override;
+
+	void set_compiled_ruleset(const falco_compiled_ruleset* compiled, bool verify) override;
+
+	void get_compiled_stats(compiled_stats& stats) override;
+
+	void set_rule_tracer(std::shared_ptr<rule_tracer> tracer) override;
+
+	void set_compile_on_enable(bool enabled) override;
+
+	/*!
+		\brief Collects the values a condition constrains a field to, with
+		the "=" and "in" operators. Returns false if the condition can be
+		true for other values of the field too.
+	*/
+	static bool dispatch_values(
+		libsinsp::filter::ast::expr* condition,
+		const std::string& field,
+		std::set<std::string>& values);
+
 private:
 
 	// Helper used by enable()/disable()
@@ -105,11 +152,112 @@ private:
 		falco_rule rule;
 		libsinsp::events::set<ppm_sc_code> sc_codes;
 		libsinsp::events::set<ppm_event_code> event_codes;
+		// nullptr until the rule is first enabled, if its compilation
+		// was deferred when adding it
 		std::shared_ptr<sinsp_filter> filter;
+		std::shared_ptr<libsinsp::filter::ast::expr> condition;
+
+		// the values of the dispatch field the rule can match, only
+		// meaningful if dispatched is true
+		bool dispatched = false;
+		std::set<std::string> dispatch_values;
+
+		// bitmask of the monitored fields the rule refers to, see
+		// eval_monitor
+		uint64_t monitored_fields = 0;
+
+		// the fields the condition reads, sorted
+		std::vector<std::string> fields;
+
+		// the compiled condition used in place of the filter, if any,
+		// and the number of times they disagreed when verifying. The
+		// traced rules are evaluated by the tracer the same way.
+		bool (*compiled)(void* state, sinsp_evt* evt) = nullptr;
+		void* compiled_state = nullptr;
+		bool verify = false;
+		uint64_t mismatches = 0;
+		std::shared_ptr<rule_tracer::traced_rule> traced;
+
+		inline bool run(sinsp_evt* evt)
+		{
+			if(compiled == nullptr)
+			{
+				return filter->run(evt);
+			}
+			if(!verify)
+			{
+				return compiled(compiled_state, evt);
+			}
+			bool res = filter->run(evt);
+			if(compiled(compiled_state, evt) != res)
+			{
+				mismatches++;
+			}
+			return res;
+		}
+
+		// only updated when profiling is enabled
+		uint64_t evaluations = 0;
+		uint64_t eval_time_ns = 0;
 	};
 
 	typedef std::list<std::shared_ptr<filter_wrapper>> filter_wrapper_list;
 
+	// Detects the events whose rules take longer than the budget to
+	// evaluate. It never changes how the rules are evaluated. While
+	// evaluating, it only tracks which monitored fields the evaluated
+	// rules read; their lengths are only extracted for the slow events.
+	class eval_monitor
+	{
+	public:
+		void set_thresholds(const eval_thresholds& thresholds, sinsp_filter_factory& factory);
+
+		// Returns the bitmask of the monitored fields a condition refers to
+		uint64_t fields_mask(libsinsp::filter::ast::expr* condition) const;
+
+		inline bool enabled() const
+		{
+			return m_budget_ns > 0;
+		}
+
+		void begin_event();
+
+		inline void on_rule(uint64_t fields_mask)
+		{
+			m_read_fields |= fields_mask;
+		}
+
+		void end_event(sinsp_evt *evt);
+
+		// Returns true and fills v if the last event was slow and this
+		// was not reported yet
+		bool pop_slow_evaluation(slow_evaluation& v);
+
+	private:
+		struct monitored_field
+		{
+			std::string field;
+			size_t max_length = 0;
+			std::unique_ptr<sinsp_filter_check> check;
+		};
+
+		std::vector<monitored_field> m_fields;
+		uint64_t m_budget_ns = 0;
+		std::vector<extract_value_t> m_extracted;
+
+		// state of the current event
+		uint64_t m_read_fields = 0;
+		std::chrono::steady_clock::time_point m_start;
+		bool m_slow = false;
+		slow_evaluation m_slow_evaluation;
+	};
+
+	// Compiles the filter of a rule if it was deferred, throws a
+	// falco_exception on failure. Invoked before enabling a rule, or
+	// later if m_compile_on_enable is false.
+	void compile_filter(filter_wrapper& wrap);
+	bool m_compile_on_enable = true;
+
 	// A group of filters all having the same ruleset
 	class ruleset_filters {
 	public:
@@ -128,19 +276,67 @@ private:
 		}
 
 		// Evaluate an event against the ruleset and return the first rule
-		// that matched.
-		bool run(sinsp_evt *evt, falco_rule& match);
+		// that matched. dispatch_value is the value of the dispatch field
+		// for the event, or nullptr if it has none.
+		bool run(sinsp_evt *evt, const std::string* dispatch_value, falco_rule& match, bool profiling, std::atomic<int64_t>* current_rule, eval_monitor* monitor);
 
 		//  Evaluate an event against the ruleset and return all the
 		//	matching rules.
-		bool run(sinsp_evt *evt, std::vector<falco_rule>& matches);
+		bool run(sinsp_evt *evt, const std::string* dispatch_value, std::vector<falco_rule>& matches, bool profiling, std::atomic<int64_t>* current_rule, eval_monitor* monitor);
+
+		// Evaluate an event against the ruleset in priority order and
+		// return the first rule that matched, see
+		// filter_ruleset::run_by_priority()
+		bool run_by_priority(sinsp_evt *evt, const std::string* dispatch_value, falco_rule& match, bool profiling, std::atomic<int64_t>* current_rule, eval_monitor* monitor, priority_match_stats& stats);
 
 		libsinsp::events::set<ppm_sc_code> sc_codes();
 
 		libsinsp::events::set<ppm_event_code> event_codes();
 
+		// Computes the extraction plan of an event type, see
+		// filter_ruleset::get_extraction_plan()
+		void extraction_plan(ppm_event_code etype, std::vector<extraction_plan_field>& plan, const std::string* dispatch_value = nullptr) const;
+
+		// Returns the values of the dispatch field indexing some rules
+		std::vector<std::string> dispatch_values() const;
+
 	private:
+		// Evaluates the filter of a single rule, accounting its cost
+		// if profiling is enabled, tracking it if current_rule is set,
+		// and the monitored fields it reads if monitor is set
+		static inline bool run_filter(filter_wrapper& wrap, sinsp_evt *evt, bool profiling, std::atomic<int64_t>* current_rule, eval_monitor* monitor);
+
+		// Returns the rules indexed by the given value of the dispatch
+		// field, or nullptr if there are none
+		const filter_wrapper_list* dispatch_list(const std::string* dispatch_value) const;
+
+		// Invokes visit on the rules of two lists merged by rule id, so
+		// that they are visited in the order in which they were defined,
+		// until visit returns true. Returns true if visit did.
+		template<typename Visit>
+		static inline bool visit_by_id(const filter_wrapper_list* a, const filter_wrapper_list& b, Visit visit)
+		{
+			static const filter_wrapper_list empty;
+			if(a == nullptr)
+			{
+				a = &empty;
+			}
+			auto ia = a->begin();
+			auto ib = b.begin();
+			while(ia != a->end() || ib != b.end())
+			{
+				bool take_a = ib == b.end() || (ia != a->end() && (*ia)->rule.id < (*ib)->rule.id);
+				const auto &wrap = take_a ? *ia++ : *ib++;
+				if(visit(*wrap))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
 		void add_wrapper_to_list(filter_wrapper_list &wrappers, std::shared_ptr<filter_wrapper> wrap);
+		void add_wrapper_to_sorted_list(filter_wrapper_list &wrappers, std::shared_ptr<filter_wrapper> wrap);
 		void remove_wrapper_from_list(filter_wrapper_list &wrappers, std::shared_ptr<filter_wrapper> wrap);
 
 		// Vector indexes from event type to a set of filters. There can
@@ -150,6 +346,17 @@ private:
 
 		filter_wrapper_list m_filter_all_event_types;
 
+		// Plugin event filters indexed by the values of the dispatch
+		// field. The ones that don't constrain the field are in
+		// m_filter_by_event_type instead.
+		std::unordered_map<std::string, filter_wrapper_list> m_filter_by_dispatch_value;
+
+		// Same as the above, with each list sorted by priority and then
+		// by rule id, used by run_by_priority()
+		std::vector<filter_wrapper_list> m_priority_by_event_type;
+		filter_wrapper_list m_priority_all_event_types;
+		std::unordered_map<std::string, filter_wrapper_list> m_priority_by_dispatch_value;
+
 		// All filters added. Used to make num_filters() fast.
 		std::set<std::shared_ptr<filter_wrapper>> m_filters;
 	};
@@ -160,8 +367,39 @@ private:
 	// All filters added. The set of enabled filters is held in m_rulesets
 	std::set<std::shared_ptr<filter_wrapper>> m_filters;
 
+	// All filters added, by rule name. Used to make enabling and
+	// disabling rules by exact name fast, which the engine does for
+	// each rule when loading.
+	std::unordered_map<std::string, std::vector<std::shared_ptr<filter_wrapper>>> m_filters_by_name;
+
 	std::shared_ptr<sinsp_filter_factory> m_filter_factory;
+	std::shared_ptr<sinsp_filter_cache_factory> m_filter_cache_factory;
 	std::vector<std::string> m_ruleset_names;
+
+	bool m_profiling = false;
+	priority_match_stats m_priority_match_stats;
+	std::atomic<int64_t>* m_current_rule = nullptr;
+
+	// Secondary index of the plugin events, if m_dispatch_check is set
+	std::string m_dispatch_field;
+	std::unique_ptr<sinsp_filter_check> m_dispatch_check;
+	std::vector<extract_value_t> m_dispatch_extracted;
+	std::string m_dispatch_value;
+
+	// Extracts the value of the dispatch field from the event, and
+	// returns nullptr if the event has none
+	const std::string* extract_dispatch_value(sinsp_evt *evt);
+
+	eval_monitor m_eval_monitor;
+
+	// The compiled conditions of the rules, by rule name, and the state
+	// they share
+	std::unordered_map<std::string, const falco_compiled_rule*> m_compiled_rules;
+	std::shared_ptr<void> m_compiled_state;
+	bool m_compiled_verify = false;
+	uint64_t m_stale_compiled_rules = 0;
+
+	std::shared_ptr<rule_tracer> m_rule_tracer;
 };
 
 class evttype_index_ruleset_factory: public filter_ruleset_factory
@@ -30,7 +30,8 @@ static std::vector<std::string> priority_names = {
 
 static std::vector<std::string> rule_matching_names = {
 	"first",
-	"all"
+	"all",
+	"priority"
 };
 
 bool falco_common::parse_priority(const std::string& v, priority_type& out)
@@ -67,7 +67,11 @@ namespace falco_common
 	enum rule_matching
 	{
 		FIRST = 0,
-		ALL = 1
+		ALL = 1,
+		// like FIRST, but the matching rule is the one with the highest
+		// priority, and the one defined first among those with the same
+		// priority
+		PRIORITY = 2
 	};
 
 	bool parse_rule_matching(const std::string& v, rule_matching& out);
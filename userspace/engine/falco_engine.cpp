@@ -44,6 +44,8 @@ limitations under the License.
 #include "formats.h"
 
 #include "evttype_index_ruleset.h"
+#include "filter_evttype_resolver.h"
+#include "falco_usdt.h"
 
 const std::string falco_engine::s_default_ruleset = "falco-default-ruleset";
 
@@ -200,67 +202,174 @@ std::unique_ptr<load_result> falco_engine::load_rules(const std::string &rules_c
 	// read rules YAML file and collect its definitions
 	if(m_rule_reader->read(cfg, *m_rule_collector))
 	{
-		// compile the definitions (resolve macro/list refs, exceptions, ...)
-		m_last_compile_output = m_rule_compiler->new_compile_output();
-		m_rule_compiler->compile(cfg, *m_rule_collector, *m_last_compile_output);
-
-		// clear the rules known by the engine and each ruleset
-		m_rules.clear();
-		for (auto &src : m_sources)
-		// add rules to each ruleset
+		compile_collected_rules(cfg);
+	}
+
+	if (cfg.res->successful())
+	{
+		m_rule_stats_manager.clear();
+		for (const auto &r : m_rules)
 		{
-			src.ruleset = create_ruleset(src.ruleset_factory);
-			src.ruleset->add_compile_output(*m_last_compile_output,
-							m_min_priority,
-							src.name);
+			m_rule_stats_manager.on_rule_loaded(r);
 		}
+	}
 
-		// add rules to the engine and the rulesets
-		for (const auto& rule : m_last_compile_output->rules)
-		{
-			auto info = m_rule_collector->rules().at(rule.name);
-			if (!info)
-			{
-				// this is just defensive, it should never happen
-				throw falco_exception("can't find internal rule info at name: " + name);
-			}
+	return std::move(cfg.res);
+}
 
-			auto source = find_source(rule.source);
-			auto rule_id = m_rules.insert(rule, rule.name);
-			if (rule_id != rule.id)
-			{
-				throw falco_exception("Incompatible ID for rule: " + rule.name +
-						      " | compiled ID: " + std::to_string(rule.id) +
-						      " | stats_mgr ID: " + std::to_string(rule_id));
-			}
+void falco_engine::stage_rules(const std::string &rules_content, const std::string &name)
+{
+	auto& staged = m_staged_rules.emplace_back();
+	staged.content = rules_content;
+	staged.cfg = std::make_unique<rule_loader::configuration>(staged.content, m_sources, name);
+	staged.cfg->output_extra = m_extra;
+	staged.cfg->replace_output_container_info = m_replace_container_info;
 
-			// By default rules are enabled/disabled for the default ruleset
-			// skip the rule if below the minimum priority
-			if (rule.priority > m_min_priority)
-			{
-				continue;
-			}
-			if(info->enabled)
+	// read rules YAML file and collect its definitions
+	m_rule_reader->read(*staged.cfg, *m_rule_collector);
+}
+
+std::vector<std::unique_ptr<load_result>> falco_engine::compile_staged_rules(
+	const std::function<void(falco_engine&)>& on_loaded)
+{
+	std::vector<std::unique_ptr<load_result>> res;
+	if (m_staged_rules.empty())
+	{
+		return res;
+	}
+
+	bool read_ok = true;
+	std::vector<rule_loader::result*> file_results;
+	for (auto& staged : m_staged_rules)
+	{
+		read_ok = read_ok && staged.cfg->res->successful();
+		file_results.push_back(staged.cfg->res.get());
+	}
+
+	if (read_ok)
+	{
+		// compile everything once, then attribute each error and warning
+		// to the content it occurred in
+		auto& last = m_staged_rules.back();
+		rule_loader::configuration cfg(last.content, m_sources, last.cfg->name);
+		cfg.output_extra = m_extra;
+		cfg.replace_output_container_info = m_replace_container_info;
+		// the filters are only compiled once the selection has been
+		// applied, so that the rules it disables are never compiled
+		compile_collected_rules(cfg, false);
+		cfg.res->move_to(file_results);
+
+		bool successful = true;
+		for (auto r : file_results)
+		{
+			successful = successful && r->successful();
+		}
+		if (successful)
+		{
+			if (on_loaded)
 			{
-				source->ruleset->enable(rule.name, filter_ruleset::match_type::exact, m_default_ruleset_id);
+				on_loaded(*this);
 			}
-			else
+			compile_enabled_filters();
+			m_rule_stats_manager.clear();
+			for (const auto &r : m_rules)
 			{
-				source->ruleset->disable(rule.name, filter_ruleset::match_type::exact, m_default_ruleset_id);
+				m_rule_stats_manager.on_rule_loaded(r);
 			}
 		}
 	}
 
-	if (cfg.res->successful())
+	for (auto& staged : m_staged_rules)
 	{
-		m_rule_stats_manager.clear();
-		for (const auto &r : m_rules)
+		res.push_back(std::move(staged.cfg->res));
+	}
+	m_staged_rules.clear();
+	return res;
+}
+
+void falco_engine::compile_collected_rules(rule_loader::configuration& cfg, bool compile_enabled)
+{
+	// compile the definitions (resolve macro/list refs, exceptions, ...)
+	cfg.lazy_filters = m_lazy_filters;
+	cfg.min_priority = m_min_priority;
+	for (auto &src : m_sources)
+	{
+		// the cache entries refer to the filterchecks of the previous
+		// filters, so they must not survive a recompilation
+		src.filter_cache_factory = m_extraction_cache
+			? std::make_shared<exprstr_sinsp_filter_cache_factory>()
+			: nullptr;
+	}
+	m_last_compile_output = m_rule_compiler->new_compile_output();
+	m_rule_compiler->compile(cfg, *m_rule_collector, *m_last_compile_output);
+
+	// clear the rules known by the engine and each ruleset
+	m_rules.clear();
+	for (auto &src : m_sources)
+	// add rules to each ruleset
+	{
+		src.ruleset = create_ruleset(src.ruleset_factory);
+		if (!src.dispatch_field.empty())
 		{
-			m_rule_stats_manager.on_rule_loaded(r);
+			src.ruleset->set_dispatch_field(src.dispatch_field);
 		}
+		src.ruleset->set_eval_thresholds(m_eval_thresholds);
+		src.ruleset->set_filter_cache_factory(src.filter_cache_factory);
+		src.ruleset->set_compiled_ruleset(src.compiled_ruleset, m_compiled_verify);
+		src.ruleset->set_rule_tracer(m_rule_tracer);
+		src.ruleset->set_compile_on_enable(false);
+		src.ruleset->add_compile_output(*m_last_compile_output,
+						m_min_priority,
+						src.name);
 	}
 
-	return std::move(cfg.res);
+	// add rules to the engine and the rulesets
+	for (const auto& rule : m_last_compile_output->rules)
+	{
+		auto info = m_rule_collector->rules().at(rule.name);
+		if (!info)
+		{
+			// this is just defensive, it should never happen
+			throw falco_exception("can't find internal rule info at name: " + cfg.name);
+		}
+
+		auto source = find_source(rule.source);
+		auto rule_id = m_rules.insert(rule, rule.name);
+		if (rule_id != rule.id)
+		{
+			throw falco_exception("Incompatible ID for rule: " + rule.name +
+					      " | compiled ID: " + std::to_string(rule.id) +
+					      " | stats_mgr ID: " + std::to_string(rule_id));
+		}
+
+		// By default rules are enabled/disabled for the default ruleset
+		// skip the rule if below the minimum priority
+		if (rule.priority > m_min_priority)
+		{
+			continue;
+		}
+		if(info->enabled)
+		{
+			source->ruleset->enable(rule.name, filter_ruleset::match_type::exact, m_default_ruleset_id);
+		}
+		else
+		{
+			source->ruleset->disable(rule.name, filter_ruleset::match_type::exact, m_default_ruleset_id);
+		}
+	}
+
+	if (compile_enabled)
+	{
+		compile_enabled_filters();
+	}
+}
+
+void falco_engine::compile_enabled_filters()
+{
+	for (auto &src : m_sources)
+	{
+		src.ruleset->set_compile_on_enable(true);
+	}
 }
 
 void falco_engine::enable_rule(const std::string &substring, bool enabled, const std::string &ruleset)
@@ -356,6 +465,16 @@ void falco_engine::set_min_priority(falco_common::priority_type priority)
 	m_min_priority = priority;
 }
 
+void falco_engine::set_lazy_filters(bool enabled)
+{
+	m_lazy_filters = enabled;
+}
+
+void falco_engine::set_extraction_cache(bool enabled)
+{
+	m_extraction_cache = enabled;
+}
+
 uint16_t falco_engine::find_ruleset_id(const std::string &ruleset)
 {
 	auto it = m_known_rulesets.lower_bound(ruleset);
@@ -437,6 +556,16 @@ std::unique_ptr<std::vector<falco_engine::rule_result>> falco_engine::process_ev
 			return nullptr;
 		}
 		break;
+	case falco_common::rule_matching::PRIORITY:
+		if (source->m_rules.size() != 1)
+		{
+			source->m_rules.resize(1);
+		}
+		if (!source->ruleset->run_by_priority(ev, source->m_rules[0], ruleset_id))
+		{
+			return nullptr;
+		}
+		break;
 	}
 
 	auto res = std::make_unique<std::vector<falco_engine::rule_result>>();
@@ -451,6 +580,7 @@ std::unique_ptr<std::vector<falco_engine::rule_result>> falco_engine::process_ev
 		rule_result.tags = rule.tags;
 		rule_result.exception_fields = rule.exception_fields;
 		m_rule_stats_manager.on_event(rule);
+		FALCO_PROBE3(rule_match, rule.id, rule.priority, source->name.c_str());
 		res->push_back(rule_result);
 	}
 
@@ -802,7 +932,7 @@ void falco_engine::get_json_evt_types(
 	// not good but it's our best option for now
 	if (source.empty() || source == falco_common::syscall_source)
 	{
-		auto evtcodes = libsinsp::filter::ast::ppm_event_codes(ast);
+		auto evtcodes = filter_evttype_resolver().event_codes(ast);
 		evtcodes.insert(ppm_event_code::PPME_ASYNCEVENT_E);
 		auto syscodes = libsinsp::filter::ast::ppm_sc_codes(ast);
 		auto syscodes_to_evt_names = libsinsp::events::sc_set_to_event_names(syscodes);
@@ -961,6 +1091,44 @@ std::shared_ptr<filter_ruleset> falco_engine::ruleset_for_source(std::size_t sou
 	return source->ruleset;
 }
 
+void falco_engine::set_source_dispatch_field(const std::string& source, const std::string& field)
+{
+	auto src = m_sources.at(source);
+	if(!src)
+	{
+		throw falco_exception("Unknown event source " + source);
+	}
+	if(source == falco_common::syscall_source && !field.empty())
+	{
+		throw falco_exception("Dispatch fields are not supported for the " + source + " source");
+	}
+
+	// validate the field right away with a throwaway ruleset
+	create_ruleset(src->ruleset_factory)->set_dispatch_field(field);
+	src->dispatch_field = field;
+}
+
+void falco_engine::set_eval_thresholds(const filter_ruleset::eval_thresholds& thresholds)
+{
+	m_eval_thresholds = thresholds;
+}
+
+void falco_engine::set_source_compiled_ruleset(const std::string& source, const falco_compiled_ruleset* compiled, bool verify)
+{
+	auto src = m_sources.at(source);
+	if(!src)
+	{
+		throw falco_exception("Unknown event source " + source);
+	}
+	src->compiled_ruleset = compiled;
+	m_compiled_verify = verify;
+}
+
+void falco_engine::set_rule_tracer(std::shared_ptr<rule_tracer> tracer)
+{
+	m_rule_tracer = tracer;
+}
+
 void falco_engine::read_file(const std::string& filename, std::string& contents)
 {
 	std::ifstream is;
@@ -18,9 +18,12 @@ limitations under the License.
 #pragma once
 
 #include <atomic>
+#include <functional>
+#include <list>
 #include <string>
 #include <memory>
 #include <set>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
@@ -34,6 +37,7 @@ limitations under the License.
 #include "falco_source.h"
 #include "falco_load_result.h"
 #include "filter_details_resolver.h"
+#include "rule_tracer.h"
 
 //
 // This class acts as the primary interface between a program and the
@@ -82,6 +86,30 @@ public:
 	//
 	std::unique_ptr<falco::load_result> load_rules(const std::string &rules_content, const std::string &name);
 
+	//
+	// Read the definitions of a rules content without compiling them.
+	// The staged contents are compiled all at once by
+	// compile_staged_rules(), so that loading many rules files compiles
+	// each rule and builds each ruleset only once, whereas calling
+	// load_rules() for each file compiles all the rules read so far
+	// every time. The content is copied.
+	//
+	void stage_rules(const std::string &rules_content, const std::string &name);
+
+	//
+	// Compile all the staged rules contents, and build the rulesets of all
+	// the sources. Returns one result per staged content, in the staging
+	// order, each holding the errors and warnings occurred in that
+	// content. Nothing is compiled if reading any of the contents failed.
+	// If provided, on_loaded is invoked once the rules are loaded
+	// successfully, which is where the rules selection (e.g. with
+	// enable_rule) must be applied so that it happens in the same pass.
+	// With lazy filters, only the rules left enabled after on_loaded
+	// are compiled into filters.
+	//
+	std::vector<std::unique_ptr<falco::load_result>> compile_staged_rules(
+		const std::function<void(falco_engine&)>& on_loaded = nullptr);
+
 	//
 	// Enable/Disable any rules matching the provided substring.
 	// If the substring is "", all rules are enabled/disabled.
@@ -129,6 +157,23 @@ public:
 	// Only load rules having this priority or more severe.
 	void set_min_priority(falco_common::priority_type priority);
 
+	//
+	// If true, the rules loaded afterwards that are disabled or below
+	// the minimum priority are not compiled into filters until they
+	// are first enabled. This saves compile time and memory, but the
+	// errors in the conditions of those rules are only reported when
+	// enabling them, so this should be off when validating rules.
+	//
+	void set_lazy_filters(bool enabled);
+
+	//
+	// If true (the default), the filters of the rules of each source
+	// loaded afterwards share a per-event cache of the extracted
+	// fields and of the comparisons, so that a field referenced by
+	// many rules is extracted at most once per event.
+	//
+	void set_extraction_cache(bool enabled);
+
 	//
 	// Return the ruleset id corresponding to this ruleset name,
 	// creating a new one if necessary. If you provide any ruleset
@@ -164,6 +209,11 @@ public:
 	//
 	const stats_manager& get_rule_stats_manager() const;
 
+	//
+	// Return the id of the ruleset used when none is specified.
+	//
+	inline uint16_t default_ruleset_id() const { return m_default_ruleset_id; }
+
 	//
 	// Set the sampling ratio, which can affect which events are
 	// matched against the set of rules.
@@ -280,6 +330,55 @@ public:
 	std::shared_ptr<filter_ruleset> ruleset_for_source(const std::string& source);
 	std::shared_ptr<filter_ruleset> ruleset_for_source(std::size_t source_idx);
 
+	//
+	// Set a field used by the rulesets of a source to index its rules by
+	// the values they constrain the field to (see
+	// filter_ruleset::set_dispatch_field). This is meant for the plugin
+	// sources, and applies to the rules loaded from now on. Throws a
+	// falco_exception if the source is unknown or the field can't be used.
+	//
+	void set_source_dispatch_field(const std::string& source, const std::string& field);
+
+	//
+	// Set the thresholds above which the rulesets of all the sources
+	// report the evaluation of the rules against an event as slow (see
+	// filter_ruleset::set_eval_thresholds). This applies to the rules
+	// loaded from now on.
+	//
+	void set_eval_thresholds(const filter_ruleset::eval_thresholds& thresholds);
+
+	//
+	// Set the compiled conditions used by the rulesets of a source in
+	// place of the filters of the rules (see
+	// filter_ruleset::set_compiled_ruleset), or nullptr to use the
+	// filters only. The compiled ruleset must outlive the engine. If
+	// verify is true, the filters are evaluated too, and the results are
+	// compared. This applies to the rules loaded from now on. Throws a
+	// falco_exception if the source is unknown.
+	//
+	void set_source_compiled_ruleset(const std::string& source, const falco_compiled_ruleset* compiled, bool verify);
+
+	//
+	// Set the tracer of the evaluations of the rules of all the sources
+	// (see filter_ruleset::set_rule_tracer), or nullptr to disable
+	// tracing. This applies to the rules loaded from now on.
+	//
+	void set_rule_tracer(std::shared_ptr<rule_tracer> tracer);
+
+	inline std::shared_ptr<rule_tracer> get_rule_tracer() const
+	{
+		return m_rule_tracer;
+	}
+
+	//
+	// Return true and fill v if the last event processed for the given
+	// source exceeded the evaluation limits.
+	//
+	inline bool last_slow_evaluation(std::size_t source_idx, filter_ruleset::slow_evaluation& v)
+	{
+		return find_source(source_idx)->ruleset->last_slow_evaluation(v);
+	}
+
 	//
 	// Given an event source and ruleset, fill in a bitset
 	// containing the event types for which this ruleset can run.
@@ -432,9 +531,34 @@ private:
 	uint16_t m_next_ruleset_id;
 	std::map<std::string, uint16_t> m_known_rulesets;
 	falco_common::priority_type m_min_priority;
+	bool m_lazy_filters = false;
+	bool m_extraction_cache = true;
+	filter_ruleset::eval_thresholds m_eval_thresholds;
+	bool m_compiled_verify = false;
+	std::shared_ptr<rule_tracer> m_rule_tracer;
 
 	std::unique_ptr<rule_loader::compile_output> m_last_compile_output;
 
+	// Rules contents read by stage_rules() and not compiled yet. A list
+	// is used because each configuration refers to the content of its
+	// own entry.
+	struct staged_rules
+	{
+		std::string content;
+		std::unique_ptr<rule_loader::configuration> cfg;
+	};
+	std::list<staged_rules> m_staged_rules;
+
+	// Compiles all the definitions collected so far, and rebuilds the
+	// rules known by the engine and the rulesets of all the sources.
+	// If compile_enabled is false, the deferred filters of the enabled
+	// rules are left to compile_enabled_filters().
+	void compile_collected_rules(rule_loader::configuration& cfg, bool compile_enabled = true);
+
+	// Compiles the deferred filters of the rules enabled in the
+	// rulesets of all the sources
+	void compile_enabled_filters();
+
 	//
 	// Here's how the sampling ratio and multiplier influence
 	// whether or not an event is dropped in
@@ -0,0 +1,428 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "falco_engine_c.h"
+#include "falco_engine.h"
+
+#include <libsinsp/sinsp.h>
+#include <libsinsp/filter_check_list.h>
+
+#include <cstring>
+
+namespace
+{
+
+// The fields and the extractor of a caller-defined source. The event being
+// evaluated is published in current_evt, so that the filterchecks can pass
+// it to the extractor.
+struct c_source
+{
+	std::string name;
+	std::vector<falco_engine_c_field_type> types;
+	std::vector<filtercheck_field_info> fields;
+	filter_check_info info;
+	falco_engine_c_extract_fn extract = nullptr;
+	void* user_data = nullptr;
+	const falco_engine_c_event* current_evt = nullptr;
+
+	filter_check_list filterchecks;
+	size_t engine_idx = 0;
+
+	// A plugin event without payload, which carries the timestamp of the
+	// current event through the engine and lets it use the event type index
+	std::vector<uint8_t> evt_buf;
+	sinsp_evt evt;
+	uint64_t num_evts = 0;
+};
+
+class c_source_filtercheck : public sinsp_filter_check
+{
+public:
+	explicit c_source_filtercheck(c_source* src): m_src(src)
+	{
+		m_info = &src->info;
+	}
+
+	std::unique_ptr<sinsp_filter_check> allocate_new() override
+	{
+		return std::make_unique<c_source_filtercheck>(m_src);
+	}
+
+protected:
+	uint8_t* extract_single(sinsp_evt* evt, uint32_t* len, bool sanitize_strings = true) override
+	{
+		if(m_src->current_evt == nullptr)
+		{
+			return nullptr;
+		}
+
+		falco_engine_c_value v = {};
+		if(m_src->extract(m_src->user_data, m_src->current_evt, m_field_id, &v) == 0)
+		{
+			return nullptr;
+		}
+
+		switch(m_src->types[m_field_id])
+		{
+		case FALCO_ENGINE_C_FIELD_STRING:
+			if(v.str == nullptr)
+			{
+				return nullptr;
+			}
+			m_strval = v.str;
+			*len = m_strval.size();
+			return (uint8_t*) m_strval.c_str();
+		case FALCO_ENGINE_C_FIELD_UINT64:
+			m_u64val = v.u64;
+			*len = sizeof(m_u64val);
+			return (uint8_t*) &m_u64val;
+		case FALCO_ENGINE_C_FIELD_BOOL:
+			m_boolval = v.boolean ? 1 : 0;
+			*len = sizeof(m_boolval);
+			return (uint8_t*) &m_boolval;
+		default:
+			return nullptr;
+		}
+	}
+
+private:
+	c_source* m_src;
+	std::string m_strval;
+	uint64_t m_u64val = 0;
+	uint32_t m_boolval = 0;
+};
+
+} // namespace
+
+struct falco_engine_c
+{
+	sinsp inspector;
+	falco_engine engine;
+	std::vector<std::unique_ptr<c_source>> sources;
+	mutable std::string last_error;
+	std::string load_result;
+};
+
+#define C_API_TRY try
+#define C_API_CATCH(e) \
+	catch(const std::exception& ex) \
+	{ \
+		(e)->last_error = ex.what(); \
+		return FALCO_ENGINE_C_ERROR; \
+	} \
+	catch(...) \
+	{ \
+		(e)->last_error = "unknown error"; \
+		return FALCO_ENGINE_C_ERROR; \
+	}
+
+static void init_source_event(c_source& src)
+{
+	// the plugin event has two parameters with 32-bit lengths: the plugin
+	// id, which is left to zero, and an empty payload
+	src.evt_buf.assign(sizeof(scap_evt) + 2 * sizeof(uint32_t) + sizeof(uint32_t), 0);
+	auto hdr = (scap_evt*) src.evt_buf.data();
+	hdr->tid = (uint64_t) -1;
+	hdr->len = (uint32_t) src.evt_buf.size();
+	hdr->type = PPME_PLUGINEVENT_E;
+	hdr->nparams = 2;
+	uint32_t plugin_id_len = sizeof(uint32_t);
+	memcpy(src.evt_buf.data() + sizeof(scap_evt), &plugin_id_len, sizeof(uint32_t));
+	src.evt.init(src.evt_buf.data(), 0);
+}
+
+uint32_t falco_engine_c_api_version(void)
+{
+	return FALCO_ENGINE_C_API_VERSION;
+}
+
+falco_engine_c* falco_engine_c_create(void)
+{
+	try
+	{
+		return new falco_engine_c();
+	}
+	catch(...)
+	{
+		return nullptr;
+	}
+}
+
+void falco_engine_c_destroy(falco_engine_c* engine)
+{
+	delete engine;
+}
+
+const char* falco_engine_c_last_error(const falco_engine_c* engine)
+{
+	return engine->last_error.c_str();
+}
+
+int falco_engine_c_add_source(
+	falco_engine_c* engine,
+	const char* source,
+	const falco_engine_c_field* fields,
+	uint32_t num_fields,
+	falco_engine_c_extract_fn extract,
+	void* user_data,
+	uint32_t* source_idx)
+{
+	C_API_TRY
+	{
+		if(source == nullptr || extract == nullptr || (fields == nullptr && num_fields > 0))
+		{
+			throw falco_exception("source name, fields and extractor are required");
+		}
+
+		auto src = std::make_unique<c_source>();
+		src->name = source;
+		src->extract = extract;
+		src->user_data = user_data;
+		src->fields.resize(num_fields);
+		for(uint32_t i = 0; i < num_fields; i++)
+		{
+			if(fields[i].name == nullptr)
+			{
+				throw falco_exception("field " + std::to_string(i) + " of source " + src->name + " has no name");
+			}
+			auto& f = src->fields[i];
+			f.m_name = fields[i].name;
+			f.m_display = fields[i].name;
+			f.m_description = fields[i].description != nullptr ? fields[i].description : "";
+			f.m_flags = EPF_NONE;
+			switch(fields[i].type)
+			{
+			case FALCO_ENGINE_C_FIELD_STRING:
+				f.m_type = PT_CHARBUF;
+				f.m_print_format = PF_NA;
+				break;
+			case FALCO_ENGINE_C_FIELD_UINT64:
+				f.m_type = PT_UINT64;
+				f.m_print_format = PF_DEC;
+				break;
+			case FALCO_ENGINE_C_FIELD_BOOL:
+				f.m_type = PT_BOOL;
+				f.m_print_format = PF_NA;
+				break;
+			default:
+				throw falco_exception("field " + f.m_name + " has an unknown type");
+			}
+			src->types.push_back(fields[i].type);
+		}
+		src->info.m_name = src->name;
+		src->info.m_desc = "fields of the " + src->name + " source";
+		src->info.m_nfields = (int32_t) src->fields.size();
+		src->info.m_fields = src->fields.data();
+		src->info.m_flags = filter_check_info::FL_NONE;
+
+		src->filterchecks.add_filter_check(std::make_unique<c_source_filtercheck>(src.get()));
+		init_source_event(*src);
+
+		auto filter_factory = std::make_shared<sinsp_filter_factory>(&engine->inspector, src->filterchecks);
+		auto formatter_factory = std::make_shared<sinsp_evt_formatter_factory>(&engine->inspector, src->filterchecks);
+		src->engine_idx = engine->engine.add_source(src->name, filter_factory, formatter_factory);
+		if(source_idx != nullptr)
+		{
+			*source_idx = (uint32_t) engine->sources.size();
+		}
+		engine->sources.push_back(std::move(src));
+		return FALCO_ENGINE_C_OK;
+	}
+	C_API_CATCH(engine)
+}
+
+int falco_engine_c_load_rules(falco_engine_c* engine, const char* content, const char* name)
+{
+	C_API_TRY
+	{
+		if(content == nullptr)
+		{
+			throw falco_exception("rules content is required");
+		}
+
+		std::string rules_content = content;
+		std::string rules_name = name != nullptr ? name : "rules";
+		falco::load_result::rules_contents_t rc = {{rules_name, rules_content}};
+		auto res = engine->engine.load_rules(rules_content, rules_name);
+		engine->load_result = res->as_json(rc).dump();
+		if(!res->successful())
+		{
+			throw falco_exception(res->as_string(true, rc));
+		}
+		return FALCO_ENGINE_C_OK;
+	}
+	C_API_CATCH(engine)
+}
+
+const char* falco_engine_c_load_result(const falco_engine_c* engine)
+{
+	return engine->load_result.c_str();
+}
+
+int falco_engine_c_enable_rules(falco_engine_c* engine, const char* pattern, int enabled)
+{
+	C_API_TRY
+	{
+		if(pattern == nullptr)
+		{
+			throw falco_exception("rule name pattern is required");
+		}
+		engine->engine.enable_rule_wildcard(pattern, enabled != 0);
+		return FALCO_ENGINE_C_OK;
+	}
+	C_API_CATCH(engine)
+}
+
+uint32_t falco_engine_c_num_rules(const falco_engine_c* engine)
+{
+	return (uint32_t) engine->engine.get_rules().size();
+}
+
+const char* falco_engine_c_rule_name(const falco_engine_c* engine, uint32_t rule_id)
+{
+	auto r = engine->engine.get_rules().at(rule_id);
+	return r != nullptr ? r->name.c_str() : nullptr;
+}
+
+const char* falco_engine_c_rule_source(const falco_engine_c* engine, uint32_t rule_id)
+{
+	auto r = engine->engine.get_rules().at(rule_id);
+	return r != nullptr ? r->source.c_str() : nullptr;
+}
+
+uint32_t falco_engine_c_num_enabled_rules(const falco_engine_c* engine, uint32_t source_idx)
+{
+	if(source_idx >= engine->sources.size())
+	{
+		return 0;
+	}
+	auto& e = const_cast<falco_engine&>(engine->engine);
+	auto ruleset = e.ruleset_for_source(engine->sources[source_idx]->engine_idx);
+	return ruleset->enabled_count(engine->engine.default_ruleset_id());
+}
+
+int falco_engine_c_evaluate(
+	falco_engine_c* engine,
+	uint32_t source_idx,
+	const falco_engine_c_event* events,
+	uint32_t num_events,
+	falco_engine_c_match* matches,
+	uint32_t max_matches,
+	uint32_t* num_matches,
+	uint32_t* num_consumed)
+{
+	C_API_TRY
+	{
+		if(source_idx >= engine->sources.size())
+		{
+			throw falco_exception("unknown source index " + std::to_string(source_idx));
+		}
+		if((events == nullptr && num_events > 0) || (matches == nullptr && max_matches > 0)
+			|| num_matches == nullptr || num_consumed == nullptr)
+		{
+			throw falco_exception("events, matches, num_matches and num_consumed are required");
+		}
+
+		auto& src = *engine->sources[source_idx];
+		uint32_t max_per_event = falco_engine_c_num_enabled_rules(engine, source_idx);
+		if(num_events > 0 && max_matches < max_per_event)
+		{
+			throw falco_exception("the match buffer must have room for at least "
+				+ std::to_string(max_per_event) + " matches");
+		}
+
+		auto hdr = (scap_evt*) src.evt_buf.data();
+		uint32_t n = 0;
+		uint32_t i = 0;
+		for(; i < num_events && max_matches - n >= max_per_event; i++)
+		{
+			// a distinct event number for each event avoids reusing values
+			// that filterchecks cached for the previous one
+			hdr->ts = events[i].ts;
+			src.evt.set_num(++src.num_evts);
+			src.current_evt = &events[i];
+			auto res = engine->engine.process_event(src.engine_idx, &src.evt, falco_common::rule_matching::ALL);
+			src.current_evt = nullptr;
+			if(res == nullptr)
+			{
+				continue;
+			}
+
+			const auto& rules = engine->engine.get_rules();
+			for(const auto& r : *res)
+			{
+				auto rule = rules.at(r.rule);
+				matches[n].event_idx = i;
+				matches[n].rule_id = rule != nullptr ? (uint32_t) rule->id : UINT32_MAX;
+				matches[n].priority = (int32_t) r.priority_num;
+				n++;
+			}
+		}
+
+		*num_matches = n;
+		*num_consumed = i;
+		return FALCO_ENGINE_C_OK;
+	}
+	C_API_CATCH(engine)
+}
+
+int falco_engine_c_set_profiling(falco_engine_c* engine, uint32_t source_idx, int enabled)
+{
+	C_API_TRY
+	{
+		if(source_idx >= engine->sources.size())
+		{
+			throw falco_exception("unknown source index " + std::to_string(source_idx));
+		}
+		engine->engine.ruleset_for_source(engine->sources[source_idx]->engine_idx)->set_profiling(enabled != 0);
+		return FALCO_ENGINE_C_OK;
+	}
+	C_API_CATCH(engine)
+}
+
+int falco_engine_c_rule_stats(
+	const falco_engine_c* engine,
+	uint32_t rule_id,
+	falco_engine_c_rule_stats* stats)
+{
+	C_API_TRY
+	{
+		auto rule = engine->engine.get_rules().at(rule_id);
+		if(rule == nullptr || stats == nullptr)
+		{
+			throw falco_exception("unknown rule id " + std::to_string(rule_id));
+		}
+
+		*stats = {};
+		const auto& by_rule = engine->engine.get_rule_stats_manager().get_by_rule_id();
+		if(rule_id < by_rule.size() && by_rule[rule_id] != nullptr)
+		{
+			stats->matches = by_rule[rule_id]->load();
+		}
+
+		auto& e = const_cast<falco_engine&>(engine->engine);
+		std::vector<filter_ruleset::rule_profile> profile;
+		e.ruleset_for_source(rule->source)->get_profile(profile);
+		if(rule_id < profile.size())
+		{
+			stats->evaluations = profile[rule_id].evaluations;
+			stats->eval_time_ns = profile[rule_id].eval_time_ns;
+		}
+		return FALCO_ENGINE_C_OK;
+	}
+	C_API_CATCH(engine)
+}
@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+/*
+	C interface of the rule engine, built as the falco_engine_c shared
+	library. It allows embedding the engine in programs that are not written
+	in C++ and that bring their own events: each event source is described
+	by a list of fields, whose values are extracted by a callback supplied
+	by the caller, and events are evaluated in batches.
+
+	All the strings returned by these functions are owned by the engine, and
+	stay valid until the next call on the same engine handle. None of the
+	functions throws or aborts on errors: they return FALCO_ENGINE_C_ERROR
+	and the error message can be retrieved with falco_engine_c_last_error().
+
+	An engine handle can't be used concurrently, except for
+	falco_engine_c_evaluate(), which can be invoked in parallel as long as
+	each thread evaluates events of a different source.
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bumped every time the interface changes in a non backward compatible way
+#define FALCO_ENGINE_C_API_VERSION 1
+
+#if defined(FALCO_ENGINE_C_BUILD) && defined(__GNUC__)
+#define FALCO_ENGINE_C_API __attribute__((visibility("default")))
+#else
+#define FALCO_ENGINE_C_API
+#endif
+
+#define FALCO_ENGINE_C_OK 0
+#define FALCO_ENGINE_C_ERROR 1
+
+typedef struct falco_engine_c falco_engine_c;
+
+typedef enum falco_engine_c_field_type
+{
+	FALCO_ENGINE_C_FIELD_STRING = 0,
+	FALCO_ENGINE_C_FIELD_UINT64 = 1,
+	FALCO_ENGINE_C_FIELD_BOOL = 2,
+} falco_engine_c_field_type;
+
+// Describes a field that can be used in the conditions and outputs
+// of the rules of a source, e.g. "myapp.user"
+typedef struct falco_engine_c_field
+{
+	const char* name;
+	falco_engine_c_field_type type;
+	const char* description;
+} falco_engine_c_field;
+
+// An event of a caller-defined source. The engine never reads data,
+// which is passed as-is to the field extractor.
+typedef struct falco_engine_c_event
+{
+	uint64_t ts;
+	const void* data;
+	uint64_t datalen;
+} falco_engine_c_event;
+
+// The value of a field, only the member matching the field type is read.
+// Strings must stay valid until the next invocation of the extractor.
+typedef struct falco_engine_c_value
+{
+	const char* str;
+	uint64_t u64;
+	uint8_t boolean;
+} falco_engine_c_value;
+
+// Extracts the field with the given index, in the order in which the fields
+// were passed to falco_engine_c_add_source(). Returns 1 and fills value if
+// the field has a value for the event, and 0 otherwise.
+typedef int (*falco_engine_c_extract_fn)(
+	void* user_data,
+	const falco_engine_c_event* evt,
+	uint32_t field_idx,
+	falco_engine_c_value* value);
+
+// A rule that matched an event of a batch
+typedef struct falco_engine_c_match
+{
+	// index of the event in the evaluated batch
+	uint32_t event_idx;
+	// id of the rule, see falco_engine_c_rule_name()
+	uint32_t rule_id;
+	// one of the priorities of the rules, from 0 (emergency) to 7 (debug)
+	int32_t priority;
+} falco_engine_c_match;
+
+typedef struct falco_engine_c_rule_stats
+{
+	uint64_t matches;
+	// only populated after falco_engine_c_set_profiling() has been
+	// enabled for the source of the rule
+	uint64_t evaluations;
+	uint64_t eval_time_ns;
+} falco_engine_c_rule_stats;
+
+FALCO_ENGINE_C_API uint32_t falco_engine_c_api_version(void);
+
+// Returns NULL if the engine can't be created
+FALCO_ENGINE_C_API falco_engine_c* falco_engine_c_create(void);
+FALCO_ENGINE_C_API void falco_engine_c_destroy(falco_engine_c* engine);
+
+// Returns the message of the last error occurred on the engine handle
+FALCO_ENGINE_C_API const char* falco_engine_c_last_error(const falco_engine_c* engine);
+
+// Adds an event source with its fields. All the sources must be added
+// before loading rules. Returns the index of the source in source_idx.
+FALCO_ENGINE_C_API int falco_engine_c_add_source(
+	falco_engine_c* engine,
+	const char* source,
+	const falco_engine_c_field* fields,
+	uint32_t num_fields,
+	falco_engine_c_extract_fn extract,
+	void* user_data,
+	uint32_t* source_idx);
+
+// Loads rules from an in-memory YAML document, name is used in
+// errors and warnings. The JSON-formatted result of the last load,
+// warnings included, can be read with falco_engine_c_load_result().
+FALCO_ENGINE_C_API int falco_engine_c_load_rules(falco_engine_c* engine, const char* content, const char* name);
+FALCO_ENGINE_C_API const char* falco_engine_c_load_result(const falco_engine_c* engine);
+
+// Enables or disables the rules whose name matches the given pattern,
+// which supports the "*" and "?" wildcards
+FALCO_ENGINE_C_API int falco_engine_c_enable_rules(falco_engine_c* engine, const char* pattern, int enabled);
+
+FALCO_ENGINE_C_API uint32_t falco_engine_c_num_rules(const falco_engine_c* engine);
+
+// Returns NULL if the rule id is not valid
+FALCO_ENGINE_C_API const char* falco_engine_c_rule_name(const falco_engine_c* engine, uint32_t rule_id);
+FALCO_ENGINE_C_API const char* falco_engine_c_rule_source(const falco_engine_c* engine, uint32_t rule_id);
+
+// Returns the number of enabled rules of a source, which is also the
+// maximum number of matches a single event can produce
+FALCO_ENGINE_C_API uint32_t falco_engine_c_num_enabled_rules(const falco_engine_c* engine, uint32_t source_idx);
+
+// Evaluates a batch of events of a source against all the enabled rules,
+// and writes every match into the matches buffer. Evaluation stops early
+// if the buffer may not have room for all the matches of the next event,
+// in which case num_consumed is less than num_events and the caller can
+// invoke this again with the remaining events. The buffer must have room
+// for at least falco_engine_c_num_enabled_rules() matches.
+FALCO_ENGINE_C_API int falco_engine_c_evaluate(
+	falco_engine_c* engine,
+	uint32_t source_idx,
+	const falco_engine_c_event* events,
+	uint32_t num_events,
+	falco_engine_c_match* matches,
+	uint32_t max_matches,
+	uint32_t* num_matches,
+	uint32_t* num_consumed);
+
+// Enables the collection of the per-rule evaluation counters and times
+// of a source, which slightly slows down the evaluation
+FALCO_ENGINE_C_API int falco_engine_c_set_profiling(falco_engine_c* engine, uint32_t source_idx, int enabled);
+
+FALCO_ENGINE_C_API int falco_engine_c_rule_stats(
+	const falco_engine_c* engine,
+	uint32_t rule_id,
+	falco_engine_c_rule_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -76,7 +76,8 @@ static const std::string warning_codes[] = {
 	"LOAD_EXCEPTION_NAME_NOT_UNIQUE",
 	"LOAD_INVALID_MACRO_NAME",
 	"LOAD_INVALID_LIST_NAME",
-	"LOAD_COMPILE_CONDITION"
+	"LOAD_COMPILE_CONDITION",
+	"LOAD_UNSATISFIABLE_CONDITION"
 };
 
 const std::string& falco::load_result::warning_code_str(warning_code wc)
@@ -98,7 +99,8 @@ static const std::string warning_strings[] = {
 	"Multiple exceptions defined with the same name",
 	"Invalid macro name",
 	"Invalid list name",
-	"Warning in rule condition"
+	"Warning in rule condition",
+	"Condition can never match"
 };
 
 const std::string& falco::load_result::warning_str(warning_code wc)
@@ -120,7 +122,8 @@ static const std::string warning_descs[] = {
 	"A rule is defining multiple exceptions with the same name",
 	"A macro is defined with an invalid name",
 	"A list is defined with an invalid name",
-	"A rule condition or output have been parsed with a warning"
+	"A rule condition or output have been parsed with a warning",
+	"A rule condition can not be true for any event type, for example because it requires two different evt.type values at once or it checks an event parameter that no matching event has. The rule will never trigger."
 };
 
 const std::string& falco::load_result::warning_desc(warning_code wc)
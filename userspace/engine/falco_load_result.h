@@ -62,7 +62,8 @@ public:
 		LOAD_EXCEPTION_NAME_NOT_UNIQUE,
 		LOAD_INVALID_MACRO_NAME,
 		LOAD_INVALID_LIST_NAME,
-		LOAD_COMPILE_CONDITION
+		LOAD_COMPILE_CONDITION,
+		LOAD_UNSATISFIABLE_CONDITION
 	};
 
 	virtual ~load_result() = default;
@@ -35,7 +35,10 @@ struct falco_source
 		ruleset(s.ruleset),
 		ruleset_factory(s.ruleset_factory),
 		filter_factory(s.filter_factory),
-		formatter_factory(s.formatter_factory) { };
+		formatter_factory(s.formatter_factory),
+		filter_cache_factory(s.filter_cache_factory),
+		dispatch_field(s.dispatch_field),
+		compiled_ruleset(s.compiled_ruleset) { };
 	falco_source& operator = (const falco_source& s)
 	{
 		name = s.name;
@@ -43,6 +46,9 @@ struct falco_source
 		ruleset_factory = s.ruleset_factory;
 		filter_factory = s.filter_factory;
 		formatter_factory = s.formatter_factory;
+		filter_cache_factory = s.filter_cache_factory;
+		dispatch_field = s.dispatch_field;
+		compiled_ruleset = s.compiled_ruleset;
 		return *this;
 	};
 
@@ -51,6 +57,15 @@ struct falco_source
 	std::shared_ptr<filter_ruleset_factory> ruleset_factory;
 	std::shared_ptr<sinsp_filter_factory> filter_factory;
 	std::shared_ptr<sinsp_evt_formatter_factory> formatter_factory;
+	// Shared by the filters of all the rules of the source, so that the
+	// values of a field are extracted at most once per event. Recreated
+	// every time the rules are compiled, nullptr if caching is disabled.
+	std::shared_ptr<sinsp_filter_cache_factory> filter_cache_factory;
+	// Field used as a secondary index by the rulesets, if not empty
+	std::string dispatch_field;
+	// Compiled conditions used by the rulesets in place of the filters,
+	// if not nullptr
+	const falco_compiled_ruleset* compiled_ruleset = nullptr;
 
 	// Used by the filter_ruleset interface. Filled in when a rule
 	// matches an event.
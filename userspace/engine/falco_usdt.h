@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+/*
+	USDT static tracepoints, available when building with -DUSE_USDT=ON.
+	All the probes belong to the "falco" provider, and can be listed with
+	`bpftrace -l 'usdt:/usr/bin/falco:falco:*'` or `perf list sdt_falco:*`.
+	A probe compiles to a single nop instruction, which is patched only
+	while a tracer is attached, so the probe arguments must be cheap to
+	compute: plain integers and pointers already at hand, never clock reads
+	or string formatting. Tracers compute latencies from pairs of probes.
+	When USDT support is disabled, the probes and their arguments compile
+	to nothing.
+
+	Probes:
+	- event_dequeued(source_idx, evt_type, evt_num): an event was fetched
+	  from the inspector in the event processing loop
+	- rule_eval_start(rule_id, evt_type) and
+	  rule_eval_end(rule_id, evt_type, matched): around the evaluation of
+	  the filter of a rule
+	- rule_match(rule_id, priority, source): a matching rule was returned
+	  by the engine
+	- output_enqueue(type, evt_ts), output_dequeue(type, evt_ts),
+	  output_drop(type, evt_ts): a message entering, leaving, or being
+	  dropped by the outputs queue
+	- output_start(sink, type) and output_end(sink, type): around the
+	  processing of a message by each output channel
+	- metrics_snapshot(source, num_evts): a metrics snapshot was taken
+	- app_start(), app_steps_done(success), app_teardown(),
+	  app_end(restart): the phases of a run of the application, which
+	  restarts by running again from app_start
+*/
+
+#if defined(HAS_USDT)
+
+#include <sys/sdt.h>
+
+#define FALCO_PROBE(name) DTRACE_PROBE(falco, name)
+#define FALCO_PROBE1(name, a1) DTRACE_PROBE1(falco, name, a1)
+#define FALCO_PROBE2(name, a1, a2) DTRACE_PROBE2(falco, name, a1, a2)
+#define FALCO_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(falco, name, a1, a2, a3)
+
+#else
+
+#define FALCO_PROBE(name)
+#define FALCO_PROBE1(name, a1)
+#define FALCO_PROBE2(name, a1, a2)
+#define FALCO_PROBE3(name, a1, a2, a3)
+
+#endif
@@ -28,6 +28,7 @@ limitations under the License.
 #include <cstring>
 #include <fstream>
 #include <iomanip>
+#include <string_view>
 #include <thread>
 
 #define RGX_PROMETHEUS_TIME_DURATION "^((?P<y>[0-9]+)y)?((?P<w>[0-9]+)w)?((?P<d>[0-9]+)d)?((?P<h>[0-9]+)h)?((?P<m>[0-9]+)m)?((?P<s>[0-9]+)s)?((?P<ms>[0-9]+)ms)?$"
@@ -211,44 +212,50 @@ void readfile(const std::string& filename, std::string& data)
 
 bool matches_wildcard(const std::string &pattern, const std::string &s)
 {
-	std::string::size_type star_pos = pattern.find("*");
-	if(star_pos == std::string::npos)
+	// The pattern is made of literal segments separated by stars. The first
+	// segment must be a prefix of s and the last one a suffix, and the ones
+	// in between are matched at their leftmost position, which never
+	// prevents the following ones from matching. This requires no
+	// backtracking, so crafted inputs can't make matching expensive.
+	std::string_view p(pattern);
+	std::string_view str(s);
+	auto first_star = p.find('*');
+	if(first_star == std::string_view::npos)
 	{
 		// regular match (no wildcards)
-		return pattern == s;
+		return p == str;
 	}
 
-	if(star_pos == 0)
+	auto last_star = p.rfind('*');
+	auto prefix = p.substr(0, first_star);
+	auto suffix = p.substr(last_star + 1);
+	if(str.size() < prefix.size() + suffix.size()
+		|| str.substr(0, prefix.size()) != prefix
+		|| str.substr(str.size() - suffix.size()) != suffix)
 	{
-		// wildcard at the beginning "*something*..."
-
-		std::string::size_type next_pattern_start = pattern.find_first_not_of("*");
-		if(next_pattern_start == std::string::npos)
-		{
-			// pattern was just a sequence of stars *, **, ***, ... . This always matches.
-			return true;
-		}
+		return false;
+	}
 
-		std::string next_pattern = pattern.substr(next_pattern_start);
-		std::string to_find = next_pattern.substr(0, next_pattern.find("*"));
-		std::string::size_type lit_pos = s.find(to_find);
-		if(lit_pos == std::string::npos)
+	auto middle = str.substr(prefix.size(), str.size() - prefix.size() - suffix.size());
+	auto pos = first_star + 1;
+	while(pos < last_star)
+	{
+		auto next_star = p.find('*', pos);
+		auto segment = p.substr(pos, next_star - pos);
+		pos = next_star + 1;
+		if(segment.empty())
 		{
-			return false;
+			continue;
 		}
 
-		return matches_wildcard(next_pattern.substr(to_find.size()), s.substr(lit_pos + to_find.size()));
-	} else
-	{
-		// wildcard at the end or in the middle "something*else*..."
-		
-		if(pattern.substr(0, star_pos) != s.substr(0, star_pos))
+		auto found = middle.find(segment);
+		if(found == std::string_view::npos)
 		{
 			return false;
 		}
-
-		return matches_wildcard(pattern.substr(star_pos), s.substr(star_pos));
+		middle = middle.substr(found + segment.size());
 	}
+	return true;
 }
 
 namespace network
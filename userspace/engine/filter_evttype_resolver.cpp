@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "filter_evttype_resolver.h"
+
+#include <cstdlib>
+
+using namespace libsinsp::filter;
+
+static const libsinsp::events::set<ppm_event_code>& all_event_codes()
+{
+	static const auto s_all = libsinsp::events::all_event_set();
+	return s_all;
+}
+
+libsinsp::events::set<ppm_event_code> filter_evttype_resolver::event_codes(ast::expr* filter) const
+{
+	visitor v;
+	filter->accept(&v);
+	return ast::ppm_event_codes(filter).intersect(v.m_may);
+}
+
+bool filter_evttype_resolver::is_universal(const libsinsp::events::set<ppm_event_code>& codes)
+{
+	return all_event_codes().diff(codes).empty();
+}
+
+filter_evttype_resolver::visitor::visitor():
+	m_all(all_event_codes()),
+	m_may(all_event_codes()),
+	m_field_transformed(false)
+{
+}
+
+void filter_evttype_resolver::visitor::unknown()
+{
+	m_may = m_all;
+	m_must.clear();
+}
+
+const libsinsp::events::set<ppm_event_code>& filter_evttype_resolver::visitor::codes_with_param(const std::string& name)
+{
+	// built only once, the event table never changes at runtime
+	static const auto s_by_param = []()
+	{
+		std::unordered_map<std::string, libsinsp::events::set<ppm_event_code>> res;
+		for(const auto& e : all_event_codes())
+		{
+			const auto* info = libsinsp::events::info(e);
+			for(uint32_t i = 0; i < info->nparams; i++)
+			{
+				// the parameters of an enter event are considered available
+				// in its exit event too, and the other way around, because
+				// some versions of libsinsp look them up in the paired event
+				auto pair = (ppm_event_code) (PPME_IS_ENTER(e) ? e + 1 : e - 1);
+				auto& codes = res[info->params[i].name];
+				codes.insert(e);
+				if(all_event_codes().contains(pair))
+				{
+					codes.insert(pair);
+				}
+			}
+		}
+		return res;
+	}();
+	static const libsinsp::events::set<ppm_event_code> s_none;
+
+	auto it = s_by_param.find(name);
+	return it != s_by_param.end() ? it->second : s_none;
+}
+
+libsinsp::events::set<ppm_event_code> filter_evttype_resolver::visitor::codes_with_arg(const std::string& arg)
+{
+	// evt.arg[N] refers to the N-th parameter of the event
+	if(arg.find_first_not_of("0123456789") == std::string::npos)
+	{
+		libsinsp::events::set<ppm_event_code> res;
+		auto idx = std::strtoul(arg.c_str(), nullptr, 10);
+		for(const auto& e : all_event_codes())
+		{
+			auto pair = (ppm_event_code) (PPME_IS_ENTER(e) ? e + 1 : e - 1);
+			if(libsinsp::events::info(e)->nparams > idx
+				|| (all_event_codes().contains(pair) && libsinsp::events::info(pair)->nparams > idx))
+			{
+				res.insert(e);
+			}
+		}
+		return res;
+	}
+	return codes_with_param(arg);
+}
+
+void filter_evttype_resolver::visitor::visit(ast::and_expr* e)
+{
+	auto may = m_all;
+	auto must = m_all;
+	for(auto& c : e->children)
+	{
+		c->accept(this);
+		may = may.intersect(m_may);
+		must = must.intersect(m_must);
+	}
+	m_may = std::move(may);
+	m_must = std::move(must);
+}
+
+void filter_evttype_resolver::visitor::visit(ast::or_expr* e)
+{
+	libsinsp::events::set<ppm_event_code> may;
+	libsinsp::events::set<ppm_event_code> must;
+	for(auto& c : e->children)
+	{
+		c->accept(this);
+		may.insert(m_may.begin(), m_may.end());
+		must.insert(m_must.begin(), m_must.end());
+	}
+	m_may = std::move(may);
+	m_must = std::move(must);
+}
+
+void filter_evttype_resolver::visitor::visit(ast::not_expr* e)
+{
+	e->child->accept(this);
+	auto may = m_all.diff(m_must);
+	m_must = m_all.diff(m_may);
+	m_may = std::move(may);
+}
+
+void filter_evttype_resolver::visitor::visit(ast::identifier_expr* e)
+{
+	// macros are expected to be resolved already
+	unknown();
+}
+
+void filter_evttype_resolver::visitor::visit(ast::value_expr* e)
+{
+	m_values = { e->value };
+}
+
+void filter_evttype_resolver::visitor::visit(ast::list_expr* e)
+{
+	m_values.clear();
+	m_values.insert(e->values.begin(), e->values.end());
+}
+
+void filter_evttype_resolver::visitor::visit(ast::unary_check_expr* e)
+{
+	m_field.clear();
+	e->left->accept(this);
+	if(!m_field_transformed && (m_field == "evt.arg" || m_field == "evt.rawarg") && !m_field_arg.empty())
+	{
+		// a missing parameter makes the "exists" check false as well
+		m_may = codes_with_arg(m_field_arg);
+		m_must.clear();
+		return;
+	}
+	unknown();
+}
+
+void filter_evttype_resolver::visitor::visit(ast::binary_check_expr* e)
+{
+	m_field.clear();
+	e->left->accept(this);
+	if(m_field_transformed)
+	{
+		unknown();
+		return;
+	}
+
+	if((m_field == "evt.arg" || m_field == "evt.rawarg") && !m_field_arg.empty())
+	{
+		// comparisons on a field without a value are always false
+		m_may = codes_with_arg(m_field_arg);
+		m_must.clear();
+		return;
+	}
+
+	bool equal = e->op == "=" || e->op == "==" || e->op == "in";
+	if((!equal && e->op != "!=") || (m_field != "evt.type" && m_field != "evt.dir"))
+	{
+		unknown();
+		return;
+	}
+
+	m_values.clear();
+	e->right->accept(this);
+	libsinsp::events::set<ppm_event_code> codes;
+	if(m_field == "evt.type")
+	{
+		codes = libsinsp::events::names_to_event_set(m_values);
+	}
+	else
+	{
+		for(const auto& v : m_values)
+		{
+			if(v != ">" && v != "<")
+			{
+				continue;
+			}
+			for(const auto& c : m_all)
+			{
+				if((PPME_IS_ENTER(c) != 0) == (v == ">"))
+				{
+					codes.insert(c);
+				}
+			}
+		}
+	}
+
+	// both checks are exact, and always have a value
+	m_may = equal ? codes.intersect(m_all) : m_all.diff(codes);
+	m_must = m_may;
+}
+
+void filter_evttype_resolver::visitor::visit(ast::field_expr* e)
+{
+	m_field_transformed = false;
+	m_field = e->field;
+	m_field_arg = e->arg;
+	// evt.arg.name is equivalent to evt.arg[name]
+	for(const auto& prefix : {"evt.arg.", "evt.rawarg."})
+	{
+		std::string p = prefix;
+		if(m_field.compare(0, p.size(), p) == 0 && m_field.size() > p.size())
+		{
+			m_field_arg = m_field.substr(p.size());
+			m_field = p.substr(0, p.size() - 1);
+		}
+	}
+}
+
+void filter_evttype_resolver::visitor::visit(ast::field_transformer_expr* e)
+{
+	e->value->accept(this);
+	m_field_transformed = true;
+}
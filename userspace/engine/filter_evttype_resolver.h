@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <libsinsp/filter/parser.h>
+#include <libsinsp/events/sinsp_events.h>
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+/*!
+	\brief Helper class for narrowing down the event types for which the
+	filter of a syscall rule can possibly be true, on top of what libsinsp
+	derives from the evt.type checks.
+	For each node of the filter, two sets of event types are computed: the
+	ones for which the node may be true, and the ones for which it's always
+	true. This accounts for the evt.type and evt.dir checks under negations,
+	and for the evt.arg and evt.rawarg fields, which have no value (and thus
+	make their checks false) for the events that lack the given parameter.
+	All the other checks are considered to be possibly true for any type.
+*/
+class filter_evttype_resolver
+{
+public:
+	/*!
+		\brief Returns the event types for which the filter may be true.
+		\param filter The filter AST to be processed.
+	*/
+	libsinsp::events::set<ppm_event_code> event_codes(libsinsp::filter::ast::expr* filter) const;
+
+	/*!
+		\brief Returns true if the given set contains all the event types,
+		meaning that a rule with these types is evaluated for every event.
+	*/
+	static bool is_universal(const libsinsp::events::set<ppm_event_code>& codes);
+
+private:
+	struct visitor : public libsinsp::filter::ast::expr_visitor
+	{
+		visitor();
+		visitor(visitor&&) = default;
+		visitor(const visitor&) = delete;
+
+		void visit(libsinsp::filter::ast::and_expr* e) override;
+		void visit(libsinsp::filter::ast::or_expr* e) override;
+		void visit(libsinsp::filter::ast::not_expr* e) override;
+		void visit(libsinsp::filter::ast::identifier_expr* e) override;
+		void visit(libsinsp::filter::ast::value_expr* e) override;
+		void visit(libsinsp::filter::ast::list_expr* e) override;
+		void visit(libsinsp::filter::ast::unary_check_expr* e) override;
+		void visit(libsinsp::filter::ast::binary_check_expr* e) override;
+		void visit(libsinsp::filter::ast::field_expr* e) override;
+		void visit(libsinsp::filter::ast::field_transformer_expr* e) override;
+
+		void unknown();
+		static const libsinsp::events::set<ppm_event_code>& codes_with_param(const std::string& name);
+		static libsinsp::events::set<ppm_event_code> codes_with_arg(const std::string& arg);
+
+		const libsinsp::events::set<ppm_event_code>& m_all;
+		// the event types for which the last visited node may be true,
+		// and the ones for which it's always true
+		libsinsp::events::set<ppm_event_code> m_may;
+		libsinsp::events::set<ppm_event_code> m_must;
+		// the last visited field, and the values of the last visited operand
+		std::string m_field;
+		std::string m_field_arg;
+		bool m_field_transformed;
+		std::unordered_set<std::string> m_values;
+	};
+};
@@ -21,9 +21,17 @@ limitations under the License.
 #include "rule_loader_compile_output.h"
 #include <libsinsp/filter/ast.h>
 #include <libsinsp/filter.h>
+#include <libsinsp/filter_cache.h>
 #include <libsinsp/event.h>
 #include <libsinsp/events/sinsp_events.h>
 
+#include <atomic>
+#include <map>
+#include <memory>
+
+struct falco_compiled_ruleset;
+class rule_tracer;
+
 /*!
 	\brief Manages a set of rulesets. A ruleset is a set of
 	enabled rules that is able to process events and find matches for those rules.
@@ -60,6 +68,9 @@ public:
 		or do other analysis/indexing of the condition.
 		\param rule The rule to be added
 		\param the filter representing the rule's filtering condition.
+		This is nullptr if the engine deferred its compilation (see
+		falco_engine::set_lazy_filters()), in which case the filter
+		must be compiled from the condition when enabling the rule.
 		\param condition The AST representing the rule's filtering condition
 	*/
 	virtual void add(
@@ -134,6 +145,59 @@ public:
 		std::vector<falco_rule>& matches,
 		uint16_t ruleset_id) = 0;
 
+	/*!
+		\brief Processes an event and finds the matching rule with the
+		highest priority, the one added first among those with the same
+		priority. The default implementation evaluates all the rules and
+		picks the match among the results.
+		\return true if a match is found, false otherwise
+		\param evt The event to be processed
+		\param match If true is returned, this is filled-out with the
+		matching rule
+		\param ruleset_id The id of the ruleset to be used
+	*/
+	virtual bool run_by_priority(
+		sinsp_evt *evt,
+		falco_rule& match,
+		uint16_t ruleset_id)
+	{
+		std::vector<falco_rule> matches;
+		if(!run(evt, matches, ruleset_id))
+		{
+			return false;
+		}
+		auto best = matches.begin();
+		for(auto it = matches.begin(); it != matches.end(); it++)
+		{
+			if(it->priority < best->priority
+			   || (it->priority == best->priority && it->id < best->id))
+			{
+				best = it;
+			}
+		}
+		match = *best;
+		return true;
+	}
+
+	/*!
+		\brief Counts the rule evaluations performed by run_by_priority()
+	*/
+	struct priority_match_stats
+	{
+		uint64_t events = 0;
+		// rules evaluated until the first match
+		uint64_t evaluations = 0;
+		// rules that run() evaluates at most to find all the matches
+		uint64_t candidates = 0;
+	};
+
+	/*!
+		\brief Adds the counters of run_by_priority() to stats. This must
+		not be called concurrently with run_by_priority(). The default
+		implementation does not count anything.
+	*/
+	virtual void get_priority_match_stats(priority_match_stats& stats) { }
+
 	/*!
 		\brief Returns the number of rules enabled in a given ruleset
 		\param ruleset_id The id of the ruleset to be used
@@ -234,6 +298,189 @@ public:
 		const std::set<std::string> &tags,
 		uint16_t ruleset_id) = 0;
 
+	/*!
+		\brief Evaluation cost of a single rule, accounted across all
+		rulesets while profiling is enabled
+	*/
+	struct rule_profile
+	{
+		uint64_t evaluations = 0;
+		uint64_t eval_time_ns = 0;
+	};
+
+	/*!
+		\brief Enables or disables the accounting of the evaluation cost
+		of each rule. This adds a clock read around each filter evaluation
+		and is meant for offline analysis only. The default implementation
+		does not support profiling.
+	*/
+	virtual void set_profiling(bool enabled) { }
+
+	/*!
+		\brief Adds the evaluation cost accounted for each rule to the
+		provided vector, which is indexed by rule id and resized if needed.
+		This must not be called concurrently with run().
+	*/
+	virtual void get_profile(std::vector<rule_profile>& profile) { }
+
+	/*!
+		\brief Sets a tracker in which run() stores the id of the rule
+		whose filter is being evaluated, and -1 once the evaluation is
+		over. This lets a monitor running on another thread tell which rule
+		is taking too long. Passing nullptr disables the tracking. The
+		default implementation does not support tracking.
+	*/
+	virtual void set_current_rule_tracker(std::atomic<int64_t>* tracker) { }
+
+	/*!
+		\brief Sets a field used as a secondary index for the rules of
+		sources whose events all have the same type, such as the plugin
+		ones. Rules whose condition constrains the field to specific values
+		are only evaluated on the events having one of those values, and
+		the field is extracted once per event. An empty field disables the
+		index. This must be called before adding any rule. The default
+		implementation does not support any index. Throws a
+		falco_exception if the field can't be used as an index.
+	*/
+	virtual void set_dispatch_field(const std::string& field) { }
+
+	/*!
+		\brief Thresholds above which the evaluation of the rules against
+		an event is reported as slow, see set_eval_thresholds(). They are
+		only used for reporting: the rules are always all evaluated.
+	*/
+	struct eval_thresholds
+	{
+		// time spent evaluating the rules against an event above which
+		// the event is reported, 0 means never
+		uint64_t event_budget_ns = 0;
+
+		// expected maximum length of the values of each field. For the
+		// events reported as slow, the fields read by the evaluated rules
+		// that are longer are reported too, as the likely cause.
+		std::map<std::string, size_t> max_field_lengths;
+	};
+
+	/*!
+		\brief Describes the slow evaluation of the rules against the last
+		event processed by run()
+	*/
+	struct slow_evaluation
+	{
+		// the time spent evaluating the rules
+		uint64_t eval_time_ns = 0;
+
+		// the first field read by the evaluated rules that was found
+		// longer than its maximum length, if any
+		std::string field;
+		size_t field_length = 0;
+	};
+
+	/*!
+		\brief Sets the thresholds above which the evaluation of the rules
+		is reported. The fields unknown to the source of the ruleset are
+		ignored. This must be called before adding any rule. The default
+		implementation never reports.
+	*/
+	virtual void set_eval_thresholds(const eval_thresholds& thresholds) { }
+
+	/*!
+		\brief Returns true and fills v if the evaluation of the rules
+		against the last event processed by run() was slow, so that the
+		event can be reported. Each slow evaluation is only returned once.
+		The default implementation never reports.
+	*/
+	virtual bool last_slow_evaluation(slow_evaluation& v) { return false; }
+
+	/*!
+		\brief Sets the cache factory used when compiling the filters
+		whose compilation was deferred (see add()), which should be the
+		same used for the filters passed to add(). This must be called
+		before adding any rule. The default implementation ignores it.
+	*/
+	virtual void set_filter_cache_factory(std::shared_ptr<sinsp_filter_cache_factory> factory) { }
+
+	/*!
+		\brief A field read by the enabled rules of an event type
+	*/
+	struct extraction_plan_field
+	{
+		std::string field;
+		// position of the first rule reading the field, in the order
+		// in which the rules are evaluated
+		size_t first_rule = 0;
+		// number of rules reading the field
+		size_t num_rules = 0;
+	};
+
+	/*!
+		\brief Fills plan with the union of the fields read by the rules
+		enabled for the given event type, sorted by the position of the
+		first rule reading each. With a filter cache, every field in the
+		plan is extracted at most once per event, when evaluating that
+		first rule. If dispatch_value is not null, the rules indexed by
+		that value of the dispatch field (see set_dispatch_field()) are
+		included too, otherwise they are excluded. The default
+		implementation returns an empty plan.
+	*/
+	virtual void get_extraction_plan(
+		ppm_event_code etype,
+		std::vector<extraction_plan_field>& plan,
+		uint16_t ruleset_id,
+		const std::string* dispatch_value = nullptr) { plan.clear(); }
+
+	/*!
+		\brief Sets the compiled conditions (see compiled_ruleset.h) to be
+		used in place of the filters of the rules added afterwards. Only
+		the rules whose condition did not change after the code generation
+		use them. If verify is true, both the filter and the compiled
+		condition are evaluated, the result of the filter is used, and the
+		evaluations in which they disagree are counted. This must be called
+		before adding any rule. The default implementation ignores them.
+		Throws a falco_exception if the compiled conditions can't be used
+		with the fields of the source.
+	*/
+	virtual void set_compiled_ruleset(const falco_compiled_ruleset* compiled, bool verify) { }
+
+	/*!
+		\brief Usage of the compiled conditions, see set_compiled_ruleset()
+	*/
+	struct compiled_stats
+	{
+		// rules using a compiled condition
+		uint64_t compiled_rules = 0;
+		// rules with a compiled condition generated from another condition
+		uint64_t stale_rules = 0;
+		// evaluations of each rule in which the compiled condition and the
+		// filter disagreed, only counted when verifying
+		std::map<std::string, uint64_t> mismatches;
+	};
+
+	/*!
+		\brief Adds the usage of the compiled conditions to stats. This
+		must not be called concurrently with run(). The default
+		implementation does not use compiled conditions.
+	*/
+	virtual void get_compiled_stats(compiled_stats& stats) { }
+
+	/*!
+		\brief Sets the tracer that evaluates the rules it traces, see
+		rule_tracer.h. The rules are handed to it when enabled, and this
+		must be called before adding any rule. Passing nullptr disables
+		tracing. The default implementation ignores it.
+	*/
+	virtual void set_rule_tracer(std::shared_ptr<rule_tracer> tracer) { }
+
+	/*!
+		\brief If false, enabling a rule whose filter was deferred (see
+		add()) does not compile it yet. Setting it back to true compiles
+		the filters of the rules enabled in any ruleset meanwhile, so
+		that the rules enabled and then disabled again while applying
+		a selection are never compiled. Throws a falco_exception if a
+		condition can't be compiled. The default implementation ignores it.
+	*/
+	virtual void set_compile_on_enable(bool enabled) { }
+
 private:
 	engine_state_funcs m_engine_state;
 };
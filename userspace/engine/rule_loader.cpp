@@ -311,6 +311,42 @@ void rule_loader::result::add_warning(load_result::warning_code wc, const std::s
 	warnings.push_back(warn);
 }
 
+void rule_loader::result::move_to(const std::vector<result*>& targets)
+{
+	if(targets.empty())
+	{
+		return;
+	}
+
+	auto target_for = [&targets](const context& ctx)
+	{
+		for(auto t : targets)
+		{
+			if(t->name == ctx.name())
+			{
+				return t;
+			}
+		}
+		return targets.back();
+	};
+
+	for(auto& err : errors)
+	{
+		target_for(err.ctx)->add_error(err.ec, err.msg, err.ctx);
+	}
+	for(auto& warn : warnings)
+	{
+		target_for(warn.ctx)->add_warning(warn.wc, warn.msg, warn.ctx);
+	}
+
+	errors.clear();
+	warnings.clear();
+	success = true;
+	res_summary_string.clear();
+	res_verbose_string.clear();
+	res_json = {};
+}
+
 const std::string& rule_loader::result::as_string(bool verbose, const rules_contents_t& contents)
 {
 	if(verbose)
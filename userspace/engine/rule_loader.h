@@ -246,6 +246,13 @@ namespace rule_loader
 		void add_warning(falco::load_result::warning_code ec,
 				 const std::string& msg,
 				 const context& ctx);
+
+		/*!
+			\brief Moves each error and warning to the result among
+			targets that has the name of the content it occurred in,
+			or to the last one if there is none
+		*/
+		void move_to(const std::vector<result*>& targets);
 	protected:
 
 		const std::string& as_summary_string();
@@ -281,6 +288,12 @@ namespace rule_loader
 		std::string output_extra;
 		bool replace_output_container_info = false;
 
+		// if true, the filters of the rules that are disabled or below
+		// min_priority are not compiled, and are left for the ruleset
+		// to compile when the rules are first enabled
+		bool lazy_filters = false;
+		falco_common::priority_type min_priority = falco_common::PRIORITY_DEBUG;
+
 		// outputs
 		std::unique_ptr<result> res;
 	};
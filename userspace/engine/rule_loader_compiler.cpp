@@ -22,6 +22,7 @@ limitations under the License.
 
 #include "rule_loader_compiler.h"
 #include "filter_warning_resolver.h"
+#include "filter_evttype_resolver.h"
 
 #define MAX_VISIBILITY		((uint32_t) -1)
 
@@ -414,12 +415,14 @@ bool rule_loader::compiler::compile_condition(
 	const indexed_vector<rule_loader::macro_info>& macros,
 	const std::string& condition,
 	std::shared_ptr<sinsp_filter_factory> filter_factory,
+	std::shared_ptr<sinsp_filter_cache_factory> cache_factory,
 	const rule_loader::context& cond_ctx,
 	const rule_loader::context& parent_ctx,
 	bool allow_unknown_fields,
 	indexed_vector<falco_macro>& macros_out,
 	std::shared_ptr<libsinsp::filter::ast::expr>& ast_out,
-	std::shared_ptr<sinsp_filter>& filter_out) const
+	std::shared_ptr<sinsp_filter>& filter_out,
+	bool build_filter) const
 {
 	std::set<falco::load_result::load_result::warning_code> warn_codes;
 	filter_warning_resolver warn_resolver;
@@ -435,9 +438,15 @@ bool rule_loader::compiler::compile_condition(
 		}
 	}
 
+	if (!build_filter)
+	{
+		filter_out = nullptr;
+		return true;
+	}
+
 	// validate the rule's condition: we compile it into a sinsp filter
 	// on-the-fly and we throw an exception with details on failure
-	sinsp_filter_compiler compiler(filter_factory, ast_out.get());
+	sinsp_filter_compiler compiler(filter_factory, ast_out.get(), cache_factory);
 	try
 	{
 		filter_out = compiler.compile();
@@ -530,18 +539,28 @@ void rule_loader::compiler::compile_rule_infos(
 				r.output_ctx);
 		}
 
+		// the filter of a rule that won't be enabled after loading is
+		// compiled by the ruleset if the rule ever gets enabled. Rules
+		// that can be skipped are always compiled, because whether they
+		// are skipped must be known now.
+		bool defer_filter = cfg.lazy_filters
+			&& !r.skip_if_unknown_filter
+			&& (!r.enabled || r.priority > cfg.min_priority);
+
 		if (!compile_condition(cfg,
 				  macro_resolver,
 				  lists,
 				  col.macros(),
 				  condition,
 				  cfg.sources.at(r.source)->filter_factory,
+				  cfg.sources.at(r.source)->filter_cache_factory,
 				  r.cond_ctx,
 				  r.ctx,
 				  r.skip_if_unknown_filter,
 				  macros,
 				  rule.condition,
-				  rule.filter))
+				  rule.filter,
+				  !defer_filter))
 		{
 			continue;
 		}
@@ -549,8 +568,18 @@ void rule_loader::compiler::compile_rule_infos(
 		// populate set of event types and emit an special warning
 		if(r.source == falco_common::syscall_source)
 		{
-			auto evttypes = libsinsp::filter::ast::ppm_event_codes(rule.condition.get());
-			if ((evttypes.empty() || evttypes.size() > 100) && r.warn_evttypes)
+			auto evttypes = filter_evttype_resolver().event_codes(rule.condition.get());
+			if (evttypes.empty())
+			{
+				// the resolver found no event type for which the
+				// condition can be true, so this is not a performance
+				// issue but a rule that can never trigger
+				cfg.res->add_warning(
+					falco::load_result::load_result::LOAD_UNSATISFIABLE_CONDITION,
+					"Rule condition can never match any event. The rule will never trigger.",
+					r.ctx);
+			}
+			else if (evttypes.size() > 100 && r.warn_evttypes)
 			{
 				cfg.res->add_warning(
 					falco::load_result::load_result::LOAD_NO_EVTTYPE,
@@ -58,7 +58,10 @@ protected:
 
 		returns true if the condition could be compiled, and sets
 		ast_out/filter_out with the compiled filter + ast. Returns false if
-		the condition could not be compiled and should be skipped.
+		the condition could not be compiled and should be skipped. If
+		build_filter is false, only the ast is built and filter_out is
+		set to nullptr. The filters compiled with the same non-null
+		cache_factory share the values extracted from each event.
         */
 	bool compile_condition(
 		configuration& cfg,
@@ -67,12 +70,14 @@ protected:
 		const indexed_vector<rule_loader::macro_info>& macros,
 		const std::string& condition,
 		std::shared_ptr<sinsp_filter_factory> filter_factory,
+		std::shared_ptr<sinsp_filter_cache_factory> cache_factory,
 		const rule_loader::context& cond_ctx,
 		const rule_loader::context& parent_ctx,
 		bool allow_unknown_fields,
 		indexed_vector<falco_macro>& macros_out,
 		std::shared_ptr<libsinsp::filter::ast::expr>& ast_out,
-		std::shared_ptr<sinsp_filter>& filter_out) const;
+		std::shared_ptr<sinsp_filter>& filter_out,
+		bool build_filter = true) const;
 
 private:
 	void compile_list_infos(
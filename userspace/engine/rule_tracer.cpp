@@ -0,0 +1,312 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "rule_tracer.h"
+#include "falco_common.h"
+
+#include <chrono>
+
+using namespace libsinsp::filter;
+
+// A node of a traced condition. The "and", "or" and "not" expressions are
+// evaluated by the tracer, and the rest are predicates compiled on their own.
+struct trace_node
+{
+	enum class kind { AND, OR, NOT, PREDICATE };
+
+	kind type = kind::PREDICATE;
+	std::vector<trace_node> children;
+
+	std::string predicate;
+	std::shared_ptr<sinsp_filter> filter;
+	// the field read by the predicate, if it reads a plain field
+	std::shared_ptr<sinsp_filter_check> value_check;
+};
+
+class rule_tracer::traced_rule
+{
+public:
+	rule_tracer* tracer = nullptr;
+	std::string name;
+	std::string source;
+	std::shared_ptr<sinsp_filter> filter;
+	std::unique_ptr<sinsp_filter_check> proc_check;
+	trace_node root;
+	uint64_t eligible = 0;
+};
+
+static std::unique_ptr<sinsp_filter_check> new_check(sinsp_filter_factory& factory, const std::string& field)
+{
+	auto check = factory.new_filtercheck(field.c_str());
+	if (check == nullptr || check->parse_field_name(field.c_str(), true, false) != (int32_t) field.size())
+	{
+		return nullptr;
+	}
+	return check;
+}
+
+static std::shared_ptr<sinsp_filter> compile(std::shared_ptr<sinsp_filter_factory> factory, ast::expr* e)
+{
+	sinsp_filter_compiler compiler(factory, e);
+	return compiler.compile();
+}
+
+static void build_node(
+	trace_node& node,
+	ast::expr* e,
+	std::shared_ptr<sinsp_filter_factory> factory)
+{
+	const std::vector<std::unique_ptr<ast::expr>>* children = nullptr;
+	if (auto and_e = dynamic_cast<ast::and_expr*>(e))
+	{
+		node.type = trace_node::kind::AND;
+		children = &and_e->children;
+	}
+	else if (auto or_e = dynamic_cast<ast::or_expr*>(e))
+	{
+		node.type = trace_node::kind::OR;
+		children = &or_e->children;
+	}
+	if (children != nullptr)
+	{
+		node.children.resize(children->size());
+		for (size_t i = 0; i < children->size(); i++)
+		{
+			build_node(node.children[i], (*children)[i].get(), factory);
+		}
+		return;
+	}
+
+	auto not_e = dynamic_cast<ast::not_expr*>(e);
+	if (not_e != nullptr)
+	{
+		node.type = trace_node::kind::NOT;
+		node.children.resize(1);
+		build_node(node.children[0], not_e->child.get(), factory);
+		return;
+	}
+
+	node.type = trace_node::kind::PREDICATE;
+	node.predicate = ast::as_string(e);
+	node.filter = compile(factory, e);
+
+	ast::expr* left = nullptr;
+	if (auto b = dynamic_cast<ast::binary_check_expr*>(e))
+	{
+		left = b->left.get();
+	}
+	else if (auto u = dynamic_cast<ast::unary_check_expr*>(e))
+	{
+		left = u->left.get();
+	}
+	auto field = dynamic_cast<ast::field_expr*>(left);
+	if (field != nullptr)
+	{
+		auto name = field->arg.empty() ? field->field : field->field + "[" + field->arg + "]";
+		node.value_check = new_check(*factory, name);
+	}
+}
+
+static std::string truncated(const char* s, size_t max_length)
+{
+	std::string res(s);
+	if (res.size() > max_length)
+	{
+		res.resize(max_length);
+		res += "...";
+	}
+	return res;
+}
+
+static bool run_node(trace_node& node, sinsp_evt* evt, size_t max_value_length, rule_tracer::trace& t)
+{
+	switch (node.type)
+	{
+	case trace_node::kind::AND:
+		for (auto& c : node.children)
+		{
+			if (!run_node(c, evt, max_value_length, t))
+			{
+				return false;
+			}
+		}
+		return true;
+	case trace_node::kind::OR:
+		for (auto& c : node.children)
+		{
+			if (run_node(c, evt, max_value_length, t))
+			{
+				return true;
+			}
+		}
+		return false;
+	case trace_node::kind::NOT:
+		return !run_node(node.children[0], evt, max_value_length, t);
+	default:
+		break;
+	}
+
+	rule_tracer::step s;
+	s.predicate = node.predicate;
+	auto start = std::chrono::steady_clock::now();
+	s.result = node.filter->run(evt);
+	s.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	if (node.value_check != nullptr)
+	{
+		auto v = node.value_check->tostring(evt);
+		if (v != nullptr)
+		{
+			s.values.push_back(truncated(v, max_value_length));
+		}
+	}
+	t.steps.push_back(std::move(s));
+	return t.steps.back().result;
+}
+
+rule_tracer::rule_tracer(const config& c): m_config(c)
+{
+	if (m_config.sampling_ratio == 0)
+	{
+		m_config.sampling_ratio = 1;
+	}
+}
+
+rule_tracer::~rule_tracer() = default;
+
+std::shared_ptr<rule_tracer::traced_rule> rule_tracer::trace_rule(
+	const falco_rule& rule,
+	ast::expr* condition,
+	std::shared_ptr<sinsp_filter_factory> factory)
+{
+	auto res = std::make_shared<traced_rule>();
+	res->tracer = this;
+	res->name = rule.name;
+	res->source = rule.source;
+	try
+	{
+		res->filter = compile(factory, condition);
+		build_node(res->root, condition, factory);
+	}
+	catch (const sinsp_exception& e)
+	{
+		throw falco_exception("Could not trace rule " + rule.name + ": " + e.what());
+	}
+	if (!m_config.processes.empty())
+	{
+		res->proc_check = new_check(*factory, "proc.name");
+	}
+	return res;
+}
+
+bool rule_tracer::run(void* rule, sinsp_evt* evt)
+{
+	auto r = static_cast<traced_rule*>(rule);
+	const auto& cfg = r->tracer->m_config;
+
+	std::string proc_name;
+	if (r->proc_check != nullptr)
+	{
+		auto v = r->proc_check->tostring(evt);
+		if (v == nullptr || cfg.processes.find(v) == cfg.processes.end())
+		{
+			return r->filter->run(evt);
+		}
+		proc_name = v;
+	}
+	if (r->eligible++ % cfg.sampling_ratio != 0)
+	{
+		return r->filter->run(evt);
+	}
+
+	trace t;
+	t.rule = r->name;
+	t.source = r->source;
+	t.evt_num = evt->get_num();
+	t.evt_ts = evt->get_ts();
+	t.evt_type = evt->get_name();
+	t.proc_name = std::move(proc_name);
+	auto start = std::chrono::steady_clock::now();
+	t.result = run_node(r->root, evt, cfg.max_value_length, t);
+	t.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	bool res = t.result;
+	r->tracer->record(std::move(t));
+	return res;
+}
+
+void rule_tracer::record(trace&& t)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if (m_config.capacity == 0)
+	{
+		return;
+	}
+	if (m_ring.size() >= m_config.capacity)
+	{
+		m_ring.pop_front();
+	}
+	m_ring.push_back(std::move(t));
+	m_recorded++;
+}
+
+std::vector<rule_tracer::trace> rule_tracer::get_traces() const
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	return std::vector<trace>(m_ring.begin(), m_ring.end());
+}
+
+nlohmann::json rule_tracer::to_json() const
+{
+	nlohmann::json res;
+	uint64_t recorded;
+	std::vector<trace> traces;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		recorded = m_recorded;
+		traces.assign(m_ring.begin(), m_ring.end());
+	}
+
+	res["recorded"] = recorded;
+	res["traces"] = nlohmann::json::array();
+	for (const auto& t : traces)
+	{
+		nlohmann::json jt;
+		jt["rule"] = t.rule;
+		jt["source"] = t.source;
+		jt["evt.num"] = t.evt_num;
+		jt["evt.time"] = t.evt_ts;
+		jt["evt.type"] = t.evt_type;
+		if (!t.proc_name.empty())
+		{
+			jt["proc.name"] = t.proc_name;
+		}
+		jt["result"] = t.result;
+		jt["time_ns"] = t.time_ns;
+		jt["steps"] = nlohmann::json::array();
+		for (const auto& s : t.steps)
+		{
+			nlohmann::json js;
+			js["predicate"] = s.predicate;
+			js["result"] = s.result;
+			js["values"] = s.values;
+			js["time_ns"] = s.time_ns;
+			jt["steps"].push_back(std::move(js));
+		}
+		res["traces"].push_back(std::move(jt));
+	}
+	return res;
+}
@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#pragma once
+
+#include "falco_rule.h"
+
+#include <libsinsp/sinsp.h>
+#include <libsinsp/filter.h>
+#include <libsinsp/filter/ast.h>
+#include <libsinsp/event.h>
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/*!
+	\brief Records how the conditions of a selected set of rules are
+	evaluated, to debug rules that are slow or that match unexpectedly.
+	A sample of the evaluations of the traced rules is recorded, each with
+	the predicates evaluated until the result was known, their results, the
+	values of the fields they read and the time spent on them. The last
+	recorded evaluations are kept in a bounded ring.
+	The rulesets only hand the evaluation of the traced rules to the tracer,
+	and the other rules are evaluated as usual.
+*/
+class rule_tracer
+{
+public:
+	struct config
+	{
+		// the names of the traced rules
+		std::set<std::string> rules;
+		// if not empty, only the events of the processes with these
+		// names are traced. Ignored for the rules of the sources with
+		// no proc.name field.
+		std::set<std::string> processes;
+		// one evaluation out of sampling_ratio is traced
+		uint64_t sampling_ratio = 1;
+		// the extracted values are truncated to this length
+		size_t max_value_length = 64;
+		// the number of traced evaluations kept
+		size_t capacity = 1000;
+	};
+
+	struct step
+	{
+		std::string predicate;
+		bool result = false;
+		std::vector<std::string> values;
+		uint64_t time_ns = 0;
+	};
+
+	struct trace
+	{
+		std::string rule;
+		std::string source;
+		uint64_t evt_num = 0;
+		uint64_t evt_ts = 0;
+		std::string evt_type;
+		std::string proc_name;
+		bool result = false;
+		uint64_t time_ns = 0;
+		std::vector<step> steps;
+	};
+
+	class traced_rule;
+
+	explicit rule_tracer(const config& c);
+	virtual ~rule_tracer();
+
+	inline const config& get_config() const
+	{
+		return m_config;
+	}
+
+	inline bool traces(const std::string& rule) const
+	{
+		return m_config.rules.find(rule) != m_config.rules.end();
+	}
+
+	/*!
+		\brief Prepares the tracing of a rule, whose condition is split
+		in its predicates and compiled with the given factory. Throws a
+		falco_exception if the condition can't be compiled.
+	*/
+	std::shared_ptr<traced_rule> trace_rule(
+		const falco_rule& rule,
+		libsinsp::filter::ast::expr* condition,
+		std::shared_ptr<sinsp_filter_factory> factory);
+
+	/*!
+		\brief Evaluates a rule prepared with trace_rule(), which is
+		passed as an opaque pointer, and records the evaluation if sampled
+	*/
+	static bool run(void* rule, sinsp_evt* evt);
+
+	/*!
+		\brief Returns the traced evaluations in the ring, the oldest first
+	*/
+	std::vector<trace> get_traces() const;
+
+	/*!
+		\brief Returns the traced evaluations in the ring as JSON, along
+		with the number of evaluations traced so far
+	*/
+	nlohmann::json to_json() const;
+
+private:
+	void record(trace&& t);
+
+	config m_config;
+	mutable std::mutex m_mtx;
+	std::deque<trace> m_ring;
+	uint64_t m_recorded = 0;
+};
@@ -0,0 +1,417 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "ruleset_codegen.h"
+#include "compiled_ruleset.h"
+#include "falco_common.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdlib>
+
+using namespace libsinsp::filter;
+
+static bool is_decimal(const std::string& s, bool allow_sign)
+{
+	size_t start = allow_sign && !s.empty() && s[0] == '-' ? 1 : 0;
+	if (s.size() <= start)
+	{
+		return false;
+	}
+	return std::all_of(s.begin() + start, s.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+// Returns the given number as a C++ literal, or an empty string if it
+// can't be represented as the given kind
+static std::string number_literal(const std::string& v, const std::string& kind)
+{
+	errno = 0;
+	if (kind == "unsigned_number")
+	{
+		if (!is_decimal(v, false))
+		{
+			return "";
+		}
+		auto n = strtoull(v.c_str(), nullptr, 10);
+		return errno == 0 ? "UINT64_C(" + std::to_string(n) + ")" : "";
+	}
+
+	if (!is_decimal(v, true))
+	{
+		return "";
+	}
+	auto n = strtoll(v.c_str(), nullptr, 10);
+	// the minimum value can't be written as a single literal
+	if (errno != 0 || n == INT64_MIN)
+	{
+		return "";
+	}
+	return "INT64_C(" + std::to_string(n) + ")";
+}
+
+std::string ruleset_codegen::quote(const std::string& s)
+{
+	std::string res = "\"";
+	for (unsigned char c : s)
+	{
+		if (c == '"' || c == '\\')
+		{
+			res += '\\';
+			res += c;
+		}
+		else if (c >= 0x20 && c < 0x7f)
+		{
+			res += c;
+		}
+		else
+		{
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\%03o", c);
+			res += buf;
+		}
+	}
+	return res + "\"";
+}
+
+static std::string string_view_literal(const std::string& s)
+{
+	return "std::string_view(" + ruleset_codegen::quote(s) + ", " + std::to_string(s.size()) + ")";
+}
+
+void ruleset_codegen::add_source(const std::string& source, std::shared_ptr<sinsp_filter_factory> factory)
+{
+	auto src = std::make_unique<source_code>();
+	src->name = source;
+	src->factory = factory;
+	m_sources.push_back(std::move(src));
+}
+
+void ruleset_codegen::add_rule(const falco_rule& rule)
+{
+	auto it = std::find_if(m_sources.begin(), m_sources.end(),
+		[&rule](const std::unique_ptr<source_code>& s) { return s->name == rule.source; });
+	if (it == m_sources.end())
+	{
+		throw falco_exception("Can't generate the code of rule " + rule.name + ", its source " + rule.source + " is unknown");
+	}
+	auto& src = **it;
+
+	visitor v(src, m_stats);
+	rule.condition->accept(&v);
+
+	std::string comment = rule.name;
+	std::replace(comment.begin(), comment.end(), '\n', ' ');
+	auto fn = "rule_" + std::to_string(src.num_rules++);
+	src.rules << "// " << comment << "\n"
+		<< "static bool " << fn << "(void* s, sinsp_evt* evt)\n"
+		<< "{\n"
+		<< "\tauto& st = *static_cast<state*>(s);\n"
+		<< "\treturn " << v.m_code << ";\n"
+		<< "}\n\n";
+
+	char hash[32];
+	snprintf(hash, sizeof(hash), "0x%016" PRIx64 "ULL", falco_compiled::condition_hash(rule.condition.get()));
+	src.table << "\t{" << quote(rule.name) << ", " << hash << ", " << fn << "},\n";
+	m_stats.rules++;
+}
+
+std::string ruleset_codegen::generate() const
+{
+	std::ostringstream os;
+	os << "// Generated by falco --codegen-rules, do not edit\n\n"
+		<< "#include <engine/compiled_ruleset.h>\n\n"
+		<< "namespace\n{\n\n";
+
+	std::vector<std::pair<std::string, size_t>> exported;
+	for (size_t i = 0; i < m_sources.size(); i++)
+	{
+		const auto& src = *m_sources[i];
+		if (src.num_rules == 0)
+		{
+			continue;
+		}
+		auto ns = "src_" + std::to_string(i);
+		exported.emplace_back(src.name, i);
+
+		os << "// rules of the " << src.name << " source\n"
+			<< "namespace " << ns << "\n{\n\n";
+
+		for (size_t l = 0; l < src.lists.size(); l++)
+		{
+			os << "static constexpr std::array<std::string_view, " << src.lists[l].size() << "> list_" << l << " = {{\n";
+			for (const auto& v : src.lists[l])
+			{
+				os << "\t" << string_view_literal(v) << ",\n";
+			}
+			os << "}};\n\n";
+		}
+
+		os << "struct state\n{\n"
+			<< "\tstd::array<falco_compiled::field, " << src.fields.size() << "> f;\n"
+			<< "\tstd::array<falco_compiled::interpreted, " << src.interpreted.size() << "> c;\n"
+			<< "};\n\n";
+
+		os << "static void* create(const std::shared_ptr<sinsp_filter_factory>& factory, std::string* err)\n{\n"
+			<< "\tauto st = std::make_unique<state>();\n";
+		for (size_t f = 0; f < src.fields.size(); f++)
+		{
+			os << "\tif (!st->f[" << f << "].init(*factory, " << quote(src.fields[f].first)
+				<< ", falco_compiled::field::kind::" << src.fields[f].second << ", err))\n"
+				<< "\t{\n\t\treturn nullptr;\n\t}\n";
+		}
+		for (size_t c = 0; c < src.interpreted.size(); c++)
+		{
+			os << "\tif (!st->c[" << c << "].init(factory, " << quote(src.interpreted[c]) << ", err))\n"
+				<< "\t{\n\t\treturn nullptr;\n\t}\n";
+		}
+		os << "\treturn st.release();\n}\n\n";
+
+		os << "static void destroy(void* s)\n{\n"
+			<< "\tdelete static_cast<state*>(s);\n}\n\n";
+
+		os << src.rules.str();
+
+		os << "static const falco_compiled_rule rules[] = {\n"
+			<< src.table.str()
+			<< "};\n\n";
+
+		os << "static const falco_compiled_ruleset ruleset = {\n"
+			<< "\tFALCO_COMPILED_RULESET_ABI_VERSION,\n"
+			<< "\t" << quote(src.name) << ",\n"
+			<< "\t" << src.num_rules << ",\n"
+			<< "\trules,\n"
+			<< "\tcreate,\n"
+			<< "\tdestroy,\n"
+			<< "};\n\n"
+			<< "} // namespace " << ns << "\n\n";
+	}
+
+	os << "} // namespace\n\n"
+		<< "extern \"C\" __attribute__((visibility(\"default\")))\n"
+		<< "const falco_compiled_ruleset* falco_get_compiled_ruleset(const char* source)\n{\n";
+	for (const auto& e : exported)
+	{
+		os << "\tif (strcmp(source, " << quote(e.first) << ") == 0)\n"
+			<< "\t{\n\t\treturn &src_" << e.second << "::ruleset;\n\t}\n";
+	}
+	os << "\treturn nullptr;\n}\n";
+	return os.str();
+}
+
+void ruleset_codegen::visitor::visit(ast::and_expr* e)
+{
+	std::string code;
+	for (auto &c : e->children)
+	{
+		c->accept(this);
+		code += (code.empty() ? "(" : " && ") + m_code;
+	}
+	m_code = code + ")";
+}
+
+void ruleset_codegen::visitor::visit(ast::or_expr* e)
+{
+	std::string code;
+	for (auto &c : e->children)
+	{
+		c->accept(this);
+		code += (code.empty() ? "(" : " || ") + m_code;
+	}
+	m_code = code + ")";
+}
+
+void ruleset_codegen::visitor::visit(ast::not_expr* e)
+{
+	e->child->accept(this);
+	m_code = "!" + m_code;
+}
+
+void ruleset_codegen::visitor::visit(ast::identifier_expr* e)
+{
+	interpreted(e);
+}
+
+void ruleset_codegen::visitor::visit(ast::value_expr* e)
+{
+	interpreted(e);
+}
+
+void ruleset_codegen::visitor::visit(ast::list_expr* e)
+{
+	interpreted(e);
+}
+
+void ruleset_codegen::visitor::visit(ast::field_expr* e)
+{
+	interpreted(e);
+}
+
+void ruleset_codegen::visitor::visit(ast::field_transformer_expr* e)
+{
+	interpreted(e);
+}
+
+void ruleset_codegen::visitor::visit(ast::unary_check_expr* e)
+{
+	std::string kind;
+	auto idx = native_field(e->left.get(), kind);
+	if (idx < 0 || e->op != "exists")
+	{
+		interpreted(e);
+		return;
+	}
+	m_code = "st.f[" + std::to_string(idx) + "].exists(evt)";
+	m_stats.native_checks++;
+}
+
+void ruleset_codegen::visitor::visit(ast::binary_check_expr* e)
+{
+	std::string kind;
+	auto idx = native_field(e->left.get(), kind);
+	auto value = dynamic_cast<ast::value_expr*>(e->right.get());
+	auto list = dynamic_cast<ast::list_expr*>(e->right.get());
+	if (idx < 0 || (value == nullptr && list == nullptr))
+	{
+		interpreted(e);
+		return;
+	}
+
+	auto f = "st.f[" + std::to_string(idx) + "]";
+	std::string op = e->op == "=" ? std::string("==") : e->op;
+	std::string cmp;
+	if (kind == "string" && value != nullptr)
+	{
+		auto v = string_view_literal(value->value);
+		auto len = std::to_string(value->value.size());
+		if (op == "==" || op == "!=")
+		{
+			cmp = f + ".str() " + op + " " + v;
+		}
+		else if (op == "contains")
+		{
+			cmp = f + ".str().find(" + v + ") != std::string_view::npos";
+		}
+		else if (op == "startswith")
+		{
+			cmp = f + ".str().substr(0, " + len + ") == " + v;
+		}
+		else if (op == "endswith")
+		{
+			cmp = f + ".str().size() >= " + len + " && "
+				+ f + ".str().substr(" + f + ".str().size() - " + len + ") == " + v;
+		}
+	}
+	else if (kind == "string" && list != nullptr && op == "in")
+	{
+		std::vector<std::string> values(list->values.begin(), list->values.end());
+		std::sort(values.begin(), values.end());
+		values.erase(std::unique(values.begin(), values.end()), values.end());
+		auto it = std::find(m_src.lists.begin(), m_src.lists.end(), values);
+		auto l = std::distance(m_src.lists.begin(), it);
+		if (it == m_src.lists.end())
+		{
+			m_src.lists.push_back(std::move(values));
+		}
+		cmp = "falco_compiled::in_sorted(" + f + ".str(), list_" + std::to_string(l) + ")";
+	}
+	else if (kind != "string" && value != nullptr
+		&& (op == "==" || op == "!=" || op == "<" || op == "<=" || op == ">" || op == ">="))
+	{
+		auto literal = number_literal(value->value, kind);
+		if (!literal.empty())
+		{
+			cmp = f + (kind == "unsigned_number" ? ".u64() " : ".i64() ") + op + " " + literal;
+		}
+	}
+
+	if (cmp.empty())
+	{
+		interpreted(e);
+		return;
+	}
+	m_code = "(" + f + ".extract(evt) && " + cmp + ")";
+	m_stats.native_checks++;
+}
+
+void ruleset_codegen::visitor::interpreted(ast::expr* e)
+{
+	auto cond = ast::as_string(e);
+	auto it = m_src.interpreted_index.find(cond);
+	if (it == m_src.interpreted_index.end())
+	{
+		it = m_src.interpreted_index.emplace(cond, m_src.interpreted.size()).first;
+		m_src.interpreted.push_back(cond);
+	}
+	m_code = "st.c[" + std::to_string(it->second) + "].run(evt)";
+	m_stats.interpreted_checks++;
+}
+
+int64_t ruleset_codegen::visitor::native_field(ast::expr* e, std::string& kind)
+{
+	auto field = dynamic_cast<ast::field_expr*>(e);
+	if (field == nullptr)
+	{
+		return -1;
+	}
+
+	auto name = field->field;
+	if (!field->arg.empty())
+	{
+		name += "[" + field->arg + "]";
+	}
+
+	// the event fields are compared with their own semantics
+	// (e.g. evt.type or the event arguments), so they are left
+	// to the interpreter
+	if (name.compare(0, 4, "evt.") == 0)
+	{
+		return -1;
+	}
+
+	auto it = m_src.field_index.find(name);
+	if (it != m_src.field_index.end())
+	{
+		kind = m_src.fields[it->second].second;
+		return (int64_t) it->second;
+	}
+
+	auto check = m_src.factory->new_filtercheck(name.c_str());
+	falco_compiled::field::kind k;
+	if (check == nullptr
+		|| check->parse_field_name(name.c_str(), true, false) != (int32_t) name.size()
+		|| !falco_compiled::field::kind_of(*check, k))
+	{
+		return -1;
+	}
+	switch (k)
+	{
+	case falco_compiled::field::kind::string:
+		kind = "string";
+		break;
+	case falco_compiled::field::kind::unsigned_number:
+		kind = "unsigned_number";
+		break;
+	default:
+		kind = "signed_number";
+		break;
+	}
+	m_src.field_index[name] = m_src.fields.size();
+	m_src.fields.emplace_back(name, kind);
+	return (int64_t) m_src.fields.size() - 1;
+}
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#pragma once
+
+#include "falco_rule.h"
+
+#include <libsinsp/filter.h>
+#include <libsinsp/filter/ast.h>
+
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*!
+	\brief Generates the C++ source of a compiled ruleset (see
+	compiled_ruleset.h) from the conditions of a set of rules, to be built
+	as a shared library and loaded by the engine in place of the filters
+	of those rules.
+	The conditions become straight-line code, in which the checks of
+	string and integer fields with the =, !=, <, <=, >, >=, in, contains,
+	startswith, endswith and exists operators read the field values
+	directly, and the lists of the "in" operator become sorted constant
+	arrays. The other checks, such as the ones with transformers, list
+	fields or other operators, are compiled by the interpreter when the
+	library is loaded and invoked from the generated code.
+*/
+class ruleset_codegen
+{
+public:
+	struct stats
+	{
+		uint64_t rules = 0;
+		uint64_t native_checks = 0;
+		uint64_t interpreted_checks = 0;
+	};
+
+	/*!
+		\brief Adds an event source, whose filter factory is used to
+		know the type of the fields read by its rules
+	*/
+	void add_source(const std::string& source, std::shared_ptr<sinsp_filter_factory> factory);
+
+	/*!
+		\brief Adds a rule of a previously added source. Throws a
+		falco_exception if the source is unknown.
+	*/
+	void add_rule(const falco_rule& rule);
+
+	/*!
+		\brief Returns the generated source, which can be compiled on
+		its own with the include path of the engine and of libsinsp
+	*/
+	std::string generate() const;
+
+	inline const stats& get_stats() const
+	{
+		return m_stats;
+	}
+
+	/*!
+		\brief Returns the given string as a quoted C++ string literal
+	*/
+	static std::string quote(const std::string& s);
+
+private:
+	struct source_code
+	{
+		std::string name;
+		std::shared_ptr<sinsp_filter_factory> factory;
+		// the distinct fields read natively, with their kinds
+		std::vector<std::pair<std::string, std::string>> fields;
+		std::map<std::string, size_t> field_index;
+		// the checks evaluated by the interpreter
+		std::vector<std::string> interpreted;
+		std::map<std::string, size_t> interpreted_index;
+		// the sorted lists of the "in" checks
+		std::vector<std::vector<std::string>> lists;
+		std::ostringstream rules;
+		std::ostringstream table;
+		size_t num_rules = 0;
+	};
+
+	struct visitor : public libsinsp::filter::ast::expr_visitor
+	{
+		visitor(source_code& src, stats& st): m_src(src), m_stats(st) { }
+
+		void visit(libsinsp::filter::ast::and_expr* e) override;
+		void visit(libsinsp::filter::ast::or_expr* e) override;
+		void visit(libsinsp::filter::ast::not_expr* e) override;
+		void visit(libsinsp::filter::ast::identifier_expr* e) override;
+		void visit(libsinsp::filter::ast::value_expr* e) override;
+		void visit(libsinsp::filter::ast::list_expr* e) override;
+		void visit(libsinsp::filter::ast::unary_check_expr* e) override;
+		void visit(libsinsp::filter::ast::binary_check_expr* e) override;
+		void visit(libsinsp::filter::ast::field_expr* e) override;
+		void visit(libsinsp::filter::ast::field_transformer_expr* e) override;
+
+		void interpreted(libsinsp::filter::ast::expr* e);
+		// Returns the index of the field checked by e and fills its kind
+		// if it can be read natively, and -1 otherwise
+		int64_t native_field(libsinsp::filter::ast::expr* e, std::string& kind);
+
+		source_code& m_src;
+		stats& m_stats;
+		// the C++ expression of the last visited node
+		std::string m_code;
+	};
+
+	std::vector<std::unique_ptr<source_code>> m_sources;
+	stats m_stats;
+};
@@ -33,11 +33,19 @@ static std::shared_ptr<falco::app::restart_handler> s_restarter;
 static void terminate_signal_handler(int signal)
 {
 	falco::app::g_terminate_signal.trigger();
+	falco::app::g_command_bus.broadcast(command_mailbox::command_type::terminate);
 }
 
 static void reopen_outputs_signal_handler(int signal)
 {
 	falco::app::g_reopen_outputs_signal.trigger();
+	falco::app::g_command_bus.broadcast(command_mailbox::command_type::reopen_outputs);
+}
+
+static void dump_rule_traces_signal_handler(int signal)
+{
+	falco::app::g_dump_rule_traces_signal.trigger();
+	falco::app::g_command_bus.broadcast(command_mailbox::command_type::dump_rule_traces);
 }
 
 static void restart_signal_handler(int signal)
@@ -83,10 +91,12 @@ falco::app::run_result falco::app::actions::create_signal_handlers(falco::app::s
 	falco::app::g_terminate_signal.reset();
 	falco::app::g_restart_signal.reset();
 	falco::app::g_reopen_outputs_signal.reset();
+	falco::app::g_dump_rule_traces_signal.reset();
 
 	if (!g_terminate_signal.is_lock_free()
 		|| !g_restart_signal.is_lock_free()
-		|| !g_reopen_outputs_signal.is_lock_free())
+		|| !g_reopen_outputs_signal.is_lock_free()
+		|| !g_dump_rule_traces_signal.is_lock_free())
 	{
 		falco_logger::log(falco_logger::level::WARNING, "Bundled atomics implementation is not lock-free, signal handlers may be unstable\n");
 	}
@@ -94,6 +104,7 @@ falco::app::run_result falco::app::actions::create_signal_handlers(falco::app::s
 	if(! create_handler(SIGINT, ::terminate_signal_handler, ret) ||
 	   ! create_handler(SIGTERM, ::terminate_signal_handler, ret) ||
 	   ! create_handler(SIGUSR1, ::reopen_outputs_signal_handler, ret) ||
+	   ! create_handler(SIGUSR2, ::dump_rule_traces_signal_handler, ret) ||
 	   ! create_handler(SIGHUP, ::restart_signal_handler, ret))
 	{
 		return ret;
@@ -183,6 +194,7 @@ falco::app::run_result falco::app::actions::unregister_signal_handlers(falco::ap
 	if(! create_handler(SIGINT, SIG_DFL, ret) ||
 	   ! create_handler(SIGTERM, SIG_DFL, ret) ||
 	   ! create_handler(SIGUSR1, SIG_DFL, ret) ||
+	   ! create_handler(SIGUSR2, SIG_DFL, ret) ||
 	   ! create_handler(SIGHUP, SIG_DFL, ret))
 	{
 		return ret;
@@ -27,6 +27,12 @@ namespace app {
 namespace actions {
 
 bool check_rules_plugin_requirements(falco::app::state& s, std::string& err);
+void apply_rules_selection(const falco::app::state& s, falco_engine& engine);
+falco::app::run_result load_secondary_engine(
+    const falco::app::state& s,
+    const std::list<std::string>& rules_paths,
+    const std::string& label,
+    std::shared_ptr<falco_engine>& engine);
 void print_enabled_event_sources(falco::app::state& s);
 void activate_interesting_kernel_tracepoints(falco::app::state& s, std::unique_ptr<sinsp>& inspector);
 void check_for_ignored_events(falco::app::state& s);
@@ -85,7 +85,7 @@ void falco::app::actions::print_enabled_event_sources(falco::app::state& s)
 				}
 			}
 		}
-		if (!first_plugin && s.is_nodriver())
+		if (!first_plugin && s.is_nodriver() && !s.config->m_nodriver.m_synthetic.m_enabled)
 		{
 			falco_logger::log(falco_logger::level::WARNING, "Enabled event source '"
 				+ src + "' will be opened with no driver, no event will be produced");
@@ -33,6 +33,28 @@ falco::app::run_result falco::app::actions::open_offline_inspector(falco::app::s
 	{
 		s.offline_inspector->open_savefile(s.config->m_replay.m_capture_file);
 		falco_logger::log(falco_logger::level::INFO, "Replaying events from the capture file: " + s.config->m_replay.m_capture_file + "\n");
+
+		s.capture_index.reset();
+		if (s.config->m_replay.m_use_index)
+		{
+			std::string err;
+			auto index = std::make_shared<scap_index>();
+			if (index->load(s.config->m_replay.m_capture_file, err))
+			{
+				s.capture_index = index;
+				falco_logger::log(falco_logger::level::INFO, "Using the index of the capture file: " + scap_index::sidecar_path(s.config->m_replay.m_capture_file) + "\n");
+			}
+			else
+			{
+				// a missing index is the common case, whereas an unusable one
+				// is worth a warning
+				struct stat st;
+				auto level = stat(scap_index::sidecar_path(s.config->m_replay.m_capture_file).c_str(), &st) == 0
+					? falco_logger::level::WARNING
+					: falco_logger::level::DEBUG;
+				falco_logger::log(level, "Not using a capture index, falling back to a full scan: " + err + "\n");
+			}
+		}
 		return run_result::ok();
 	}
 	catch (sinsp_exception &e)
@@ -78,6 +100,14 @@ falco::app::run_result falco::app::actions::open_live_inspector(
 		}
 		else if (s.is_nodriver()) /* nodriver engine. */
 		{
+			if (s.config->m_nodriver.m_synthetic.m_enabled)
+			{
+				s.synthetic_events = std::make_shared<synthetic_event_generator>(s.config->m_nodriver.m_synthetic);
+				falco_logger::log(falco_logger::level::INFO, "Opening '" + source + "' source with synthetic events. Pool size: " + std::to_string(s.synthetic_events->pool_size()) + "\n");
+				s.synthetic_events->open(*inspector);
+				return run_result::ok();
+			}
+
 			// when opening a capture with no driver, Falco will first check
 			// if a plugin is capable of generating raw events from the libscap
 			// event table (including system events), and if none is found it
@@ -130,7 +160,7 @@ falco::app::run_result falco::app::actions::open_live_inspector(
 			}
 		}
 	}
-	catch (sinsp_exception &e)
+	catch (std::exception &e)
 	{
 		return run_result::fatal(e.what());
 	}
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "actions.h"
+#include "../../scap_index.h"
+
+using namespace falco::app;
+using namespace falco::app::actions;
+
+// Each chunk of the index spans roughly this amount of event blocks at most
+static constexpr uint64_t s_index_chunk_size = 1024 * 1024;
+
+// The runs of skippable events shorter than this are not worth seeking over
+static constexpr uint64_t s_index_min_skippable_size = 64 * 1024;
+
+falco::app::run_result falco::app::actions::index_capture_files(const falco::app::state& s)
+{
+	if(s.options.index_capture_filenames.empty())
+	{
+		return run_result::ok();
+	}
+
+	for(const auto& filename : s.options.index_capture_filenames)
+	{
+		std::string err;
+		if(!scap_index::build(filename, s_index_chunk_size, s_index_min_skippable_size, err))
+		{
+			return run_result::fatal("Could not index capture file: " + err);
+		}
+		falco_logger::log(falco_logger::level::INFO, "Capture file " + filename + " indexed into " + scap_index::sidecar_path(filename) + "\n");
+	}
+	return run_result::exit();
+}
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "actions.h"
+
+#include <libsinsp/filter.h>
+
+using namespace falco::app;
+using namespace falco::app::actions;
+
+static columnar_writer::column_type column_type_of(ppm_param_type t)
+{
+	switch (t)
+	{
+	case PT_UINT8:
+	case PT_UINT16:
+	case PT_UINT32:
+	case PT_UINT64:
+	case PT_RELTIME:
+	case PT_ABSTIME:
+		return columnar_writer::column_type::u64;
+	case PT_INT8:
+	case PT_INT16:
+	case PT_INT32:
+	case PT_INT64:
+	case PT_ERRNO:
+	case PT_PID:
+	case PT_FD:
+		return columnar_writer::column_type::i64;
+	case PT_DOUBLE:
+		return columnar_writer::column_type::f64;
+	case PT_BOOL:
+		return columnar_writer::column_type::boolean;
+	default:
+		return columnar_writer::column_type::string;
+	}
+}
+
+falco::app::run_result falco::app::actions::init_capture_export(falco::app::state& s)
+{
+	const auto& cfg = s.config->m_capture_export;
+	if (!cfg.m_enabled)
+	{
+		return run_result::ok();
+	}
+
+	if (!s.is_capture_mode())
+	{
+		return run_result::fatal("capture_export is only supported when replaying capture files");
+	}
+
+	auto src_info = s.source_infos.at(cfg.m_source);
+	if (src_info == nullptr || s.enabled_sources.find(cfg.m_source) == s.enabled_sources.end())
+	{
+		return run_result::fatal("capture_export refers to the unknown or disabled event source '" + cfg.m_source + "'");
+	}
+
+	// the column types follow the ones of the fields, regardless of their
+	// argument (e.g. proc.aname[2] is typed as proc.aname)
+	std::vector<const filter_check_info*> infos;
+	src_info->filterchecks->get_all_fields(infos);
+	std::vector<columnar_writer::column_info> columns;
+	std::string format;
+	for (const auto& field : cfg.m_fields)
+	{
+		auto name = field.substr(0, field.find('['));
+		const filtercheck_field_info* finfo = nullptr;
+		for (const auto& info : infos)
+		{
+			for (int32_t i = 0; i < info->m_nfields && finfo == nullptr; i++)
+			{
+				if (info->m_fields[i].m_name == name)
+				{
+					finfo = &info->m_fields[i];
+				}
+			}
+		}
+		if (finfo == nullptr)
+		{
+			return run_result::fatal("capture_export refers to the unknown field '" + field + "' for source '" + cfg.m_source + "'");
+		}
+		columns.push_back({field, column_type_of(finfo->m_type)});
+		format += (format.empty() ? "%" : " %") + field;
+	}
+
+	std::shared_ptr<sinsp_filter> filter;
+	if (!cfg.m_condition.empty())
+	{
+		try
+		{
+			auto ast = libsinsp::filter::parser(cfg.m_condition).parse();
+			sinsp_filter_compiler compiler(s.engine->filter_factory_for_source(cfg.m_source), ast.get());
+			filter = compiler.compile();
+		}
+		catch (const std::exception& e)
+		{
+			return run_result::fatal("Invalid capture_export condition: " + std::string(e.what()));
+		}
+	}
+
+	nlohmann::json metadata;
+	metadata["capture_file"] = s.config->m_replay.m_capture_file;
+	metadata["source"] = cfg.m_source;
+	metadata["condition"] = cfg.m_condition;
+	try
+	{
+		auto writer = std::make_unique<columnar_writer>(
+			cfg.m_output_file, columns, cfg.m_row_group_size, metadata);
+		s.exporter = std::make_shared<capture_exporter>(
+			src_info->engine_idx, filter,
+			s.engine->create_formatter(cfg.m_source, format),
+			cfg.m_fields, std::move(writer));
+	}
+	catch (const std::exception& e)
+	{
+		return run_result::fatal(e.what());
+	}
+
+	falco_logger::log(falco_logger::level::INFO, "Exporting " + std::to_string(columns.size()) + " fields of the captured events to " + cfg.m_output_file + "\n");
+	return run_result::ok();
+}
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "actions.h"
 #include "helpers.h"
+#include "../../plugin_batch_extractor.h"
 
 #include <unordered_set>
 
@@ -63,6 +64,7 @@ static bool populate_filterchecks(
 		const std::string& source,
 		filter_check_list& filterchecks,
 		std::unordered_set<std::string>& used_plugins,
+		bool batch_extraction,
 		std::string& err)
 {
 	std::vector<const filter_check_info*> infos;
@@ -96,8 +98,18 @@ static bool populate_filterchecks(
 			}
 		}
 
-		// add plugin filterchecks to the event source
-		filterchecks.add_filter_check(sinsp_plugin::new_filtercheck(plugin));
+		// add plugin filterchecks to the event source. The batch extractor
+		// is specific to the source, because the fields read by its rules
+		// are extracted from each of its events
+		if (batch_extraction)
+		{
+			filterchecks.add_filter_check(std::make_unique<batched_plugin_filtercheck>(
+				plugin, std::make_shared<plugin_batch_extractor>(plugin)));
+		}
+		else
+		{
+			filterchecks.add_filter_check(sinsp_plugin::new_filtercheck(plugin));
+		}
 		used_plugins.insert(plugin->name());
 	}
 	return true;
@@ -184,6 +196,7 @@ falco::app::run_result falco::app::actions::init_inspectors(falco::app::state& s
 				src,
 				*src_info->filterchecks,
 				used_plugins,
+				s.config->m_plugins_batch_extraction,
 				err))
 		{
 			return run_result::fatal(err);
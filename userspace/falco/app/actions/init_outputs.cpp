@@ -24,6 +24,10 @@ limitations under the License.
 
 #include "actions.h"
 
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__) && !defined(MINIMAL_BUILD)
+#include "grpc_queue.h"
+#endif
+
 using namespace falco::app;
 using namespace falco::app::actions;
 
@@ -60,6 +64,22 @@ falco::app::run_result falco::app::actions::init_outputs(falco::app::state& s)
 		return run_result::ok();
 	}
 
+	const auto& budget_cfg = s.config->m_memory_budget;
+	if (budget_cfg.m_enabled)
+	{
+		s.budget = std::make_shared<memory_budget>(
+			budget_cfg.m_limit_mb * 1024 * 1024,
+			budget_cfg.m_shrink_threshold_pct,
+			budget_cfg.m_summarize_threshold_pct,
+			budget_cfg.m_drop_threshold_pct,
+			budget_cfg.m_shrunk_queue_capacity,
+			budget_cfg.m_summary_max_len);
+	}
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__) && !defined(MINIMAL_BUILD)
+	// note: no output is running at this point, not even after a restart
+	falco::grpc::queue::get().set_budget(s.budget);
+#endif
+
 	s.outputs = std::make_shared<falco_outputs>(
 		s.engine,
 		s.config->m_outputs,
@@ -70,7 +90,8 @@ falco::app::run_result falco::app::actions::init_outputs(falco::app::state& s)
 		s.config->m_buffered_outputs,
 		s.config->m_outputs_queue_capacity,
 		s.config->m_time_format_iso_8601,
-		hostname);
+		hostname,
+		s.budget);
 
 	return run_result::ok();
 }
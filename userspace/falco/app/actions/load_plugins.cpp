@@ -16,6 +16,7 @@ limitations under the License.
 */
 
 #include "actions.h"
+#include "../../cpu_profiler.h"
 #include <libsinsp/plugin_manager.h>
 
 using namespace falco::app;
@@ -47,11 +48,17 @@ falco::app::run_result falco::app::actions::load_plugins(falco::app::state& s)
 	s.offline_inspector = std::make_shared<sinsp>();
 
 	// Load all the configured plugins
+	cpu_profiler::set_disabled_reason("");
 	for(auto &p : s.config->m_plugins)
 	{
 		falco_logger::log(falco_logger::level::INFO, "Loading plugin '" + p.m_name + "' from file " + p.m_library_path + "\n");
 		auto plugin = s.offline_inspector->register_plugin(p.m_library_path);
 		s.plugin_configs.insert(p, plugin->name());
+		if(cpu_profiler::is_go_library(p.m_library_path))
+		{
+			cpu_profiler::set_disabled_reason("CPU profiling is not available while the Go plugin '"
+				+ plugin->name() + "' is loaded, because the Go runtime owns the SIGPROF signal");
+		}
 		if(plugin->caps() & CAP_SOURCING && plugin->id() != 0)
 		{
 			state::source_info src_info;
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "actions.h"
+#include "helpers.h"
+
+using namespace falco::app;
+using namespace falco::app::actions;
+
+// Maximum number of example events reported for each rule and direction
+static constexpr size_t s_max_examples_per_rule = 5;
+
+falco::app::run_result falco::app::actions::load_rules_diff_files(falco::app::state& s)
+{
+	if (s.options.rules_diff_filenames.empty())
+	{
+		return run_result::ok();
+	}
+
+	if (!s.is_capture_mode())
+	{
+		return run_result::fatal("Comparing rules with --rules-diff is only supported when replaying capture files");
+	}
+
+	if (s.shadow != nullptr)
+	{
+		return run_result::fatal("Comparing rules with --rules-diff can not be used together with shadow_rules");
+	}
+
+	std::shared_ptr<falco_engine> candidate;
+	auto res = load_secondary_engine(s, s.options.rules_diff_filenames, "candidate", candidate);
+	if (!res.success)
+	{
+		return res;
+	}
+
+	s.diff = std::make_shared<ruleset_diff>(s.engine, candidate, s_max_examples_per_rule);
+	for (const auto& src : s.loaded_sources)
+	{
+		s.diff->enable_profiling(s.source_infos.at(src)->engine_idx);
+	}
+
+	falco_logger::log(falco_logger::level::INFO, "Comparing loaded rules with candidate rules, alerts will not be emitted\n");
+	return run_result::ok();
+}
@@ -18,18 +18,349 @@ limitations under the License.
 #include "actions.h"
 #include "helpers.h"
 #include "falco_utils.h"
+#include "ruleset_codegen.h"
+#include "compiled_ruleset.h"
 
 #include <libsinsp/plugin_manager.h>
 
+#include <algorithm>
+#include <fstream>
 #include <unordered_set>
 
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <dlfcn.h>
+#endif
+
 using namespace falco::app;
 using namespace falco::app::actions;
 
-falco::app::run_result falco::app::actions::load_rules_files(falco::app::state& s)
+// Sets the dispatch fields of the loaded sources, so that the rules
+// loaded afterwards are indexed by their values
+static falco::app::run_result apply_dispatch_fields(const falco::app::state& s, falco_engine& engine)
+{
+	for (const auto& df : s.config->m_rules_dispatch_fields)
+	{
+		if (std::find(s.loaded_sources.begin(), s.loaded_sources.end(), df.first) == s.loaded_sources.end())
+		{
+			falco_logger::log(falco_logger::level::DEBUG, "Ignoring the dispatch field of the event source " + df.first + ", which is not loaded\n");
+			continue;
+		}
+		try
+		{
+			engine.set_source_dispatch_field(df.first, df.second);
+		}
+		catch (const falco_exception& e)
+		{
+			return run_result::fatal("Could not index the rules of the event source " + df.first + ": " + e.what());
+		}
+		falco_logger::log(falco_logger::level::DEBUG, "Indexing the rules of the event source " + df.first + " by " + df.second + "\n");
+	}
+	return run_result::ok();
+}
+
+static falco::app::run_result apply_eval_report(const falco::app::state& s, falco_engine& engine)
+{
+	filter_ruleset::eval_thresholds thresholds;
+	const auto& config = s.config->m_rule_eval_report;
+	if (config.m_enabled)
+	{
+		for (const auto& l : config.m_max_field_lengths)
+		{
+			bool known = false;
+			for (const auto& src : s.loaded_sources)
+			{
+				known = known || s.engine->filter_factory_for_source(src)->new_filtercheck(l.first.c_str()) != nullptr;
+			}
+			if (!known)
+			{
+				return run_result::fatal("Unknown field in rule_evaluation_report.max_field_lengths: " + l.first);
+			}
+		}
+		thresholds.max_field_lengths = config.m_max_field_lengths;
+		thresholds.event_budget_ns = config.m_event_budget_us * 1000;
+	}
+	engine.set_eval_thresholds(thresholds);
+	return run_result::ok();
+}
+
+// Loads the compiled_rules library, whose compiled conditions are used by
+// the rules loaded afterwards
+static falco::app::run_result apply_compiled_rules(falco::app::state& s)
+{
+	const auto& config = s.config->m_compiled_rules;
+	if (config.m_library.empty())
+	{
+		return run_result::ok();
+	}
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+	if (s.compiled_rules_library == nullptr)
+	{
+		s.compiled_rules_library = dlopen(config.m_library.c_str(), RTLD_NOW | RTLD_LOCAL);
+		if (s.compiled_rules_library == nullptr)
+		{
+			return run_result::fatal("Could not load the compiled rules library " + config.m_library + ": " + dlerror());
+		}
+	}
+	auto get = (falco_get_compiled_ruleset_fn) dlsym(s.compiled_rules_library, FALCO_COMPILED_RULESET_SYMBOL);
+	if (get == nullptr)
+	{
+		return run_result::fatal("The library " + config.m_library + " is not a compiled rules library");
+	}
+	for (const auto& src : s.loaded_sources)
+	{
+		s.engine->set_source_compiled_ruleset(src, get(src.c_str()), config.m_verify);
+	}
+	return run_result::ok();
+#else
+	return run_result::fatal("Compiled rules libraries are not supported on this platform");
+#endif
+}
+
+static void apply_rule_trace(falco::app::state& s)
+{
+	const auto& config = s.config->m_rule_trace;
+	if (!config.m_enabled)
+	{
+		s.engine->set_rule_tracer(nullptr);
+		return;
+	}
+	rule_tracer::config c;
+	c.rules = config.m_rules;
+	c.processes = config.m_processes;
+	c.sampling_ratio = config.m_sampling_ratio;
+	c.max_value_length = config.m_max_value_length;
+	c.capacity = config.m_capacity;
+	s.engine->set_rule_tracer(std::make_shared<rule_tracer>(c));
+}
+
+static void log_traced_rules(const falco::app::state& s)
+{
+	if (!s.config->m_rule_trace.m_enabled)
+	{
+		return;
+	}
+	for (const auto& name : s.config->m_rule_trace.m_rules)
+	{
+		if (s.engine->get_rules().at(name) == nullptr)
+		{
+			falco_logger::log(falco_logger::level::WARNING, "Can't trace unknown rule '" + name + "'\n");
+			continue;
+		}
+		falco_logger::log(falco_logger::level::INFO, "Tracing the evaluations of rule '" + name + "'\n");
+	}
+}
+
+static void log_compiled_rules(const falco::app::state& s)
+{
+	if (s.config->m_compiled_rules.m_library.empty())
+	{
+		return;
+	}
+	for (const auto& src : s.loaded_sources)
+	{
+		filter_ruleset::compiled_stats stats;
+		s.engine->ruleset_for_source(src)->get_compiled_stats(stats);
+		if (stats.compiled_rules == 0 && stats.stale_rules == 0)
+		{
+			continue;
+		}
+		falco_logger::log(falco_logger::level::INFO, "Using the compiled conditions of " + std::to_string(stats.compiled_rules)
+			+ " rules of the event source " + src + "\n");
+		if (stats.stale_rules > 0)
+		{
+			falco_logger::log(falco_logger::level::WARNING, std::to_string(stats.stale_rules) + " rules of the event source " + src
+				+ " changed after compiling them, and are interpreted instead\n");
+		}
+	}
+}
+
+// printout of `--codegen-rules` option
+static falco::app::run_result generate_compiled_rules(const falco::app::state& s)
+{
+	ruleset_codegen codegen;
+	for (const auto& src : s.loaded_sources)
+	{
+		codegen.add_source(src, s.engine->filter_factory_for_source(src));
+	}
+
+	std::string code;
+	try
+	{
+		for (const auto& rule : s.engine->get_rules())
+		{
+			codegen.add_rule(rule);
+		}
+		code = codegen.generate();
+	}
+	catch (const falco_exception& e)
+	{
+		return run_result::fatal(e.what());
+	}
+
+	const auto& path = s.options.codegen_rules_filename;
+	std::ofstream out(path);
+	out << code;
+	out.close();
+	if (!out.good())
+	{
+		return run_result::fatal("Could not write the compiled rules to " + path);
+	}
+
+	const auto& stats = codegen.get_stats();
+	falco_logger::log(falco_logger::level::INFO, "Generated the compiled conditions of " + std::to_string(stats.rules)
+		+ " rules into " + path + ", with " + std::to_string(stats.native_checks) + " compiled checks and "
+		+ std::to_string(stats.interpreted_checks) + " interpreted ones\n");
+	return run_result::exit();
+}
+
+void falco::app::actions::apply_rules_selection(const falco::app::state& s, falco_engine& engine)
 {
 	std::string all_rules;
 
+	for (const auto& substring : s.options.disabled_rule_substrings)
+	{
+		falco_logger::log(falco_logger::level::INFO, "Disabling rules matching substring: " + substring + "\n");
+		engine.enable_rule(substring, false);
+	}
+
+	if(!s.options.disabled_rule_tags.empty())
+	{
+		for(const auto &tag : s.options.disabled_rule_tags)
+		{
+			falco_logger::log(falco_logger::level::INFO, "Disabling rules with tag: " + tag + "\n");
+		}
+		engine.enable_rule_by_tag(s.options.disabled_rule_tags, false);
+	}
+
+	if(!s.options.enabled_rule_tags.empty())
+	{
+		// Since we only want to enable specific
+		// rules, first disable all rules.
+		engine.enable_rule(all_rules, false);
+		for(const auto &tag : s.options.enabled_rule_tags)
+		{
+			falco_logger::log(falco_logger::level::INFO, "Enabling rules with tag: " + tag + "\n");
+		}
+		engine.enable_rule_by_tag(s.options.enabled_rule_tags, true);
+	}
+
+	for(const auto& sel : s.config->m_rules_selection)
+	{
+		bool enable = sel.m_op == falco_configuration::rule_selection_operation::enable;
+
+		if(sel.m_rule != "")
+		{
+			falco_logger::log(falco_logger::level::INFO,
+				(enable ? "Enabling" : "Disabling") + std::string(" rules with name: ") + sel.m_rule + "\n");
+
+			engine.enable_rule_wildcard(sel.m_rule, enable);
+		}
+
+		if(sel.m_tag != "")
+		{
+			falco_logger::log(falco_logger::level::INFO,
+				(enable ? "Enabling" : "Disabling") + std::string(" rules with tag: ") + sel.m_tag + "\n");
+
+			engine.enable_rule_by_tag(std::set<std::string>{sel.m_tag}, enable); // TODO wildcard support
+		}
+	}
+}
+
+falco::app::run_result falco::app::actions::load_secondary_engine(
+		const falco::app::state& s,
+		const std::list<std::string>& rules_paths,
+		const std::string& label,
+		std::shared_ptr<falco_engine>& engine)
+{
+	// The secondary engine shares the filter factories of the main one,
+	// which is safe because both are only invoked by the thread processing
+	// each given event source. Sources are added in the same order so that
+	// source indexes are interchangeable across the two engines.
+	engine = std::make_shared<falco_engine>();
+	std::vector<std::pair<size_t, std::string>> sources;
+	for (const auto& src : s.loaded_sources)
+	{
+		sources.emplace_back(s.source_infos.at(src)->engine_idx, src);
+	}
+	std::sort(sources.begin(), sources.end());
+	for (const auto& src : sources)
+	{
+		auto idx = engine->add_source(src.second,
+			s.engine->filter_factory_for_source(src.first),
+			s.engine->formatter_factory_for_source(src.first));
+		if (idx != src.first)
+		{
+			return run_result::fatal("Could not add event source in the " + label + " engine: " + src.second);
+		}
+	}
+	engine->set_min_priority(s.config->m_min_priority);
+	auto dispatch_res = apply_dispatch_fields(s, *engine);
+	if (!dispatch_res.success)
+	{
+		return dispatch_res;
+	}
+	auto report_res = apply_eval_report(s, *engine);
+	if (!report_res.success)
+	{
+		return report_res;
+	}
+
+	std::list<std::string> filenames;
+	std::list<std::string> folders;
+	for (const auto &path : rules_paths)
+	{
+		falco_configuration::read_rules_file_directory(path, filenames, folders);
+	}
+
+	std::vector<std::string> rules_contents;
+	falco::load_result::rules_contents_t rc;
+	try
+	{
+		read_files(filenames.begin(), filenames.end(), rules_contents, rc);
+	}
+	catch(falco_exception& e)
+	{
+		return run_result::fatal(e.what());
+	}
+
+	for (const auto& filename : filenames)
+	{
+		falco_logger::log(falco_logger::level::INFO, "Loading " + label + " rules from file " + filename + "\n");
+		engine->stage_rules(rc.at(filename), filename);
+	}
+	// the rules that end up disabled are only compiled if enabled later,
+	// which fails if their conditions are invalid
+	engine->set_lazy_filters(true);
+	std::vector<std::unique_ptr<falco::load_result>> results;
+	try
+	{
+		results = engine->compile_staged_rules([&s](falco_engine& e)
+		{
+			apply_rules_selection(s, e);
+		});
+	}
+	catch(falco_exception& e)
+	{
+		return run_result::fatal("Error loading " + label + " rules: " + e.what());
+	}
+	for (auto& res : results)
+	{
+		if (!res->successful())
+		{
+			return run_result::fatal("Error loading " + label + " rules: " + res->as_string(true, rc));
+		}
+		if (res->has_warnings())
+		{
+			falco_logger::log(falco_logger::level::WARNING, "Loading " + label + " rules: " + res->as_string(true, rc) + "\n");
+		}
+	}
+
+	engine->complete_rule_loading();
+	return run_result::ok();
+}
+
+falco::app::run_result falco::app::actions::load_rules_files(falco::app::state& s)
+{
 	if (!s.options.rules_filenames.empty())
 	{
 		s.config->m_rules_filenames = s.options.rules_filenames;
@@ -65,14 +396,60 @@ falco::app::run_result falco::app::actions::load_rules_files(falco::app::state&
 		return run_result::fatal(e.what());
 	}
 
-	std::string err = "";
+	auto dispatch_res = apply_dispatch_fields(s, *s.engine);
+	if (!dispatch_res.success)
+	{
+		return dispatch_res;
+	}
+	auto report_res = apply_eval_report(s, *s.engine);
+	if (!report_res.success)
+	{
+		return report_res;
+	}
+	// the generated code must come from the rules alone
+	auto compiled_res = s.options.codegen_rules_filename.empty()
+		? apply_compiled_rules(s)
+		: run_result::ok();
+	if (!compiled_res.success)
+	{
+		return compiled_res;
+	}
+	apply_rule_trace(s);
+
+	if((!s.options.disabled_rule_substrings.empty() || !s.options.disabled_rule_tags.empty() || !s.options.enabled_rule_tags.empty()) &&
+		!s.config->m_rules_selection.empty())
+	{
+		return run_result::fatal("Specifying -D, -t, -T command line options together with \"rules:\" configuration or -o \"rules...\" is not supported.");
+	}
+
+	// all the files are read first, and then compiled at once along
+	// with the rules selection
 	for(auto &filename : s.config->m_loaded_rules_filenames)
 	{
 		falco_logger::log(falco_logger::level::INFO, "Loading rules from file " + filename + "\n");
-		std::unique_ptr<falco::load_result> res;
-
-		res = s.engine->load_rules(rc.at(filename), filename);
+		s.engine->stage_rules(rc.at(filename), filename);
+	}
+	// the rules that end up disabled are only compiled if enabled later,
+	// which fails if their conditions are invalid. Validating rules with
+	// -V always compiles all of them instead.
+	s.engine->set_lazy_filters(true);
+	std::vector<std::unique_ptr<falco::load_result>> results;
+	try
+	{
+		results = s.engine->compile_staged_rules([&s](falco_engine& engine)
+		{
+			apply_rules_selection(s, engine);
+		});
+	}
+	catch(falco_exception& e)
+	{
+		return run_result::fatal(e.what());
+	}
 
+	std::string err = "";
+	auto filename = s.config->m_loaded_rules_filenames.begin();
+	for(auto &res : results)
+	{
 		if(!res->successful())
 		{
 			// Return the summary version as the error
@@ -85,8 +462,9 @@ falco::app::run_result falco::app::actions::load_rules_files(falco::app::state&
 			falco_logger::log(falco_logger::level::WARNING,res->as_string(true, rc) + "\n");
 		}
 #if defined(__linux__) and !defined(MINIMAL_BUILD) and !defined(__EMSCRIPTEN__)
-		s.config->m_loaded_rules_filenames_sha256sum.insert({filename, falco::utils::calculate_file_sha256sum(filename)});
+		s.config->m_loaded_rules_filenames_sha256sum.insert({*filename, falco::utils::calculate_file_sha256sum(*filename)});
 #endif
+		++filename;
 	}
 
 	// note: we have an egg-and-chicken problem here. We would like to check
@@ -131,60 +509,6 @@ falco::app::run_result falco::app::actions::load_rules_files(falco::app::state&
 		return run_result::fatal(err);
 	}
 
-	if((!s.options.disabled_rule_substrings.empty() || !s.options.disabled_rule_tags.empty() || !s.options.enabled_rule_tags.empty()) &&
-		!s.config->m_rules_selection.empty())
-	{
-		return run_result::fatal("Specifying -D, -t, -T command line options together with \"rules:\" configuration or -o \"rules...\" is not supported.");
-	}
-
-	for (const auto& substring : s.options.disabled_rule_substrings)
-	{
-		falco_logger::log(falco_logger::level::INFO, "Disabling rules matching substring: " + substring + "\n");
-		s.engine->enable_rule(substring, false);
-	}
-
-	if(!s.options.disabled_rule_tags.empty())
-	{
-		for(const auto &tag : s.options.disabled_rule_tags)
-		{
-			falco_logger::log(falco_logger::level::INFO, "Disabling rules with tag: " + tag + "\n");
-		}
-		s.engine->enable_rule_by_tag(s.options.disabled_rule_tags, false);
-	}
-
-	if(!s.options.enabled_rule_tags.empty())
-	{
-		// Since we only want to enable specific
-		// rules, first disable all rules.
-		s.engine->enable_rule(all_rules, false);
-		for(const auto &tag : s.options.enabled_rule_tags)
-		{
-			falco_logger::log(falco_logger::level::INFO, "Enabling rules with tag: " + tag + "\n");
-		}
-		s.engine->enable_rule_by_tag(s.options.enabled_rule_tags, true);
-	}
-
-	for(const auto& sel : s.config->m_rules_selection)
-	{
-		bool enable = sel.m_op == falco_configuration::rule_selection_operation::enable;
-
-		if(sel.m_rule != "")
-		{
-			falco_logger::log(falco_logger::level::INFO,
-				(enable ? "Enabling" : "Disabling") + std::string(" rules with name: ") + sel.m_rule + "\n");
-
-			s.engine->enable_rule_wildcard(sel.m_rule, enable);
-		}
-
-		if(sel.m_tag != "")
-		{
-			falco_logger::log(falco_logger::level::INFO,
-				(enable ? "Enabling" : "Disabling") + std::string(" rules with tag: ") + sel.m_tag + "\n");
-
-			s.engine->enable_rule_by_tag(std::set<std::string>{sel.m_tag}, enable); // TODO wildcard support
-		}
-	}
-
 	// printout of `-L` option
 	if (s.options.describe_all_rules || !s.options.describe_rule.empty())
 	{
@@ -204,5 +528,12 @@ falco::app::run_result falco::app::actions::load_rules_files(falco::app::state&
 		return run_result::exit();
 	}
 
+	if (!s.options.codegen_rules_filename.empty())
+	{
+		return generate_compiled_rules(s);
+	}
+
+	log_compiled_rules(s);
+	log_traced_rules(s);
 	return run_result::ok();
 }
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "actions.h"
+#include "helpers.h"
+
+using namespace falco::app;
+using namespace falco::app::actions;
+
+falco::app::run_result falco::app::actions::load_shadow_rules_files(falco::app::state& s)
+{
+	const auto& cfg = s.config->m_shadow_rules;
+	if (!cfg.m_enabled)
+	{
+		return run_result::ok();
+	}
+
+	std::shared_ptr<falco_engine> engine;
+	auto res = load_secondary_engine(s, cfg.m_rules_filenames, "shadow", engine);
+	if (!res.success)
+	{
+		return res;
+	}
+
+	s.shadow = std::make_shared<shadow_evaluator>(engine, s.loaded_sources.size(),
+		cfg.m_sample_ratio, cfg.m_max_cpu_pct);
+
+	falco_logger::log(falco_logger::level::INFO, "Shadow rules enabled, evaluating one event every "
+		+ std::to_string(cfg.m_sample_ratio) + " with a CPU cap of "
+		+ std::to_string(cfg.m_max_cpu_pct) + "%\n");
+	return run_result::ok();
+}
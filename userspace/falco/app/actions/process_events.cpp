@@ -23,6 +23,7 @@ limitations under the License.
 #include <fcntl.h>
 #include <atomic>
 #include <unordered_map>
+#include <fstream>
 
 #include "falco_utils.h"
 
@@ -34,8 +35,12 @@ limitations under the License.
 #include "../../stats_writer.h"
 #include "../../falco_outputs.h"
 #include "../../event_drops.h"
+#include "../../stall_detector.h"
+#include "falco_usdt.h"
+#include "../../cpu_profiler.h"
 
 #include <libsinsp/plugin_manager.h>
+#include <libsinsp/token_bucket.h>
 
 using namespace falco::app;
 using namespace falco::app::actions;
@@ -96,6 +101,99 @@ private:
 	falco::semaphore& m_semaphore;
 };
 
+//
+// Paces the events read from a capture file (or generated synthetically),
+// following either their original timeline (possibly accelerated) or a fixed
+// event rate. It also rewrites timestamps for looped and rebased replays, so
+// that downstream consumers (rules, outputs, rate limiters) always see a
+// monotonic timeline.
+//
+class event_pacer
+{
+public:
+	event_pacer(double speed, uint64_t events_per_second, bool loop, bool rebase)
+		: m_speed(speed), m_events_per_second(events_per_second),
+		  m_loop(loop), m_rebase(rebase) { }
+
+	inline bool enabled() const
+	{
+		return m_speed > 0 || m_events_per_second > 0 || m_loop || m_rebase;
+	}
+
+	// Called when the event stream is started over: timestamps of the new
+	// iteration are shifted right after the last one of the previous iteration
+	// (or to the present time, if rebasing).
+	inline void restart()
+	{
+		m_next_ts = m_last_ts + 1;
+		m_first_ts = 0;
+		m_num_evts = 0;
+	}
+
+	// Rewrites the event timestamp if needed and sleeps until the
+	// event is due. The wait is sliced so that signals can still be
+	// served timely during long gaps of the original capture.
+	void pace(sinsp_evt* ev)
+	{
+		auto now = std::chrono::steady_clock::now();
+		if (m_first_ts == 0)
+		{
+			m_first_ts = ev->get_ts();
+			m_wall_start = now;
+			uint64_t base_ts = m_next_ts;
+			if (m_rebase)
+			{
+				uint64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::system_clock::now().time_since_epoch()).count();
+				base_ts = std::max(wall_ns, m_next_ts);
+			}
+			m_ts_offset = base_ts != 0 ? base_ts - m_first_ts : 0;
+		}
+
+		std::chrono::nanoseconds due(0);
+		if (m_events_per_second > 0)
+		{
+			due = std::chrono::nanoseconds((m_num_evts * ONE_SECOND_IN_NS) / m_events_per_second);
+		}
+		else if (m_speed > 0 && ev->get_ts() > m_first_ts)
+		{
+			due = std::chrono::nanoseconds((uint64_t)((ev->get_ts() - m_first_ts) / m_speed));
+		}
+		m_num_evts++;
+
+		// sub-millisecond delays are absorbed by the next events,
+		// which avoids paying one sleep syscall per event
+		auto target = m_wall_start + due;
+		while (target - now >= std::chrono::milliseconds(1)
+			&& !falco::app::g_terminate_signal.triggered()
+			&& !falco::app::g_restart_signal.triggered())
+		{
+			std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(target - now, max_sleep));
+			now = std::chrono::steady_clock::now();
+		}
+
+		if (m_ts_offset != 0)
+		{
+			ev->get_scap_evt()->ts += m_ts_offset;
+		}
+		m_last_ts = ev->get_ts();
+	}
+
+private:
+	static constexpr std::chrono::milliseconds max_sleep{100};
+
+	double m_speed;
+	uint64_t m_events_per_second;
+	bool m_loop;
+	bool m_rebase;
+	uint64_t m_next_ts = 0;
+	uint64_t m_ts_offset = 0;
+	uint64_t m_first_ts = 0;
+	uint64_t m_last_ts = 0;
+	uint64_t m_num_evts = 0;
+	std::chrono::steady_clock::time_point m_wall_start;
+};
+
 struct live_context
 {
 	// the name of the source of which events are processed
@@ -108,6 +206,114 @@ struct live_context
 	std::unique_ptr<source_sync_context> sync;
 };
 
+// Emits an internal alert for an event whose rules were slow to evaluate,
+// so that crafted events slowing down the event processing are noticed.
+// The alerts are rate-limited, so that such events can't flood the
+// outputs, and the number of suppressed ones is reported with the next.
+static void report_slow_evaluation(
+		falco::app::state& s,
+		token_bucket& bucket,
+		uint64_t& suppressed,
+		sinsp_evt* ev,
+		const filter_ruleset::slow_evaluation& v)
+{
+	if(!bucket.claim(1, ev->get_ts()))
+	{
+		suppressed++;
+		return;
+	}
+
+	std::string rule = "Falco internal: slow rule evaluation";
+	std::string msg = rule + ". Evaluation took " + std::to_string(v.eval_time_ns) + " ns.";
+	nlohmann::json fields;
+	fields["evt.num"] = ev->get_num();
+	fields["evt.type"] = ev->get_name();
+	fields["proc.pid"] = ev->get_thread_info() != nullptr ? ev->get_thread_info()->m_pid : -1;
+	fields["eval_time_ns"] = v.eval_time_ns;
+	if(!v.field.empty())
+	{
+		msg += " The value of " + v.field + " is " + std::to_string(v.field_length) + " bytes long.";
+		fields["field"] = v.field;
+		fields["field_length"] = v.field_length;
+	}
+	fields["suppressed_alerts"] = suppressed;
+	suppressed = 0;
+
+	auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	s.outputs->handle_msg(now, falco_common::PRIORITY_WARNING, msg, rule, fields);
+}
+
+// Logs how many rule evaluations matching by priority saved, compared
+// with evaluating all the candidate rules of each event like the "all"
+// strategy does. An empty source means all the enabled ones.
+static void log_priority_match_stats(falco::app::state& s, const std::string& source)
+{
+	for (const auto& src : s.enabled_sources)
+	{
+		if (!source.empty() && src != source)
+		{
+			continue;
+		}
+
+		filter_ruleset::priority_match_stats stats;
+		s.engine->ruleset_for_source(src)->get_priority_match_stats(stats);
+		if (stats.candidates == 0)
+		{
+			continue;
+		}
+		auto saved_pct = (stats.candidates - stats.evaluations) * 100 / stats.candidates;
+		falco_logger::log(falco_logger::level::INFO, "Rule matching by priority (" + src + "): "
+			+ std::to_string(stats.evaluations) + " of " + std::to_string(stats.candidates)
+			+ " candidate rules evaluated on " + std::to_string(stats.events) + " events, "
+			+ std::to_string(saved_pct) + "% fewer evaluations than with all\n");
+	}
+}
+
+// Reports the rules whose compiled condition disagreed with the filter
+// compiled from the rules files. An empty source means all the enabled ones.
+static void log_compiled_rules_mismatches(falco::app::state& s, const std::string& source)
+{
+	for (const auto& src : s.enabled_sources)
+	{
+		if (!source.empty() && src != source)
+		{
+			continue;
+		}
+
+		filter_ruleset::compiled_stats stats;
+		s.engine->ruleset_for_source(src)->get_compiled_stats(stats);
+		for (const auto& m : stats.mismatches)
+		{
+			falco_logger::log(falco_logger::level::WARNING, "The compiled condition of rule '" + m.first
+				+ "' disagreed with its filter on " + std::to_string(m.second) + " events\n");
+		}
+	}
+}
+
+// Writes the rule evaluations traced so far to the file of the rule_trace
+// config, if any
+static void dump_rule_traces(const falco::app::state& s)
+{
+	auto tracer = s.engine->get_rule_tracer();
+	const auto& path = s.config->m_rule_trace.m_file;
+	if (tracer == nullptr || path.empty())
+	{
+		return;
+	}
+
+	auto traces = tracer->to_json();
+	std::ofstream out(path);
+	out << traces.dump() << std::endl;
+	out.close();
+	if (!out.good())
+	{
+		falco_logger::log(falco_logger::level::ERR, "Could not write the rule traces to " + path + "\n");
+		return;
+	}
+	falco_logger::log(falco_logger::level::INFO, "Wrote " + std::to_string(traces["traces"].size())
+		+ " traced rule evaluations to " + path + "\n");
+}
+
 //
 // Event processing loop
 //
@@ -127,7 +333,90 @@ static falco::app::run_result do_inspect(
 	uint64_t duration_start = 0;
 	uint32_t timeouts_since_last_success_or_msg = 0;
 	const bool is_capture_mode = source.empty();
+	const bool is_synthetic = !is_capture_mode && s.synthetic_events != nullptr
+		&& source == falco_common::syscall_source;
 	size_t source_engine_idx = 0;
+	size_t next_diff_capture = 0;
+
+	// events whose rules are slow to evaluate
+	const bool report_slow_evals = s.config->m_rule_eval_report.m_enabled;
+	token_bucket slow_evals_bucket;
+	uint64_t slow_evals_suppressed = 0;
+	filter_ruleset::slow_evaluation slow_eval;
+	if(report_slow_evals)
+	{
+		slow_evals_bucket.init(s.config->m_rule_eval_report.m_alert_rate, s.config->m_rule_eval_report.m_alert_max_burst);
+	}
+
+	// byte ranges of the capture file that can't match, from its index
+	std::vector<scap_index::range> skip_ranges;
+	size_t next_skip_range = 0;
+	uint64_t skipped_bytes = 0;
+
+	// progress of this thread, only monitored if the stall detector is enabled
+	auto heartbeat = s.stall_monitor != nullptr
+		? s.stall_monitor->add_heartbeat(is_capture_mode ? "capture" : source)
+		: std::make_shared<stall_detector::heartbeat>();
+	if (s.stall_monitor != nullptr)
+	{
+		for (const auto& src : s.enabled_sources)
+		{
+			if (is_capture_mode || src == source)
+			{
+				auto idx = s.source_infos.at(src)->engine_idx;
+				s.engine->ruleset_for_source(idx)->set_current_rule_tracker(&heartbeat->current_rule);
+			}
+		}
+	}
+
+	// commands posted by signals and other threads, applied between events
+	auto* mailbox_ptr = falco::app::g_command_bus.open();
+	if (mailbox_ptr == nullptr)
+	{
+		return run_result::fatal("Too many event processing loops to deliver commands to");
+	}
+	std::shared_ptr<command_mailbox> mailbox(mailbox_ptr, [](command_mailbox* m)
+	{
+		falco::app::g_command_bus.close(m);
+	});
+	std::vector<command_mailbox::command> commands;
+
+	// the signals received before opening the mailbox were not delivered to it
+	if (falco::app::g_terminate_signal.triggered())
+	{
+		mailbox->post(command_mailbox::command_type::terminate);
+	}
+	if (falco::app::g_restart_signal.triggered())
+	{
+		mailbox->post(command_mailbox::command_type::restart);
+	}
+	if (falco::app::g_reopen_outputs_signal.triggered())
+	{
+		mailbox->post(command_mailbox::command_type::reopen_outputs);
+	}
+	if (falco::app::g_dump_rule_traces_signal.triggered())
+	{
+		mailbox->post(command_mailbox::command_type::dump_rule_traces);
+	}
+
+	// the rulesets evaluated by this loop, which it is the only one to modify
+	std::vector<size_t> owned_engine_idxs;
+	for (const auto& src : s.enabled_sources)
+	{
+		if (is_capture_mode || src == source)
+		{
+			owned_engine_idxs.push_back(s.source_infos.at(src)->engine_idx);
+		}
+	}
+
+	// comparing rules requires all the matching rules of both sides
+	const auto rule_matching = s.diff != nullptr ? falco_common::rule_matching::ALL : s.config->m_rule_matching;
+
+	// synthetic events are looped over and always rebased to the present time
+	const auto& replay_cfg = s.config->m_replay;
+	event_pacer pacer = is_capture_mode
+		? event_pacer(replay_cfg.m_speed, replay_cfg.m_events_per_second, replay_cfg.m_loop, replay_cfg.m_rebase_timestamps)
+		: event_pacer(0, is_synthetic ? s.config->m_nodriver.m_synthetic.m_events_per_second : 0, is_synthetic, is_synthetic);
 
 	// note(jasondellaluce): The "syscall" event source will always be loaded
 	// by default in an inspector, and at index 0. As such, in live mode we would
@@ -158,6 +447,20 @@ static falco::app::run_result do_inspect(
 				s.config->m_syscall_evt_simulate_drops);
 	}
 
+	if (is_capture_mode && s.capture_index != nullptr)
+	{
+		scap_index::query q;
+		q.start_ts = replay_cfg.m_start_time;
+		q.end_ts = replay_cfg.m_end_time;
+		q.tids = replay_cfg.m_tids;
+		// in rules diff mode, events must be evaluated by both sets of rules
+		if (s.diff == nullptr)
+		{
+			q.event_types = s.engine->event_codes_for_ruleset(falco_common::syscall_source);
+		}
+		skip_ranges = s.capture_index->skippable_ranges(q);
+	}
+
 	//
 	// Start capture
 	//
@@ -168,36 +471,101 @@ static falco::app::run_result do_inspect(
 	//
 	while(1)
 	{
+		heartbeat->enter(stall_detector::stage::next_event);
+
+		if(next_skip_range < skip_ranges.size())
+		{
+			// the read position is always at a block boundary between events
+			uint64_t pos = inspector->get_bytes_read();
+			while(next_skip_range < skip_ranges.size() && skip_ranges[next_skip_range].first < pos)
+			{
+				next_skip_range++;
+			}
+			if(next_skip_range < skip_ranges.size() && skip_ranges[next_skip_range].first == pos)
+			{
+				inspector->fseek(skip_ranges[next_skip_range].second);
+				skipped_bytes += skip_ranges[next_skip_range].second - pos;
+				next_skip_range++;
+			}
+		}
+
 		rc = inspector->next(&ev);
 
-		if (falco::app::g_reopen_outputs_signal.triggered())
+		if(mailbox->pending()) [[unlikely]]
 		{
-			falco::app::g_reopen_outputs_signal.handle([&s](){
-				falco_logger::log(falco_logger::level::INFO, "SIGUSR1 received, reopening outputs...\n");
-				if(s.outputs != nullptr)
+			uint32_t posted = mailbox->take(commands);
+			if(command_mailbox::has(posted, command_mailbox::command_type::reopen_outputs))
+			{
+				falco::app::g_reopen_outputs_signal.handle([&s](){
+					falco_logger::log(falco_logger::level::INFO, "SIGUSR1 received, reopening outputs...\n");
+					if(s.outputs != nullptr)
+					{
+						s.outputs->reopen_outputs();
+					}
+					falco::app::g_reopen_outputs_signal.reset();
+				});
+			}
+			if(command_mailbox::has(posted, command_mailbox::command_type::dump_rule_traces))
+			{
+				falco::app::g_dump_rule_traces_signal.handle([&s](){
+					falco_logger::log(falco_logger::level::INFO, "SIGUSR2 received, dumping the rule traces...\n");
+					dump_rule_traces(s);
+					falco::app::g_dump_rule_traces_signal.reset();
+				});
+			}
+
+			for(const auto& c : commands)
+			{
+				if(c.type != command_mailbox::command_type::enable_rule
+					&& c.type != command_mailbox::command_type::disable_rule)
 				{
-					s.outputs->reopen_outputs();
+					continue;
 				}
-				falco::app::g_reopen_outputs_signal.reset();
-			});
-		}
+				bool enable = c.type == command_mailbox::command_type::enable_rule;
+				try
+				{
+					for(auto idx : owned_engine_idxs)
+					{
+						auto ruleset = s.engine->ruleset_for_source(idx);
+						if(enable)
+						{
+							ruleset->enable(c.arg, filter_ruleset::match_type::exact, s.engine->default_ruleset_id());
+						}
+						else
+						{
+							ruleset->disable(c.arg, filter_ruleset::match_type::exact, s.engine->default_ruleset_id());
+						}
+					}
+				}
+				catch(falco_exception& e)
+				{
+					// the filter of a rule is compiled when first enabled
+					falco_logger::log(falco_logger::level::ERR, std::string("Could not enable rule '") + c.arg + "': " + e.what() + "\n");
+					continue;
+				}
+				falco_logger::log(falco_logger::level::DEBUG, std::string("Rule '") + c.arg + "' "
+					+ (enable ? "enabled" : "disabled") + " in the event processing loop of "
+					+ (is_capture_mode ? "the capture file" : "source " + source) + "\n");
+			}
 
-		if(falco::app::g_terminate_signal.triggered())
-		{
-			falco::app::g_terminate_signal.handle([&](){
-				falco_logger::log(falco_logger::level::INFO, "SIGINT received, exiting...\n");
-			});
-			break;
-		}
-		else if(falco::app::g_restart_signal.triggered())
-		{
-			falco::app::g_restart_signal.handle([&s](){
-				falco_logger::log(falco_logger::level::INFO, "SIGHUP received, restarting...\n");
-				s.restart.store(true);
-			});
-			break;
+			if(command_mailbox::has(posted, command_mailbox::command_type::terminate))
+			{
+				falco::app::g_terminate_signal.handle([&](){
+					falco_logger::log(falco_logger::level::INFO, "SIGINT received, exiting...\n");
+				});
+				break;
+			}
+			else if(command_mailbox::has(posted, command_mailbox::command_type::restart))
+			{
+				falco::app::g_restart_signal.handle([&s](){
+					falco_logger::log(falco_logger::level::INFO, "SIGHUP received, restarting...\n");
+					s.restart.store(true);
+				});
+				break;
+			}
 		}
-		else if(rc == SCAP_TIMEOUT)
+
+		if(rc == SCAP_TIMEOUT)
 		{
 			if(ev == nullptr) [[unlikely]]
 			{
@@ -229,6 +597,36 @@ static falco::app::run_result do_inspect(
 		}
 		else if(rc == SCAP_EOF)
 		{
+			if(is_capture_mode && s.diff != nullptr && next_diff_capture < s.options.rules_diff_captures.size())
+			{
+				const auto& filename = s.options.rules_diff_captures[next_diff_capture++];
+				falco_logger::log(falco_logger::level::INFO, "Replaying events from the capture file: " + filename + "\n");
+				inspector->close();
+				inspector->open_savefile(filename);
+				inspector->start_capture();
+				s.diff->start_capture(filename);
+				skip_ranges.clear();
+				pacer.restart();
+				continue;
+			}
+			if(is_capture_mode && s.config->m_replay.m_loop && num_evts > 0)
+			{
+				falco_logger::log(falco_logger::level::DEBUG, "Capture file consumed, replaying it from the beginning\n");
+				inspector->close();
+				inspector->open_savefile(s.config->m_replay.m_capture_file);
+				inspector->start_capture();
+				pacer.restart();
+				next_skip_range = 0;
+				continue;
+			}
+			if(is_synthetic)
+			{
+				inspector->close();
+				s.synthetic_events->open(*inspector);
+				inspector->start_capture();
+				pacer.restart();
+				continue;
+			}
 			break;
 		}
 		else if(rc != SCAP_SUCCESS)
@@ -283,6 +681,31 @@ static falco::app::run_result do_inspect(
 			stats_collector.collect(inspector, source, num_evts);
 		}
 
+		FALCO_PROBE3(event_dequeued, source_engine_idx, ev->get_type(), ev->get_num());
+
+		// events out of the replay time window or of other threads still
+		// update the inspector state, but are not evaluated against the rules
+		if(is_capture_mode)
+		{
+			if(replay_cfg.m_end_time > 0 && ev->get_ts() > replay_cfg.m_end_time
+				&& !replay_cfg.m_loop && next_diff_capture >= s.options.rules_diff_captures.size())
+			{
+				break;
+			}
+			if(ev->get_ts() < replay_cfg.m_start_time
+				|| (replay_cfg.m_end_time > 0 && ev->get_ts() > replay_cfg.m_end_time)
+				|| (!replay_cfg.m_tids.empty() && replay_cfg.m_tids.find(ev->get_tid()) == replay_cfg.m_tids.end()))
+			{
+				continue;
+			}
+		}
+
+		if(pacer.enabled())
+		{
+			heartbeat->enter(stall_detector::stage::idle);
+			pacer.pace(ev);
+		}
+
 		// Reset the timeouts counter, Falco successfully got an event to process
 		timeouts_since_last_success_or_msg = 0;
 		if(duration_start == 0)
@@ -307,8 +730,29 @@ static falco::app::run_result do_inspect(
 		// engine, which will match the event against the set
 		// of rules. If a match is found, pass the event to
 		// the outputs.
-		auto res = s.engine->process_event(source_engine_idx, ev, s.config->m_rule_matching);
-		if(res != nullptr)
+		heartbeat->set_event(ev->get_type());
+		heartbeat->enter(stall_detector::stage::rules);
+		const bool shadow_sampled = s.shadow != nullptr && s.shadow->should_sample(source_engine_idx);
+		uint64_t prod_start_ns = shadow_sampled ? shadow_evaluator::thread_cpu_ns() : 0;
+		auto res = s.engine->process_event(source_engine_idx, ev, rule_matching);
+		if(shadow_sampled)
+		{
+			s.shadow->on_production_result(source_engine_idx,
+				shadow_evaluator::thread_cpu_ns() - prod_start_ns,
+				res != nullptr ? res->size() : 0);
+		}
+		heartbeat->enter(stall_detector::stage::outputs);
+		if(report_slow_evals
+			&& s.engine->last_slow_evaluation(source_engine_idx, slow_eval)) [[unlikely]]
+		{
+			report_slow_evaluation(s, slow_evals_bucket, slow_evals_suppressed, ev, slow_eval);
+		}
+		if(s.diff != nullptr)
+		{
+			// alerts are replaced by the final comparison report
+			s.diff->process_event(source_engine_idx, ev, rule_matching, res.get());
+		}
+		else if(res != nullptr)
 		{
 			for(auto& rule_res : *res)
 			{
@@ -316,9 +760,37 @@ static falco::app::run_result do_inspect(
 			}
 		}
 
+		heartbeat->enter(stall_detector::stage::post_processing);
+		if(s.exporter != nullptr)
+		{
+			s.exporter->process_event(source_engine_idx, ev);
+		}
+
+		// shadow rules never produce alerts and are evaluated after the
+		// production ones, so that they can't delay them
+		if(shadow_sampled)
+		{
+			s.shadow->evaluate(source_engine_idx, ev, s.config->m_rule_matching);
+		}
+
 		num_evts++;
 	}
 
+	if(skipped_bytes > 0)
+	{
+		falco_logger::log(falco_logger::level::INFO, "Skipped " + std::to_string(skipped_bytes) + " bytes of the capture file using its index\n");
+	}
+
+	if(rule_matching == falco_common::rule_matching::PRIORITY)
+	{
+		log_priority_match_stats(s, source);
+	}
+
+	if(s.config->m_compiled_rules.m_verify)
+	{
+		log_compiled_rules_mismatches(s, source);
+	}
+
 	return run_result::ok();
 }
 
@@ -339,6 +811,8 @@ static void process_inspector_events(
 		uint64_t num_evts = 0;
 		syscall_evt_drop_mgr sdropmgr;
 		bool is_capture_mode = source.empty();
+		cpu_profiler::set_thread_role(is_capture_mode ? "capture"
+			: source == falco_common::syscall_source ? source : "plugin:" + source);
 		bool check_drops_timeouts = is_capture_mode
 			|| (source == falco_common::syscall_source && !s.is_gvisor());
 
@@ -435,8 +909,19 @@ falco::app::run_result falco::app::actions::process_events(falco::app::state& s)
 	// Notify engine that we finished loading and enabling all rules
 	s.engine->complete_rule_loading();
 
+	if (s.config->m_stall_detector.m_enabled && !s.options.dry_run)
+	{
+		const auto& cfg = s.config->m_stall_detector;
+		s.stall_monitor = std::make_shared<stall_detector>(s.engine,
+			cfg.m_threshold_ms, cfg.m_check_interval_ms, cfg.m_max_logs_per_minute,
+			[](const stall_detector::snapshot& snap)
+			{
+				falco_logger::log(falco_logger::level::WARNING, stall_detector::format(snap) + "\n");
+			});
+	}
+
 	// Initialize stats writer
-	auto statsw = std::make_shared<stats_writer>(s.outputs, s.config, s.engine);
+	auto statsw = std::make_shared<stats_writer>(s.outputs, s.config, s.engine, s.shadow, s.stall_monitor, s.budget);
 	auto res = init_stats_writer(statsw, s.config, s.options.dry_run);
 
 	if (s.options.dry_run)
@@ -450,6 +935,11 @@ falco::app::run_result falco::app::actions::process_events(falco::app::state& s)
 		return res;
 	}
 
+	if (s.stall_monitor != nullptr)
+	{
+		s.stall_monitor->start();
+	}
+
 	// Start processing events
 	bool termination_forced = false;
 	if(s.is_capture_mode())
@@ -460,9 +950,46 @@ falco::app::run_result falco::app::actions::process_events(falco::app::state& s)
 			return res;
 		}
 
+		if (s.diff != nullptr)
+		{
+			s.diff->start_capture(s.config->m_replay.m_capture_file);
+		}
+
 		process_inspector_events(s, s.offline_inspector, statsw, "", nullptr, &res);
 		s.offline_inspector->close();
 
+		if (s.exporter != nullptr)
+		{
+			try
+			{
+				auto rows = s.exporter->close();
+				falco_logger::log(falco_logger::level::INFO, "Exported " + std::to_string(rows) + " events to " + s.config->m_capture_export.m_output_file + "\n");
+			}
+			catch (const std::exception& e)
+			{
+				return run_result::fatal(e.what());
+			}
+		}
+
+		if (s.diff != nullptr && res.success)
+		{
+			auto report = s.diff->report().dump(2);
+			if (s.options.rules_diff_report.empty())
+			{
+				printf("%s\n", report.c_str());
+			}
+			else
+			{
+				std::ofstream out(s.options.rules_diff_report);
+				out << report << std::endl;
+				if (!out.good())
+				{
+					return run_result::fatal("Could not write rules diff report to " + s.options.rules_diff_report);
+				}
+				falco_logger::log(falco_logger::level::INFO, "Rules diff report written to " + s.options.rules_diff_report + "\n");
+			}
+		}
+
 		// Honor -M also when using a trace file.
 		// Since inspection stops as soon as all events have been consumed
 		// just await the given duration is reached, if needed.
@@ -544,6 +1071,7 @@ falco::app::run_result falco::app::actions::process_events(falco::app::state& s)
 				falco_logger::log(falco_logger::level::INFO, "An error occurred in an event source, forcing termination...\n");
 				falco::app::g_terminate_signal.trigger();
 				falco::app::g_terminate_signal.handle([&](){});
+				falco::app::g_command_bus.broadcast(command_mailbox::command_type::terminate);
 				termination_forced = true;
 			}
 
@@ -583,7 +1111,18 @@ falco::app::run_result falco::app::actions::process_events(falco::app::state& s)
 		}
 	}
 
+	if (s.stall_monitor != nullptr)
+	{
+		s.stall_monitor->stop();
+		auto stats = s.stall_monitor->get_stats();
+		if (stats.stalls > 0)
+		{
+			falco_logger::log(falco_logger::level::INFO, "Detected " + std::to_string(stats.stalls) + " event processing stalls, the longest lasted " + std::to_string(stats.max_ms) + "ms\n");
+		}
+	}
+
 	s.engine->print_stats();
+	dump_rule_traces(s);
 
 	return res;
 }
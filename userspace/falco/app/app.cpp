@@ -19,10 +19,13 @@ limitations under the License.
 #include "state.h"
 #include "signals.h"
 #include "actions/actions.h"
+#include "falco_usdt.h"
 
 falco::atomic_signal_handler falco::app::g_terminate_signal;
 falco::atomic_signal_handler falco::app::g_restart_signal;
 falco::atomic_signal_handler falco::app::g_reopen_outputs_signal;
+falco::atomic_signal_handler falco::app::g_dump_rule_traces_signal;
+command_bus falco::app::g_command_bus;
 
 using app_action = std::function<falco::app::run_result(falco::app::state&)>;
 
@@ -65,6 +68,7 @@ bool falco::app::run(falco::app::state& s, bool& restart, std::string& errstr)
 		falco::app::actions::print_kernel_version,
 		falco::app::actions::print_version,
 		falco::app::actions::print_page_size,
+		falco::app::actions::index_capture_files,
 		falco::app::actions::print_generated_gvisor_config,
 		falco::app::actions::print_ignored_events,
 		falco::app::actions::print_syscall_events,
@@ -78,6 +82,9 @@ bool falco::app::run(falco::app::state& s, bool& restart, std::string& errstr)
 		falco::app::actions::select_event_sources,
 		falco::app::actions::validate_rules_files,
 		falco::app::actions::load_rules_files,
+		falco::app::actions::load_shadow_rules_files,
+		falco::app::actions::load_rules_diff_files,
+		falco::app::actions::init_capture_export,
 		falco::app::actions::print_support,
 		falco::app::actions::init_outputs,
 		falco::app::actions::create_signal_handlers,
@@ -98,6 +105,7 @@ bool falco::app::run(falco::app::state& s, bool& restart, std::string& errstr)
 		falco::app::actions::close_inspectors,
 	};
 
+	FALCO_PROBE(app_start);
 	falco::app::run_result res = falco::app::run_result::ok();
 	for (const auto &func : run_steps)
 	{
@@ -107,7 +115,9 @@ bool falco::app::run(falco::app::state& s, bool& restart, std::string& errstr)
 			break;
 		}
 	}
+	FALCO_PROBE1(app_steps_done, res.success);
 
+	FALCO_PROBE(app_teardown);
 	for (const auto &func : teardown_steps)
 	{
 		res = falco::app::run_result::merge(res, func(s));
@@ -120,6 +130,7 @@ bool falco::app::run(falco::app::state& s, bool& restart, std::string& errstr)
 	}
 
 	restart = s.restart;
+	FALCO_PROBE1(app_end, restart);
 
 	return res.success;
 }
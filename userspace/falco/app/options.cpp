@@ -95,6 +95,14 @@ bool options::parse(int argc, char **argv, std::string &errstr)
 		}
 	}
 
+	if(m_cmdline_parsed.count("rules-diff") > 0)
+	{
+		for(auto &path : m_cmdline_parsed["rules-diff"].as<std::vector<std::string>>())
+		{
+			rules_diff_filenames.push_back(path);
+		}
+	}
+
 	// Convert the vectors of enabled/disabled tags into sets to match falco engine API
 	if(m_cmdline_parsed.count("T") > 0)
 	{
@@ -129,6 +137,12 @@ bool options::parse(int argc, char **argv, std::string &errstr)
 		return false;
 	}
 
+	if(rules_diff_filenames.empty() && (!rules_diff_captures.empty() || !rules_diff_report.empty()))
+	{
+		errstr = std::string("You can not specify --rules-diff-capture or --rules-diff-report without --rules-diff");
+		return false;
+	}
+
 	list_fields = m_cmdline_parsed.count("list") > 0;
 
 	return true;
@@ -150,6 +164,7 @@ void options::define(cxxopts::Options& opts)
 #endif
 		("A",                             "Monitor all events supported by Falco and defined in rules and configs. Some events are ignored by default when -A is not specified (the -i option lists these events ignored). Using -A can impact performance. This option has no effect when reproducing events from a capture file.", cxxopts::value(all_events)->default_value("false"))
 		("b,print-base64",                "Print data buffers in base64. This is useful for encoding binary data that needs to be used over media designed to consume this format.")
+		("codegen-rules",                 "Generate the C++ source of a library with the compiled conditions of the loaded rules into the specified <path> and exit. See the compiled_rules configuration for more details.", cxxopts::value(codegen_rules_filename), "<path>")
 #if !defined(_WIN32) && !defined(__EMSCRIPTEN__) && !defined(MINIMAL_BUILD)
 		("cri",                           "Path to CRI socket for container metadata. Use the specified <path> to fetch data from a CRI-compatible runtime. If not specified, built-in defaults for commonly known paths are used. This option can be passed multiple times to specify a list of sockets to be tried until a successful one is found.", cxxopts::value(cri_socket_paths), "<path>")
 		("disable-cri-async",             "Turn off asynchronous CRI metadata fetching. This is useful to let the input event wait for the container metadata fetch to finish before moving forward. Async fetching, in some environments leads to empty fields for container metadata when the fetch is not fast enough to be completed asynchronously. This can have a performance penalty on your environment depending on the number of containers and the frequency at which they are created/started/stopped.", cxxopts::value(disable_cri_async)->default_value("false"))
@@ -161,6 +176,7 @@ void options::define(cxxopts::Options& opts)
 #ifdef HAS_GVISOR
 		("gvisor-generate-config",		  "Generate a configuration file that can be used for gVisor and exit. See --gvisor-config for more details.", cxxopts::value<std::string>(gvisor_generate_config_with_socket)->implicit_value("/run/falco/gvisor.sock"), "<socket_path>")
 #endif
+		("index-capture",                 "Create a sidecar index for the specified uncompressed <capture_file> and exit. The index is used when replaying the capture to skip the parts that can't match the configured time window, thread ids and the event types of the loaded rules (see engine.replay.use_index). This option can be passed multiple times.", cxxopts::value(index_capture_filenames), "<capture_file>")
 		("i",                             "Print those events that are ignored by default for performance reasons and exit. See -A for more details.", cxxopts::value(print_ignored_events)->default_value("false"))
 		("L",                             "Show the name and description of all rules and exit. If json_output is set to true, it prints details about all rules, macros, and lists in JSON format.", cxxopts::value(describe_all_rules)->default_value("false"))
 		("l",                             "Show the name and description of the rule specified <rule> and exit. If json_output is set to true, it prints details about the rule in JSON format.", cxxopts::value(describe_rule), "<rule>")
@@ -175,6 +191,9 @@ void options::define(cxxopts::Options& opts)
 		("p,print",                       "Print (or replace) additional information in the rule's output.\nUse -pc or -pcontainer to append container details.\nUse -pk or -pkubernetes to add both container and Kubernetes details.\nIf using gVisor, choose -pcg or -pkg variants (or -pcontainer-gvisor and -pkubernetes-gvisor, respectively).\nIf a rule's output contains %container.info, it will be replaced with the corresponding details. Otherwise, these details will be directly appended to the rule's output.\nAlternatively, use -p <output_format> for a custom format. In this case, the given <output_format> will be appended to the rule's output without any replacement.", cxxopts::value(print_additional), "<output_format>")
 		("P,pidfile",                     "Write PID to specified <pid_file> path. By default, no PID file is created.", cxxopts::value(pidfilename)->default_value(""), "<pid_file>")
 		("r",                             "Rules file or directory to be loaded. This option can be passed multiple times. Falco defaults to the values in the configuration file when this option is not specified.", cxxopts::value<std::vector<std::string>>(), "<rules_file>")
+		("rules-diff",                    "Compare the rules loaded via -r or the configuration file (the baseline) with the candidate rules of the specified <rules_file> file or directory, while replaying a capture file. No alert is emitted and a JSON report with the per-rule differences in matches and evaluation cost is written at the end. This option can be passed multiple times and requires engine.kind=replay.", cxxopts::value<std::vector<std::string>>(), "<rules_file>")
+		("rules-diff-capture",            "Additional capture file to replay after the one configured in engine.replay.capture_file when used in conjunction with --rules-diff. This option can be passed multiple times.", cxxopts::value(rules_diff_captures), "<capture_file>")
+		("rules-diff-report",             "Write the --rules-diff report to the specified <path> instead of the standard output.", cxxopts::value(rules_diff_report), "<path>")
 		("S,snaplen",                     "Collect only the first <len> bytes of each I/O buffer for 'syscall' events. By default, the first 80 bytes are collected by the driver and sent to the user space for processing. Use this option with caution since it can have a strong performance impact.", cxxopts::value(snaplen)->default_value("0"), "<len>")
 		("support",                       "Print support information, including version, rules files used, loaded configuration, etc., and exit. The output is in JSON format.", cxxopts::value(print_support)->default_value("false"))
 		("T",                             "DEPRECATED: use -o rules[].disable.tag=<tag> instead. Turn off any rules with a tag=<tag>. This option can be passed multiple times. This option can not be mixed with -t.", cxxopts::value<std::vector<std::string>>(), "<tag>")
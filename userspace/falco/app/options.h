@@ -65,6 +65,10 @@ public:
 	std::string pidfilename;
 	// Rules list as passed by the user, via cmdline option '-r'
 	std::list<std::string> rules_filenames;
+	// Candidate rules list compared with the ones above, via cmdline option '--rules-diff'
+	std::list<std::string> rules_diff_filenames;
+	std::vector<std::string> rules_diff_captures;
+	std::string rules_diff_report;
 	uint64_t snaplen = 0;
 	bool print_support = false;
 	std::set<std::string> disabled_rule_tags;
@@ -74,6 +78,8 @@ public:
 	bool verbose = false;
 	bool print_version_info = false;
 	bool print_page_size = false;
+	std::vector<std::string> index_capture_filenames;
+	std::string codegen_rules_filename;
 	bool dry_run = false;
 
 	bool parse(int argc, char **argv, std::string &errstr);
@@ -160,6 +160,7 @@ void falco::app::restart_handler::watcher_loop() noexcept
             {
                 // todo(jasondellaluce): make this a callback too maybe?
                 g_restart_signal.trigger();
+                g_command_bus.broadcast(command_mailbox::command_type::restart);
                 return;
             }
 
@@ -18,6 +18,7 @@ limitations under the License.
 #pragma once
 
 #include "../atomic_signal_handler.h"
+#include "../command_mailbox.h"
 
 namespace falco {
 namespace app {
@@ -25,6 +26,11 @@ namespace app {
 extern atomic_signal_handler g_terminate_signal;
 extern atomic_signal_handler g_restart_signal;
 extern atomic_signal_handler g_reopen_outputs_signal;
+extern atomic_signal_handler g_dump_rule_traces_signal;
+
+// delivers the signals above, and the other control commands, to the
+// running event processing loops
+extern command_bus g_command_bus;
 
 }; // namespace app
 }; // namespace falco
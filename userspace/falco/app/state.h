@@ -23,6 +23,13 @@ limitations under the License.
 #include "restart_handler.h"
 #include "../configuration.h"
 #include "../stats_writer.h"
+#include "../shadow_evaluator.h"
+#include "../ruleset_diff.h"
+#include "../capture_exporter.h"
+#include "../stall_detector.h"
+#include "../memory_budget.h"
+#include "../scap_index.h"
+#include "../synthetic_event_generator.h"
 #if !defined(_WIN32) && !defined(__EMSCRIPTEN__) && !defined(MINIMAL_BUILD)
 #include "../grpc_server.h"
 #include "../webserver.h"
@@ -85,6 +92,20 @@ struct state
     std::shared_ptr<falco_outputs> outputs;
     std::shared_ptr<falco_engine> engine;
 
+    // If non-null, evaluates the shadow rules next to the production ones
+    std::shared_ptr<shadow_evaluator> shadow;
+    // If non-null, compares the loaded rules with candidate ones (capture mode only)
+    std::shared_ptr<ruleset_diff> diff;
+    // If non-null, exports the field values of the captured events (capture mode only)
+    std::shared_ptr<capture_exporter> exporter;
+    // If non-null, monitors the event processing threads for stalls
+    std::shared_ptr<stall_detector> stall_monitor;
+    // If non-null, bounds the memory held by the outputs queues
+    std::shared_ptr<memory_budget> budget;
+    // Handle of the compiled_rules library, never unloaded since the
+    // engine may refer to it until the process exits
+    void* compiled_rules_library = nullptr;
+
     // The set of loaded event sources (by default, the syscall event
     // source plus all event sources coming from the loaded plugins).
     // note: this has to be a vector to preserve the loading order,
@@ -99,6 +120,9 @@ struct state
     // this is also used to open the capture file and read its events
     std::shared_ptr<sinsp> offline_inspector;
 
+    // If non-null, the sidecar index of the capture file being replayed
+    std::shared_ptr<scap_index> capture_index;
+
     // List of all the information mapped to each event source
     // indexed by event source name
     indexed_vector<source_info> source_infos;
@@ -113,6 +137,10 @@ struct state
     // Dimension of the syscall buffer in bytes.
     uint64_t syscall_buffer_bytes_size = DEFAULT_DRIVER_BUFFER_BYTES_DIM;
 
+    // Generator of synthetic syscall events, used when the nodriver
+    // engine is configured to produce them for stress testing
+    std::shared_ptr<synthetic_event_generator> synthetic_events;
+
     // Helper responsible for watching of handling hot application restarts
     std::shared_ptr<restart_handler> restarter;
 
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "capture_exporter.h"
+
+// Value rendered by the formatters for fields that can't be extracted
+static const std::string s_missing_value = "<NA>";
+
+capture_exporter::capture_exporter(
+		size_t source_idx,
+		std::shared_ptr<sinsp_filter> filter,
+		std::shared_ptr<sinsp_evt_formatter> formatter,
+		const std::vector<std::string>& fields,
+		std::unique_ptr<columnar_writer> writer)
+	: m_source_idx(source_idx),
+	  m_filter(filter),
+	  m_formatter(formatter),
+	  m_fields(fields),
+	  m_writer(std::move(writer))
+{
+	m_row.resize(m_fields.size());
+}
+
+void capture_exporter::process_event(size_t source_idx, sinsp_evt* ev)
+{
+	if (source_idx != m_source_idx || (m_filter != nullptr && !m_filter->run(ev)))
+	{
+		return;
+	}
+
+	// a partial extraction is fine, missing fields are exported as null
+	m_values.clear();
+	m_formatter->get_field_values(ev, m_values);
+	for (size_t i = 0; i < m_fields.size(); i++)
+	{
+		auto it = m_values.find(m_fields[i]);
+		m_row[i] = (it == m_values.end() || it->second == s_missing_value) ? nullptr : &it->second;
+	}
+	m_writer->append(m_row);
+}
+
+uint64_t capture_exporter::close()
+{
+	m_writer->close();
+	return m_writer->num_rows();
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "columnar_writer.h"
+
+#include <libsinsp/sinsp.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+	\brief Exports the values of a fixed list of fields, extracted from the
+	events of a capture that satisfy an optional condition, into a file
+	with a columnar layout (see columnar_writer). Not thread-safe, meant to
+	be used in capture mode only.
+*/
+class capture_exporter
+{
+public:
+	/*!
+		\brief Creates an exporter for the events of the given source.
+		The formatter must reference all the given fields, and filter can
+		be null to export all the events.
+	*/
+	capture_exporter(
+		size_t source_idx,
+		std::shared_ptr<sinsp_filter> filter,
+		std::shared_ptr<sinsp_evt_formatter> formatter,
+		const std::vector<std::string>& fields,
+		std::unique_ptr<columnar_writer> writer);
+
+	/*!
+		\brief Appends a row with the field values of the event, if it
+		belongs to the exported source and matches the condition
+	*/
+	void process_event(size_t source_idx, sinsp_evt* ev);
+
+	/*!
+		\brief Flushes and closes the output file, and returns the number
+		of exported rows. Throws a falco_exception on failure.
+	*/
+	uint64_t close();
+
+private:
+	size_t m_source_idx;
+	std::shared_ptr<sinsp_filter> m_filter;
+	std::shared_ptr<sinsp_evt_formatter> m_formatter;
+	std::vector<std::string> m_fields;
+	std::unique_ptr<columnar_writer> m_writer;
+
+	// reused across events to avoid reallocations
+	std::map<std::string, std::string> m_values;
+	std::vector<const std::string*> m_row;
+};
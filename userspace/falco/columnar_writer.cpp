@@ -0,0 +1,425 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "columnar_writer.h"
+#include "falco_common.h"
+
+#include <zlib.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+// Maximum number of full row groups waiting for the background writer,
+// the caller blocks once this is reached
+static constexpr size_t s_max_pending_row_groups = 4;
+
+static bool parse_u64(const std::string& s, uint64_t& out)
+{
+	if (s.empty() || s[0] == '-')
+	{
+		return false;
+	}
+	char* end = nullptr;
+	errno = 0;
+	out = strtoull(s.c_str(), &end, 10);
+	return errno == 0 && *end == '\0';
+}
+
+static bool parse_i64(const std::string& s, int64_t& out)
+{
+	if (s.empty())
+	{
+		return false;
+	}
+	char* end = nullptr;
+	errno = 0;
+	out = strtoll(s.c_str(), &end, 10);
+	return errno == 0 && *end == '\0';
+}
+
+static bool parse_f64(const std::string& s, double& out)
+{
+	if (s.empty())
+	{
+		return false;
+	}
+	char* end = nullptr;
+	errno = 0;
+	out = strtod(s.c_str(), &end);
+	return errno == 0 && *end == '\0';
+}
+
+static bool parse_bool(const std::string& s, uint64_t& out)
+{
+	if (s == "true" || s == "1")
+	{
+		out = 1;
+		return true;
+	}
+	if (s == "false" || s == "0")
+	{
+		out = 0;
+		return true;
+	}
+	return false;
+}
+
+static bool ends_with(const std::string& s, const std::string& suffix)
+{
+	return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+const char* columnar_writer::type_name(column_type t)
+{
+	switch (t)
+	{
+	case column_type::u64:
+		return "u64";
+	case column_type::i64:
+		return "i64";
+	case column_type::f64:
+		return "f64";
+	case column_type::boolean:
+		return "bool";
+	default:
+		return "string";
+	}
+}
+
+columnar_writer::columnar_writer(
+		const std::string& filename,
+		const std::vector<column_info>& columns,
+		size_t row_group_size,
+		const nlohmann::json& metadata)
+	: m_columns(columns),
+	  m_row_group_size(row_group_size)
+{
+	// the "T" mode writes a plain file through the same zlib API
+	m_file = gzopen(filename.c_str(), ends_with(filename, ".gz") ? "wb" : "wbT");
+	if (m_file == nullptr)
+	{
+		throw falco_exception("Could not open export file " + filename + ": " + strerror(errno));
+	}
+
+	nlohmann::json header = metadata;
+	header["columns"] = nlohmann::json::array();
+	for (const auto& c : m_columns)
+	{
+		nlohmann::json jc;
+		jc["name"] = c.name;
+		jc["type"] = type_name(c.type);
+		header["columns"].push_back(jc);
+	}
+	write_line(header.dump());
+
+	m_current = new_row_group();
+	m_thread = std::thread(&columnar_writer::writer_loop, this);
+}
+
+columnar_writer::~columnar_writer()
+{
+	try
+	{
+		close();
+	}
+	catch (...)
+	{
+		// errors are only reported by explicit close() calls
+	}
+}
+
+std::unique_ptr<columnar_writer::row_group> columnar_writer::new_row_group()
+{
+	auto g = std::make_unique<row_group>();
+	g->id = m_next_row_group_id++;
+	g->columns.resize(m_columns.size());
+	for (size_t i = 0; i < m_columns.size(); i++)
+	{
+		g->columns[i].type = m_columns[i].type;
+	}
+	return g;
+}
+
+void columnar_writer::append_string(column& c, const std::string& v)
+{
+	auto it = c.dictionary_index.find(v);
+	if (it == c.dictionary_index.end())
+	{
+		it = c.dictionary_index.emplace(v, (uint32_t) c.dictionary.size()).first;
+		c.dictionary.push_back(v);
+	}
+	c.indices.push_back(it->second);
+}
+
+void columnar_writer::convert_to_string(column& c)
+{
+	for (size_t i = 0; i < c.valid.size(); i++)
+	{
+		if (!c.valid[i])
+		{
+			c.indices.push_back(0);
+			continue;
+		}
+		switch (c.type)
+		{
+		case column_type::u64:
+			append_string(c, std::to_string(c.u64[i]));
+			break;
+		case column_type::i64:
+			append_string(c, std::to_string(c.i64[i]));
+			break;
+		case column_type::f64:
+			append_string(c, nlohmann::json(c.f64[i]).dump());
+			break;
+		case column_type::boolean:
+			append_string(c, c.u64[i] ? "true" : "false");
+			break;
+		default:
+			break;
+		}
+	}
+	c.u64.clear();
+	c.i64.clear();
+	c.f64.clear();
+	c.type = column_type::string;
+}
+
+void columnar_writer::append(const std::vector<const std::string*>& values)
+{
+	for (size_t i = 0; i < m_columns.size(); i++)
+	{
+		auto& c = m_current->columns[i];
+		const std::string* v = i < values.size() ? values[i] : nullptr;
+		if (v == nullptr)
+		{
+			c.valid.push_back(false);
+			switch (c.type)
+			{
+			case column_type::i64:
+				c.i64.push_back(0);
+				break;
+			case column_type::f64:
+				c.f64.push_back(0);
+				break;
+			case column_type::string:
+				c.indices.push_back(0);
+				break;
+			default:
+				c.u64.push_back(0);
+				break;
+			}
+			continue;
+		}
+
+		bool parsed = true;
+		switch (c.type)
+		{
+		case column_type::u64:
+		{
+			uint64_t u;
+			if ((parsed = parse_u64(*v, u)))
+			{
+				c.u64.push_back(u);
+			}
+			break;
+		}
+		case column_type::i64:
+		{
+			int64_t n;
+			if ((parsed = parse_i64(*v, n)))
+			{
+				c.i64.push_back(n);
+			}
+			break;
+		}
+		case column_type::f64:
+		{
+			double d;
+			if ((parsed = parse_f64(*v, d)))
+			{
+				c.f64.push_back(d);
+			}
+			break;
+		}
+		case column_type::boolean:
+		{
+			uint64_t b;
+			if ((parsed = parse_bool(*v, b)))
+			{
+				c.u64.push_back(b);
+			}
+			break;
+		}
+		default:
+			append_string(c, *v);
+			break;
+		}
+
+		if (!parsed)
+		{
+			convert_to_string(c);
+			append_string(c, *v);
+		}
+		c.valid.push_back(true);
+	}
+
+	m_num_rows++;
+	if (++m_current->num_rows >= m_row_group_size)
+	{
+		push_row_group();
+	}
+}
+
+void columnar_writer::push_row_group()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	m_cv.wait(lock, [this]{ return m_queue.size() < s_max_pending_row_groups || !m_error.empty(); });
+	if (!m_error.empty())
+	{
+		throw falco_exception(m_error);
+	}
+	m_queue.push_back(std::move(m_current));
+	m_current = new_row_group();
+	m_cv.notify_all();
+}
+
+std::string columnar_writer::serialize(const row_group& g, const std::vector<column_info>& infos)
+{
+	nlohmann::json j;
+	j["row_group"] = g.id;
+	j["num_rows"] = g.num_rows;
+	j["columns"] = nlohmann::json::array();
+	for (size_t i = 0; i < g.columns.size(); i++)
+	{
+		const auto& c = g.columns[i];
+		nlohmann::json jc;
+		jc["name"] = infos[i].name;
+		jc["type"] = type_name(c.type);
+		auto values = nlohmann::json::array();
+		for (size_t r = 0; r < c.valid.size(); r++)
+		{
+			if (!c.valid[r])
+			{
+				values.push_back(nullptr);
+				continue;
+			}
+			switch (c.type)
+			{
+			case column_type::u64:
+				values.push_back(c.u64[r]);
+				break;
+			case column_type::i64:
+				values.push_back(c.i64[r]);
+				break;
+			case column_type::f64:
+				values.push_back(c.f64[r]);
+				break;
+			case column_type::boolean:
+				values.push_back(c.u64[r] != 0);
+				break;
+			default:
+				values.push_back(c.indices[r]);
+				break;
+			}
+		}
+		if (c.type == column_type::string)
+		{
+			jc["dictionary"] = c.dictionary;
+			jc["indices"] = std::move(values);
+		}
+		else
+		{
+			jc["values"] = std::move(values);
+		}
+		j["columns"].push_back(std::move(jc));
+	}
+	return j.dump();
+}
+
+void columnar_writer::write_line(const std::string& line)
+{
+	if (gzwrite(m_file, line.c_str(), line.size()) != (int) line.size()
+		|| gzputc(m_file, '\n') != '\n')
+	{
+		int errnum = 0;
+		throw falco_exception(std::string("Could not write to export file: ") + gzerror(m_file, &errnum));
+	}
+}
+
+void columnar_writer::writer_loop()
+{
+	while (true)
+	{
+		std::unique_ptr<row_group> g;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_cv.wait(lock, [this]{ return !m_queue.empty() || m_stop; });
+			if (m_queue.empty())
+			{
+				return;
+			}
+			g = std::move(m_queue.front());
+			m_queue.pop_front();
+			m_cv.notify_all();
+		}
+
+		try
+		{
+			write_line(serialize(*g, m_columns));
+		}
+		catch (const std::exception& e)
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_error = e.what();
+			m_queue.clear();
+			m_cv.notify_all();
+			return;
+		}
+	}
+}
+
+void columnar_writer::close()
+{
+	if (m_closed)
+	{
+		return;
+	}
+	m_closed = true;
+
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if (m_current->num_rows > 0 && m_error.empty())
+		{
+			m_queue.push_back(std::move(m_current));
+		}
+		m_stop = true;
+		m_cv.notify_all();
+	}
+	m_thread.join();
+
+	if (gzclose(m_file) != Z_OK && m_error.empty())
+	{
+		m_error = "Could not close export file";
+	}
+	m_file = nullptr;
+
+	if (!m_error.empty())
+	{
+		throw falco_exception(m_error);
+	}
+}
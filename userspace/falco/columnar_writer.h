@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*!
+	\brief Writes rows of values into a file in a columnar layout. Rows are
+	accumulated in row groups, and each full row group is serialized and
+	written by a background thread, so that the caller only pays for
+	parsing and dictionary-encoding the values.
+
+	The file is made of JSON lines: the first one describes the columns,
+	and each of the following ones holds a row group, column by column.
+	String columns are dictionary-encoded within each row group. Missing
+	values are encoded as null. The file is gzip-compressed if its name
+	ends with ".gz".
+*/
+class columnar_writer
+{
+public:
+	enum class column_type
+	{
+		u64,
+		i64,
+		f64,
+		boolean,
+		string
+	};
+
+	struct column_info
+	{
+		std::string name;
+		column_type type;
+	};
+
+	/*!
+		\brief Opens the output file and writes the header line, which
+		holds the column infos and the given metadata. Throws a
+		falco_exception if the file can't be opened.
+	*/
+	columnar_writer(
+		const std::string& filename,
+		const std::vector<column_info>& columns,
+		size_t row_group_size,
+		const nlohmann::json& metadata);
+	virtual ~columnar_writer();
+	columnar_writer(columnar_writer&&) = delete;
+	columnar_writer& operator = (columnar_writer&&) = delete;
+	columnar_writer(const columnar_writer&) = delete;
+	columnar_writer& operator = (const columnar_writer&) = delete;
+
+	/*!
+		\brief Appends a row. values[i] is the value of the i-th column
+		in its textual representation, or nullptr if missing. A value
+		that can't be parsed as the type of its column turns the column
+		into a string one for the current row group.
+	*/
+	void append(const std::vector<const std::string*>& values);
+
+	/*!
+		\brief Writes the pending rows, stops the background thread and
+		closes the file. Throws a falco_exception if any write failed.
+	*/
+	void close();
+
+	inline uint64_t num_rows() const
+	{
+		return m_num_rows;
+	}
+
+	static const char* type_name(column_type t);
+
+private:
+	struct column
+	{
+		column_type type;
+		std::vector<bool> valid;
+		std::vector<uint64_t> u64;
+		std::vector<int64_t> i64;
+		std::vector<double> f64;
+		std::vector<uint32_t> indices;
+		std::vector<std::string> dictionary;
+		std::unordered_map<std::string, uint32_t> dictionary_index;
+	};
+
+	struct row_group
+	{
+		uint64_t id = 0;
+		size_t num_rows = 0;
+		std::vector<column> columns;
+	};
+
+	std::unique_ptr<row_group> new_row_group();
+	static void append_string(column& c, const std::string& v);
+	static void convert_to_string(column& c);
+	static std::string serialize(const row_group& g, const std::vector<column_info>& infos);
+	void push_row_group();
+	void write_line(const std::string& line);
+	void writer_loop();
+
+	std::vector<column_info> m_columns;
+	size_t m_row_group_size;
+	uint64_t m_num_rows = 0;
+	uint64_t m_next_row_group_id = 0;
+	std::unique_ptr<row_group> m_current;
+	struct gzFile_s* m_file = nullptr;
+	bool m_closed = false;
+
+	std::thread m_thread;
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+	std::deque<std::unique_ptr<row_group>> m_queue;
+	bool m_stop = false;
+	std::string m_error;
+};
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "command_mailbox.h"
+
+static_assert(command_bus::max_mailboxes <= 32, "mailboxes must fit in a 32 bit mask");
+
+void command_mailbox::post(const command& c)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_commands.push_back(c);
+	}
+	post(c.type);
+}
+
+uint32_t command_mailbox::take(std::vector<command>& commands)
+{
+	// a command queued right after the exchange is taken too, leaving its
+	// bit set with an empty queue for the next call, which is harmless
+	uint32_t res = m_pending.exchange(0, std::memory_order_acquire);
+	std::unique_lock<std::mutex> lock(m_mtx);
+	commands.clear();
+	commands.swap(m_commands);
+	return res;
+}
+
+void command_mailbox::reset()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	m_commands.clear();
+	m_pending.store(0, std::memory_order_release);
+}
+
+command_mailbox* command_bus::open()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	uint32_t open = m_open.load(std::memory_order_acquire);
+	for (size_t i = 0; i < max_mailboxes; i++)
+	{
+		if (!(open & (1u << i)))
+		{
+			// clear what was left over by broadcasts racing with the
+			// last close, before the mailbox gets visible
+			m_mailboxes[i].reset();
+			m_open.fetch_or(1u << i, std::memory_order_acq_rel);
+			return &m_mailboxes[i];
+		}
+	}
+	return nullptr;
+}
+
+void command_bus::close(command_mailbox* m)
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	auto i = m - m_mailboxes.data();
+	m_open.fetch_and(~(1u << i), std::memory_order_acq_rel);
+}
+
+void command_bus::broadcast(command_mailbox::command_type t)
+{
+	uint32_t open = m_open.load(std::memory_order_acquire);
+	for (size_t i = 0; i < max_mailboxes; i++)
+	{
+		if (open & (1u << i))
+		{
+			m_mailboxes[i].post(t);
+		}
+	}
+}
+
+void command_bus::broadcast(const command_mailbox::command& c)
+{
+	uint32_t open = m_open.load(std::memory_order_acquire);
+	for (size_t i = 0; i < max_mailboxes; i++)
+	{
+		if (open & (1u << i))
+		{
+			m_mailboxes[i].post(c);
+		}
+	}
+}
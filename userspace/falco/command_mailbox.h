@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*!
+	\brief A mailbox through which other threads hand commands to an event
+	processing loop, which applies them between two events. Checking for
+	pending commands costs a single relaxed atomic load, so that the loop
+	can do it at every iteration.
+
+	Commands without arguments are only recorded as bits in an atomic mask,
+	and posting them is lock-free and async-signal-safe. Repeated posts of
+	the same command before the loop takes it are coalesced. Commands with
+	arguments are queued in order.
+*/
+class command_mailbox
+{
+public:
+	enum class command_type : uint32_t
+	{
+		terminate = 1 << 0,
+		restart = 1 << 1,
+		reopen_outputs = 1 << 2,
+		enable_rule = 1 << 3,
+		disable_rule = 1 << 4,
+		dump_rule_traces = 1 << 5,
+	};
+
+	struct command
+	{
+		command_type type;
+		std::string arg;
+	};
+
+	/*!
+		\brief Returns true if any command has been posted since the last
+		call to take().
+	*/
+	inline bool pending() const
+	{
+		return m_pending.load(std::memory_order_relaxed) != 0;
+	}
+
+	/*!
+		\brief Posts a command without arguments. This is safe to be
+		invoked from within a signal handler.
+	*/
+	inline void post(command_type t)
+	{
+		m_pending.fetch_or((uint32_t) t, std::memory_order_release);
+	}
+
+	/*!
+		\brief Queues a command with its argument.
+	*/
+	void post(const command& c);
+
+	/*!
+		\brief Returns the mask of the posted command types, and moves the
+		queued commands into the given vector. The mailbox is empty after
+		this returns.
+	*/
+	uint32_t take(std::vector<command>& commands);
+
+	/*!
+		\brief Drops all the posted commands.
+	*/
+	void reset();
+
+	static inline bool has(uint32_t mask, command_type t)
+	{
+		return (mask & (uint32_t) t) != 0;
+	}
+
+private:
+	std::atomic<uint32_t> m_pending{0};
+	std::mutex m_mtx;
+	std::vector<command> m_commands;
+};
+
+/*!
+	\brief A fixed set of command mailboxes, one for each running event
+	processing loop, which allows broadcasting commands to all of them.
+	Mailboxes are preallocated so that broadcasting never races with a
+	loop opening or closing its own.
+*/
+class command_bus
+{
+public:
+	static constexpr size_t max_mailboxes = 32;
+
+	/*!
+		\brief Returns an empty mailbox that receives all the commands
+		broadcast from now on, or nullptr if all of them are in use.
+	*/
+	command_mailbox* open();
+
+	/*!
+		\brief Releases a mailbox returned by open().
+	*/
+	void close(command_mailbox* m);
+
+	/*!
+		\brief Posts a command without arguments to all the open mailboxes.
+		This is safe to be invoked from within a signal handler.
+	*/
+	void broadcast(command_mailbox::command_type t);
+
+	/*!
+		\brief Posts a command with its argument to all the open mailboxes.
+	*/
+	void broadcast(const command_mailbox::command& c);
+
+private:
+	std::array<command_mailbox, max_mailboxes> m_mailboxes;
+	std::atomic<uint32_t> m_open{0};
+	// serializes open() and close(), never taken when broadcasting
+	std::mutex m_mtx;
+};
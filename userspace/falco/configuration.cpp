@@ -235,6 +235,27 @@ void falco_configuration::load_engine_config(const std::string& config_name)
 		{
 			throw std::logic_error("Error reading config file (" + config_name + "): engine.kind is 'replay' but no engine.replay.capture_file specified.");
 		}
+		m_replay.m_speed = config.get_scalar<double>("engine.replay.speed", 0);
+		if (m_replay.m_speed < 0)
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): engine.replay.speed must be a non-negative number.");
+		}
+		m_replay.m_events_per_second = config.get_scalar<uint64_t>("engine.replay.events_per_second", 0);
+		if (m_replay.m_speed > 0 && m_replay.m_events_per_second > 0)
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): engine.replay.speed and engine.replay.events_per_second are mutually exclusive.");
+		}
+		m_replay.m_loop = config.get_scalar<bool>("engine.replay.loop", false);
+		m_replay.m_rebase_timestamps = config.get_scalar<bool>("engine.replay.rebase_timestamps", false);
+		m_replay.m_start_time = config.get_scalar<uint64_t>("engine.replay.time_window.start", 0);
+		m_replay.m_end_time = config.get_scalar<uint64_t>("engine.replay.time_window.end", 0);
+		if (m_replay.m_end_time > 0 && m_replay.m_end_time < m_replay.m_start_time)
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): engine.replay.time_window.end must not precede engine.replay.time_window.start.");
+		}
+		m_replay.m_tids.clear();
+		config.get_sequence<std::set<int64_t>>(m_replay.m_tids, "engine.replay.tids");
+		m_replay.m_use_index = config.get_scalar<bool>("engine.replay.use_index", true);
 		break;
 	case engine_kind_t::GVISOR:
 		m_gvisor.m_config = config.get_scalar<std::string>("engine.gvisor.config", "");
@@ -245,9 +266,70 @@ void falco_configuration::load_engine_config(const std::string& config_name)
 		m_gvisor.m_root = config.get_scalar<std::string>("engine.gvisor.root", "");
 		break;
 	case engine_kind_t::NODRIVER:
+		{
+			auto& synth = m_nodriver.m_synthetic;
+			synth = {};
+			synth.m_enabled = config.get_scalar<bool>("engine.nodriver.synthetic.enabled", false);
+			synth.m_events_per_second = config.get_scalar<uint64_t>("engine.nodriver.synthetic.events_per_second", 0);
+			config.get_sequence<std::vector<synthetic_event_weight>>(synth.m_event_mix, "engine.nodriver.synthetic.event_mix");
+			synth.m_processes = config.get_scalar<uint32_t>("engine.nodriver.synthetic.processes", 16);
+			synth.m_fds_per_process = config.get_scalar<uint32_t>("engine.nodriver.synthetic.fds_per_process", 16);
+			synth.m_min_string_len = config.get_scalar<uint32_t>("engine.nodriver.synthetic.string_length.min", 8);
+			synth.m_max_string_len = config.get_scalar<uint32_t>("engine.nodriver.synthetic.string_length.max", 64);
+			synth.m_string_pattern = config.get_scalar<std::string>("engine.nodriver.synthetic.string_pattern", "random");
+			synth.m_pool_size = config.get_scalar<uint32_t>("engine.nodriver.synthetic.pool_size", 65536);
+			synth.m_seed = config.get_scalar<uint64_t>("engine.nodriver.synthetic.seed", 0);
+			if (synth.m_enabled)
+			{
+				if (synth.m_processes == 0 || synth.m_fds_per_process == 0 || synth.m_pool_size == 0)
+				{
+					throw std::logic_error("Error reading config file (" + config_name + "): engine.nodriver.synthetic processes, fds_per_process and pool_size must be greater than zero.");
+				}
+				if (synth.m_min_string_len > synth.m_max_string_len)
+				{
+					throw std::logic_error("Error reading config file (" + config_name + "): engine.nodriver.synthetic.string_length.min can't be greater than max.");
+				}
+				if (synth.m_max_string_len > synthetic_config::max_string_len)
+				{
+					throw std::logic_error("Error reading config file (" + config_name + "): engine.nodriver.synthetic.string_length.max can't be greater than " + std::to_string(synthetic_config::max_string_len) + ".");
+				}
+				if (synth.m_string_pattern != "random" && synth.m_string_pattern != "repeated")
+				{
+					throw std::logic_error("Error reading config file (" + config_name + "): engine.nodriver.synthetic.string_pattern must be one of: random, repeated.");
+				}
+				if (synth.m_event_mix.empty())
+				{
+					synth.m_event_mix = {{"openat", 30}, {"read", 30}, {"write", 10}, {"close", 30}};
+				}
+			}
+		}
+		break;
 	default:
 		break;
 	}
+
+	m_capture_export = {};
+	m_capture_export.m_enabled = config.get_scalar<bool>("capture_export.enabled", false);
+	m_capture_export.m_output_file = config.get_scalar<std::string>("capture_export.output_file", "");
+	m_capture_export.m_source = config.get_scalar<std::string>("capture_export.source", "syscall");
+	m_capture_export.m_condition = config.get_scalar<std::string>("capture_export.condition", "");
+	config.get_sequence<std::vector<std::string>>(m_capture_export.m_fields, "capture_export.fields");
+	m_capture_export.m_row_group_size = config.get_scalar<uint32_t>("capture_export.row_group_size", 65536);
+	if (m_capture_export.m_enabled)
+	{
+		if (m_engine_mode != engine_kind_t::REPLAY)
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): capture_export is only supported with engine.kind 'replay'.");
+		}
+		if (m_capture_export.m_output_file.empty() || m_capture_export.m_fields.empty())
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): capture_export requires an output_file and at least one field.");
+		}
+		if (m_capture_export.m_row_group_size == 0)
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): capture_export.row_group_size must be greater than zero.");
+		}
+	}
 }
 
 void falco_configuration::load_yaml(const std::string& config_name)
@@ -404,6 +486,50 @@ void falco_configuration::load_yaml(const std::string& config_name)
 		m_outputs.push_back(http_output);
 	}
 
+	m_otlp_output = {};
+	m_otlp_output.name = "otlp";
+	m_otlp_metrics_enabled = false;
+	if(config.get_scalar<bool>("otlp_output.enabled", false))
+	{
+		std::string endpoint = config.get_scalar<std::string>("otlp_output.endpoint", "");
+		if(endpoint.empty())
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): otlp output enabled but no endpoint in configuration block");
+		}
+		m_otlp_output.options["endpoint"] = endpoint;
+
+		std::vector<std::string> headers;
+		config.get_sequence<std::vector<std::string>>(headers, "otlp_output.headers");
+		std::string joined_headers;
+		for(const auto& h : headers)
+		{
+			joined_headers += h + "\n";
+		}
+		m_otlp_output.options["headers"] = joined_headers;
+
+		auto batch_size = config.get_scalar<uint32_t>("otlp_output.batch_size", 512);
+		auto max_pending_batches = config.get_scalar<uint32_t>("otlp_output.max_pending_batches", 64);
+		if(batch_size == 0 || max_pending_batches == 0)
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): otlp_output.batch_size and otlp_output.max_pending_batches must be greater than 0");
+		}
+		m_otlp_output.options["batch_size"] = std::to_string(batch_size);
+		m_otlp_output.options["max_pending_batches"] = std::to_string(max_pending_batches);
+		m_otlp_output.options["linger_ms"] = std::to_string(config.get_scalar<uint32_t>("otlp_output.linger_ms", 1000));
+		m_otlp_output.options["max_retries"] = std::to_string(config.get_scalar<uint32_t>("otlp_output.max_retries", 3));
+		m_otlp_output.options["retry_backoff_ms"] = std::to_string(config.get_scalar<uint32_t>("otlp_output.retry_backoff_ms", 500));
+		m_otlp_output.options["timeout_ms"] = std::to_string(config.get_scalar<uint32_t>("otlp_output.timeout_ms", 10000));
+		m_otlp_output.options["compress"] = config.get_scalar<bool>("otlp_output.compress", true) ? std::string("true") : std::string("false");
+		m_otlp_output.options["insecure"] = config.get_scalar<bool>("otlp_output.insecure", false) ? std::string("true") : std::string("false");
+		m_otlp_output.options["ca_cert"] = config.get_scalar<std::string>("otlp_output.ca_cert", "");
+
+		if(config.get_scalar<bool>("otlp_output.alerts_enabled", true))
+		{
+			m_outputs.push_back(m_otlp_output);
+		}
+		m_otlp_metrics_enabled = config.get_scalar<bool>("otlp_output.metrics_enabled", false);
+	}
+
 	m_grpc_enabled = config.get_scalar<bool>("grpc.enabled", false);
 	m_grpc_bind_address = config.get_scalar<std::string>("grpc.bind_address", "0.0.0.0:5060");
 	m_grpc_threadiness = config.get_scalar<uint32_t>("grpc.threadiness", 0);
@@ -429,7 +555,7 @@ void falco_configuration::load_yaml(const std::string& config_name)
 	std::string rule_matching = config.get_scalar<std::string>("rule_matching", "first");
 	if (!falco_common::parse_rule_matching(rule_matching, m_rule_matching))
 	{
-		throw std::logic_error("Unknown rule matching strategy \"" + rule_matching + "\"--must be one of first, all");
+		throw std::logic_error("Unknown rule matching strategy \"" + rule_matching + "\"--must be one of first, all, priority");
 	}
 
 	std::string priority = config.get_scalar<std::string>("priority", "debug");
@@ -465,6 +591,9 @@ void falco_configuration::load_yaml(const std::string& config_name)
 		m_webserver_config.m_threadiness = falco::utils::hardware_concurrency();
 	}
 	m_webserver_config.m_prometheus_metrics_enabled = config.get_scalar<bool>("webserver.prometheus_metrics_enabled", false);
+	m_webserver_config.m_profiler_enabled = config.get_scalar<bool>("webserver.profiler_enabled", false);
+	m_webserver_config.m_profiler_max_duration_s = config.get_scalar<uint32_t>("webserver.profiler_max_duration_s", 60);
+	m_webserver_config.m_rules_control_enabled = config.get_scalar<bool>("webserver.rules_control_enabled", false);
 
 	std::list<std::string> syscall_event_drop_acts;
 	config.get_sequence(syscall_event_drop_acts, "syscall_event_drops.actions");
@@ -561,6 +690,106 @@ void falco_configuration::load_yaml(const std::string& config_name)
 
 	config.get_sequence<std::vector<rule_selection_config>>(m_rules_selection, "rules");
 
+	m_rules_dispatch_fields = config.get_scalar<std::map<std::string, std::string>>("rules_dispatch_fields", {});
+
+	m_rule_eval_report = {};
+	m_rule_eval_report.m_enabled = config.get_scalar<bool>("rule_evaluation_report.enabled", false);
+	m_rule_eval_report.m_max_field_lengths = config.get_scalar<std::map<std::string, size_t>>("rule_evaluation_report.max_field_lengths", {});
+	m_rule_eval_report.m_event_budget_us = config.get_scalar<uint64_t>("rule_evaluation_report.event_budget_us", 0);
+	m_rule_eval_report.m_alert_rate = config.get_scalar<double>("rule_evaluation_report.alert_rate", 1);
+	m_rule_eval_report.m_alert_max_burst = config.get_scalar<double>("rule_evaluation_report.alert_max_burst", 10);
+	if (m_rule_eval_report.m_enabled)
+	{
+		for (const auto& l : m_rule_eval_report.m_max_field_lengths)
+		{
+			if (l.second == 0)
+			{
+				throw std::logic_error("Error reading config file (" + config_name + "): rule_evaluation_report.max_field_lengths." + l.first + " must be greater than zero.");
+			}
+		}
+		if (m_rule_eval_report.m_event_budget_us == 0)
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): rule_evaluation_report.event_budget_us must be greater than zero.");
+		}
+		if (m_rule_eval_report.m_alert_rate <= 0 || m_rule_eval_report.m_alert_max_burst < 1)
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): rule_evaluation_report.alert_rate must be greater than zero and rule_evaluation_report.alert_max_burst at least one.");
+		}
+	}
+
+	m_compiled_rules = {};
+	m_compiled_rules.m_library = config.get_scalar<std::string>("compiled_rules.library", "");
+	m_compiled_rules.m_verify = config.get_scalar<bool>("compiled_rules.verify", false);
+
+	m_rule_trace = {};
+	m_rule_trace.m_enabled = config.get_scalar<bool>("rule_trace.enabled", false);
+	config.get_sequence<std::set<std::string>>(m_rule_trace.m_rules, "rule_trace.rules");
+	config.get_sequence<std::set<std::string>>(m_rule_trace.m_processes, "rule_trace.processes");
+	m_rule_trace.m_sampling_ratio = config.get_scalar<uint64_t>("rule_trace.sampling_ratio", 1);
+	m_rule_trace.m_max_value_length = config.get_scalar<uint32_t>("rule_trace.max_value_length", 64);
+	m_rule_trace.m_capacity = config.get_scalar<uint32_t>("rule_trace.capacity", 1000);
+	m_rule_trace.m_file = config.get_scalar<std::string>("rule_trace.file", "");
+	if (m_rule_trace.m_enabled)
+	{
+		if (m_rule_trace.m_rules.empty())
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): rule_trace is enabled but no rule_trace.rules specified.");
+		}
+		if (m_rule_trace.m_sampling_ratio == 0 || m_rule_trace.m_capacity == 0)
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): rule_trace.sampling_ratio and rule_trace.capacity must be greater than zero.");
+		}
+	}
+
+	m_shadow_rules = {};
+	m_shadow_rules.m_enabled = config.get_scalar<bool>("shadow_rules.enabled", false);
+	config.get_sequence<std::list<std::string>>(m_shadow_rules.m_rules_filenames, "shadow_rules.rules_files");
+	m_shadow_rules.m_sample_ratio = config.get_scalar<uint32_t>("shadow_rules.sample_ratio", 10);
+	m_shadow_rules.m_max_cpu_pct = config.get_scalar<double>("shadow_rules.max_cpu_pct", 5);
+	if (m_shadow_rules.m_enabled)
+	{
+		if (m_shadow_rules.m_rules_filenames.empty())
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): shadow_rules is enabled but no shadow_rules.rules_files specified.");
+		}
+		if (m_shadow_rules.m_sample_ratio == 0)
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): shadow_rules.sample_ratio must be greater than zero.");
+		}
+		if (m_shadow_rules.m_max_cpu_pct <= 0 || m_shadow_rules.m_max_cpu_pct > 100)
+		{
+			throw std::logic_error("Error reading config file (" + config_name + "): shadow_rules.max_cpu_pct must be in the range (0, 100].");
+		}
+	}
+
+	m_stall_detector = {};
+	m_stall_detector.m_enabled = config.get_scalar<bool>("stall_detector.enabled", false);
+	m_stall_detector.m_threshold_ms = config.get_scalar<uint32_t>("stall_detector.threshold_ms", 200);
+	m_stall_detector.m_check_interval_ms = config.get_scalar<uint32_t>("stall_detector.check_interval_ms", 50);
+	m_stall_detector.m_max_logs_per_minute = config.get_scalar<uint32_t>("stall_detector.max_logs_per_minute", 10);
+	if (m_stall_detector.m_enabled
+		&& (m_stall_detector.m_threshold_ms == 0 || m_stall_detector.m_check_interval_ms == 0))
+	{
+		throw std::logic_error("Error reading config file (" + config_name + "): stall_detector.threshold_ms and stall_detector.check_interval_ms must be greater than zero.");
+	}
+
+	m_memory_budget = {};
+	m_memory_budget.m_enabled = config.get_scalar<bool>("memory_budget.enabled", false);
+	m_memory_budget.m_limit_mb = config.get_scalar<uint64_t>("memory_budget.limit_mb", 256);
+	m_memory_budget.m_shrink_threshold_pct = config.get_scalar<uint32_t>("memory_budget.shrink_threshold_pct", 70);
+	m_memory_budget.m_summarize_threshold_pct = config.get_scalar<uint32_t>("memory_budget.summarize_threshold_pct", 85);
+	m_memory_budget.m_drop_threshold_pct = config.get_scalar<uint32_t>("memory_budget.drop_threshold_pct", 95);
+	m_memory_budget.m_shrunk_queue_capacity = config.get_scalar<uint32_t>("memory_budget.shrunk_queue_capacity", 1000);
+	m_memory_budget.m_summary_max_len = config.get_scalar<uint32_t>("memory_budget.summary_max_len", 256);
+	if (m_memory_budget.m_enabled
+		&& (m_memory_budget.m_limit_mb == 0
+			|| m_memory_budget.m_shrink_threshold_pct > m_memory_budget.m_summarize_threshold_pct
+			|| m_memory_budget.m_summarize_threshold_pct > m_memory_budget.m_drop_threshold_pct
+			|| m_memory_budget.m_drop_threshold_pct > 100))
+	{
+		throw std::logic_error("Error reading config file (" + config_name + "): memory_budget.limit_mb must be greater than zero, and the thresholds must be increasing percentages.");
+	}
+
 	std::vector<std::string> load_plugins;
 
 	bool load_plugins_node_defined = config.is_defined("load_plugins");
@@ -611,6 +840,8 @@ void falco_configuration::load_yaml(const std::string& config_name)
 		}
 	}
 
+	m_plugins_batch_extraction = config.get_scalar<bool>("plugins_batch_extraction", false);
+
 	m_watch_config_files = config.get_scalar<bool>("watch_config_files", true);
 }
 
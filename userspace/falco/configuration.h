@@ -28,6 +28,7 @@ limitations under the License.
 #include <string>
 #include <vector>
 #include <list>
+#include <map>
 #include <set>
 #include <iostream>
 #include <fstream>
@@ -76,6 +77,22 @@ public:
 
 	struct replay_config {
 		std::string m_capture_file;
+		// Pacing: 0 replays as fast as possible, 1 follows the original
+		// timestamps, N replays N times faster than the original timeline.
+		double m_speed = 0;
+		// Pacing: fixed event rate target, overrides m_speed when non-zero.
+		uint64_t m_events_per_second = 0;
+		bool m_loop = false;
+		bool m_rebase_timestamps = false;
+		// Only events within this time window (in ns since epoch, 0 means
+		// unbounded) and generated by these thread ids (empty means all)
+		// are evaluated against the rules.
+		uint64_t m_start_time = 0;
+		uint64_t m_end_time = 0;
+		std::set<int64_t> m_tids;
+		// Skip the blocks of the capture that can't match, using the
+		// sidecar index of the capture file if present and up to date
+		bool m_use_index = true;
 	};
 
 	struct gvisor_config {
@@ -83,6 +100,45 @@ public:
 		std::string m_root;
 	};
 
+	struct synthetic_event_weight {
+		std::string m_syscall;
+		uint32_t m_weight = 1;
+	};
+
+	struct synthetic_config {
+		bool m_enabled = false;
+		// 0 means generating events as fast as possible
+		uint64_t m_events_per_second = 0;
+		std::vector<synthetic_event_weight> m_event_mix;
+		uint32_t m_processes = 16;
+		uint32_t m_fds_per_process = 16;
+		// the strings are parameters of events with 16-bit lengths,
+		// including their terminator, so they can't be longer than
+		// max_string_len
+		static constexpr uint32_t max_string_len = 65534;
+		uint32_t m_min_string_len = 8;
+		uint32_t m_max_string_len = 64;
+		// "random" strings of lowercase letters, or "repeated" ones made
+		// of a single letter, which are the worst case of most matchers
+		std::string m_string_pattern = "random";
+		// number of events generated up front and replayed in a loop
+		uint32_t m_pool_size = 65536;
+		uint64_t m_seed = 0;
+	};
+
+	struct nodriver_config {
+		synthetic_config m_synthetic;
+	};
+
+	struct capture_export_config {
+		bool m_enabled = false;
+		std::string m_output_file;
+		std::string m_source = "syscall";
+		std::string m_condition;
+		std::vector<std::string> m_fields;
+		uint32_t m_row_group_size = 65536;
+	};
+
 	struct webserver_config {
 		uint32_t m_threadiness = 0;
 		uint32_t m_listen_port = 8765;
@@ -91,6 +147,56 @@ public:
 		bool m_ssl_enabled = false;
 		std::string m_ssl_certificate;
 		bool m_prometheus_metrics_enabled = false;
+		bool m_profiler_enabled = false;
+		uint32_t m_profiler_max_duration_s = 60;
+		bool m_rules_control_enabled = false;
+	};
+
+	struct shadow_rules_config {
+		bool m_enabled = false;
+		std::list<std::string> m_rules_filenames;
+		uint32_t m_sample_ratio = 10;
+		double m_max_cpu_pct = 5;
+	};
+
+	struct stall_detector_config {
+		bool m_enabled = false;
+		uint32_t m_threshold_ms = 200;
+		uint32_t m_check_interval_ms = 50;
+		uint32_t m_max_logs_per_minute = 10;
+	};
+
+	struct memory_budget_config {
+		bool m_enabled = false;
+		uint64_t m_limit_mb = 256;
+		uint32_t m_shrink_threshold_pct = 70;
+		uint32_t m_summarize_threshold_pct = 85;
+		uint32_t m_drop_threshold_pct = 95;
+		uint32_t m_shrunk_queue_capacity = 1000;
+		uint32_t m_summary_max_len = 256;
+	};
+
+	struct rule_eval_report_config {
+		bool m_enabled = false;
+		std::map<std::string, size_t> m_max_field_lengths;
+		uint64_t m_event_budget_us = 0;
+		double m_alert_rate = 1;
+		double m_alert_max_burst = 10;
+	};
+
+	struct compiled_rules_config {
+		std::string m_library;
+		bool m_verify = false;
+	};
+
+	struct rule_trace_config {
+		bool m_enabled = false;
+		std::set<std::string> m_rules;
+		std::set<std::string> m_processes;
+		uint64_t m_sampling_ratio = 1;
+		uint32_t m_max_value_length = 64;
+		uint32_t m_capacity = 1000;
+		std::string m_file;
 	};
 
 	enum class rule_selection_operation {
@@ -131,12 +237,22 @@ public:
 	std::list<std::string> m_loaded_rules_folders;
 	// Rule selection options passed by the user
 	std::vector<rule_selection_config> m_rules_selection;
+	// Candidate rules evaluated without emitting alerts
+	shadow_rules_config m_shadow_rules;
+	// Field indexing the rules of each plugin source, by source name
+	std::map<std::string, std::string> m_rules_dispatch_fields;
+	rule_eval_report_config m_rule_eval_report;
+	compiled_rules_config m_compiled_rules;
+	rule_trace_config m_rule_trace;
 
 	bool m_json_output;
 	bool m_json_include_output_property;
 	bool m_json_include_tags_property;
 	std::string m_log_level;
 	std::vector<falco::outputs::config> m_outputs;
+	// Options of the OTLP exporters, shared by alerts and metrics
+	falco::outputs::config m_otlp_output;
+	bool m_otlp_metrics_enabled = false;
 
 	falco_common::priority_type m_min_priority;
 	falco_common::rule_matching m_rule_matching;
@@ -181,7 +297,10 @@ public:
 	uint32_t m_metrics_flags;
 	bool m_metrics_convert_memory_to_mb;
 	bool m_metrics_include_empty_values;
+	stall_detector_config m_stall_detector;
+	memory_budget_config m_memory_budget;
 	std::vector<plugin_config> m_plugins;
+	bool m_plugins_batch_extraction = false;
 
 	// Falco engine
 	engine_kind_t m_engine_mode = engine_kind_t::KMOD;
@@ -190,6 +309,8 @@ public:
 	modern_ebpf_config m_modern_ebpf = {};
 	replay_config m_replay = {};
 	gvisor_config m_gvisor = {};
+	nodriver_config m_nodriver = {};
+	capture_export_config m_capture_export = {};
 
 	// Needed by tests
 	yaml_helper config;
@@ -295,6 +416,29 @@ namespace YAML {
 		}
 	};
 
+	template<>
+	struct convert<falco_configuration::synthetic_event_weight> {
+		static Node encode(const falco_configuration::synthetic_event_weight & rhs) {
+			Node node;
+			node["syscall"] = rhs.m_syscall;
+			node["weight"] = rhs.m_weight;
+			return node;
+		}
+
+		static bool decode(const Node& node, falco_configuration::synthetic_event_weight & rhs) {
+			if(!node.IsMap() || !node["syscall"])
+			{
+				return false;
+			}
+			rhs.m_syscall = node["syscall"].as<std::string>();
+			if(node["weight"])
+			{
+				rhs.m_weight = node["weight"].as<uint32_t>();
+			}
+			return true;
+		}
+	};
+
 	template<>
 	struct convert<falco_configuration::plugin_config> {
 
@@ -0,0 +1,318 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "cpu_profiler.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+#if defined(__linux__) && defined(__GLIBC__)
+#define HAS_CPU_PROFILER
+#endif
+
+#ifdef HAS_CPU_PROFILER
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#endif
+
+static constexpr size_t s_role_size = 32;
+
+static thread_local char t_role[s_role_size] = "other";
+
+static std::mutex s_disabled_mtx;
+static std::string s_disabled_reason;
+
+void cpu_profiler::set_thread_role(const std::string& role)
+{
+	auto len = std::min(role.size(), s_role_size - 1);
+	memcpy(t_role, role.c_str(), len);
+	t_role[len] = '\0';
+}
+
+void cpu_profiler::set_disabled_reason(const std::string& reason)
+{
+	std::lock_guard<std::mutex> lock(s_disabled_mtx);
+	s_disabled_reason = reason;
+}
+
+static std::string disabled_reason()
+{
+	std::lock_guard<std::mutex> lock(s_disabled_mtx);
+	return s_disabled_reason;
+}
+
+#ifdef HAS_CPU_PROFILER
+
+// Maximum depth of the unwound stacks
+static constexpr int s_max_depth = 48;
+
+// Frames of the signal handler and of the signal trampoline, which are at
+// the top of every unwound stack
+static constexpr int s_skipped_frames = 2;
+
+// Upper bound of the samples kept by a single profile
+static constexpr size_t s_max_samples = 20000;
+
+struct sample
+{
+	char role[s_role_size];
+	int depth;
+	void* pcs[s_max_depth];
+};
+
+// State shared with the signal handler. The handler never allocates and
+// only touches the preallocated samples while the profiler is armed.
+static std::atomic<bool> s_armed{false};
+static std::atomic<uint32_t> s_in_flight{0};
+static std::atomic<size_t> s_next_sample{0};
+static std::atomic<uint64_t> s_dropped{0};
+static sample* s_samples = nullptr;
+static size_t s_capacity = 0;
+
+static std::atomic<bool> s_running{false};
+
+static void on_sigprof(int, siginfo_t*, void*)
+{
+	int saved_errno = errno;
+	// sequentially consistent, paired with the disarming in profile(): either
+	// the handler sees the profiler disarmed, or profile() sees it in flight
+	s_in_flight.fetch_add(1);
+	if (s_armed.load())
+	{
+		size_t i = s_next_sample.fetch_add(1, std::memory_order_relaxed);
+		if (i < s_capacity)
+		{
+			auto& s = s_samples[i];
+			memcpy(s.role, t_role, s_role_size);
+			s.depth = backtrace(s.pcs, s_max_depth);
+		}
+		else
+		{
+			s_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	s_in_flight.fetch_sub(1, std::memory_order_release);
+	errno = saved_errno;
+}
+
+static bool install_handler(std::string& err)
+{
+	// the handler stays installed once set, so that a SIGPROF still
+	// pending after a profile never reaches the default action, which
+	// terminates the process
+	static std::once_flag s_once;
+	static bool s_installed = false;
+	std::call_once(s_once, [&err]()
+	{
+		// backtrace() lazily loads libgcc on its first call, which is not
+		// safe in a signal handler
+		void* warmup[1];
+		backtrace(warmup, 1);
+
+		struct sigaction sa = {};
+		sa.sa_sigaction = on_sigprof;
+		// SA_ONSTACK lets the handler run on the alternate signal stack of
+		// the threads that have one, which the Go runtime requires
+		sa.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+		sigemptyset(&sa.sa_mask);
+		if (sigaction(SIGPROF, &sa, nullptr) != 0)
+		{
+			err = std::string("could not install the SIGPROF handler: ") + strerror(errno);
+			return;
+		}
+		s_installed = true;
+	});
+	if (!s_installed && err.empty())
+	{
+		err = "the SIGPROF handler could not be installed";
+	}
+	return s_installed;
+}
+
+static bool set_timer(uint32_t frequency_hz)
+{
+	struct itimerval tv = {};
+	if (frequency_hz > 0)
+	{
+		tv.it_interval.tv_sec = 0;
+		tv.it_interval.tv_usec = 1000000 / frequency_hz;
+		tv.it_value = tv.it_interval;
+	}
+	return setitimer(ITIMER_PROF, &tv, nullptr) == 0;
+}
+
+static std::string symbolize(void* pc)
+{
+	Dl_info info = {};
+	if (dladdr(pc, &info) != 0)
+	{
+		if (info.dli_sname != nullptr)
+		{
+			int status = 0;
+			char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+			std::string res = (status == 0 && demangled != nullptr) ? demangled : info.dli_sname;
+			free(demangled);
+			return res;
+		}
+		if (info.dli_fname != nullptr)
+		{
+			const char* base = strrchr(info.dli_fname, '/');
+			char offset[32];
+			snprintf(offset, sizeof(offset), "+0x%lx", (unsigned long) ((char*) pc - (char*) info.dli_fbase));
+			return std::string(base != nullptr ? base + 1 : info.dli_fname) + offset;
+		}
+	}
+	char addr[32];
+	snprintf(addr, sizeof(addr), "0x%lx", (unsigned long) pc);
+	return addr;
+}
+
+bool cpu_profiler::supported()
+{
+	return true;
+}
+
+bool cpu_profiler::is_go_library(const std::string& path)
+{
+	// only inspects libraries that are already loaded
+	void* handle = dlopen(path.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+	if (handle == nullptr)
+	{
+		return false;
+	}
+	// exported by the cgo runtime of every Go shared library
+	bool res = dlsym(handle, "crosscall2") != nullptr || dlsym(handle, "_cgo_topofstack") != nullptr;
+	dlclose(handle);
+	return res;
+}
+
+bool cpu_profiler::profile(uint32_t duration_ms, uint32_t frequency_hz, result& res, std::string& err)
+{
+	if (frequency_hz == 0 || frequency_hz > max_frequency_hz)
+	{
+		err = "the sampling frequency must be in the range [1, " + std::to_string(max_frequency_hz) + "]";
+		return false;
+	}
+
+	auto reason = disabled_reason();
+	if (!reason.empty())
+	{
+		err = reason;
+		return false;
+	}
+
+	if (s_running.exchange(true))
+	{
+		err = "another profile is already running";
+		return false;
+	}
+
+	if (!install_handler(err))
+	{
+		s_running.store(false);
+		return false;
+	}
+
+	std::vector<sample> samples(s_max_samples);
+	s_samples = samples.data();
+	s_capacity = samples.size();
+	s_next_sample.store(0);
+	s_dropped.store(0);
+	s_armed.store(true, std::memory_order_release);
+
+	if (!set_timer(frequency_hz))
+	{
+		err = std::string("could not arm the profiling timer: ") + strerror(errno);
+		s_armed.store(false);
+		s_running.store(false);
+		return false;
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+
+	set_timer(0);
+	s_armed.store(false);
+	while (s_in_flight.load() > 0)
+	{
+		std::this_thread::yield();
+	}
+
+	size_t num_samples = std::min(s_next_sample.load(), s_capacity);
+	res.samples = num_samples;
+	res.dropped = s_dropped.load();
+	s_samples = nullptr;
+	s_capacity = 0;
+
+	// aggregate identical stacks and symbolize each address once
+	std::unordered_map<void*, std::string> symbols;
+	std::map<std::string, uint64_t> stacks;
+	for (size_t i = 0; i < num_samples; i++)
+	{
+		const auto& s = samples[i];
+		std::string stack = s.role;
+		for (int d = s.depth - 1; d >= s_skipped_frames; d--)
+		{
+			auto it = symbols.find(s.pcs[d]);
+			if (it == symbols.end())
+			{
+				it = symbols.emplace(s.pcs[d], symbolize(s.pcs[d])).first;
+			}
+			stack += ";" + it->second;
+		}
+		stacks[stack]++;
+	}
+
+	res.folded.clear();
+	for (const auto& s : stacks)
+	{
+		res.folded += s.first + " " + std::to_string(s.second) + "\n";
+	}
+
+	s_running.store(false);
+	return true;
+}
+
+#else
+
+bool cpu_profiler::supported()
+{
+	return false;
+}
+
+bool cpu_profiler::is_go_library(const std::string&)
+{
+	return false;
+}
+
+bool cpu_profiler::profile(uint32_t, uint32_t, result&, std::string& err)
+{
+	err = "CPU profiling is not supported on this platform";
+	return false;
+}
+
+#endif
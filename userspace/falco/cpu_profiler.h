@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/*!
+	\brief An in-process sampling CPU profiler. While a profile runs, the
+	process CPU-time timer (ITIMER_PROF) periodically delivers SIGPROF to
+	the running thread, whose stack is unwound in the signal handler along
+	with the role of the thread (e.g. "syscall", "outputs"). Samples are
+	aggregated and symbolized once the profile is over.
+
+	Only supported on Linux with glibc, where stack unwinding from a signal
+	handler is available. Meant to be used by the webserver, which is why
+	the profiles are blocking.
+*/
+class cpu_profiler
+{
+public:
+	struct result
+	{
+		// one line per distinct stack, in the "folded" format used by
+		// FlameGraph, speedscope, and most flame graph tools:
+		// role;outermost_frame;...;innermost_frame count
+		std::string folded;
+		uint64_t samples = 0;
+		// samples that did not fit the preallocated buffer
+		uint64_t dropped = 0;
+	};
+
+	/*!
+		\brief Sets the role of the calling thread, which tags all its
+		samples. Roles longer than 31 characters are truncated.
+		Threads without a role are tagged as "other".
+	*/
+	static void set_thread_role(const std::string& role);
+
+	/*!
+		\brief Returns true if profiling is supported on this platform
+	*/
+	static bool supported();
+
+	static constexpr uint32_t max_frequency_hz = 1000;
+
+	/*!
+		\brief Makes profile() fail with the given reason until invoked
+		again with an empty one. Used while profiling is unsafe, e.g. when
+		a Go plugin is loaded: the Go runtime relies on SIGPROF for its own
+		profiler and aborts if a signal handler it did not install runs
+		on one of its threads without SA_ONSTACK.
+	*/
+	static void set_disabled_reason(const std::string& reason);
+
+	/*!
+		\brief Returns true if the already loaded shared library at the
+		given path is built with Go
+	*/
+	static bool is_go_library(const std::string& path);
+
+	/*!
+		\brief Profiles the whole process for duration_ms, sampling at
+		frequency_hz per CPU-second, and blocks until done. Returns false
+		and fills err if profiling is not supported or disabled, if
+		frequency_hz is not in [1, max_frequency_hz], or if another profile
+		is running.
+	*/
+	static bool profile(uint32_t duration_ms, uint32_t frequency_hz, result& res, std::string& err);
+};
@@ -190,6 +190,175 @@ std::string falco_metrics::to_text(const falco::app::state& state)
 				prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(metric, "falcosecurity", "falco", const_labels);
 			}
 		}
+
+		// shadow rules comparison, always enabled along with shadow rules
+		if (state.shadow)
+		{
+			auto shadow_stats = state.shadow->get_stats();
+			std::vector<metrics_v2> shadow_metrics;
+			const std::vector<std::pair<const char*, uint64_t>> shadow_counters = {
+				{"shadow.sampled_evts", shadow_stats.sampled_evts},
+				{"shadow.skipped_evts", shadow_stats.skipped_evts},
+				{"shadow.prod_matches", shadow_stats.prod_matches},
+				{"shadow.matches", shadow_stats.shadow_matches},
+			};
+			for (const auto& c : shadow_counters)
+			{
+				shadow_metrics.emplace_back(libs_metrics_collector.new_metric(c.first,
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_COUNT,
+																	METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+																	c.second));
+			}
+			shadow_metrics.emplace_back(libs_metrics_collector.new_metric("shadow.prod_cpu_ns",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_TIME_NS_COUNT,
+																	METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+																	shadow_stats.prod_cpu_ns));
+			shadow_metrics.emplace_back(libs_metrics_collector.new_metric("shadow.cpu_ns",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_TIME_NS_COUNT,
+																	METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+																	shadow_stats.shadow_cpu_ns));
+			for (auto metric: shadow_metrics)
+			{
+				prometheus_metrics_converter.convert_metric_to_unit_convention(metric);
+				prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(metric, "falcosecurity", "falco");
+			}
+
+			const auto& shadow_engine = state.shadow->engine();
+			const indexed_vector<falco_rule>& shadow_rules = shadow_engine.get_rules();
+			const auto& shadow_rules_by_id = shadow_engine.get_rule_stats_manager().get_by_rule_id();
+			for (size_t i = 0; i < shadow_rules_by_id.size(); i++)
+			{
+				auto rule = shadow_rules.at(i);
+				auto metric = libs_metrics_collector.new_metric("shadow.rules",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_COUNT,
+																	METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+																	shadow_rules_by_id[i]->load());
+				prometheus_metrics_converter.convert_metric_to_unit_convention(metric);
+				const std::map<std::string, std::string>& const_labels = {
+					{"rule", rule->name},
+					{"priority", std::to_string(rule->priority)},
+					{"source", rule->source}
+				};
+				prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(metric, "falcosecurity", "falco", const_labels);
+			}
+		}
+
+		// stall detector, always enabled along with it
+		if (state.stall_monitor)
+		{
+			auto stall_stats = state.stall_monitor->get_stats();
+			std::vector<metrics_v2> stall_metrics;
+			stall_metrics.emplace_back(libs_metrics_collector.new_metric("stall.count",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_COUNT,
+																	METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+																	stall_stats.stalls));
+			stall_metrics.emplace_back(libs_metrics_collector.new_metric("stall.ongoing",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_COUNT,
+																	METRIC_VALUE_METRIC_TYPE_NON_MONOTONIC_CURRENT,
+																	stall_stats.ongoing));
+			stall_metrics.emplace_back(libs_metrics_collector.new_metric("stall.duration_ns",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_TIME_NS_COUNT,
+																	METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+																	stall_stats.total_ms * 1000 * 1000));
+			for (auto metric: stall_metrics)
+			{
+				prometheus_metrics_converter.convert_metric_to_unit_convention(metric);
+				prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(metric, "falcosecurity", "falco");
+			}
+
+			// cumulative histogram buckets, with their bound in seconds
+			for (const auto& b : stall_stats.buckets_le_ms)
+			{
+				auto metric = libs_metrics_collector.new_metric("stall.duration_seconds_bucket",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_COUNT,
+																	METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+																	b.second);
+				char le[32] = "+Inf";
+				if (b.first != UINT64_MAX)
+				{
+					snprintf(le, sizeof(le), "%g", b.first / 1000.0);
+				}
+				const std::map<std::string, std::string>& const_labels = {
+					{"le", le}
+				};
+				prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(metric, "falcosecurity", "falco", const_labels);
+			}
+		}
+
+		// memory budget, always enabled along with it
+		if (state.budget)
+		{
+			std::vector<metrics_v2> budget_metrics;
+			budget_metrics.emplace_back(libs_metrics_collector.new_metric("memory_budget.used_bytes",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_MEMORY_BYTES,
+																	METRIC_VALUE_METRIC_TYPE_NON_MONOTONIC_CURRENT,
+																	state.budget->used()));
+			budget_metrics.emplace_back(libs_metrics_collector.new_metric("memory_budget.limit_bytes",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_MEMORY_BYTES,
+																	METRIC_VALUE_METRIC_TYPE_NON_MONOTONIC_CURRENT,
+																	state.budget->limit()));
+			budget_metrics.emplace_back(libs_metrics_collector.new_metric("memory_budget.level",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_COUNT,
+																	METRIC_VALUE_METRIC_TYPE_NON_MONOTONIC_CURRENT,
+																	(uint64_t) state.budget->current_level()));
+			for (auto metric: budget_metrics)
+			{
+				prometheus_metrics_converter.convert_metric_to_unit_convention(metric);
+				prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(metric, "falcosecurity", "falco");
+			}
+
+			// per component usage
+			for (const auto& u : state.budget->get_usage())
+			{
+				const std::map<std::string, std::string>& const_labels = {
+					{"component", u.name}
+				};
+				auto used = libs_metrics_collector.new_metric("memory_budget.component_used_bytes",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_MEMORY_BYTES,
+																	METRIC_VALUE_METRIC_TYPE_NON_MONOTONIC_CURRENT,
+																	u.used_bytes);
+				prometheus_metrics_converter.convert_metric_to_unit_convention(used);
+				prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(used, "falcosecurity", "falco", const_labels);
+				auto summarized = libs_metrics_collector.new_metric("memory_budget.summarized",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_COUNT,
+																	METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+																	u.summarized);
+				prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(summarized, "falcosecurity", "falco", const_labels);
+				auto dropped = libs_metrics_collector.new_metric("memory_budget.dropped",
+																	METRICS_V2_MISC,
+																	METRIC_VALUE_TYPE_U64,
+																	METRIC_VALUE_UNIT_COUNT,
+																	METRIC_VALUE_METRIC_TYPE_MONOTONIC,
+																	u.dropped);
+				prometheus_text += prometheus_metrics_converter.convert_metric_to_text_prometheus(dropped, "falcosecurity", "falco", const_labels);
+			}
+		}
 	}
 
 	// Libs metrics categories
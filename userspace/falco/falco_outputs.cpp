@@ -25,6 +25,8 @@ limitations under the License.
 #include "formats.h"
 #include "logger.h"
 #include "watchdog.h"
+#include "falco_usdt.h"
+#include "cpu_profiler.h"
 
 #include "outputs_file.h"
 #include "outputs_stdout.h"
@@ -34,6 +36,7 @@ limitations under the License.
 #endif
 #if !defined(_WIN32) && !defined(__EMSCRIPTEN__) && !defined(MINIMAL_BUILD)
 #include "outputs_http.h"
+#include "outputs_otlp.h"
 #include "outputs_grpc.h"
 #endif
 
@@ -49,19 +52,26 @@ falco_outputs::falco_outputs(
 	bool buffered,
 	size_t outputs_queue_capacity,
 	bool time_format_iso_8601,
-	const std::string& hostname)
+	const std::string& hostname,
+	const std::shared_ptr<memory_budget>& budget)
 	: m_formats(std::make_unique<falco_formats>(engine, json_include_output_property, json_include_tags_property)),
 	  m_buffered(buffered),
 	  m_json_output(json_output),
 	  m_time_format_iso_8601(time_format_iso_8601),
 	  m_timeout(std::chrono::milliseconds(timeout)),
-	  m_hostname(hostname)
+	  m_hostname(hostname),
+	  m_budget(budget)
 {
 	for(const auto& output : outputs)
 	{
 		add_output(output);
 	}
 
+	if(m_budget != nullptr)
+	{
+		m_budget_account = m_budget->add_account("outputs_queue");
+	}
+
 #ifndef __EMSCRIPTEN__
 	m_queue.set_capacity(outputs_queue_capacity);
 	m_worker_thread = std::thread(&falco_outputs::worker, this);
@@ -109,6 +119,10 @@ void falco_outputs::add_output(const falco::outputs::config &oc)
 	{
 		oo = std::make_unique<falco::outputs::output_grpc>();
 	}
+	else if(oc.name == "otlp")
+	{
+		oo = std::make_unique<falco::outputs::output_otlp>();
+	}
 #endif
 	else
 	{
@@ -275,11 +289,131 @@ inline void falco_outputs::push_ctrl(ctrl_msg_type cmt)
 	this->push(cmsg);
 }
 
-inline void falco_outputs::push(const ctrl_msg& cmsg)
+static void truncate_string(std::string& s, size_t max_len, bool& truncated)
+{
+	if(s.size() > max_len)
+	{
+		s.resize(max_len);
+		s += "...(truncated)";
+		truncated = true;
+	}
+}
+
+static void truncate_fields(nlohmann::json& fields, size_t max_len, bool& truncated)
+{
+	for(auto& v : fields)
+	{
+		if(v.is_string())
+		{
+			truncate_string(v.get_ref<std::string&>(), max_len, truncated);
+		}
+	}
+}
+
+// Estimates the heap memory held by a message, which is dominated by the
+// formatted output and the field values
+static uint64_t estimate_size(const falco::outputs::message& m)
+{
+	uint64_t res = sizeof(m) + m.msg.size() + m.rule.size() + m.source.size();
+	for(const auto& t : m.tags)
+	{
+		res += t.size() + 32;
+	}
+	for(auto it = m.fields.begin(); it != m.fields.end(); ++it)
+	{
+		res += it.key().size() + 64;
+		if(it.value().is_string())
+		{
+			res += it.value().get_ref<const std::string&>().size();
+		}
+	}
+	return res;
+}
+
+void falco_outputs::summarize(ctrl_msg& cmsg) const
 {
+	bool truncated = false;
+	size_t max_len = m_budget->summary_max_len();
+	truncate_fields(cmsg.fields, max_len, truncated);
+	if(m_json_output && cmsg.source != s_internal_source)
+	{
+		// the message holds the whole alert as a JSON document
+		auto jmsg = nlohmann::json::parse(cmsg.msg, nullptr, false);
+		if(jmsg.is_object())
+		{
+			if(jmsg.contains("output") && jmsg["output"].is_string())
+			{
+				truncate_string(jmsg["output"].get_ref<std::string&>(), max_len, truncated);
+			}
+			if(jmsg.contains("output_fields"))
+			{
+				truncate_fields(jmsg["output_fields"], max_len, truncated);
+			}
+			if(truncated)
+			{
+				cmsg.msg = jmsg.dump();
+			}
+		}
+	}
+	else
+	{
+		truncate_string(cmsg.msg, max_len, truncated);
+	}
+	if(truncated)
+	{
+		m_budget_account->count_summarized();
+	}
+}
+
+// Applies the back-pressure of the memory budget to an alert, and returns
+// false if it must be dropped. Control messages are never affected.
+bool falco_outputs::apply_budget(ctrl_msg& cmsg)
+{
+	cmsg.cost = 0;
+	if(m_budget == nullptr || cmsg.type != ctrl_msg_type::CTRL_MSG_OUTPUT)
+	{
+		return true;
+	}
+
+	auto level = m_budget->current_level();
+	if(level >= memory_budget::level::shrink)
+	{
+		bool drop = level == memory_budget::level::drop && m_budget->should_drop(cmsg.priority);
 #ifndef __EMSCRIPTEN__
+		drop = drop || (m_queue.size() > 0 && m_budget->should_drop_queued(cmsg.priority, (size_t) m_queue.size()));
+#endif
+		if(drop)
+		{
+			m_budget_account->count_dropped();
+			return false;
+		}
+		if(level >= memory_budget::level::summarize)
+		{
+			summarize(cmsg);
+		}
+	}
+
+	cmsg.cost = estimate_size(cmsg);
+	m_budget_account->charge(cmsg.cost);
+	return true;
+}
+
+inline void falco_outputs::push(ctrl_msg& cmsg)
+{
+#ifndef __EMSCRIPTEN__
+	FALCO_PROBE2(output_enqueue, (int) cmsg.type, cmsg.ts);
+	if (!apply_budget(cmsg))
+	{
+		FALCO_PROBE2(output_drop, (int) cmsg.type, cmsg.ts);
+		return;
+	}
 	if (!m_queue.try_push(cmsg))
 	{
+		FALCO_PROBE2(output_drop, (int) cmsg.type, cmsg.ts);
+		if (cmsg.cost > 0)
+		{
+			m_budget_account->release(cmsg.cost);
+		}
 		if(m_outputs_queue_num_drops.load() == 0)
 		{
 			falco_logger::log(falco_logger::level::ERR, "Outputs queue out of memory. Drop event and continue on ...");
@@ -290,6 +424,7 @@ inline void falco_outputs::push(const ctrl_msg& cmsg)
 	for (const auto& o : m_outputs)
 	{
 		process_msg(o.get(), cmsg);
+		o->flush();
 	}
 #endif
 }
@@ -299,6 +434,7 @@ inline void falco_outputs::push(const ctrl_msg& cmsg)
 // we still need to improve the error reporting since some inner functions can throw exceptions.
 void falco_outputs::worker() noexcept
 {
+	cpu_profiler::set_thread_role("outputs");
 	watchdog<std::string> wd;
 	wd.start([&](const std::string& payload) -> void {
 		falco_logger::log(falco_logger::level::CRIT, "\"" + payload + "\" output timeout, all output channels are blocked\n");
@@ -309,14 +445,35 @@ void falco_outputs::worker() noexcept
 	falco_outputs::ctrl_msg cmsg;
 	do
 	{
-		// Block until a message becomes available.
 #ifndef __EMSCRIPTEN__
-		m_queue.pop(cmsg);
+		// Before blocking on an empty queue, let outputs write out
+		// whatever they batched while the queue was being drained.
+		if(!m_queue.try_pop(cmsg))
+		{
+			for(const auto& o : m_outputs)
+			{
+				wd.set_timeout(timeout, o->get_name());
+				try
+				{
+					o->flush();
+				}
+				catch(const std::exception &e)
+				{
+					falco_logger::log(falco_logger::level::ERR, o->get_name() + ": " + std::string(e.what()) + "\n");
+				}
+			}
+			wd.cancel_timeout();
+
+			// Block until a message becomes available.
+			m_queue.pop(cmsg);
+		}
+		FALCO_PROBE2(output_dequeue, (int) cmsg.type, cmsg.ts);
 #endif
 
 		for(const auto& o : m_outputs)
 		{
 			wd.set_timeout(timeout, o->get_name());
+			FALCO_PROBE2(output_start, o->get_name().c_str(), (int) cmsg.type);
 			try
 			{
 				process_msg(o.get(), cmsg);
@@ -325,8 +482,14 @@ void falco_outputs::worker() noexcept
 			{
 				falco_logger::log(falco_logger::level::ERR, o->get_name() + ": " + std::string(e.what()) + "\n");
 			}
+			FALCO_PROBE2(output_end, o->get_name().c_str(), (int) cmsg.type);
 		}
 		wd.cancel_timeout();
+
+		if(cmsg.cost > 0)
+		{
+			m_budget_account->release(cmsg.cost);
+		}
 	} while(cmsg.type != ctrl_msg_type::CTRL_MSG_STOP);
 }
 
@@ -24,6 +24,7 @@ limitations under the License.
 #include "falco_engine.h"
 #include "outputs.h"
 #include "formats.h"
+#include "memory_budget.h"
 #ifndef __EMSCRIPTEN__
 #include "tbb/concurrent_queue.h"
 #endif
@@ -50,7 +51,8 @@ public:
 		bool buffered,
 		size_t outputs_queue_capacity,
 		bool time_format_iso_8601,
-		const std::string& hostname);
+		const std::string& hostname,
+		const std::shared_ptr<memory_budget>& budget = nullptr);
 
 	virtual ~falco_outputs();
 
@@ -90,6 +92,11 @@ public:
 	*/
 	uint64_t get_outputs_queue_num_drops();
 
+	inline const std::string& get_hostname() const
+	{
+		return m_hostname;
+	}
+
 private:
 	std::unique_ptr<falco_formats> m_formats;
 
@@ -112,6 +119,8 @@ private:
 	struct ctrl_msg : falco::outputs::message
 	{
 		ctrl_msg_type type;
+		// estimated size charged to the memory budget
+		uint64_t cost;
 	};
 
 #ifndef __EMSCRIPTEN__
@@ -120,8 +129,12 @@ private:
 #endif
 
 	std::atomic<uint64_t> m_outputs_queue_num_drops = 0;
+	std::shared_ptr<memory_budget> m_budget;
+	std::shared_ptr<memory_budget::account> m_budget_account;
 	std::thread m_worker_thread;
-	inline void push(const ctrl_msg& cmsg);
+	inline void push(ctrl_msg& cmsg);
+	bool apply_budget(ctrl_msg& cmsg);
+	void summarize(ctrl_msg& cmsg) const;
 	inline void push_ctrl(ctrl_msg_type cmt);
 	void worker() noexcept;
 	void stop_worker();
@@ -18,8 +18,11 @@ limitations under the License.
 #pragma once
 
 #include "outputs.pb.h"
+#include "memory_budget.h"
 #include "tbb/concurrent_queue.h"
 
+#include <atomic>
+
 namespace falco
 {
 namespace grpc
@@ -37,20 +40,72 @@ public:
 
 	bool try_pop(outputs::response& res)
 	{
-		return m_queue.try_pop(res);
+		if(!m_queue.try_pop(res))
+		{
+			return false;
+		}
+		uint64_t size = res.ByteSizeLong();
+		m_items--;
+		m_bytes -= size;
+		if(m_budget_account != nullptr)
+		{
+			m_budget_account->release(size);
+		}
+		return true;
 	}
 
 	void push(outputs::response& res)
 	{
+		// responses pile up when no client is consuming them
+		if(m_budget != nullptr)
+		{
+			auto level = m_budget->current_level();
+			auto priority = (falco_common::priority_type) res.priority();
+			if(m_budget->should_drop_queued(priority, m_items.load())
+				|| (level == memory_budget::level::drop && m_budget->should_drop(priority)))
+			{
+				m_budget_account->count_dropped();
+				return;
+			}
+		}
+		uint64_t size = res.ByteSizeLong();
+		m_items++;
+		m_bytes += size;
+		if(m_budget_account != nullptr)
+		{
+			m_budget_account->charge(size);
+		}
 		m_queue.push(res);
 	}
 
+	/*!
+		\brief Accounts the queue against a memory budget, or against none
+		if nullptr. Must not be called while responses are pushed or popped.
+	*/
+	void set_budget(const std::shared_ptr<memory_budget>& budget)
+	{
+		if(m_budget_account != nullptr)
+		{
+			m_budget_account->release(m_bytes);
+		}
+		m_budget = budget;
+		m_budget_account = budget != nullptr ? budget->add_account("grpc_queue") : nullptr;
+		if(m_budget_account != nullptr)
+		{
+			m_budget_account->charge(m_bytes);
+		}
+	}
+
 private:
 	queue()
 	{
 	}
 
 	response_cq m_queue;
+	std::atomic<size_t> m_items{0};
+	std::atomic<uint64_t> m_bytes{0};
+	std::shared_ptr<memory_budget> m_budget;
+	std::shared_ptr<memory_budget::account> m_budget_account;
 
 	// We can use the better technique of deleting the methods we don't want.
 public:
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "memory_budget.h"
+
+memory_budget::memory_budget(
+		uint64_t limit_bytes,
+		uint32_t shrink_pct,
+		uint32_t summarize_pct,
+		uint32_t drop_pct,
+		size_t shrunk_queue_capacity,
+		size_t summary_max_len)
+	: m_limit(limit_bytes),
+	  m_shrink_bytes(limit_bytes / 100 * shrink_pct),
+	  m_summarize_bytes(limit_bytes / 100 * summarize_pct),
+	  m_drop_bytes(limit_bytes / 100 * drop_pct),
+	  m_shrunk_queue_capacity(shrunk_queue_capacity),
+	  m_summary_max_len(summary_max_len),
+	  m_total(std::make_shared<std::atomic<uint64_t>>(0))
+{
+}
+
+std::shared_ptr<memory_budget::account> memory_budget::add_account(const std::string& name)
+{
+	auto res = std::make_shared<account>();
+	res->m_name = name;
+	res->m_total = m_total;
+	std::unique_lock<std::mutex> lock(m_mtx);
+	m_accounts.push_back(res);
+	return res;
+}
+
+bool memory_budget::should_drop(falco_common::priority_type priority) const
+{
+	auto used = this->used();
+	if (used < m_drop_bytes)
+	{
+		return false;
+	}
+
+	double progress = 1;
+	if (used < m_limit && m_limit > m_drop_bytes)
+	{
+		progress = (double) (used - m_drop_bytes) / (m_limit - m_drop_bytes);
+	}
+	int range = falco_common::PRIORITY_DEBUG - falco_common::PRIORITY_ERROR;
+	int most_severe_dropped = falco_common::PRIORITY_DEBUG - (int) (progress * range);
+	return (int) priority >= most_severe_dropped;
+}
+
+bool memory_budget::should_drop_queued(falco_common::priority_type priority, size_t queued) const
+{
+	return priority > falco_common::PRIORITY_CRITICAL
+		&& queued >= m_shrunk_queue_capacity
+		&& current_level() >= level::shrink;
+}
+
+std::vector<memory_budget::usage> memory_budget::get_usage() const
+{
+	std::vector<usage> res;
+	std::unique_lock<std::mutex> lock(m_mtx);
+	for (const auto& a : m_accounts)
+	{
+		auto& u = res.emplace_back();
+		u.name = a->m_name;
+		u.used_bytes = a->m_used.load(std::memory_order_relaxed);
+		u.summarized = a->m_summarized.load(std::memory_order_relaxed);
+		u.dropped = a->m_dropped.load(std::memory_order_relaxed);
+	}
+	return res;
+}
+
+const char* memory_budget::level_name(level l)
+{
+	switch (l)
+	{
+	case level::shrink:
+		return "shrink";
+	case level::summarize:
+		return "summarize";
+	case level::drop:
+		return "drop";
+	default:
+		return "none";
+	}
+}
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "falco_common.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*!
+	\brief A process-wide budget, in bytes, of the memory held by the
+	queues of Falco. Each queue charges the estimated size of the items it
+	holds to its own account, and checks the pressure level of the budget
+	before accepting new ones. The levels are graded, so that the queues
+	first shrink, then summarize the alerts they hold, and finally drop
+	them starting from the least severe priorities.
+*/
+class memory_budget
+{
+public:
+	enum class level
+	{
+		none = 0,
+		// queues accept a reduced number of items
+		shrink,
+		// long alert messages and field values are truncated
+		summarize,
+		// alerts are dropped by priority
+		drop,
+	};
+
+	/*!
+		\brief The memory usage of a single component.
+	*/
+	class account
+	{
+	public:
+		inline void charge(uint64_t bytes)
+		{
+			m_used.fetch_add(bytes, std::memory_order_relaxed);
+			m_total->fetch_add(bytes, std::memory_order_relaxed);
+		}
+
+		inline void release(uint64_t bytes)
+		{
+			m_used.fetch_sub(bytes, std::memory_order_relaxed);
+			m_total->fetch_sub(bytes, std::memory_order_relaxed);
+		}
+
+		inline void count_summarized()
+		{
+			m_summarized.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		inline void count_dropped()
+		{
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+
+	private:
+		friend class memory_budget;
+		std::string m_name;
+		// shared with the budget, so that accounts can outlive it
+		std::shared_ptr<std::atomic<uint64_t>> m_total;
+		std::atomic<uint64_t> m_used{0};
+		std::atomic<uint64_t> m_summarized{0};
+		std::atomic<uint64_t> m_dropped{0};
+	};
+
+	struct usage
+	{
+		std::string name;
+		uint64_t used_bytes = 0;
+		uint64_t summarized = 0;
+		uint64_t dropped = 0;
+	};
+
+	/*!
+		\brief Creates a budget of limit_bytes. The pressure levels start
+		at the given percentages of the limit.
+	*/
+	memory_budget(
+		uint64_t limit_bytes,
+		uint32_t shrink_pct,
+		uint32_t summarize_pct,
+		uint32_t drop_pct,
+		size_t shrunk_queue_capacity,
+		size_t summary_max_len);
+
+	/*!
+		\brief Creates the account of a component, which is reported
+		with the given name.
+	*/
+	std::shared_ptr<account> add_account(const std::string& name);
+
+	inline uint64_t used() const
+	{
+		return m_total->load(std::memory_order_relaxed);
+	}
+
+	inline uint64_t limit() const
+	{
+		return m_limit;
+	}
+
+	inline level current_level() const
+	{
+		auto used = this->used();
+		return used >= m_drop_bytes ? level::drop
+			: used >= m_summarize_bytes ? level::summarize
+			: used >= m_shrink_bytes ? level::shrink
+			: level::none;
+	}
+
+	/*!
+		\brief Returns true if an alert of the given priority must be
+		dropped. In the drop level, the most severe dropped priority
+		rises from debug when entering it, to error when reaching the limit.
+		More severe alerts are never dropped.
+	*/
+	bool should_drop(falco_common::priority_type priority) const;
+
+	/*!
+		\brief Returns true if an alert of the given priority must be
+		dropped because its queue already holds queued alerts, which from
+		the shrink level on can't exceed shrunk_queue_capacity(). Critical
+		and more severe alerts are never dropped.
+	*/
+	bool should_drop_queued(falco_common::priority_type priority, size_t queued) const;
+
+	/*!
+		\brief Number of items a queue can hold from the shrink level on
+	*/
+	inline size_t shrunk_queue_capacity() const
+	{
+		return m_shrunk_queue_capacity;
+	}
+
+	/*!
+		\brief Length at which strings are truncated from the summarize
+		level on
+	*/
+	inline size_t summary_max_len() const
+	{
+		return m_summary_max_len;
+	}
+
+	std::vector<usage> get_usage() const;
+
+	static const char* level_name(level l);
+
+private:
+	uint64_t m_limit;
+	uint64_t m_shrink_bytes;
+	uint64_t m_summarize_bytes;
+	uint64_t m_drop_bytes;
+	size_t m_shrunk_queue_capacity;
+	size_t m_summary_max_len;
+	std::shared_ptr<std::atomic<uint64_t>> m_total;
+
+	mutable std::mutex m_mtx;
+	std::vector<std::shared_ptr<account>> m_accounts;
+};
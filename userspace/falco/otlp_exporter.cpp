@@ -0,0 +1,516 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "otlp_exporter.h"
+#include "config_falco.h"
+#include "falco_common.h"
+#include "logger.h"
+
+#include <curl/curl.h>
+#include <zlib.h>
+
+#include <sstream>
+
+static size_t noop_write_callback(void *contents, size_t size, size_t nmemb, void *userp)
+{
+	return size * nmemb;
+}
+
+static bool is_retryable(long status)
+{
+	// network errors, throttling and unavailability, as of the OTLP spec
+	return status == 0 || status == 429 || status == 502 || status == 503 || status == 504;
+}
+
+static uint64_t now_unix_nano()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static void set_any_value(falco::otlp::AnyValue* v, const nlohmann::json& j)
+{
+	if (j.is_string())
+	{
+		v->set_string_value(j.get_ref<const std::string&>());
+	}
+	else if (j.is_boolean())
+	{
+		v->set_bool_value(j.get<bool>());
+	}
+	else if (j.is_number_integer())
+	{
+		v->set_int_value(j.get<int64_t>());
+	}
+	else if (j.is_number_float())
+	{
+		v->set_double_value(j.get<double>());
+	}
+	else
+	{
+		v->set_string_value(j.dump());
+	}
+}
+
+static void add_attribute(google::protobuf::RepeatedPtrField<falco::otlp::KeyValue>* attrs, const std::string& key, const std::string& value)
+{
+	auto kv = attrs->Add();
+	kv->set_key(key);
+	kv->mutable_value()->set_string_value(value);
+}
+
+static falco::otlp::SeverityNumber severity_number(falco_common::priority_type p)
+{
+	switch (p)
+	{
+	case falco_common::PRIORITY_EMERGENCY:
+		return falco::otlp::SEVERITY_NUMBER_FATAL4;
+	case falco_common::PRIORITY_ALERT:
+		return falco::otlp::SEVERITY_NUMBER_FATAL3;
+	case falco_common::PRIORITY_CRITICAL:
+		return falco::otlp::SEVERITY_NUMBER_FATAL;
+	case falco_common::PRIORITY_ERROR:
+		return falco::otlp::SEVERITY_NUMBER_ERROR;
+	case falco_common::PRIORITY_WARNING:
+		return falco::otlp::SEVERITY_NUMBER_WARN;
+	case falco_common::PRIORITY_NOTICE:
+		return falco::otlp::SEVERITY_NUMBER_INFO2;
+	case falco_common::PRIORITY_INFORMATIONAL:
+		return falco::otlp::SEVERITY_NUMBER_INFO;
+	default:
+		return falco::otlp::SEVERITY_NUMBER_DEBUG;
+	}
+}
+
+static void set_resource(falco::otlp::Resource* r, const std::string& hostname)
+{
+	add_attribute(r->mutable_attributes(), "service.name", "falco");
+	add_attribute(r->mutable_attributes(), "service.version", FALCO_VERSION);
+	add_attribute(r->mutable_attributes(), "host.name", hostname);
+}
+
+static void set_scope(falco::otlp::InstrumentationScope* s)
+{
+	s->set_name("falco");
+	s->set_version(FALCO_VERSION);
+}
+
+otlp_exporter::otlp_exporter(const config& cfg, const encoder_t& encoder)
+	: m_config(cfg),
+	  m_encoder(encoder)
+{
+	CURL* curl = curl_easy_init();
+	if (curl == nullptr)
+	{
+		throw falco_exception("OTLP exporter: libcurl failed to initialize the handle");
+	}
+	m_curl = curl;
+
+	m_headers = curl_slist_append(m_headers, "Content-Type: application/x-protobuf");
+	if (m_config.compress)
+	{
+		m_headers = curl_slist_append(m_headers, "Content-Encoding: gzip");
+	}
+	for (const auto& h : m_config.headers)
+	{
+		m_headers = curl_slist_append(m_headers, h.c_str());
+	}
+
+	CURLcode res = curl_easy_setopt(curl, CURLOPT_HTTPHEADER, m_headers);
+	if (res == CURLE_OK) res = curl_easy_setopt(curl, CURLOPT_URL, m_config.url.c_str());
+	if (res == CURLE_OK) res = curl_easy_setopt(curl, CURLOPT_USERAGENT, "falcosecurity/falco");
+	if (res == CURLE_OK) res = curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long) m_config.timeout_ms);
+	if (res == CURLE_OK) res = curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+	if (res == CURLE_OK) res = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, noop_write_callback);
+	if (res == CURLE_OK && m_config.insecure)
+	{
+		res = curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+		if (res == CURLE_OK) res = curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+	}
+	if (res == CURLE_OK && !m_config.ca_cert.empty())
+	{
+		res = curl_easy_setopt(curl, CURLOPT_CAINFO, m_config.ca_cert.c_str());
+	}
+	if (res != CURLE_OK)
+	{
+		curl_easy_cleanup(curl);
+		curl_slist_free_all(m_headers);
+		throw falco_exception("OTLP exporter: libcurl error: " + std::string(curl_easy_strerror(res)));
+	}
+
+	m_thread = std::thread(&otlp_exporter::sender_loop, this);
+}
+
+otlp_exporter::~otlp_exporter()
+{
+	stop();
+	curl_easy_cleanup((CURL*) m_curl);
+	curl_slist_free_all(m_headers);
+}
+
+void otlp_exporter::add(record_t record)
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	if (m_current.empty())
+	{
+		m_current_start = std::chrono::steady_clock::now();
+	}
+	m_current.push_back(std::move(record));
+	if (m_current.size() >= m_config.batch_size)
+	{
+		m_ready.push_back(std::move(m_current));
+		m_current.clear();
+		if (m_ready.size() > m_config.max_pending_batches)
+		{
+			m_stats.dropped_records += m_ready.front().size();
+			m_ready.pop_front();
+		}
+		m_cv.notify_all();
+	}
+	else if (m_current.size() == 1)
+	{
+		// the sender must wake up when the linger time elapses
+		m_cv.notify_all();
+	}
+}
+
+void otlp_exporter::stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if (m_stop)
+		{
+			return;
+		}
+		m_stop = true;
+		m_cv.notify_all();
+	}
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+otlp_exporter::stats otlp_exporter::get_stats() const
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	return m_stats;
+}
+
+void otlp_exporter::sender_loop()
+{
+	auto linger = std::chrono::milliseconds(m_config.linger_ms);
+	while (true)
+	{
+		std::vector<record_t> batch;
+		bool stopping;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			while (m_ready.empty() && !m_stop)
+			{
+				if (m_current.empty())
+				{
+					m_cv.wait(lock);
+				}
+				else
+				{
+					m_cv.wait_until(lock, m_current_start + linger);
+					if (!m_current.empty() && std::chrono::steady_clock::now() >= m_current_start + linger)
+					{
+						m_ready.push_back(std::move(m_current));
+						m_current.clear();
+					}
+				}
+			}
+			if (m_ready.empty() && !m_current.empty())
+			{
+				m_ready.push_back(std::move(m_current));
+				m_current.clear();
+			}
+			if (m_ready.empty())
+			{
+				return;
+			}
+			batch = std::move(m_ready.front());
+			m_ready.pop_front();
+			stopping = m_stop;
+		}
+
+		size_t num_records = batch.size();
+		std::string body = m_encoder(batch);
+		if (m_config.compress)
+		{
+			body = gzip(body);
+		}
+		bool sent = send(body, !stopping);
+
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if (sent)
+		{
+			m_stats.sent_records += num_records;
+		}
+		else
+		{
+			m_stats.dropped_records += num_records;
+		}
+	}
+}
+
+bool otlp_exporter::send(const std::string& body, bool retry)
+{
+	auto backoff = std::chrono::milliseconds(m_config.retry_backoff_ms);
+	for (uint32_t attempt = 0; ; attempt++)
+	{
+		std::string err;
+		long status = post(body, err);
+		if (status >= 200 && status < 300)
+		{
+			return true;
+		}
+
+		bool retryable = is_retryable(status);
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_stats.failed_requests++;
+			if (m_stats.failed_requests == 1)
+			{
+				falco_logger::log(falco_logger::level::ERR, "OTLP exporter: request to " + m_config.url + " failed: "
+					+ (status == 0 ? err : "HTTP status " + std::to_string(status)) + "\n");
+			}
+			if (!retry || !retryable || attempt >= m_config.max_retries)
+			{
+				return false;
+			}
+			m_stats.retried_requests++;
+
+			// stop waiting as soon as the exporter is stopped
+			if (m_cv.wait_for(lock, backoff, [this]{ return m_stop; }))
+			{
+				retry = false;
+			}
+		}
+		backoff *= 2;
+	}
+}
+
+long otlp_exporter::post(const std::string& body, std::string& err)
+{
+	CURL* curl = (CURL*) m_curl;
+	CURLcode res = curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long) body.size());
+	if (res == CURLE_OK) res = curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.data());
+	if (res == CURLE_OK) res = curl_easy_perform(curl);
+	if (res != CURLE_OK)
+	{
+		err = curl_easy_strerror(res);
+		return 0;
+	}
+	long status = 0;
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+	return status;
+}
+
+std::string otlp_exporter::gzip(const std::string& data)
+{
+	z_stream zs = {};
+	// 16 selects the gzip format rather than the zlib one
+	if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		throw falco_exception("OTLP exporter: can't initialize gzip compression");
+	}
+	std::string res;
+	res.resize(deflateBound(&zs, data.size()));
+	zs.next_in = (Bytef*) data.data();
+	zs.avail_in = data.size();
+	zs.next_out = (Bytef*) &res[0];
+	zs.avail_out = res.size();
+	int ret = deflate(&zs, Z_FINISH);
+	res.resize(zs.total_out);
+	deflateEnd(&zs);
+	if (ret != Z_STREAM_END)
+	{
+		throw falco_exception("OTLP exporter: gzip compression failed");
+	}
+	return res;
+}
+
+otlp_exporter::config otlp_exporter::parse_options(const std::map<std::string, std::string>& options, const std::string& path)
+{
+	auto get = [&options](const std::string& key) -> std::string
+	{
+		auto it = options.find(key);
+		return it != options.end() ? it->second : "";
+	};
+	auto get_num = [&get](const std::string& key, uint64_t def) -> uint64_t
+	{
+		auto v = get(key);
+		return v.empty() ? def : std::stoull(v);
+	};
+
+	config res;
+	res.url = get("endpoint");
+	while (!res.url.empty() && res.url.back() == '/')
+	{
+		res.url.pop_back();
+	}
+	res.url += path;
+	std::istringstream headers(get("headers"));
+	std::string h;
+	while (std::getline(headers, h))
+	{
+		if (!h.empty())
+		{
+			res.headers.push_back(h);
+		}
+	}
+	res.batch_size = get_num("batch_size", res.batch_size);
+	res.linger_ms = get_num("linger_ms", res.linger_ms);
+	res.compress = get("compress") != "false";
+	res.max_pending_batches = get_num("max_pending_batches", res.max_pending_batches);
+	res.max_retries = get_num("max_retries", res.max_retries);
+	res.retry_backoff_ms = get_num("retry_backoff_ms", res.retry_backoff_ms);
+	res.timeout_ms = get_num("timeout_ms", res.timeout_ms);
+	res.insecure = get("insecure") == "true";
+	res.ca_cert = get("ca_cert");
+	return res;
+}
+
+std::unique_ptr<falco::otlp::LogRecord> otlp_exporter::make_log_record(const falco::outputs::message& msg, bool json_output)
+{
+	auto res = std::make_unique<falco::otlp::LogRecord>();
+	res->set_time_unix_nano(msg.ts);
+	res->set_observed_time_unix_nano(now_unix_nano());
+	res->set_severity_number(severity_number(msg.priority));
+	res->set_severity_text(falco_common::format_priority(msg.priority));
+
+	// the body is the plain output text, which is part of the alert JSON
+	// document when json_output is enabled
+	auto body = res->mutable_body();
+	if (json_output)
+	{
+		auto j = nlohmann::json::parse(msg.msg, nullptr, false);
+		if (j.is_object() && j.contains("output") && j["output"].is_string())
+		{
+			body->set_string_value(j["output"].get<std::string>());
+		}
+		else
+		{
+			body->set_string_value(msg.msg);
+		}
+	}
+	else
+	{
+		body->set_string_value(msg.msg);
+	}
+
+	auto attrs = res->mutable_attributes();
+	add_attribute(attrs, "falco.rule", msg.rule);
+	add_attribute(attrs, "falco.source", msg.source);
+	if (!msg.tags.empty())
+	{
+		auto kv = attrs->Add();
+		kv->set_key("falco.tags");
+		auto arr = kv->mutable_value()->mutable_array_value();
+		for (const auto& t : msg.tags)
+		{
+			arr->add_values()->set_string_value(t);
+		}
+	}
+	if (msg.fields.is_object())
+	{
+		for (auto it = msg.fields.begin(); it != msg.fields.end(); ++it)
+		{
+			if (it.value().is_null())
+			{
+				continue;
+			}
+			auto kv = attrs->Add();
+			kv->set_key(it.key());
+			set_any_value(kv->mutable_value(), it.value());
+		}
+	}
+	return res;
+}
+
+void otlp_exporter::make_metrics(uint64_t ts, const nlohmann::json& output_fields, std::vector<record_t>& out)
+{
+	google::protobuf::RepeatedPtrField<falco::otlp::KeyValue> attrs;
+	for (auto it = output_fields.begin(); it != output_fields.end(); ++it)
+	{
+		if (!it.value().is_number() && !it.value().is_null())
+		{
+			auto kv = attrs.Add();
+			kv->set_key(it.key());
+			set_any_value(kv->mutable_value(), it.value());
+		}
+	}
+
+	for (auto it = output_fields.begin(); it != output_fields.end(); ++it)
+	{
+		if (!it.value().is_number())
+		{
+			continue;
+		}
+		auto m = std::make_unique<falco::otlp::Metric>();
+		m->set_name(it.key());
+		auto dp = m->mutable_gauge()->add_data_points();
+		dp->set_time_unix_nano(ts);
+		if (it.value().is_number_float())
+		{
+			dp->set_as_double(it.value().get<double>());
+		}
+		else
+		{
+			dp->set_as_int(it.value().get<int64_t>());
+		}
+		*dp->mutable_attributes() = attrs;
+		out.push_back(std::move(m));
+	}
+}
+
+otlp_exporter::encoder_t otlp_exporter::logs_encoder(const std::string& hostname)
+{
+	return [hostname](std::vector<record_t>& batch)
+	{
+		falco::otlp::ExportLogsServiceRequest req;
+		auto rl = req.add_resource_logs();
+		set_resource(rl->mutable_resource(), hostname);
+		auto sl = rl->add_scope_logs();
+		set_scope(sl->mutable_scope());
+		for (auto& r : batch)
+		{
+			sl->mutable_log_records()->AddAllocated(static_cast<falco::otlp::LogRecord*>(r.release()));
+		}
+		return req.SerializeAsString();
+	};
+}
+
+otlp_exporter::encoder_t otlp_exporter::metrics_encoder(const std::string& hostname)
+{
+	return [hostname](std::vector<record_t>& batch)
+	{
+		falco::otlp::ExportMetricsServiceRequest req;
+		auto rm = req.add_resource_metrics();
+		set_resource(rm->mutable_resource(), hostname);
+		auto sm = rm->add_scope_metrics();
+		set_scope(sm->mutable_scope());
+		for (auto& r : batch)
+		{
+			sm->mutable_metrics()->AddAllocated(static_cast<falco::otlp::Metric*>(r.release()));
+		}
+		return req.SerializeAsString();
+	};
+}
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "outputs.h"
+#include "otlp.pb.h"
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*!
+	\brief Exports records to an OpenTelemetry collector with OTLP/HTTP and
+	the protobuf encoding. Records are grouped in batches, which are sent by
+	a background thread once they reach a given size or once their oldest
+	record waited for a given time. Failed requests are retried with an
+	exponential backoff, and the number of batches waiting to be sent is
+	bounded: the oldest ones are dropped when the collector can't keep up.
+*/
+class otlp_exporter
+{
+public:
+	struct config
+	{
+		// e.g. http://localhost:4318/v1/logs
+		std::string url;
+		// each one in the "Name: value" form
+		std::vector<std::string> headers;
+		size_t batch_size = 512;
+		uint32_t linger_ms = 1000;
+		bool compress = true;
+		size_t max_pending_batches = 64;
+		uint32_t max_retries = 3;
+		uint32_t retry_backoff_ms = 500;
+		uint32_t timeout_ms = 10000;
+		bool insecure = false;
+		std::string ca_cert;
+	};
+
+	struct stats
+	{
+		uint64_t sent_records = 0;
+		uint64_t dropped_records = 0;
+		uint64_t failed_requests = 0;
+		uint64_t retried_requests = 0;
+	};
+
+	using record_t = std::unique_ptr<google::protobuf::MessageLite>;
+
+	/*!
+		\brief Builds the body of a request from a batch of records, which
+		it can take the ownership of.
+	*/
+	using encoder_t = std::function<std::string(std::vector<record_t>& batch)>;
+
+	/*!
+		\brief Starts the background thread. Throws a falco_exception if
+		the HTTP client can't be initialized.
+	*/
+	otlp_exporter(const config& cfg, const encoder_t& encoder);
+	virtual ~otlp_exporter();
+	otlp_exporter(otlp_exporter&&) = delete;
+	otlp_exporter& operator = (otlp_exporter&&) = delete;
+	otlp_exporter(const otlp_exporter&) = delete;
+	otlp_exporter& operator = (const otlp_exporter&) = delete;
+
+	/*!
+		\brief Queues a record to be sent in the next batch
+	*/
+	void add(record_t record);
+
+	/*!
+		\brief Sends the pending records, without retrying, and stops the
+		background thread
+	*/
+	void stop();
+
+	stats get_stats() const;
+
+	/*!
+		\brief Reads the exporter config from the options of an output,
+		using path as the path of the endpoint URL (e.g. /v1/logs)
+	*/
+	static config parse_options(const std::map<std::string, std::string>& options, const std::string& path);
+
+	/*!
+		\brief Converts an alert into a log record
+	*/
+	static std::unique_ptr<falco::otlp::LogRecord> make_log_record(const falco::outputs::message& msg, bool json_output);
+
+	/*!
+		\brief Converts a metrics snapshot of the stats_writer into one
+		gauge per numeric field. The other fields become attributes of all
+		the data points.
+	*/
+	static void make_metrics(uint64_t ts, const nlohmann::json& output_fields, std::vector<record_t>& out);
+
+	/*!
+		\brief Encoders of ExportLogsServiceRequest and of
+		ExportMetricsServiceRequest bodies
+	*/
+	static encoder_t logs_encoder(const std::string& hostname);
+	static encoder_t metrics_encoder(const std::string& hostname);
+
+	static std::string gzip(const std::string& data);
+
+private:
+	void sender_loop();
+	bool send(const std::string& body, bool retry);
+	long post(const std::string& body, std::string& err);
+
+	config m_config;
+	encoder_t m_encoder;
+	void* m_curl = nullptr;
+	struct curl_slist* m_headers = nullptr;
+
+	std::thread m_thread;
+	mutable std::mutex m_mtx;
+	std::condition_variable m_cv;
+	std::vector<record_t> m_current;
+	std::chrono::steady_clock::time_point m_current_start;
+	std::deque<std::vector<record_t>> m_ready;
+	bool m_stop = false;
+	stats m_stats;
+};
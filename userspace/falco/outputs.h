@@ -38,6 +38,12 @@ struct config
 	std::map<std::string, std::string> options;
 };
 
+//
+// Upper bound, in bytes, of the messages an output may batch
+// before writing them out.
+//
+constexpr size_t max_batch_size = 64 * 1024;
+
 //
 // The message to be outputted. It can either refer to:
 //  - an event that has matched some rule,
@@ -76,7 +82,7 @@ public:
 	}
 
 	// Return the output's name as per its configuration.
-	const std::string get_name() const
+	const std::string& get_name() const
 	{
 		return m_oc.name;
 	}
@@ -90,6 +96,11 @@ public:
 	// Possibly flush the output.
 	virtual void cleanup() {}
 
+	// Possibly write out the messages batched by previous output() calls.
+	// This is invoked by the outputs worker every time its queue is drained,
+	// so that batching outputs never hold back a message while idle.
+	virtual void flush() {}
+
 protected:
 	config m_oc;
 	bool m_buffered;
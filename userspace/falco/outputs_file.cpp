@@ -35,19 +35,60 @@ void falco::outputs::output_file::open_file()
 	}
 }
 
-void falco::outputs::output_file::output(const message *msg)
+void falco::outputs::output_file::write_out(const std::string& data)
 {
 	open_file();
-	m_outfile << msg->msg + "\n";
+	m_outfile.write(data.data(), data.size());
 
 	if(m_oc.options["keep_alive"] != "true")
 	{
-		cleanup();
+		m_outfile.close();
+	}
+}
+
+void falco::outputs::output_file::output(const message *msg)
+{
+	if(!m_buffered)
+	{
+		write_out(msg->msg + "\n");
+		return;
+	}
+
+	// Messages are coalesced and written out with a single write once the
+	// outputs queue is drained (or the batch grows too big), instead of
+	// paying one write (and possibly one open/close) per alert.
+	m_batch.append(msg->msg);
+	m_batch.push_back('\n');
+	if(m_batch.size() >= max_batch_size)
+	{
+		flush();
+	}
+}
+
+void falco::outputs::output_file::flush()
+{
+	if(m_batch.empty())
+	{
+		return;
+	}
+
+	// the batch is dropped if it can't be written, so that it doesn't
+	// grow without bound while the file can't be opened
+	try
+	{
+		write_out(m_batch);
+	}
+	catch(const falco_exception&)
+	{
+		m_batch.clear();
+		throw;
 	}
+	m_batch.clear();
 }
 
 void falco::outputs::output_file::cleanup()
 {
+	flush();
 	if(m_outfile.is_open())
 	{
 		m_outfile.close();
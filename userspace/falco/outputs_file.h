@@ -34,10 +34,16 @@ class output_file : public abstract_output
 
 	void reopen() override;
 
+	void flush() override;
+
 private:
 	void open_file();
 
+	// Writes data to the file, opening it first if needed
+	void write_out(const std::string& data);
+
 	std::ofstream m_outfile;
+	std::string m_batch;
 };
 
 } // namespace outputs
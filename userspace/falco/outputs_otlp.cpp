@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "outputs_otlp.h"
+
+bool falco::outputs::output_otlp::init(const config& oc, bool buffered, const std::string& hostname, bool json_output, std::string &err)
+{
+	if (!falco::outputs::abstract_output::init(oc, buffered, hostname, json_output, err)) {
+		return false;
+	}
+
+	try
+	{
+		auto cfg = otlp_exporter::parse_options(m_oc.options, "/v1/logs");
+		m_exporter = std::make_unique<otlp_exporter>(cfg, otlp_exporter::logs_encoder(hostname));
+	}
+	catch (const std::exception& e)
+	{
+		err = e.what();
+		return false;
+	}
+	return true;
+}
+
+void falco::outputs::output_otlp::output(const message *msg)
+{
+	m_exporter->add(otlp_exporter::make_log_record(*msg, m_json_output));
+}
+
+void falco::outputs::output_otlp::cleanup()
+{
+	m_exporter->stop();
+}
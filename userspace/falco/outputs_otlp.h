@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "outputs.h"
+#include "otlp_exporter.h"
+
+namespace falco
+{
+namespace outputs
+{
+
+/*!
+	\brief Sends the alerts as OTLP log records to an OpenTelemetry
+	collector, through OTLP/HTTP with the protobuf encoding
+*/
+class output_otlp : public abstract_output
+{
+	bool init(const config& oc, bool buffered, const std::string& hostname, bool json_output, std::string &err) override;
+	void output(const message *msg) override;
+	void cleanup() override;
+
+private:
+	std::unique_ptr<otlp_exporter> m_exporter;
+};
+
+} // namespace outputs
+} // namespace falco
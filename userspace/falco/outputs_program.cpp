@@ -33,18 +33,50 @@ void falco::outputs::output_program::open_pfile()
 
 void falco::outputs::output_program::output(const message *msg)
 {
-	open_pfile();
+	// Without keep_alive, each message is handed to its own run of the
+	// program, which may expect a single message on its input
+	if(m_oc.options["keep_alive"] != "true")
+	{
+		open_pfile();
+		fprintf(m_pfile, "%s\n", msg->msg.c_str());
+		pclose(m_pfile);
+		m_pfile = nullptr;
+		return;
+	}
+
+	if(!m_buffered)
+	{
+		open_pfile();
+		fprintf(m_pfile, "%s\n", msg->msg.c_str());
+		return;
+	}
 
-	fprintf(m_pfile, "%s\n", msg->msg.c_str());
+	// Messages are coalesced and written to the program with a single
+	// write once the outputs queue is drained (or the batch grows too big).
+	m_batch.append(msg->msg);
+	m_batch.push_back('\n');
+	if(m_batch.size() >= max_batch_size)
+	{
+		flush();
+	}
+}
 
-	if(m_oc.options["keep_alive"] != "true")
+void falco::outputs::output_program::flush()
+{
+	if(m_batch.empty())
 	{
-		cleanup();
+		return;
 	}
+
+	open_pfile();
+	fwrite(m_batch.data(), 1, m_batch.size(), m_pfile);
+	fflush(m_pfile);
+	m_batch.clear();
 }
 
 void falco::outputs::output_program::cleanup()
 {
+	flush();
 	if(m_pfile != nullptr)
 	{
 		pclose(m_pfile);
@@ -32,10 +32,13 @@ class output_program : public abstract_output
 
 	void reopen() override;
 
+	void flush() override;
+
 private:
 	void open_pfile();
 
-	FILE *m_pfile;
+	FILE *m_pfile = nullptr;
+	std::string m_batch;
 };
 
 } // namespace outputs
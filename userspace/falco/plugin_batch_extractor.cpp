@@ -0,0 +1,273 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "plugin_batch_extractor.h"
+
+#include <cstdlib>
+
+plugin_batch_extractor::plugin_batch_extractor(std::shared_ptr<sinsp_plugin> plugin):
+	m_plugin(plugin)
+{
+}
+
+int32_t plugin_batch_extractor::add_field(uint32_t field_id, const std::string& arg)
+{
+	const auto& fields = m_plugin->fields();
+	if(field_id >= fields.size())
+	{
+		return -1;
+	}
+
+	const auto& info = fields[field_id];
+	switch(info.m_type)
+	{
+	case PT_CHARBUF:
+	case PT_UINT64:
+	case PT_RELTIME:
+	case PT_ABSTIME:
+	case PT_BOOL:
+	case PT_IPADDR:
+	case PT_IPNET:
+		break;
+	default:
+		return -1;
+	}
+
+	auto key = info.m_name + "[" + arg + "]";
+	auto it = m_slots_by_name.find(key);
+	if(it != m_slots_by_name.end())
+	{
+		return it->second;
+	}
+
+	slot s;
+	s.field_id = field_id;
+	s.name = info.m_name;
+	s.arg = arg;
+	// like libsinsp, numeric arguments are indexes only for the fields
+	// accepting them, and keys otherwise
+	if((info.m_flags & EPF_ARG_INDEX) && !arg.empty()
+		&& arg.find_first_not_of("0123456789") == std::string::npos)
+	{
+		s.arg_is_index = true;
+		s.arg_index = std::strtoull(arg.c_str(), nullptr, 10);
+	}
+	s.type = info.m_type;
+	s.list = (info.m_flags & EPF_IS_LIST) != 0;
+	m_slots.push_back(std::move(s));
+	auto idx = (int32_t) m_slots.size() - 1;
+	m_slots_by_name[key] = idx;
+
+	// the requests point to the strings of the slots, which may have
+	// moved when adding this one
+	m_requests.resize(m_slots.size());
+	for(size_t i = 0; i < m_slots.size(); i++)
+	{
+		auto& r = m_requests[i];
+		const auto& sl = m_slots[i];
+		r = {};
+		r.field_id = sl.field_id;
+		r.field = sl.name.c_str();
+		r.arg_key = sl.arg.empty() || sl.arg_is_index ? nullptr : sl.arg.c_str();
+		r.arg_index = sl.arg_index;
+		r.arg_present = !sl.arg.empty();
+		r.ftype = sl.type;
+		r.flist = sl.list;
+	}
+
+	// forget the last event, which was extracted without this field
+	m_last_evt = nullptr;
+	return idx;
+}
+
+bool plugin_batch_extractor::compatible(sinsp_evt* evt)
+{
+	if(evt->get_type() != PPME_PLUGINEVENT_E
+		|| !m_plugin->extract_event_codes().contains(PPME_PLUGINEVENT_E))
+	{
+		return false;
+	}
+
+	auto idx = evt->get_source_idx();
+	if(idx == sinsp_no_event_source_idx)
+	{
+		return false;
+	}
+	if(idx >= m_compatible_sources.size())
+	{
+		m_compatible_sources.resize(idx + 1, -1);
+	}
+	if(m_compatible_sources[idx] < 0)
+	{
+		const auto& sources = m_plugin->extract_event_sources();
+		const char* name = evt->get_source_name();
+		m_compatible_sources[idx] = name != nullptr
+			&& (sources.empty() || sources.find(name) != sources.end());
+	}
+	return m_compatible_sources[idx] == 1;
+}
+
+bool plugin_batch_extractor::extract(sinsp_evt* evt)
+{
+	for(auto& r : m_requests)
+	{
+		r.res_len = 0;
+	}
+	if(!m_plugin->extract_fields(evt, m_requests.size(), m_requests.data()))
+	{
+		return false;
+	}
+	m_stats.events++;
+	m_stats.extracted_fields += m_slots.size();
+
+	for(size_t i = 0; i < m_slots.size(); i++)
+	{
+		auto& s = m_slots[i];
+		const auto& r = m_requests[i];
+		s.read = false;
+		s.strs.clear();
+		s.nums.clear();
+		s.bools.clear();
+		s.bufs.clear();
+		s.values.clear();
+
+		// copy the values first, and then take their addresses, because
+		// the vectors may reallocate while being filled
+		for(uint64_t j = 0; j < r.res_len; j++)
+		{
+			switch(s.type)
+			{
+			case PT_CHARBUF:
+				s.strs.emplace_back(r.res.str[j]);
+				break;
+			case PT_UINT64:
+			case PT_RELTIME:
+			case PT_ABSTIME:
+				s.nums.push_back(r.res.u64[j]);
+				break;
+			case PT_BOOL:
+				s.bools.push_back(r.res.boolean[j]);
+				break;
+			default:
+			{
+				auto p = (const uint8_t*) r.res.buf[j].ptr;
+				s.bufs.emplace_back(p, p + r.res.buf[j].len);
+				break;
+			}
+			}
+		}
+
+		for(uint64_t j = 0; j < r.res_len; j++)
+		{
+			extract_value_t v;
+			switch(s.type)
+			{
+			case PT_CHARBUF:
+				v.ptr = (uint8_t*) s.strs[j].c_str();
+				v.len = s.strs[j].size();
+				break;
+			case PT_UINT64:
+			case PT_RELTIME:
+			case PT_ABSTIME:
+				v.ptr = (uint8_t*) &s.nums[j];
+				v.len = sizeof(uint64_t);
+				break;
+			case PT_BOOL:
+				v.ptr = (uint8_t*) &s.bools[j];
+				v.len = sizeof(uint32_t);
+				break;
+			default:
+				v.ptr = s.bufs[j].data();
+				v.len = s.bufs[j].size();
+				break;
+			}
+			s.values.push_back(v);
+		}
+	}
+	return true;
+}
+
+bool plugin_batch_extractor::get(sinsp_evt* evt, int32_t slot, std::vector<extract_value_t>& values)
+{
+	if(slot < 0 || (size_t) slot >= m_slots.size())
+	{
+		return false;
+	}
+
+	if(evt != m_last_evt || evt->get_num() != m_last_evtnum)
+	{
+		m_last_evt = evt;
+		m_last_evtnum = evt->get_num();
+		m_last_ok = compatible(evt) && extract(evt);
+	}
+
+	if(!m_last_ok)
+	{
+		return false;
+	}
+	auto& s = m_slots[slot];
+	if(!s.read)
+	{
+		s.read = true;
+		m_stats.read_fields++;
+	}
+	values = s.values;
+	return true;
+}
+
+batched_plugin_filtercheck::batched_plugin_filtercheck(
+		std::shared_ptr<sinsp_plugin> plugin,
+		std::shared_ptr<plugin_batch_extractor> extractor):
+	sinsp_filter_check_plugin(plugin),
+	m_batch_plugin(plugin),
+	m_extractor(extractor)
+{
+}
+
+std::unique_ptr<sinsp_filter_check> batched_plugin_filtercheck::allocate_new()
+{
+	return std::make_unique<batched_plugin_filtercheck>(m_batch_plugin, m_extractor);
+}
+
+int32_t batched_plugin_filtercheck::parse_field_name(std::string_view str, bool alloc_state, bool needed_for_filtering)
+{
+	auto res = sinsp_filter_check_plugin::parse_field_name(str, alloc_state, needed_for_filtering);
+
+	// only the fields read by the rules are extracted in batch, the
+	// ones only used in the outputs are extracted when formatting them
+	if(res > 0 && needed_for_filtering)
+	{
+		std::string field(str.substr(0, res));
+		std::string arg;
+		auto pos = field.find('[');
+		if(pos != std::string::npos && field.back() == ']')
+		{
+			arg = field.substr(pos + 1, field.size() - pos - 2);
+		}
+		m_slot = m_extractor->add_field(m_field_id, arg);
+	}
+	return res;
+}
+
+bool batched_plugin_filtercheck::extract_nocache(sinsp_evt* evt, std::vector<extract_value_t>& values, bool sanitize_strings)
+{
+	if(m_slot >= 0 && m_extractor->get(evt, m_slot, values))
+	{
+		return !values.empty();
+	}
+	return sinsp_filter_check_plugin::extract_nocache(evt, values, sanitize_strings);
+}
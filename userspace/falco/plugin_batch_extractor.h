@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <libsinsp/plugin.h>
+#include <libsinsp/plugin_filtercheck.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*!
+	\brief Extracts all the fields of a plugin that the rules of an event
+	source read with a single call to the plugin per event, instead of one
+	call per field. The fields are registered when the rules are compiled,
+	and the values extracted from an event are copied, so that they stay
+	valid even if the plugin is invoked again for other fields before the
+	next event.
+
+	All the registered fields are extracted from every event, including
+	the ones only read by rules that the event won't reach. Plugin events
+	all have the same type, so the only finer buckets are the values of a
+	dispatch field (see filter_ruleset::set_dispatch_field()), and the
+	bucket of an event is only known after extracting that field, which
+	would take a second call per event. The fields are registered by the
+	filterchecks while compiling, without knowing which rule they belong
+	to, so they can't be grouped by bucket either. An unneeded field
+	costs the plugin lookup and a copy, which get_stats() allows to
+	measure against the fields actually read.
+*/
+class plugin_batch_extractor
+{
+public:
+	explicit plugin_batch_extractor(std::shared_ptr<sinsp_plugin> plugin);
+
+	/*!
+		\brief Registers a field of the plugin, and returns the slot of
+		its values. Registering the same field with the same argument
+		twice returns the same slot. Returns -1 if the field type can't be
+		extracted in batch.
+	*/
+	int32_t add_field(uint32_t field_id, const std::string& arg);
+
+	/*!
+		\brief Fills values with the values of the field in the given slot
+		for evt, extracting all the registered fields if evt was not seen
+		yet. Returns false if the fields could not be extracted in batch
+		from evt, in which case the caller should extract them one by one.
+	*/
+	bool get(sinsp_evt* evt, int32_t slot, std::vector<extract_value_t>& values);
+
+	/*!
+		\brief Counters of the batch extractions, telling how many of the
+		extracted fields are read
+	*/
+	struct stats
+	{
+		// events whose fields were extracted in batch
+		uint64_t events = 0;
+		// fields extracted from those events
+		uint64_t extracted_fields = 0;
+		// fields read by the filterchecks, each at most once per event
+		uint64_t read_fields = 0;
+	};
+
+	inline const stats& get_stats() const
+	{
+		return m_stats;
+	}
+
+private:
+	struct slot
+	{
+		uint32_t field_id = 0;
+		std::string name;
+		std::string arg;
+		// the argument is passed either as an index or as a key,
+		// depending on the flags of the field
+		bool arg_is_index = false;
+		uint64_t arg_index = 0;
+		uint32_t type = 0;
+		bool list = false;
+
+		// whether the last event was read already
+		bool read = false;
+
+		// values extracted from the last event
+		std::vector<std::string> strs;
+		std::vector<uint64_t> nums;
+		std::vector<uint32_t> bools;
+		std::vector<std::vector<uint8_t>> bufs;
+		std::vector<extract_value_t> values;
+	};
+
+	bool extract(sinsp_evt* evt);
+	bool compatible(sinsp_evt* evt);
+
+	std::shared_ptr<sinsp_plugin> m_plugin;
+	std::vector<slot> m_slots;
+	std::unordered_map<std::string, int32_t> m_slots_by_name;
+	std::vector<ss_plugin_extract_field> m_requests;
+
+	// identifies the last event seen, and whether it was extracted
+	const sinsp_evt* m_last_evt = nullptr;
+	uint64_t m_last_evtnum = 0;
+	bool m_last_ok = false;
+
+	// compatibility of the plugin with each event source index
+	std::vector<int8_t> m_compatible_sources;
+
+	stats m_stats;
+};
+
+/*!
+	\brief A plugin filtercheck that reads the values of its field from a
+	plugin_batch_extractor shared with the other filterchecks of the same
+	plugin and event source, and falls back to extracting its field alone
+	if that's not possible.
+*/
+class batched_plugin_filtercheck : public sinsp_filter_check_plugin
+{
+public:
+	batched_plugin_filtercheck(
+		std::shared_ptr<sinsp_plugin> plugin,
+		std::shared_ptr<plugin_batch_extractor> extractor);
+
+	std::unique_ptr<sinsp_filter_check> allocate_new() override;
+
+	int32_t parse_field_name(std::string_view str, bool alloc_state, bool needed_for_filtering) override;
+
+protected:
+	bool extract_nocache(sinsp_evt* evt, std::vector<extract_value_t>& values, bool sanitize_strings = true) override;
+
+private:
+	std::shared_ptr<sinsp_plugin> m_batch_plugin;
+	std::shared_ptr<plugin_batch_extractor> m_extractor;
+	int32_t m_slot = -1;
+};
@@ -0,0 +1,255 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "ruleset_diff.h"
+
+#include <set>
+
+// Per-rule evaluation cost, keyed by rule name
+using rule_costs_t = std::map<std::string, filter_ruleset::rule_profile>;
+
+static rule_costs_t collect_costs(falco_engine& engine, const std::vector<size_t>& sources)
+{
+	std::vector<filter_ruleset::rule_profile> profile;
+	for (auto idx : sources)
+	{
+		engine.ruleset_for_source(idx)->get_profile(profile);
+	}
+
+	rule_costs_t res;
+	const auto& rules = engine.get_rules();
+	for (size_t i = 0; i < profile.size() && i < rules.size(); i++)
+	{
+		auto& cost = res[rules.at(i)->name];
+		cost.evaluations += profile[i].evaluations;
+		cost.eval_time_ns += profile[i].eval_time_ns;
+	}
+	return res;
+}
+
+static std::string rule_status(const falco_rule* baseline, const falco_rule* candidate)
+{
+	if (baseline == nullptr)
+	{
+		return "added";
+	}
+	if (candidate == nullptr)
+	{
+		return "removed";
+	}
+	if (baseline->output != candidate->output
+		|| baseline->priority != candidate->priority
+		|| libsinsp::filter::ast::as_string(baseline->condition.get())
+			!= libsinsp::filter::ast::as_string(candidate->condition.get()))
+	{
+		return "modified";
+	}
+	return "unchanged";
+}
+
+ruleset_diff::ruleset_diff(
+		std::shared_ptr<falco_engine> baseline,
+		std::shared_ptr<falco_engine> candidate,
+		size_t max_examples)
+	: m_baseline(baseline),
+	  m_candidate(candidate),
+	  m_max_examples(max_examples)
+{
+}
+
+void ruleset_diff::enable_profiling(size_t source_idx)
+{
+	m_baseline->ruleset_for_source(source_idx)->set_profiling(true);
+	m_candidate->ruleset_for_source(source_idx)->set_profiling(true);
+	m_profiled_sources.push_back(source_idx);
+}
+
+void ruleset_diff::start_capture(const std::string& filename)
+{
+	m_captures.emplace_back();
+	m_captures.back().filename = filename;
+}
+
+void ruleset_diff::add_example(
+		std::vector<example>& examples,
+		const falco_engine& engine,
+		const falco_engine::rule_result& res) const
+{
+	if (examples.size() >= m_max_examples)
+	{
+		return;
+	}
+
+	example ex;
+	ex.evt_num = res.evt->get_num();
+	ex.evt_ts = res.evt->get_ts();
+	ex.capture = m_captures.empty() ? "" : m_captures.back().filename;
+	try
+	{
+		engine.create_formatter(res.source, res.format)->tostring_withformat(
+			res.evt, ex.output, sinsp_evt_formatter::OF_NORMAL);
+	}
+	catch (const std::exception& e)
+	{
+		ex.output = "<output formatting failed: " + std::string(e.what()) + ">";
+	}
+	examples.push_back(std::move(ex));
+}
+
+void ruleset_diff::process_event(
+		size_t source_idx,
+		sinsp_evt* ev,
+		falco_common::rule_matching strategy,
+		const std::vector<falco_engine::rule_result>* baseline_res)
+{
+	m_events++;
+	if (!m_captures.empty())
+	{
+		m_captures.back().events++;
+	}
+
+	auto candidate_res = m_candidate->process_event(source_idx, ev, strategy);
+
+	std::set<std::string> baseline_rules;
+	if (baseline_res != nullptr)
+	{
+		for (const auto& r : *baseline_res)
+		{
+			baseline_rules.insert(r.rule);
+		}
+	}
+
+	std::set<std::string> candidate_rules;
+	if (candidate_res != nullptr)
+	{
+		for (const auto& r : *candidate_res)
+		{
+			candidate_rules.insert(r.rule);
+			auto& delta = m_rules[r.rule];
+			delta.candidate_matches++;
+			if (baseline_rules.find(r.rule) == baseline_rules.end())
+			{
+				delta.new_matches++;
+				add_example(delta.new_examples, *m_candidate, r);
+			}
+		}
+	}
+
+	if (baseline_res != nullptr)
+	{
+		for (const auto& r : *baseline_res)
+		{
+			auto& delta = m_rules[r.rule];
+			delta.baseline_matches++;
+			if (candidate_rules.find(r.rule) == candidate_rules.end())
+			{
+				delta.lost_matches++;
+				add_example(delta.lost_examples, *m_baseline, r);
+			}
+		}
+	}
+}
+
+nlohmann::json ruleset_diff::report() const
+{
+	auto baseline_costs = collect_costs(*m_baseline, m_profiled_sources);
+	auto candidate_costs = collect_costs(*m_candidate, m_profiled_sources);
+
+	// all the rules known by either side, even if they never matched
+	std::map<std::string, std::pair<const falco_rule*, const falco_rule*>> all_rules;
+	for (const auto& r : m_baseline->get_rules())
+	{
+		all_rules[r.name].first = &r;
+	}
+	for (const auto& r : m_candidate->get_rules())
+	{
+		all_rules[r.name].second = &r;
+	}
+
+	auto examples_to_json = [](const std::vector<example>& examples)
+	{
+		auto res = nlohmann::json::array();
+		for (const auto& ex : examples)
+		{
+			nlohmann::json jex;
+			jex["capture"] = ex.capture;
+			jex["evt_num"] = ex.evt_num;
+			jex["evt_time"] = ex.evt_ts;
+			jex["output"] = ex.output;
+			res.push_back(jex);
+		}
+		return res;
+	};
+
+	uint64_t baseline_matches = 0, candidate_matches = 0;
+	uint64_t baseline_time_ns = 0, candidate_time_ns = 0;
+
+	auto jrules = nlohmann::json::array();
+	static const rule_delta s_no_delta;
+	static const filter_ruleset::rule_profile s_no_cost;
+	for (const auto& r : all_rules)
+	{
+		const auto& name = r.first;
+		auto it = m_rules.find(name);
+		const auto& delta = it != m_rules.end() ? it->second : s_no_delta;
+		auto bit = baseline_costs.find(name);
+		const auto& bcost = bit != baseline_costs.end() ? bit->second : s_no_cost;
+		auto cit = candidate_costs.find(name);
+		const auto& ccost = cit != candidate_costs.end() ? cit->second : s_no_cost;
+
+		baseline_matches += delta.baseline_matches;
+		candidate_matches += delta.candidate_matches;
+		baseline_time_ns += bcost.eval_time_ns;
+		candidate_time_ns += ccost.eval_time_ns;
+
+		nlohmann::json jrule;
+		jrule["name"] = name;
+		jrule["status"] = rule_status(r.second.first, r.second.second);
+		jrule["baseline"]["matches"] = delta.baseline_matches;
+		jrule["baseline"]["evaluations"] = bcost.evaluations;
+		jrule["baseline"]["eval_time_ns"] = bcost.eval_time_ns;
+		jrule["candidate"]["matches"] = delta.candidate_matches;
+		jrule["candidate"]["evaluations"] = ccost.evaluations;
+		jrule["candidate"]["eval_time_ns"] = ccost.eval_time_ns;
+		jrule["matches_delta"] = (int64_t) delta.candidate_matches - (int64_t) delta.baseline_matches;
+		jrule["eval_time_ns_delta"] = (int64_t) ccost.eval_time_ns - (int64_t) bcost.eval_time_ns;
+		jrule["new_matches"] = delta.new_matches;
+		jrule["lost_matches"] = delta.lost_matches;
+		jrule["examples"]["new"] = examples_to_json(delta.new_examples);
+		jrule["examples"]["lost"] = examples_to_json(delta.lost_examples);
+		jrules.push_back(jrule);
+	}
+
+	nlohmann::json res;
+	res["captures"] = nlohmann::json::array();
+	for (const auto& c : m_captures)
+	{
+		nlohmann::json jc;
+		jc["filename"] = c.filename;
+		jc["events"] = c.events;
+		res["captures"].push_back(jc);
+	}
+	res["events"] = m_events;
+	res["baseline"]["rules"] = m_baseline->get_rules().size();
+	res["baseline"]["matches"] = baseline_matches;
+	res["baseline"]["eval_time_ns"] = baseline_time_ns;
+	res["candidate"]["rules"] = m_candidate->get_rules().size();
+	res["candidate"]["matches"] = candidate_matches;
+	res["candidate"]["eval_time_ns"] = candidate_time_ns;
+	res["rules"] = jrules;
+	return res;
+}
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "falco_engine.h"
+
+#include <nlohmann/json.hpp>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+	\brief Compares the alerts and the evaluation cost of two sets of rules,
+	a baseline and a candidate, over the same stream of events. The two
+	rulesets live in two engines sharing the same filter factories, so that
+	each event is parsed once by the inspector and evaluated by both.
+	Not thread-safe, meant to be used in capture mode only.
+*/
+class ruleset_diff
+{
+public:
+	ruleset_diff(
+		std::shared_ptr<falco_engine> baseline,
+		std::shared_ptr<falco_engine> candidate,
+		size_t max_examples);
+
+	/*!
+		\brief Enables the per-rule cost accounting on the rulesets of
+		both engines for the given event source
+	*/
+	void enable_profiling(size_t source_idx);
+
+	/*!
+		\brief Marks the beginning of the replay of a given capture file,
+		events processed afterwards are accounted to it
+	*/
+	void start_capture(const std::string& filename);
+
+	/*!
+		\brief Evaluates an event with the candidate rules and compares the
+		matches with the ones already found by the baseline rules
+	*/
+	void process_event(
+		size_t source_idx,
+		sinsp_evt* ev,
+		falco_common::rule_matching strategy,
+		const std::vector<falco_engine::rule_result>* baseline_res);
+
+	/*!
+		\brief Returns the comparison report in JSON format
+	*/
+	nlohmann::json report() const;
+
+private:
+	struct example
+	{
+		uint64_t evt_num = 0;
+		uint64_t evt_ts = 0;
+		std::string capture;
+		std::string output;
+	};
+
+	struct rule_delta
+	{
+		uint64_t baseline_matches = 0;
+		uint64_t candidate_matches = 0;
+		// events matched by the candidate rule only
+		uint64_t new_matches = 0;
+		// events matched by the baseline rule only
+		uint64_t lost_matches = 0;
+		std::vector<example> new_examples;
+		std::vector<example> lost_examples;
+	};
+
+	struct capture_info
+	{
+		std::string filename;
+		uint64_t events = 0;
+	};
+
+	void add_example(
+		std::vector<example>& examples,
+		const falco_engine& engine,
+		const falco_engine::rule_result& res) const;
+
+	std::shared_ptr<falco_engine> m_baseline;
+	std::shared_ptr<falco_engine> m_candidate;
+	size_t m_max_examples;
+	std::map<std::string, rule_delta> m_rules;
+	std::list<capture_info> m_captures;
+	std::vector<size_t> m_profiled_sources;
+	uint64_t m_events = 0;
+};
@@ -0,0 +1,381 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "scap_index.h"
+
+#include <nlohmann/json.hpp>
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+// Bump this every time the index format changes
+static constexpr uint32_t s_index_version = 2;
+
+// Block types of the scap file format (see libscap's scap_savefile.h),
+// which follows the layout of pcapng: each block starts with a header
+// made of its type and its total length, and ends with the length again.
+static constexpr uint32_t s_shb_block_type = 0x0A0D0D0A;
+static constexpr uint32_t s_byte_order_magic = 0x1A2B3C4D;
+static constexpr uint32_t s_ev_block_type = 0x204;
+static constexpr uint32_t s_evf_block_type = 0x208;
+static constexpr uint32_t s_ev_block_type_v2 = 0x216;
+static constexpr uint32_t s_evf_block_type_v2 = 0x217;
+static constexpr uint32_t s_ev_block_type_v2_large = 0x221;
+static constexpr uint32_t s_evf_block_type_v2_large = 0x222;
+
+#pragma pack(push, 1)
+struct block_header
+{
+	uint32_t block_type;
+	uint32_t block_total_length;
+};
+
+// Same layout as scap_evt
+struct event_header
+{
+	uint64_t ts;
+	uint64_t tid;
+	uint32_t len;
+	uint16_t type;
+	uint32_t nparams;
+};
+#pragma pack(pop)
+
+static bool stat_file(const std::string& path, uint64_t& size, uint64_t& mtime)
+{
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+	{
+		return false;
+	}
+	size = st.st_size;
+	mtime = st.st_mtime;
+	return true;
+}
+
+static bool is_event_block(uint32_t block_type, bool& has_flags)
+{
+	switch (block_type)
+	{
+	case s_ev_block_type:
+	case s_ev_block_type_v2:
+	case s_ev_block_type_v2_large:
+		has_flags = false;
+		return true;
+	case s_evf_block_type:
+	case s_evf_block_type_v2:
+	case s_evf_block_type_v2_large:
+		has_flags = true;
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Only syscall events that don't contribute to the thread state can be
+// skipped without side effects on the other events
+static libsinsp::events::set<ppm_event_code> skippable_event_types()
+{
+	auto state_events = libsinsp::events::sc_set_to_event_set(libsinsp::events::sinsp_state_sc_set());
+	libsinsp::events::set<ppm_event_code> res;
+	for (const auto& e : libsinsp::events::all_event_set())
+	{
+		if (libsinsp::events::is_syscall_event(e) && !state_events.contains(e))
+		{
+			res.insert(e);
+		}
+	}
+	return res;
+}
+
+std::string scap_index::sidecar_path(const std::string& capture_file)
+{
+	return capture_file + ".fidx";
+}
+
+bool scap_index::build(const std::string& capture_file, uint64_t chunk_size, uint64_t min_skippable_size, std::string& err)
+{
+	uint64_t file_size, file_mtime;
+	if (!stat_file(capture_file, file_size, file_mtime))
+	{
+		err = "can't stat capture file " + capture_file + ": " + strerror(errno);
+		return false;
+	}
+
+	std::ifstream in(capture_file, std::ios::binary);
+	if (!in.is_open())
+	{
+		err = "can't open capture file " + capture_file;
+		return false;
+	}
+
+	block_header bh;
+	uint32_t magic = 0;
+	if (!in.read((char*) &bh, sizeof(bh)) || !in.read((char*) &magic, sizeof(magic)))
+	{
+		err = "capture file " + capture_file + " is too short";
+		return false;
+	}
+	if ((bh.block_type & 0xffff) == 0x8b1f)
+	{
+		err = "capture file " + capture_file + " is compressed, only uncompressed captures can be indexed";
+		return false;
+	}
+	if (bh.block_type != s_shb_block_type || magic != s_byte_order_magic)
+	{
+		err = "capture file " + capture_file + " is not a valid scap file, or has a different byte order";
+		return false;
+	}
+
+	auto skippable_types = skippable_event_types();
+	std::vector<chunk> chunks;
+	chunk* cur = nullptr;
+	bool cur_skippable = false;
+	uint64_t offset = 0;
+	while (offset < file_size)
+	{
+		in.seekg(offset);
+		if (!in.read((char*) &bh, sizeof(bh)))
+		{
+			break;
+		}
+		if (bh.block_total_length < sizeof(bh) || offset + bh.block_total_length > file_size)
+		{
+			err = "capture file " + capture_file + " has a corrupted or truncated block at offset " + std::to_string(offset);
+			return false;
+		}
+
+		bool has_flags = false;
+		if (is_event_block(bh.block_type, has_flags))
+		{
+			uint16_t cpuid;
+			uint32_t flags;
+			event_header eh;
+			if (!in.read((char*) &cpuid, sizeof(cpuid))
+				|| (has_flags && !in.read((char*) &flags, sizeof(flags)))
+				|| !in.read((char*) &eh, sizeof(eh)))
+			{
+				err = "capture file " + capture_file + " has a truncated event at offset " + std::to_string(offset);
+				return false;
+			}
+
+			// the runs of skippable events and the ones of state events
+			// are indexed in separate chunks
+			bool skippable = skippable_types.contains((ppm_event_code) eh.type);
+			if (cur != nullptr && skippable != cur_skippable)
+			{
+				cur = nullptr;
+			}
+			if (cur == nullptr)
+			{
+				cur = &chunks.emplace_back();
+				cur->start_offset = offset;
+				cur_skippable = skippable;
+			}
+			cur->num_events++;
+			cur->min_ts = std::min(cur->min_ts, eh.ts);
+			cur->max_ts = std::max(cur->max_ts, eh.ts);
+			cur->min_tid = std::min(cur->min_tid, (int64_t) eh.tid);
+			cur->max_tid = std::max(cur->max_tid, (int64_t) eh.tid);
+			cur->event_types.insert((ppm_event_code) eh.type);
+		}
+		else if (cur != nullptr && cur_skippable)
+		{
+			// the blocks other than events (e.g. the process list) are
+			// never part of a skippable chunk, they end it instead
+			cur = nullptr;
+		}
+		else if (cur != nullptr)
+		{
+			cur->has_other_blocks = true;
+		}
+
+		offset += bh.block_total_length;
+		if (cur != nullptr)
+		{
+			cur->end_offset = offset;
+			if (cur->end_offset - cur->start_offset >= chunk_size)
+			{
+				cur = nullptr;
+			}
+		}
+	}
+
+	// the short runs of skippable events are merged with the chunk
+	// preceding them, if any
+	std::vector<chunk> merged;
+	for (auto& c : chunks)
+	{
+		bool short_run = c.end_offset - c.start_offset < min_skippable_size
+			&& c.event_types.diff(skippable_types).empty();
+		if (short_run && !merged.empty() && merged.back().end_offset == c.start_offset)
+		{
+			auto& prev = merged.back();
+			prev.end_offset = c.end_offset;
+			prev.num_events += c.num_events;
+			prev.min_ts = std::min(prev.min_ts, c.min_ts);
+			prev.max_ts = std::max(prev.max_ts, c.max_ts);
+			prev.min_tid = std::min(prev.min_tid, c.min_tid);
+			prev.max_tid = std::max(prev.max_tid, c.max_tid);
+			prev.event_types = prev.event_types.merge(c.event_types);
+			continue;
+		}
+		merged.push_back(std::move(c));
+	}
+	chunks = std::move(merged);
+
+	nlohmann::json j;
+	j["version"] = s_index_version;
+	j["capture_size"] = file_size;
+	j["capture_mtime"] = file_mtime;
+	j["chunks"] = nlohmann::json::array();
+	for (const auto& c : chunks)
+	{
+		nlohmann::json jc;
+		jc["start"] = c.start_offset;
+		jc["end"] = c.end_offset;
+		jc["events"] = c.num_events;
+		jc["min_ts"] = c.min_ts;
+		jc["max_ts"] = c.max_ts;
+		jc["min_tid"] = c.min_tid;
+		jc["max_tid"] = c.max_tid;
+		jc["other_blocks"] = c.has_other_blocks;
+		jc["event_types"] = nlohmann::json::array();
+		for (const auto& e : c.event_types)
+		{
+			jc["event_types"].push_back((uint16_t) e);
+		}
+		j["chunks"].push_back(jc);
+	}
+
+	// write to a temporary file first, so that a concurrent replay never
+	// reads a partially-written index
+	auto path = sidecar_path(capture_file);
+	auto tmp_path = path + ".tmp";
+	std::ofstream out(tmp_path);
+	out << j.dump() << std::endl;
+	out.close();
+	if (!out.good() || std::rename(tmp_path.c_str(), path.c_str()) != 0)
+	{
+		err = "can't write capture index " + path + ": " + strerror(errno);
+		std::remove(tmp_path.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool scap_index::load(const std::string& capture_file, std::string& err)
+{
+	m_chunks.clear();
+
+	auto path = sidecar_path(capture_file);
+	std::ifstream in(path);
+	if (!in.is_open())
+	{
+		err = "no index found at " + path;
+		return false;
+	}
+
+	uint64_t file_size, file_mtime;
+	if (!stat_file(capture_file, file_size, file_mtime))
+	{
+		err = "can't stat capture file " + capture_file + ": " + strerror(errno);
+		return false;
+	}
+
+	try
+	{
+		auto j = nlohmann::json::parse(in);
+		if (j.at("version").get<uint32_t>() != s_index_version)
+		{
+			err = "index " + path + " has an unsupported version";
+			return false;
+		}
+		if (j.at("capture_size").get<uint64_t>() != file_size
+			|| j.at("capture_mtime").get<uint64_t>() != file_mtime)
+		{
+			err = "index " + path + " is stale, the capture file changed after indexing it";
+			return false;
+		}
+
+		for (const auto& jc : j.at("chunks"))
+		{
+			auto& c = m_chunks.emplace_back();
+			c.start_offset = jc.at("start").get<uint64_t>();
+			c.end_offset = jc.at("end").get<uint64_t>();
+			c.num_events = jc.at("events").get<uint64_t>();
+			c.min_ts = jc.at("min_ts").get<uint64_t>();
+			c.max_ts = jc.at("max_ts").get<uint64_t>();
+			c.min_tid = jc.at("min_tid").get<int64_t>();
+			c.max_tid = jc.at("max_tid").get<int64_t>();
+			c.has_other_blocks = jc.at("other_blocks").get<bool>();
+			for (const auto& e : jc.at("event_types"))
+			{
+				c.event_types.insert((ppm_event_code) e.get<uint16_t>());
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		m_chunks.clear();
+		err = "index " + path + " is malformed: " + e.what();
+		return false;
+	}
+
+	return true;
+}
+
+std::vector<scap_index::range> scap_index::skippable_ranges(const query& q) const
+{
+	auto skippable_types = skippable_event_types();
+	std::vector<range> res;
+	for (const auto& c : m_chunks)
+	{
+		if (c.has_other_blocks || !c.event_types.diff(skippable_types).empty())
+		{
+			continue;
+		}
+
+		bool out_of_window = (q.start_ts > 0 && c.max_ts < q.start_ts)
+			|| (q.end_ts > 0 && c.min_ts > q.end_ts);
+		bool no_tids = false;
+		if (!q.tids.empty())
+		{
+			auto it = q.tids.lower_bound(c.min_tid);
+			no_tids = it == q.tids.end() || *it > c.max_tid;
+		}
+		bool no_event_types = !q.event_types.empty()
+			&& c.event_types.intersect(q.event_types).empty();
+
+		if (out_of_window || no_tids || no_event_types)
+		{
+			if (!res.empty() && res.back().second == c.start_offset)
+			{
+				res.back().second = c.end_offset;
+			}
+			else
+			{
+				res.emplace_back(c.start_offset, c.end_offset);
+			}
+		}
+	}
+	return res;
+}
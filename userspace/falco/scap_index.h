@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <libsinsp/events/sinsp_events.h>
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+	\brief A sidecar index of a scap capture file. The event blocks of the
+	capture are grouped in contiguous chunks, and for each chunk the index
+	holds its byte range in the file, the range of event timestamps and
+	thread ids, and the set of event types it contains. This allows
+	skipping the chunks that can't produce any match when replaying the
+	capture. Only uncompressed captures can be indexed, because seeking
+	into gzip-compressed ones would require decompressing them anyway.
+*/
+class scap_index
+{
+public:
+	struct chunk
+	{
+		uint64_t start_offset = 0;
+		uint64_t end_offset = 0;
+		uint64_t num_events = 0;
+		uint64_t min_ts = UINT64_MAX;
+		uint64_t max_ts = 0;
+		int64_t min_tid = INT64_MAX;
+		int64_t max_tid = INT64_MIN;
+		libsinsp::events::set<ppm_event_code> event_types;
+		// true if the chunk contains blocks other than events
+		bool has_other_blocks = false;
+	};
+
+	/*!
+		\brief Describes which events are of interest when replaying
+	*/
+	struct query
+	{
+		// in ns since epoch, 0 means unbounded
+		uint64_t start_ts = 0;
+		uint64_t end_ts = 0;
+		// empty means all the thread ids
+		std::set<int64_t> tids;
+		// empty means all the event types
+		libsinsp::events::set<ppm_event_code> event_types;
+	};
+
+	// A [start, end) byte range of the capture file
+	using range = std::pair<uint64_t, uint64_t>;
+
+	/*!
+		\brief Returns the path of the sidecar index of a capture file
+	*/
+	static std::string sidecar_path(const std::string& capture_file);
+
+	/*!
+		\brief Scans a capture file and writes its sidecar index. Each chunk
+		spans at most approximately chunk_size bytes of event blocks, and
+		the runs of events that don't update the thread state are kept in
+		chunks of their own, so that they can be skipped even if the
+		events around them can't. The runs shorter than
+		min_skippable_size bytes are merged with the chunk preceding them
+		instead, to keep the index small. Returns false and fills err in
+		case of failure.
+	*/
+	static bool build(const std::string& capture_file, uint64_t chunk_size, uint64_t min_skippable_size, std::string& err);
+
+	/*!
+		\brief Loads the sidecar index of a capture file. Returns false and
+		fills err if the index is missing, malformed, or stale with respect
+		to the capture file.
+	*/
+	bool load(const std::string& capture_file, std::string& err);
+
+	/*!
+		\brief Returns the sorted byte ranges of the capture that can be
+		skipped because none of their events is of interest. Chunks holding
+		events that update the thread state are never skipped, so that the
+		state of the events that are processed stays accurate.
+	*/
+	std::vector<range> skippable_ranges(const query& q) const;
+
+	inline const std::vector<chunk>& chunks() const
+	{
+		return m_chunks;
+	}
+
+private:
+	std::vector<chunk> m_chunks;
+};
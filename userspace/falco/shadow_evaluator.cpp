@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "shadow_evaluator.h"
+
+// The CPU cap is enforced over windows of one second
+static constexpr uint64_t s_window_ns = 1000000000;
+
+shadow_evaluator::shadow_evaluator(
+		std::shared_ptr<falco_engine> engine,
+		size_t num_sources,
+		uint32_t sample_ratio,
+		double max_cpu_pct)
+	: m_engine(engine),
+	  m_sample_ratio(sample_ratio),
+	  m_max_cpu_ns_per_window((uint64_t) (s_window_ns * (max_cpu_pct / 100.0)))
+{
+	for (size_t i = 0; i < num_sources; i++)
+	{
+		m_sources.push_back(std::make_unique<source_stats>());
+	}
+}
+
+void shadow_evaluator::on_production_result(size_t source_idx, uint64_t elapsed_ns, size_t num_matches)
+{
+	auto& st = *m_sources[source_idx];
+	st.sampled_evts.fetch_add(1, std::memory_order_relaxed);
+	st.prod_cpu_ns.fetch_add(elapsed_ns, std::memory_order_relaxed);
+	st.prod_matches.fetch_add(num_matches, std::memory_order_relaxed);
+}
+
+void shadow_evaluator::evaluate(size_t source_idx, sinsp_evt* ev, falco_common::rule_matching strategy)
+{
+	auto& st = *m_sources[source_idx];
+	// the cap is a share of the wall clock time of each window, and the
+	// cost of the shadow evaluation is the CPU time it consumed
+	auto now = now_ns();
+	if (now - st.window_start_ns >= s_window_ns)
+	{
+		st.window_start_ns = now;
+		st.window_cpu_ns = 0;
+	}
+
+	if (st.window_cpu_ns >= m_max_cpu_ns_per_window)
+	{
+		st.skipped_evts.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	auto start = thread_cpu_ns();
+	auto res = m_engine->process_event(source_idx, ev, strategy);
+	auto elapsed = thread_cpu_ns() - start;
+
+	st.window_cpu_ns += elapsed;
+	st.shadow_cpu_ns.fetch_add(elapsed, std::memory_order_relaxed);
+	if (res != nullptr)
+	{
+		st.shadow_matches.fetch_add(res->size(), std::memory_order_relaxed);
+	}
+}
+
+shadow_evaluator::stats shadow_evaluator::get_stats() const
+{
+	stats ret;
+	for (const auto& st : m_sources)
+	{
+		ret.sampled_evts += st->sampled_evts.load(std::memory_order_relaxed);
+		ret.skipped_evts += st->skipped_evts.load(std::memory_order_relaxed);
+		ret.prod_matches += st->prod_matches.load(std::memory_order_relaxed);
+		ret.shadow_matches += st->shadow_matches.load(std::memory_order_relaxed);
+		ret.prod_cpu_ns += st->prod_cpu_ns.load(std::memory_order_relaxed);
+		ret.shadow_cpu_ns += st->shadow_cpu_ns.load(std::memory_order_relaxed);
+	}
+	return ret;
+}
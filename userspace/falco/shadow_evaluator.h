@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "falco_engine.h"
+#include "falco_common.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+/*!
+	\brief Evaluates a candidate ("shadow") set of rules on a sample of the
+	events, without emitting any alert, and accounts its match counts and
+	evaluation cost next to the ones of the production rules on the same
+	events. The shadow evaluation work is capped to a maximum share of CPU
+	time. Each event source is accounted separately: the methods receiving
+	a source index inherit the thread-safety guarantees of
+	falco_engine::process_event(), whereas get_stats() is thread-safe.
+*/
+class shadow_evaluator
+{
+public:
+	/*!
+		\brief Counters accounted on the sampled events only
+	*/
+	struct stats
+	{
+		// events sampled for comparison
+		uint64_t sampled_evts = 0;
+		// sampled events not evaluated by the shadow rules due to the CPU cap
+		uint64_t skipped_evts = 0;
+		uint64_t prod_matches = 0;
+		uint64_t shadow_matches = 0;
+		uint64_t prod_cpu_ns = 0;
+		uint64_t shadow_cpu_ns = 0;
+	};
+
+	shadow_evaluator(
+		std::shared_ptr<falco_engine> engine,
+		size_t num_sources,
+		uint32_t sample_ratio,
+		double max_cpu_pct);
+
+	/*!
+		\brief Returns true if the next event of the given source should be
+		compared across the production and the shadow rules
+	*/
+	inline bool should_sample(size_t source_idx)
+	{
+		auto& st = *m_sources[source_idx];
+		if (++st.counter < m_sample_ratio)
+		{
+			return false;
+		}
+		st.counter = 0;
+		return true;
+	}
+
+	/*!
+		\brief Accounts the evaluation of a sampled event with the production
+		rules, given the thread CPU time it took (see thread_cpu_ns()) and
+		the number of matching rules
+	*/
+	void on_production_result(size_t source_idx, uint64_t elapsed_ns, size_t num_matches);
+
+	/*!
+		\brief Evaluates a sampled event with the shadow rules, unless
+		doing so would exceed the CPU cap
+	*/
+	void evaluate(size_t source_idx, sinsp_evt* ev, falco_common::rule_matching strategy);
+
+	/*!
+		\brief Returns the counters aggregated across all event sources
+	*/
+	stats get_stats() const;
+
+	/*!
+		\brief Returns the engine holding the shadow rules, for accessing
+		its per-rule stats
+	*/
+	inline const falco_engine& engine() const
+	{
+		return *m_engine;
+	}
+
+	static inline uint64_t now_ns()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/*!
+		\brief Returns the CPU time consumed by the calling thread, so that
+		the time the thread is preempted or blocked is not accounted.
+		Falls back to the wall clock where not supported.
+	*/
+	static inline uint64_t thread_cpu_ns()
+	{
+#ifndef _WIN32
+		struct timespec ts;
+		if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+		{
+			return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+		}
+#endif
+		return now_ns();
+	}
+
+private:
+	struct source_stats
+	{
+		// only accessed by the thread processing the source
+		uint32_t counter = 0;
+		uint64_t window_start_ns = 0;
+		uint64_t window_cpu_ns = 0;
+
+		// read by the metrics collection thread too
+		std::atomic<uint64_t> sampled_evts{0};
+		std::atomic<uint64_t> skipped_evts{0};
+		std::atomic<uint64_t> prod_matches{0};
+		std::atomic<uint64_t> shadow_matches{0};
+		std::atomic<uint64_t> prod_cpu_ns{0};
+		std::atomic<uint64_t> shadow_cpu_ns{0};
+	};
+
+	std::shared_ptr<falco_engine> m_engine;
+	std::vector<std::unique_ptr<source_stats>> m_sources;
+	uint32_t m_sample_ratio;
+	uint64_t m_max_cpu_ns_per_window;
+};
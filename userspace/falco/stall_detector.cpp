@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "stall_detector.h"
+
+#include <libsinsp/events/sinsp_events.h>
+
+#include <chrono>
+
+static constexpr uint64_t s_ns_per_ms = 1000 * 1000;
+static constexpr uint64_t s_log_window_ns = 60 * 1000 * s_ns_per_ms;
+
+// Upper bounds of the stall duration histogram buckets
+static const std::vector<uint64_t> s_bucket_bounds_ms = {100, 250, 500, 1000, 2500, 5000, 10000, UINT64_MAX};
+
+static uint64_t steady_now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+stall_detector::stall_detector(
+		std::shared_ptr<const falco_engine> engine,
+		uint32_t threshold_ms,
+		uint32_t check_interval_ms,
+		uint32_t max_logs_per_minute,
+		log_fn log)
+	: m_engine(engine),
+	  m_threshold_ns(threshold_ms * s_ns_per_ms),
+	  m_check_interval_ns(check_interval_ms * s_ns_per_ms),
+	  m_max_logs_per_minute(max_logs_per_minute),
+	  m_log(log)
+{
+	for (auto b : s_bucket_bounds_ms)
+	{
+		m_stats.buckets_le_ms.emplace_back(b, 0);
+	}
+}
+
+stall_detector::~stall_detector()
+{
+	stop();
+}
+
+std::shared_ptr<stall_detector::heartbeat> stall_detector::add_heartbeat(const std::string& source)
+{
+	auto hb = std::make_shared<heartbeat>();
+	hb->source = source;
+
+	std::unique_lock<std::mutex> lock(m_mtx);
+	auto& m = m_monitored.emplace_back();
+	m.hb = hb;
+	m.last_change_ns = steady_now_ns();
+	return hb;
+}
+
+void stall_detector::start()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	if (!m_stop)
+	{
+		return;
+	}
+	m_stop = false;
+	m_thread = std::thread([this]()
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		while (!m_stop)
+		{
+			m_cv.wait_for(lock, std::chrono::nanoseconds(m_check_interval_ns));
+			if (!m_stop)
+			{
+				lock.unlock();
+				check(steady_now_ns());
+				lock.lock();
+			}
+		}
+	});
+}
+
+void stall_detector::stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if (m_stop)
+		{
+			return;
+		}
+		m_stop = true;
+		m_cv.notify_all();
+	}
+	m_thread.join();
+
+	// stalls still ongoing are accounted with their duration so far
+	std::unique_lock<std::mutex> lock(m_mtx);
+	auto now = steady_now_ns();
+	for (auto& m : m_monitored)
+	{
+		if (m.in_stall)
+		{
+			finish_stall(m, now);
+		}
+	}
+}
+
+void stall_detector::finish_stall(monitored& m, uint64_t now_ns)
+{
+	uint64_t duration_ms = (now_ns - m.last_change_ns) / s_ns_per_ms;
+	m.in_stall = false;
+	m_stats.ongoing--;
+	m_stats.completed++;
+	m_stats.total_ms += duration_ms;
+	m_stats.max_ms = std::max(m_stats.max_ms, duration_ms);
+	for (auto& b : m_stats.buckets_le_ms)
+	{
+		if (duration_ms <= b.first)
+		{
+			b.second++;
+		}
+	}
+}
+
+void stall_detector::check(uint64_t now_ns)
+{
+	std::vector<snapshot> to_log;
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		for (auto& m : m_monitored)
+		{
+			auto progress = m.hb->progress.load(std::memory_order_relaxed);
+			if (progress != m.last_progress)
+			{
+				if (m.in_stall)
+				{
+					finish_stall(m, now_ns);
+				}
+				m.last_progress = progress;
+				m.last_change_ns = now_ns;
+				continue;
+			}
+
+			auto st = (stage) m.hb->current_stage.load(std::memory_order_relaxed);
+			if (st == stage::idle)
+			{
+				m.last_change_ns = now_ns;
+				continue;
+			}
+
+			if (m.in_stall || now_ns - m.last_change_ns < m_threshold_ns)
+			{
+				continue;
+			}
+
+			// a new stall, each one is counted and logged only once
+			m.in_stall = true;
+			m_stats.stalls++;
+			m_stats.ongoing++;
+
+			if (now_ns - m_log_window_start_ns >= s_log_window_ns)
+			{
+				m_log_window_start_ns = now_ns;
+				m_logs_in_window = 0;
+			}
+			if (m_max_logs_per_minute > 0 && m_logs_in_window >= m_max_logs_per_minute)
+			{
+				continue;
+			}
+			m_logs_in_window++;
+
+			snapshot snap;
+			snap.source = m.hb->source;
+			snap.duration_ms = (now_ns - m.last_change_ns) / s_ns_per_ms;
+			snap.current_stage = st;
+			snap.evt_type = m.hb->evt_type.load(std::memory_order_relaxed);
+			auto rule_id = m.hb->current_rule.load(std::memory_order_relaxed);
+			if (st == stage::rules && rule_id >= 0 && m_engine != nullptr
+				&& (size_t) rule_id < m_engine->get_rules().size())
+			{
+				snap.rule = m_engine->get_rules().at(rule_id)->name;
+			}
+			to_log.push_back(std::move(snap));
+		}
+	}
+
+	// logging may block, so it happens outside of the lock
+	if (m_log)
+	{
+		for (const auto& snap : to_log)
+		{
+			m_log(snap);
+		}
+	}
+}
+
+stall_detector::stats stall_detector::get_stats() const
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	return m_stats;
+}
+
+const char* stall_detector::stage_name(stage st)
+{
+	switch (st)
+	{
+	case stage::next_event:
+		return "fetching the next event";
+	case stage::rules:
+		return "evaluating rules";
+	case stage::outputs:
+		return "emitting outputs";
+	case stage::post_processing:
+		return "post-processing";
+	default:
+		return "idle";
+	}
+}
+
+std::string stall_detector::format(const snapshot& snap)
+{
+	std::string res = "Event processing stalled for more than " + std::to_string(snap.duration_ms) + "ms";
+	res += " (source: " + snap.source + ", stage: " + stage_name(snap.current_stage);
+	if (snap.current_stage != stage::next_event)
+	{
+		const auto* info = libsinsp::events::info((ppm_event_code) snap.evt_type);
+		res += ", evt.type: ";
+		res += info != nullptr ? info->name : std::to_string(snap.evt_type);
+	}
+	if (!snap.rule.empty())
+	{
+		res += ", rule: " + snap.rule;
+	}
+	res += ")";
+	return res;
+}
@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "falco_engine.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*!
+	\brief Detects stalls of the event processing threads. Each thread owns
+	a heartbeat that it updates at every stage of the processing of an
+	event, and a monitor thread periodically checks that all heartbeats
+	make progress. The heartbeat updates are plain relaxed stores and never
+	read the clock, so that the cost on the event processing threads is
+	negligible. As a consequence, stall durations are only as accurate as
+	the check interval.
+*/
+class stall_detector
+{
+public:
+	/*!
+		\brief What an event processing thread is doing
+	*/
+	enum class stage : uint8_t
+	{
+		// waiting on purpose (e.g. replay pacing), never reported as a stall
+		idle = 0,
+		next_event,
+		rules,
+		outputs,
+		post_processing
+	};
+
+	/*!
+		\brief The progress of a single event processing thread. Must only
+		be updated by the thread owning it.
+	*/
+	struct heartbeat
+	{
+		std::string source;
+		std::atomic<uint64_t> progress{0};
+		std::atomic<uint8_t> current_stage{(uint8_t) stage::idle};
+		std::atomic<uint16_t> evt_type{0};
+		// id of the rule being evaluated, or -1
+		std::atomic<int64_t> current_rule{-1};
+
+		inline void enter(stage st)
+		{
+			progress.store(progress.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			current_stage.store((uint8_t) st, std::memory_order_relaxed);
+		}
+
+		inline void set_event(uint16_t type)
+		{
+			evt_type.store(type, std::memory_order_relaxed);
+		}
+	};
+
+	/*!
+		\brief Counters and duration histogram of the detected stalls. The
+		histogram buckets are cumulative, as in Prometheus: each one counts
+		the stalls that lasted at most its upper bound.
+	*/
+	struct stats
+	{
+		uint64_t stalls = 0;
+		uint64_t ongoing = 0;
+		uint64_t total_ms = 0;
+		uint64_t max_ms = 0;
+		std::vector<std::pair<uint64_t, uint64_t>> buckets_le_ms;
+		uint64_t completed = 0;
+	};
+
+	/*!
+		\brief Describes a stall at the time it was detected
+	*/
+	struct snapshot
+	{
+		std::string source;
+		uint64_t duration_ms = 0;
+		stage current_stage = stage::idle;
+		uint16_t evt_type = 0;
+		std::string rule;
+	};
+
+	using log_fn = std::function<void(const snapshot&)>;
+
+	/*!
+		\brief Creates a detector reporting stalls longer than threshold_ms.
+		The rule names of the snapshots are resolved with the given engine.
+		Detected stalls are passed to log, at most max_logs_per_minute
+		times per minute (0 means unlimited).
+	*/
+	stall_detector(
+		std::shared_ptr<const falco_engine> engine,
+		uint32_t threshold_ms,
+		uint32_t check_interval_ms,
+		uint32_t max_logs_per_minute,
+		log_fn log);
+	virtual ~stall_detector();
+	stall_detector(stall_detector&&) = delete;
+	stall_detector& operator = (stall_detector&&) = delete;
+	stall_detector(const stall_detector&) = delete;
+	stall_detector& operator = (const stall_detector&) = delete;
+
+	/*!
+		\brief Creates the heartbeat of a new event processing thread. The
+		heartbeat stays valid for the lifetime of the detector.
+	*/
+	std::shared_ptr<heartbeat> add_heartbeat(const std::string& source);
+
+	void start();
+	void stop();
+
+	/*!
+		\brief Runs a single check at the given time, in ns of the steady
+		clock. This is what the monitor thread does at each interval.
+	*/
+	void check(uint64_t now_ns);
+
+	stats get_stats() const;
+
+	static const char* stage_name(stage st);
+	static std::string format(const snapshot& snap);
+
+private:
+	struct monitored
+	{
+		std::shared_ptr<heartbeat> hb;
+		uint64_t last_progress = 0;
+		uint64_t last_change_ns = 0;
+		bool in_stall = false;
+	};
+
+	void finish_stall(monitored& m, uint64_t now_ns);
+
+	std::shared_ptr<const falco_engine> m_engine;
+	uint64_t m_threshold_ns;
+	uint64_t m_check_interval_ns;
+	uint32_t m_max_logs_per_minute;
+	log_fn m_log;
+
+	mutable std::mutex m_mtx;
+	std::list<monitored> m_monitored;
+	stats m_stats;
+	uint64_t m_log_window_start_ns = 0;
+	uint32_t m_logs_in_window = 0;
+
+	std::thread m_thread;
+	std::condition_variable m_cv;
+	bool m_stop = true;
+};
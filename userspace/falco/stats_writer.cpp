@@ -28,6 +28,8 @@ limitations under the License.
 #include "stats_writer.h"
 #include "logger.h"
 #include "config_falco.h"
+#include "falco_usdt.h"
+#include "cpu_profiler.h"
 #include "falco_utils.h"
 #include <libscap/strl.h>
 #include <libscap/scap_vtable.h>
@@ -172,8 +174,11 @@ stats_writer::ticker_t stats_writer::get_ticker()
 stats_writer::stats_writer(
 		const std::shared_ptr<falco_outputs>& outputs,
 		const std::shared_ptr<const falco_configuration>& config,
-		const std::shared_ptr<const falco_engine>& engine)
-	: m_config(config), m_engine(engine)
+		const std::shared_ptr<const falco_engine>& engine,
+		const std::shared_ptr<const shadow_evaluator>& shadow,
+		const std::shared_ptr<const stall_detector>& stalls,
+		const std::shared_ptr<const memory_budget>& budget)
+	: m_config(config), m_engine(engine), m_shadow(shadow), m_stalls(stalls), m_budget(budget)
 {
 	if (config->m_metrics_enabled)
 	{
@@ -193,6 +198,15 @@ stats_writer::stats_writer(
 		{
 			m_initialized = true;
 		}
+
+#if defined(__linux__) and !defined(MINIMAL_BUILD) and !defined(__EMSCRIPTEN__)
+		if (config->m_otlp_metrics_enabled)
+		{
+			auto cfg = otlp_exporter::parse_options(config->m_otlp_output.options, "/v1/metrics");
+			m_otlp_exporter = std::make_unique<otlp_exporter>(cfg, otlp_exporter::metrics_encoder(outputs->get_hostname()));
+			m_initialized = true;
+		}
+#endif
 	}
 
 	if (m_initialized)
@@ -211,6 +225,12 @@ stats_writer::~stats_writer()
 	{
 #ifndef __EMSCRIPTEN__
 		stop_worker();
+#endif
+#if defined(__linux__) and !defined(MINIMAL_BUILD) and !defined(__EMSCRIPTEN__)
+		if (m_otlp_exporter)
+		{
+			m_otlp_exporter->stop();
+		}
 #endif
 		if (!m_config->m_metrics_output_file.empty())
 		{
@@ -251,6 +271,7 @@ inline void stats_writer::push(const stats_writer::msg& m)
 
 void stats_writer::worker() noexcept
 {
+	cpu_profiler::set_thread_role("stats");
 	stats_writer::msg m;
 	bool use_outputs = m_config->m_metrics_stats_rule_enabled;
 	bool use_file = !m_config->m_metrics_output_file.empty();
@@ -295,6 +316,18 @@ void stats_writer::worker() noexcept
 					jmsg["output_fields"] = m.output_fields;
 					m_file_output << jmsg.dump() << std::endl;
 				}
+
+#if defined(__linux__) and !defined(MINIMAL_BUILD) and !defined(__EMSCRIPTEN__)
+				if (m_otlp_exporter)
+				{
+					std::vector<otlp_exporter::record_t> metrics;
+					otlp_exporter::make_metrics(m.ts, m.output_fields, metrics);
+					for (auto& r : metrics)
+					{
+						m_otlp_exporter->add(std::move(r));
+					}
+				}
+#endif
 			}
 			catch(const std::exception &e)
 			{
@@ -399,6 +432,61 @@ void stats_writer::collector::get_metrics_output_fields_additional(
 		}
 	}
 
+	// shadow rules comparison, always enabled along with shadow rules
+	if (m_writer->m_shadow)
+	{
+		auto shadow_stats = m_writer->m_shadow->get_stats();
+		output_fields["falco.shadow.sampled_evts"] = shadow_stats.sampled_evts;
+		output_fields["falco.shadow.skipped_evts"] = shadow_stats.skipped_evts;
+		output_fields["falco.shadow.prod_matches"] = shadow_stats.prod_matches;
+		output_fields["falco.shadow.matches"] = shadow_stats.shadow_matches;
+		output_fields["falco.shadow.prod_cpu_ns"] = shadow_stats.prod_cpu_ns;
+		output_fields["falco.shadow.cpu_ns"] = shadow_stats.shadow_cpu_ns;
+
+		const auto& shadow_engine = m_writer->m_shadow->engine();
+		const indexed_vector<falco_rule>& shadow_rules = shadow_engine.get_rules();
+		const auto& shadow_rules_by_id = shadow_engine.get_rule_stats_manager().get_by_rule_id();
+		for (size_t i = 0; i < shadow_rules_by_id.size(); i++)
+		{
+			auto rule_count = shadow_rules_by_id[i]->load();
+			if (rule_count == 0 && !m_writer->m_config->m_metrics_include_empty_values)
+			{
+				continue;
+			}
+			std::string rules_metric_name = "falco.shadow.rules." + falco::utils::sanitize_metric_name(shadow_rules.at(i)->name);
+			output_fields[rules_metric_name] = rule_count;
+		}
+	}
+
+	// stall detector, always enabled along with it
+	if (m_writer->m_stalls)
+	{
+		auto stall_stats = m_writer->m_stalls->get_stats();
+		output_fields["falco.stall.count"] = stall_stats.stalls;
+		output_fields["falco.stall.ongoing"] = stall_stats.ongoing;
+		output_fields["falco.stall.total_ms"] = stall_stats.total_ms;
+		output_fields["falco.stall.max_ms"] = stall_stats.max_ms;
+		for (const auto& b : stall_stats.buckets_le_ms)
+		{
+			std::string bound = b.first == UINT64_MAX ? "inf" : (std::to_string(b.first) + "ms");
+			output_fields["falco.stall.duration_le_" + bound] = b.second;
+		}
+	}
+
+	// memory budget, always enabled along with it
+	if (m_writer->m_budget)
+	{
+		output_fields["falco.memory_budget.used_bytes"] = m_writer->m_budget->used();
+		output_fields["falco.memory_budget.limit_bytes"] = m_writer->m_budget->limit();
+		output_fields["falco.memory_budget.level"] = memory_budget::level_name(m_writer->m_budget->current_level());
+		for (const auto& u : m_writer->m_budget->get_usage())
+		{
+			output_fields["falco.memory_budget." + u.name + ".used_bytes"] = u.used_bytes;
+			output_fields["falco.memory_budget." + u.name + ".summarized"] = u.summarized;
+			output_fields["falco.memory_budget." + u.name + ".dropped"] = u.dropped;
+		}
+	}
+
 #if defined(__linux__) and !defined(MINIMAL_BUILD) and !defined(__EMSCRIPTEN__)
 	if (m_writer->m_libs_metrics_collector && m_writer->m_output_rule_metrics_converter)
 	{
@@ -559,6 +647,8 @@ void stats_writer::collector::collect(const std::shared_ptr<sinsp>& inspector, c
 			get_metrics_output_fields_wrapper(output_fields, inspector, src, num_evts, now, stats_snapshot_time_delta_sec);
 			get_metrics_output_fields_additional(output_fields, stats_snapshot_time_delta_sec);
 
+			FALCO_PROBE2(metrics_snapshot, src.c_str(), num_evts);
+
 			/* Send message in the queue */
 			stats_writer::msg msg;
 			msg.ts = now;
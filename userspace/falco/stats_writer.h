@@ -28,6 +28,12 @@ limitations under the License.
 #endif
 #include "falco_outputs.h"
 #include "configuration.h"
+#include "shadow_evaluator.h"
+#include "stall_detector.h"
+#include "memory_budget.h"
+#if defined(__linux__) and !defined(MINIMAL_BUILD) and !defined(__EMSCRIPTEN__)
+#include "otlp_exporter.h"
+#endif
 
 /*!
 	\brief Writes stats samples collected from inspectors into a given output.
@@ -97,7 +103,10 @@ public:
 	*/
 	stats_writer(const std::shared_ptr<falco_outputs>& outputs,
 		const std::shared_ptr<const falco_configuration>& config,
-		const std::shared_ptr<const falco_engine>& engine);
+		const std::shared_ptr<const falco_engine>& engine,
+		const std::shared_ptr<const shadow_evaluator>& shadow = nullptr,
+		const std::shared_ptr<const stall_detector>& stalls = nullptr,
+		const std::shared_ptr<const memory_budget>& budget = nullptr);
 
 	/*!
 		\brief Returns true if the writer is configured with a valid output.
@@ -150,10 +159,14 @@ private:
 #if defined(__linux__) and !defined(MINIMAL_BUILD) and !defined(__EMSCRIPTEN__)
 	std::unique_ptr<libs::metrics::libs_metrics_collector> m_libs_metrics_collector;
 	std::unique_ptr<libs::metrics::output_rule_metrics_converter> m_output_rule_metrics_converter;
+	std::unique_ptr<otlp_exporter> m_otlp_exporter;
 #endif
 	std::shared_ptr<falco_outputs> m_outputs;
 	std::shared_ptr<const falco_configuration> m_config;
 	std::shared_ptr<const falco_engine> m_engine;
+	std::shared_ptr<const shadow_evaluator> m_shadow;
+	std::shared_ptr<const stall_detector> m_stalls;
+	std::shared_ptr<const memory_budget> m_budget;
 	// note: in this way, only collectors can push into the queue
 	friend class stats_writer::collector;
 };
@@ -0,0 +1,289 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "synthetic_event_generator.h"
+#include "falco_common.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+static constexpr uint64_t s_first_pid = 100000;
+static constexpr int64_t s_first_fd = 3;
+static constexpr int64_t s_at_fdcwd = -100;
+
+// Returns the size of fixed-size parameters, or 0 for variable-size ones
+static uint32_t fixed_param_size(ppm_param_type t)
+{
+	switch(t)
+	{
+	case PT_INT8:
+	case PT_UINT8:
+	case PT_FLAGS8:
+	case PT_ENUMFLAGS8:
+	case PT_SIGTYPE:
+	case PT_L4PROTO:
+	case PT_SOCKFAMILY:
+		return 1;
+	case PT_INT16:
+	case PT_UINT16:
+	case PT_FLAGS16:
+	case PT_ENUMFLAGS16:
+	case PT_SYSCALLID:
+	case PT_PORT:
+		return 2;
+	case PT_INT32:
+	case PT_UINT32:
+	case PT_FLAGS32:
+	case PT_ENUMFLAGS32:
+	case PT_UID:
+	case PT_GID:
+	case PT_MODE:
+	case PT_BOOL:
+	case PT_SIGSET:
+	case PT_IPV4ADDR:
+		return 4;
+	case PT_INT64:
+	case PT_UINT64:
+	case PT_ERRNO:
+	case PT_FD:
+	case PT_PID:
+	case PT_RELTIME:
+	case PT_ABSTIME:
+	case PT_DOUBLE:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+synthetic_event_generator::synthetic_event_generator(
+		const falco_configuration::synthetic_config& config)
+	: m_config(config), m_data()
+{
+	init_threads();
+	init_events();
+}
+
+void synthetic_event_generator::open(sinsp& inspector)
+{
+	m_data.events = m_events.data();
+	m_data.event_count = m_events.size();
+	m_data.threads = m_threads.data();
+	m_data.thread_count = m_threads.size();
+	m_data.fdinfo_data = nullptr;
+	m_data.fdinfo_data_count = 0;
+	inspector.open_test_input(&m_data, SINSP_MODE_TEST);
+}
+
+void synthetic_event_generator::init_threads()
+{
+	m_threads.resize(m_config.m_processes);
+	for (size_t i = 0; i < m_threads.size(); i++)
+	{
+		auto& tinfo = m_threads[i];
+		memset(&tinfo, 0, sizeof(tinfo));
+		tinfo.tid = s_first_pid + i;
+		tinfo.pid = tinfo.tid;
+		tinfo.ptid = 1;
+		tinfo.sid = tinfo.tid;
+		tinfo.vpgid = tinfo.tid;
+		tinfo.fdlimit = s_first_fd + m_config.m_fds_per_process;
+		snprintf(tinfo.comm, sizeof(tinfo.comm), "synthetic-%zu", i);
+		snprintf(tinfo.exe, sizeof(tinfo.exe), "synthetic-%zu", i);
+		snprintf(tinfo.exepath, sizeof(tinfo.exepath), "/usr/bin/synthetic-%zu", i);
+		snprintf(tinfo.cwd, sizeof(tinfo.cwd), "/");
+	}
+}
+
+void synthetic_event_generator::init_events()
+{
+	const auto* etable = scap_get_event_info_table();
+
+	// resolve each syscall of the mix into its most recent event pair
+	std::vector<syscall_info> syscalls;
+	std::vector<uint32_t> weights;
+	for (const auto& w : m_config.m_event_mix)
+	{
+		int64_t found = -1;
+		for (uint32_t e = 0; e + 1 < PPM_EVENT_MAX; e += 2)
+		{
+			if ((etable[e].flags & (EF_UNUSED | EF_OLD_VERSION)) == 0
+				&& w.m_syscall == etable[e].name)
+			{
+				found = e;
+			}
+		}
+		if (found < 0)
+		{
+			throw falco_exception("synthetic event generator: unknown syscall '" + w.m_syscall + "'");
+		}
+		syscalls.push_back({(ppm_event_code) found, (ppm_event_code) (found + 1)});
+		weights.push_back(w.m_weight);
+	}
+
+	std::mt19937_64 rng(m_config.m_seed);
+	std::discrete_distribution<size_t> syscall_dist(weights.begin(), weights.end());
+	std::uniform_int_distribution<size_t> proc_dist(0, m_threads.size() - 1);
+	std::uniform_int_distribution<int64_t> fd_dist(0, m_config.m_fds_per_process - 1);
+	std::uniform_int_distribution<uint32_t> len_dist(m_config.m_min_string_len, m_config.m_max_string_len);
+	std::uniform_int_distribution<int> char_dist('a', 'z');
+	const bool repeated = m_config.m_string_pattern == "repeated";
+	std::vector<int64_t> next_fd(m_threads.size(), 0);
+
+	// timestamps are spaced according to the target rate, so that
+	// they look realistic once rebased to the present time
+	uint64_t ts = 0;
+	uint64_t ts_step = m_config.m_events_per_second > 0
+		? ONE_SECOND_IN_NS / m_config.m_events_per_second
+		: 1000;
+
+	std::vector<size_t> offsets;
+	std::string str;
+	size_t num_pairs = std::max<size_t>(1, m_config.m_pool_size / 2);
+	for (size_t i = 0; i < num_pairs; i++)
+	{
+		const auto& sc = syscalls[syscall_dist(rng)];
+		auto proc_idx = proc_dist(rng);
+		auto flags = etable[sc.enter].flags | etable[sc.exit].flags;
+
+		int64_t fd = s_at_fdcwd;
+		if (flags & EF_CREATES_FD)
+		{
+			fd = s_first_fd + (next_fd[proc_idx]++ % m_config.m_fds_per_process);
+		}
+		else if (flags & EF_USES_FD)
+		{
+			fd = s_first_fd + fd_dist(rng);
+		}
+
+		str = "/synthetic/";
+		auto len = len_dist(rng);
+		if (repeated)
+		{
+			str.resize(std::max<size_t>(len, str.size()), 'a');
+		}
+		while (str.size() < len)
+		{
+			str.push_back((char) char_dist(rng));
+		}
+		str.resize(len);
+
+		offsets.push_back(m_buffer.size());
+		encode_event(sc.enter, ts += ts_step, proc_idx, fd, str);
+		offsets.push_back(m_buffer.size());
+		encode_event(sc.exit, ts += ts_step, proc_idx, fd, str);
+	}
+
+	// the buffer does not grow anymore, so pointers can be safely taken
+	m_events.clear();
+	for (auto off : offsets)
+	{
+		m_events.push_back((scap_evt*) (m_buffer.data() + off));
+	}
+}
+
+void synthetic_event_generator::encode_event(
+	ppm_event_code type, uint64_t ts, size_t proc_idx, int64_t fd, const std::string& str)
+{
+	const auto* etable = scap_get_event_info_table();
+	const auto& info = etable[type];
+	const auto flags = info.flags | etable[type ^ PPME_DIRECTION_FLAG].flags;
+	const bool is_exit = PPME_IS_EXIT(type);
+	const bool large_payload = (info.flags & EF_LARGE_PAYLOAD) != 0;
+	const uint32_t len_size = large_payload ? sizeof(uint32_t) : sizeof(uint16_t);
+
+	// the strings that don't fit in a 16-bit length, terminator included,
+	// are truncated rather than corrupting the event
+	size_t str_len = str.size();
+	if (!large_payload)
+	{
+		str_len = std::min<size_t>(str_len, UINT16_MAX - 1);
+	}
+
+	size_t start = m_buffer.size();
+	size_t lens_start = start + sizeof(scap_evt);
+	m_buffer.resize(lens_start + len_size * info.nparams);
+
+	for (uint32_t i = 0; i < info.nparams; i++)
+	{
+		auto ptype = info.params[i].type;
+		uint32_t plen = fixed_param_size(ptype);
+		size_t poff = m_buffer.size();
+		if (plen > 0)
+		{
+			// unless specified below, numeric parameters are zeroed
+			int64_t val = 0;
+			if (ptype == PT_FD)
+			{
+				// the return value of exit events, or the fd used by the syscall
+				bool is_res = is_exit && i == 0;
+				val = (is_res || (flags & EF_USES_FD)) ? fd : s_at_fdcwd;
+			}
+			else if (ptype == PT_ERRNO && is_exit && i == 0)
+			{
+				if (flags & EF_CREATES_FD)
+				{
+					val = fd;
+				}
+				else if (flags & (EF_READS_FROM_FD | EF_WRITES_TO_FD))
+				{
+					val = (int64_t) str_len;
+				}
+			}
+			else if (ptype == PT_PID)
+			{
+				val = (int64_t) m_threads[proc_idx].pid;
+			}
+			m_buffer.resize(poff + plen);
+			// little-endian hosts only, like the scap format itself
+			memcpy(m_buffer.data() + poff, &val, plen);
+		}
+		else if (ptype == PT_CHARBUF || ptype == PT_FSPATH || ptype == PT_FSRELPATH)
+		{
+			plen = str_len + 1;
+			m_buffer.insert(m_buffer.end(), str.c_str(), str.c_str() + str_len);
+			m_buffer.push_back('\0');
+		}
+		else if (ptype == PT_BYTEBUF)
+		{
+			plen = str_len;
+			m_buffer.insert(m_buffer.end(), str.begin(), str.begin() + str_len);
+		}
+		// compound parameters (socket addresses, argument arrays, ...)
+		// are left empty, which parsers treat as missing values
+
+		uint8_t* lenptr = m_buffer.data() + lens_start + (size_t) i * len_size;
+		if (large_payload)
+		{
+			memcpy(lenptr, &plen, sizeof(uint32_t));
+		}
+		else
+		{
+			uint16_t plen16 = (uint16_t) plen;
+			memcpy(lenptr, &plen16, sizeof(uint16_t));
+		}
+	}
+
+	scap_evt hdr;
+	hdr.ts = ts;
+	hdr.tid = m_threads[proc_idx].tid;
+	hdr.len = (uint32_t) (m_buffer.size() - start);
+	hdr.type = type;
+	hdr.nparams = info.nparams;
+	memcpy(m_buffer.data() + start, &hdr, sizeof(scap_evt));
+}
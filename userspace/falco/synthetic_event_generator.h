@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+Copyright (C) 2024 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "configuration.h"
+
+#include <libsinsp/sinsp.h>
+#include <libscap/engine/test_input/test_input_public.h>
+
+#include <string>
+#include <vector>
+
+/*!
+	\brief Generates a pool of synthetic syscall events following a
+	configurable syscall mix, process and file descriptor cardinalities,
+	and string length distribution. The pool is fed to an inspector
+	through the libscap test input engine, so that the generated events
+	go through the same parsing and thread-state updates of real ones.
+*/
+class synthetic_event_generator
+{
+public:
+	explicit synthetic_event_generator(const falco_configuration::synthetic_config& config);
+	virtual ~synthetic_event_generator() = default;
+	synthetic_event_generator(synthetic_event_generator&&) = default;
+	synthetic_event_generator& operator = (synthetic_event_generator&&) = default;
+	synthetic_event_generator(const synthetic_event_generator&) = delete;
+	synthetic_event_generator& operator = (const synthetic_event_generator&) = delete;
+
+	/*!
+		\brief Opens the given inspector on the generated events. The
+		inspector returns SCAP_EOF once all the events of the pool have
+		been consumed, and it can then be opened again to loop over them.
+	*/
+	void open(sinsp& inspector);
+
+	/*!
+		\brief Returns the number of events in the generated pool.
+	*/
+	inline size_t pool_size() const
+	{
+		return m_events.size();
+	}
+
+private:
+	struct syscall_info
+	{
+		ppm_event_code enter;
+		ppm_event_code exit;
+	};
+
+	void init_threads();
+	void init_events();
+	void encode_event(ppm_event_code type, uint64_t ts, size_t proc_idx,
+		int64_t fd, const std::string& str);
+
+	falco_configuration::synthetic_config m_config;
+	std::vector<scap_threadinfo> m_threads;
+	std::vector<uint8_t> m_buffer;
+	std::vector<scap_evt*> m_events;
+	scap_test_input_data m_data;
+};
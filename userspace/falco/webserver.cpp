@@ -19,7 +19,9 @@ limitations under the License.
 #include "falco_utils.h"
 #include "falco_metrics.h"
 #include "app/state.h"
+#include "app/signals.h"
 #include "versions_info.h"
+#include "cpu_profiler.h"
 #include <atomic>
 
 falco_webserver::~falco_webserver()
@@ -72,6 +74,111 @@ void falco_webserver::start(
                 res.set_content(falco_metrics::to_text(state), falco_metrics::content_type);
             });
     }
+
+    if (webserver_config.m_profiler_enabled)
+    {
+        const uint32_t max_duration_s = webserver_config.m_profiler_max_duration_s;
+        m_server->Get("/profile",
+            [max_duration_s](const httplib::Request &req, httplib::Response &res) {
+                // parsed as unsigned long and range checked before
+                // narrowing, so that large values are not truncated
+                unsigned long seconds = 10;
+                unsigned long hz = 99;
+                try
+                {
+                    if (req.has_param("seconds"))
+                    {
+                        seconds = std::stoul(req.get_param_value("seconds"));
+                    }
+                    if (req.has_param("hz"))
+                    {
+                        hz = std::stoul(req.get_param_value("hz"));
+                    }
+                }
+                catch (const std::exception &)
+                {
+                    res.status = 400;
+                    res.set_content("invalid seconds or hz parameter\n", "text/plain");
+                    return;
+                }
+                if (seconds == 0 || seconds > max_duration_s)
+                {
+                    res.status = 400;
+                    res.set_content("seconds must be in the range [1, " + std::to_string(max_duration_s) + "]\n", "text/plain");
+                    return;
+                }
+                if (hz == 0 || hz > cpu_profiler::max_frequency_hz)
+                {
+                    res.status = 400;
+                    res.set_content("hz must be in the range [1, " + std::to_string(cpu_profiler::max_frequency_hz) + "]\n", "text/plain");
+                    return;
+                }
+
+                cpu_profiler::result profile;
+                std::string err;
+                if (!cpu_profiler::profile((uint32_t) seconds * 1000, (uint32_t) hz, profile, err))
+                {
+                    res.status = cpu_profiler::supported() ? 409 : 501;
+                    res.set_content(err + "\n", "text/plain");
+                    return;
+                }
+                res.set_header("X-Falco-Profile-Samples", std::to_string(profile.samples));
+                res.set_header("X-Falco-Profile-Dropped", std::to_string(profile.dropped));
+                res.set_content(profile.folded, "text/plain");
+            });
+    }
+
+    if (webserver_config.m_rules_control_enabled)
+    {
+        auto engine = state.engine;
+        auto rules_control = [engine](const httplib::Request &req, httplib::Response &res, bool enable) {
+            if (!req.has_param("name"))
+            {
+                res.status = 400;
+                res.set_content("missing name parameter\n", "text/plain");
+                return;
+            }
+            auto name = req.get_param_value("name");
+            if (engine->get_rules().at(name) == nullptr)
+            {
+                res.status = 404;
+                res.set_content("unknown rule: " + name + "\n", "text/plain");
+                return;
+            }
+            falco_logger::log(falco_logger::level::INFO,
+                std::string(enable ? "Enabling" : "Disabling") + " rule '" + name + "' on request of the webserver\n");
+            falco::app::g_command_bus.broadcast(command_mailbox::command{
+                enable ? command_mailbox::command_type::enable_rule : command_mailbox::command_type::disable_rule,
+                name});
+            res.status = 202;
+            res.set_content("{\"status\": \"accepted\"}", "application/json");
+        };
+        m_server->Post("/rules/enable",
+            [rules_control](const httplib::Request &req, httplib::Response &res) {
+                rules_control(req, res, true);
+            });
+        m_server->Post("/rules/disable",
+            [rules_control](const httplib::Request &req, httplib::Response &res) {
+                rules_control(req, res, false);
+            });
+    }
+
+    if (state.config->m_rule_trace.m_enabled)
+    {
+        auto engine = state.engine;
+        m_server->Get("/rules/trace",
+            [engine](const httplib::Request &, httplib::Response &res) {
+                auto tracer = engine->get_rule_tracer();
+                if (tracer == nullptr)
+                {
+                    res.status = 404;
+                    res.set_content("rule tracing is not enabled\n", "text/plain");
+                    return;
+                }
+                res.set_content(tracer->to_json().dump(), "application/json");
+            });
+    }
+
     // run server in a separate thread
     if (!m_server->is_valid())
     {